@@ -23,6 +23,7 @@
 #include "stm32wbxx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "usbd_conf.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -58,7 +59,9 @@
 /* External variables --------------------------------------------------------*/
 extern PCD_HandleTypeDef hpcd_USB_FS;
 /* USER CODE BEGIN EV */
-
+#if (USBD_PMA_DMA == 1U)
+extern DMA_HandleTypeDef hdma_usb_pma;
+#endif /* USBD_PMA_DMA */
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -205,7 +208,7 @@ void USB_HP_IRQHandler(void)
   /* USER CODE BEGIN USB_HP_IRQn 0 */
 
   /* USER CODE END USB_HP_IRQn 0 */
-  HAL_PCD_IRQHandler(&hpcd_USB_FS);
+  HAL_PCD_HP_IRQHandler(&hpcd_USB_FS);
   /* USER CODE BEGIN USB_HP_IRQn 1 */
 
   /* USER CODE END USB_HP_IRQn 1 */
@@ -226,6 +229,14 @@ void USB_LP_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
-
+#if (USBD_PMA_DMA == 1U)
+/**
+  * @brief This function handles DMA1 channel1 global interrupt, packet memory copies.
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usb_pma);
+}
+#endif /* USBD_PMA_DMA */
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
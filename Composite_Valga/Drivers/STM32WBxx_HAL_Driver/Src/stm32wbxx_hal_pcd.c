@@ -78,6 +78,10 @@
   */
 #define PCD_MIN(a, b)  (((a) < (b)) ? (a) : (b))
 #define PCD_MAX(a, b)  (((a) > (b)) ? (a) : (b))
+/* Endpoints of the high priority interrupt: isochronous, and bulk with
+   double buffering */
+#define PCD_EP_IS_FAST(wEPVal)  ((((wEPVal) & USB_EP_T_FIELD) == USB_EP_ISOCHRONOUS) || \
+                                 ((((wEPVal) & USB_EP_T_FIELD) == USB_EP_BULK) && (((wEPVal) & USB_EP_KIND) != 0U)))
 /**
   * @}
   */
@@ -88,6 +92,8 @@
   */
 
 static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd);
+static void PCD_EP_Service(PCD_HandleTypeDef *hpcd, uint8_t epindex, uint16_t wEPVal);
+static void PCD_EP_OutStage(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t count);
 
 /**
   * @}
@@ -1113,6 +1119,37 @@ void HAL_PCD_IRQHandler(PCD_HandleTypeDef *hpcd)
   }
 }
 
+/**
+  * @brief  This function handles the PCD high priority interrupt request:
+  *         correct transfers of the isochronous and double buffered bulk
+  *         endpoints only. The interrupt flags and every other endpoint are
+  *         left to HAL_PCD_IRQHandler, on the low priority interrupt.
+  * @param  hpcd PCD handle
+  * @retval None
+  */
+void HAL_PCD_HP_IRQHandler(PCD_HandleTypeDef *hpcd)
+{
+  uint16_t wEPVal;
+  uint8_t epindex;
+  uint8_t serviced;
+
+  /* Scan the endpoint registers: the endpoint number of ISTR is the lowest
+     pending one, which may belong to the low priority interrupt */
+  do
+  {
+    serviced = 0U;
+    for (epindex = 1U; epindex < hpcd->Init.dev_endpoints; epindex++)
+    {
+      wEPVal = PCD_GET_ENDPOINT(hpcd->Instance, epindex);
+      if (((wEPVal & (USB_EP_CTR_RX | USB_EP_CTR_TX)) != 0U) && PCD_EP_IS_FAST(wEPVal))
+      {
+        PCD_EP_Service(hpcd, epindex, wEPVal);
+        serviced = 1U;
+      }
+    }
+  } while (serviced != 0U);
+}
+
 
 /**
   * @brief  Data OUT stage callback.
@@ -1256,6 +1293,29 @@ __weak void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epn
    */
 }
 
+/**
+  * @brief  Packet memory copy callback, offers the user the copy of a packet
+  *         of a single buffered non control endpoint.
+  * @param  hpcd PCD handle
+  * @param  ep endpoint: IN, the packet at ep->xfer_buff goes to ep->pmaadress.
+  *         OUT, the packet at ep->pmaadress goes to ep->xfer_buff
+  * @param  len number of bytes of the packet
+  * @retval 1 when the user copies the packet and then calls
+  *         HAL_PCD_EP_PMACopyDone, 0 when the driver copies it
+  */
+__weak uint8_t HAL_PCD_PMACopyCallback(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t len)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hpcd);
+  UNUSED(ep);
+  UNUSED(len);
+
+  /* NOTE : This function should not be modified, when the callback is needed,
+            the HAL_PCD_PMACopyCallback could be implemented in the user file
+   */
+  return 0U;
+}
+
 /**
   * @brief  Connection event callback.
   * @param  hpcd PCD handle
@@ -1488,6 +1548,12 @@ HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr,
   {
     (void)USB_EP0StartXfer(hpcd->Instance, ep);
   }
+  else if ((ep->doublebuffer == 0U) && (ep->xfer_len >= ep->maxpacket) &&
+           (HAL_PCD_PMACopyCallback(hpcd, ep, (uint16_t)ep->maxpacket) != 0U))
+  {
+    /* Full packet copied by the user, sent from HAL_PCD_EP_PMACopyDone */
+    ep->xfer_len -= ep->maxpacket;
+  }
   else
   {
     (void)USB_EPStartXfer(hpcd->Instance, ep);
@@ -1496,6 +1562,40 @@ HAL_StatusTypeDef HAL_PCD_EP_Transmit(PCD_HandleTypeDef *hpcd, uint8_t ep_addr,
   return HAL_OK;
 }
 
+/**
+  * @brief  Complete a packet copy taken by HAL_PCD_PMACopyCallback. The
+  *         endpoint is validated again only if it still waits for the copy,
+  *         NAK, and not closed, stalled or reset meanwhile.
+  * @param  hpcd PCD handle
+  * @param  ep endpoint given to HAL_PCD_PMACopyCallback
+  * @param  len number of bytes copied
+  * @retval HAL status, HAL_ERROR when the packet was dropped
+  */
+HAL_StatusTypeDef HAL_PCD_EP_PMACopyDone(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t len)
+{
+  uint16_t wEPVal = PCD_GET_ENDPOINT(hpcd->Instance, ep->num);
+
+  if (ep->is_in != 0U)
+  {
+    if ((wEPVal & USB_EPTX_STAT) != USB_EP_TX_NAK)
+    {
+      return HAL_ERROR;
+    }
+    PCD_SET_EP_TX_CNT(hpcd->Instance, ep->num, len);
+    PCD_SET_EP_TX_STATUS(hpcd->Instance, ep->num, USB_EP_TX_VALID);
+  }
+  else
+  {
+    if ((wEPVal & USB_EPRX_STAT) != USB_EP_RX_NAK)
+    {
+      return HAL_ERROR;
+    }
+    PCD_EP_OutStage(hpcd, ep, len);
+  }
+
+  return HAL_OK;
+}
+
 /**
   * @brief  Set a STALL condition over an endpoint
   * @param  hpcd PCD handle
@@ -1659,7 +1759,6 @@ PCD_StateTypeDef HAL_PCD_GetState(PCD_HandleTypeDef *hpcd)
 static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
 {
   PCD_EPTypeDef *ep;
-  uint16_t count;
   uint16_t wIstr;
   uint16_t wEPVal;
   uint8_t epindex;
@@ -1762,95 +1861,140 @@ static HAL_StatusTypeDef PCD_EP_ISR_Handler(PCD_HandleTypeDef *hpcd)
 
       /* process related endpoint register */
       wEPVal = PCD_GET_ENDPOINT(hpcd->Instance, epindex);
-      if ((wEPVal & USB_EP_CTR_RX) != 0U)
+
+      /* Left to HAL_PCD_HP_IRQHandler, which preempts this handler */
+      if (PCD_EP_IS_FAST(wEPVal))
       {
-        /* clear int flag */
-        PCD_CLEAR_RX_EP_CTR(hpcd->Instance, epindex);
-        ep = &hpcd->OUT_ep[epindex];
+        break;
+      }
 
-        /* OUT double Buffering*/
-        if (ep->doublebuffer == 0U)
-        {
-          count = (uint16_t)PCD_GET_EP_RX_CNT(hpcd->Instance, ep->num);
-          if (count != 0U)
-          {
-            USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, count);
-          }
-        }
-        else
+      PCD_EP_Service(hpcd, epindex, wEPVal);
+    }
+  }
+  return HAL_OK;
+}
+
+/**
+  * @brief  Service the correct transfers of a non control endpoint.
+  * @param  hpcd PCD handle
+  * @param  epindex endpoint number
+  * @param  wEPVal endpoint register
+  * @retval None
+  */
+static void PCD_EP_Service(PCD_HandleTypeDef *hpcd, uint8_t epindex, uint16_t wEPVal)
+{
+  PCD_EPTypeDef *ep;
+  uint16_t count;
+  uint8_t deferred;
+
+  if ((wEPVal & USB_EP_CTR_RX) != 0U)
+  {
+    /* clear int flag */
+    PCD_CLEAR_RX_EP_CTR(hpcd->Instance, epindex);
+    ep = &hpcd->OUT_ep[epindex];
+
+    deferred = 0U;
+
+    /* OUT double Buffering*/
+    if (ep->doublebuffer == 0U)
+    {
+      count = (uint16_t)PCD_GET_EP_RX_CNT(hpcd->Instance, ep->num);
+      if (count != 0U)
+      {
+        deferred = HAL_PCD_PMACopyCallback(hpcd, ep, count);
+        if (deferred == 0U)
         {
-          if ((PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_RX) != 0U)
-          {
-            /*read from endpoint BUF0Addr buffer*/
-            count = (uint16_t)PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
-            if (count != 0U)
-            {
-              USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr0, count);
-            }
-          }
-          else
-          {
-            /*read from endpoint BUF1Addr buffer*/
-            count = (uint16_t)PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
-            if (count != 0U)
-            {
-              USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr1, count);
-            }
-          }
-          /* free EP OUT Buffer */
-          PCD_FreeUserBuffer(hpcd->Instance, ep->num, 0U);
+          USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaadress, count);
         }
-        /*multi-packet on the NON control OUT endpoint*/
-        ep->xfer_count += count;
-        ep->xfer_buff += count;
-
-        if ((ep->xfer_len == 0U) || (count < ep->maxpacket))
+      }
+    }
+    else
+    {
+      if ((PCD_GET_ENDPOINT(hpcd->Instance, ep->num) & USB_EP_DTOG_RX) != 0U)
+      {
+        /*read from endpoint BUF0Addr buffer*/
+        count = (uint16_t)PCD_GET_EP_DBUF0_CNT(hpcd->Instance, ep->num);
+        if (count != 0U)
         {
-          /* RX COMPLETE */
-#if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
-          hpcd->DataOutStageCallback(hpcd, ep->num);
-#else
-          HAL_PCD_DataOutStageCallback(hpcd, ep->num);
-#endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+          USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr0, count);
         }
-        else
+      }
+      else
+      {
+        /*read from endpoint BUF1Addr buffer*/
+        count = (uint16_t)PCD_GET_EP_DBUF1_CNT(hpcd->Instance, ep->num);
+        if (count != 0U)
         {
-          (void)HAL_PCD_EP_Receive(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
+          USB_ReadPMA(hpcd->Instance, ep->xfer_buff, ep->pmaaddr1, count);
         }
+      }
+      /* free EP OUT Buffer */
+      PCD_FreeUserBuffer(hpcd->Instance, ep->num, 0U);
+    }
 
-      } /* if((wEPVal & EP_CTR_RX) */
+    /* Endpoint left NAK until HAL_PCD_EP_PMACopyDone when deferred */
+    if (deferred == 0U)
+    {
+      PCD_EP_OutStage(hpcd, ep, count);
+    }
+  } /* if((wEPVal & EP_CTR_RX) */
 
-      if ((wEPVal & USB_EP_CTR_TX) != 0U)
-      {
-        ep = &hpcd->IN_ep[epindex];
+  if ((wEPVal & USB_EP_CTR_TX) != 0U)
+  {
+    ep = &hpcd->IN_ep[epindex];
 
-        /* clear int flag */
-        PCD_CLEAR_TX_EP_CTR(hpcd->Instance, epindex);
+    /* clear int flag */
+    PCD_CLEAR_TX_EP_CTR(hpcd->Instance, epindex);
 
-        /*multi-packet on the NON control IN endpoint*/
-        ep->xfer_count = PCD_GET_EP_TX_CNT(hpcd->Instance, ep->num);
-        ep->xfer_buff += ep->xfer_count;
+    /*multi-packet on the NON control IN endpoint*/
+    ep->xfer_count = PCD_GET_EP_TX_CNT(hpcd->Instance, ep->num);
+    ep->xfer_buff += ep->xfer_count;
 
-        /* Zero Length Packet? */
-        if (ep->xfer_len == 0U)
-        {
-          /* TX COMPLETE */
+    /* Zero Length Packet? */
+    if (ep->xfer_len == 0U)
+    {
+      /* TX COMPLETE */
 #if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
-          hpcd->DataInStageCallback(hpcd, ep->num);
+      hpcd->DataInStageCallback(hpcd, ep->num);
 #else
-          HAL_PCD_DataInStageCallback(hpcd, ep->num);
+      HAL_PCD_DataInStageCallback(hpcd, ep->num);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
-        }
-        else
-        {
-          (void)HAL_PCD_EP_Transmit(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
-        }
-      }
+    }
+    else
+    {
+      (void)HAL_PCD_EP_Transmit(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
     }
   }
-  return HAL_OK;
 }
 
+/**
+  * @brief  Account a packet received on a non control OUT endpoint, then
+  *         complete the transfer or receive its next packet.
+  * @param  hpcd PCD handle
+  * @param  ep endpoint
+  * @param  count number of bytes of the packet, copied to ep->xfer_buff
+  * @retval None
+  */
+static void PCD_EP_OutStage(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t count)
+{
+  /*multi-packet on the NON control OUT endpoint*/
+  ep->xfer_count += count;
+  ep->xfer_buff += count;
+
+  if ((ep->xfer_len == 0U) || (count < ep->maxpacket))
+  {
+    /* RX COMPLETE */
+#if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
+    hpcd->DataOutStageCallback(hpcd, ep->num);
+#else
+    HAL_PCD_DataOutStageCallback(hpcd, ep->num);
+#endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+  }
+  else
+  {
+    (void)HAL_PCD_EP_Receive(hpcd, ep->num, ep->xfer_buff, ep->xfer_len);
+  }
+}
 
 /**
   * @}
@@ -49,8 +49,19 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+/* Two packet memory halfwords into one word, PKHBT on a core with the DSP
+   extension */
+#if defined (__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define USB_PMA_PACK(lo, hi)    __PKHBT((lo), (hi), 16)
+#else
+#define USB_PMA_PACK(lo, hi)    ((lo) | ((hi) << 16))
+#endif /* __ARM_FEATURE_DSP */
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+#if PMA_ACCESS == 1U
+__STATIC_INLINE void USB_WritePMA8(__IO uint16_t *pdwVal, const uint8_t *pBuf);
+__STATIC_INLINE void USB_ReadPMA8(const __IO uint16_t *pdwVal, uint8_t *pBuf);
+#endif /* PMA_ACCESS */
 /* Private functions ---------------------------------------------------------*/
 
 
@@ -805,6 +816,30 @@ void USB_WritePMA(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, ui
 
   pdwVal = (__IO uint16_t *)(BaseAddr + 0x400U + ((uint32_t)wPMABufAddr * PMA_ACCESS));
 
+#if PMA_ACCESS == 1U
+  /* Word aligned user buffer: two word loads per 8 bytes, 64 bytes per pass, the
+     packet memory itself only takes halfword accesses */
+  if ((((uint32_t)pBuf) & 3U) == 0U)
+  {
+    for (; n >= 32U; n -= 32U)
+    {
+      for (i = 0U; i < 8U; i++)
+      {
+        USB_WritePMA8(pdwVal, pBuf);
+        pdwVal += 4U;
+        pBuf += 8U;
+      }
+    }
+    for (; n >= 4U; n -= 4U)
+    {
+      USB_WritePMA8(pdwVal, pBuf);
+      pdwVal += 4U;
+      pBuf += 8U;
+    }
+  }
+#endif /* PMA_ACCESS */
+
+  /* Halfwords left, or a buffer not on a word boundary, byte by byte */
   for (i = n; i != 0U; i--)
   {
     temp1 = *pBuf;
@@ -839,6 +874,29 @@ void USB_ReadPMA(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uin
 
   pdwVal = (__IO uint16_t *)(BaseAddr + 0x400U + ((uint32_t)wPMABufAddr * PMA_ACCESS));
 
+#if PMA_ACCESS == 1U
+  /* Word aligned user buffer: two word stores per 8 bytes, 64 bytes per pass */
+  if ((((uint32_t)pBuf) & 3U) == 0U)
+  {
+    for (; n >= 32U; n -= 32U)
+    {
+      for (i = 0U; i < 8U; i++)
+      {
+        USB_ReadPMA8(pdwVal, pBuf);
+        pdwVal += 4U;
+        pBuf += 8U;
+      }
+    }
+    for (; n >= 4U; n -= 4U)
+    {
+      USB_ReadPMA8(pdwVal, pBuf);
+      pdwVal += 4U;
+      pBuf += 8U;
+    }
+  }
+#endif /* PMA_ACCESS */
+
+  /* Halfwords left, or a buffer not on a word boundary, byte by byte */
   for (i = n; i != 0U; i--)
   {
     temp = *(__IO uint16_t *)pdwVal;
@@ -860,6 +918,42 @@ void USB_ReadPMA(USB_TypeDef *USBx, uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uin
   }
 }
 
+#if PMA_ACCESS == 1U
+/**
+  * @brief Copy 8 bytes from a word aligned user buffer to 4 halfwords of PMA
+  * @param   pdwVal address in PMA.
+  * @param   pBuf pointer to user memory area, on a word boundary.
+  * @retval None
+  */
+__STATIC_INLINE void USB_WritePMA8(__IO uint16_t *pdwVal, const uint8_t *pBuf)
+{
+  /* The buffer is a byte array of any type, read it through the CMSIS
+     accessors so the word loads do not break strict aliasing */
+  uint32_t lo = __UNALIGNED_UINT32_READ(pBuf);
+  uint32_t hi = __UNALIGNED_UINT32_READ(pBuf + 4U);
+
+  pdwVal[0] = (uint16_t)lo;
+  pdwVal[1] = (uint16_t)(lo >> 16);
+  pdwVal[2] = (uint16_t)hi;
+  pdwVal[3] = (uint16_t)(hi >> 16);
+}
+
+/**
+  * @brief Copy 4 halfwords of PMA to 8 bytes of a word aligned user buffer
+  * @param   pdwVal address in PMA.
+  * @param   pBuf pointer to user memory area, on a word boundary.
+  * @retval None
+  */
+__STATIC_INLINE void USB_ReadPMA8(const __IO uint16_t *pdwVal, uint8_t *pBuf)
+{
+  uint32_t lo = USB_PMA_PACK((uint32_t)pdwVal[0], (uint32_t)pdwVal[1]);
+  uint32_t hi = USB_PMA_PACK((uint32_t)pdwVal[2], (uint32_t)pdwVal[3]);
+
+  __UNALIGNED_UINT32_WRITE(pBuf, lo);
+  __UNALIGNED_UINT32_WRITE(pBuf + 4U, hi);
+}
+#endif /* PMA_ACCESS */
+
 
 /**
   * @}
@@ -0,0 +1,129 @@
+/*
+ * usbd_audio.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  USB Audio Class 1.0 speaker: an audio control interface with a USB
+ *  streaming input terminal wired to a speaker output terminal, and an audio
+ *  streaming interface whose alternate setting 1 carries 16 bit PCM on an
+ *  asynchronous isochronous OUT endpoint. The device clock paces the
+ *  playback, the host follows it through the explicit feedback endpoint.
+ *  Samples go through a USBD_AUDIO_ItfTypeDef registered by the application
+ *  (usbd_audio_if.c).
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_AUDIO_INC_USBD_AUDIO_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_AUDIO_INC_USBD_AUDIO_H_
+
+#include  "usbd_ioreq.h"
+
+/* 1 adds the audio function. An isochronous endpoint needs an endpoint
+ * register of its own and the device has one left: the audio endpoints take
+ * the numbers of the stream and of the mass storage, build it with
+ * STREAM_ENABLE 0 and MSC_ENABLE 0 */
+#ifndef AUDIO_ENABLE
+#define AUDIO_ENABLE                  0U
+#endif /* AUDIO_ENABLE */
+
+#define AUDIO_OUT_EP                  0x07U
+#define AUDIO_FB_EP                   0x86U
+
+#ifndef AUDIO_FREQ
+#define AUDIO_FREQ                    48000U
+#endif /* AUDIO_FREQ */
+
+#ifndef AUDIO_CHANNELS
+#define AUDIO_CHANNELS                2U
+#endif /* AUDIO_CHANNELS */
+
+#define AUDIO_SAMPLE_SIZE             2U
+#define AUDIO_FRAME_SIZE              (AUDIO_CHANNELS * AUDIO_SAMPLE_SIZE)
+#define AUDIO_CHANNEL_CONFIG          ((AUDIO_CHANNELS == 2U) ? 0x0003U : 0x0004U)
+
+/* Samples of one frame at the nominal rate, and one more for the host to
+ * catch up with a faster device clock */
+#define AUDIO_NOMINAL_FRAMES          (AUDIO_FREQ / 1000U)
+#define AUDIO_OUT_PACKET_SIZE         ((AUDIO_NOMINAL_FRAMES + 1U) * AUDIO_FRAME_SIZE)
+
+#if ((AUDIO_FREQ % 1000U) != 0U)
+#error "AUDIO_FREQ must be a whole number of samples per frame"
+#endif
+
+#if (AUDIO_OUT_PACKET_SIZE > 1023U)
+#error "A full speed isochronous packet holds 1023 bytes at most"
+#endif
+
+/* Sample frames between the host and the playback, a power of two. The
+ * feedback holds the queue half full: AUDIO_FIFO_FRAMES / 2 frames of
+ * latency, as much margin against a late packet */
+#ifndef AUDIO_FIFO_FRAMES
+#define AUDIO_FIFO_FRAMES             256U
+#endif /* AUDIO_FIFO_FRAMES */
+
+/* Rate feedback, 10.14 samples per frame in 3 bytes. The host reads it every
+ * 2^AUDIO_FB_REFRESH frames, the device measures its clock over
+ * 2^AUDIO_FB_WINDOW_LOG2 frames */
+#define AUDIO_FB_PACKET_SIZE          3U
+#define AUDIO_FB_REFRESH              0x05U
+#define AUDIO_FB_WINDOW_LOG2          6U
+/* A frame of FIFO level away from half full moves the rate by
+ * 2^-AUDIO_FB_LEVEL_SHIFT sample per frame */
+#define AUDIO_FB_LEVEL_SHIFT          9U
+
+/* Audio class codes */
+#define AUDIO_SUBCLASS_AUDIOCONTROL   0x01U
+#define AUDIO_SUBCLASS_AUDIOSTREAMING 0x02U
+#define AUDIO_CS_INTERFACE            0x24U
+#define AUDIO_CS_ENDPOINT             0x25U
+#define AUDIO_TERMINAL_ID_IN          0x01U
+#define AUDIO_TERMINAL_ID_OUT         0x02U
+
+#define AUDIO_REQ_SET_CUR             0x01U
+#define AUDIO_REQ_GET_CUR             0x81U
+#define AUDIO_SAMPLING_FREQ_CONTROL   0x01U
+
+typedef struct
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  /* Alternate setting 1 selected or left */
+  int8_t (* Start)(void);
+  int8_t (* Stop)(void);
+  /* One packet of len bytes, whole sample frames. Called from the USB
+   * interrupt */
+  int8_t (* Receive)(const uint8_t *buf, uint16_t len);
+  /* Sample frames played by the device clock since Start, and sample frames
+   * waiting to be played. Called from the USB interrupt */
+  void (* GetClock)(uint32_t *played, uint16_t *level);
+}
+USBD_AUDIO_ItfTypeDef;
+
+/* Feedback state, no hardware involved: the feedback loop can run on a host
+ * model of the two clocks */
+typedef struct
+{
+  uint32_t             Feedback;     /* 10.14 samples per frame sent to the host */
+  uint32_t             Rate;         /* filtered measured rate, 10.14 */
+  uint32_t             LastPlayed;
+  uint16_t             Frames;       /* frames of the current window */
+  uint16_t             Target;       /* FIFO level the loop holds, in sample frames */
+}
+USBD_AUDIO_FeedbackTypeDef;
+
+typedef struct
+{
+  uint8_t              AltSetting;
+  uint8_t              FbBuf[AUDIO_FB_PACKET_SIZE + 1U]; /* the packet memory is written by halfwords */
+  USBD_AUDIO_FeedbackTypeDef Fb;
+  uint8_t              Control[4];   /* EP0 data of a class request */
+  uint8_t              OutBuf[AUDIO_OUT_PACKET_SIZE];
+}
+USBD_AUDIO_HandleTypeDef;
+
+extern USBD_ClassTypeDef  USBD_AUDIO;
+
+uint8_t  USBD_AUDIO_RegisterInterface(void *Comp_iops, USBD_AUDIO_ItfTypeDef *fops);
+
+void     USBD_AUDIO_FeedbackInit(USBD_AUDIO_FeedbackTypeDef *fb, uint16_t target, uint32_t played);
+uint8_t  USBD_AUDIO_FeedbackFrame(USBD_AUDIO_FeedbackTypeDef *fb, uint32_t played, uint16_t level);
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_AUDIO_INC_USBD_AUDIO_H_ */
@@ -0,0 +1,473 @@
+/*
+ * usbd_audio.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Each OUT packet is handed to the application FIFO as it arrives. The
+ *  playback side reports how many sample frames the device clock consumed;
+ *  at every SOF the feedback loop compares that count with the frames
+ *  elapsed, and adds a correction pulling the FIFO level back to half full,
+ *  so that neither side runs dry or over when the two clocks drift. The
+ *  result is kept armed on the feedback endpoint for the host to read.
+ */
+
+#include "../Inc/usbd_audio.h"
+#include "usbd_ctlreq.h"
+#include "../../Composite/Inc/Composite.h"
+
+/* The interface numbers exist with the function only */
+#if (AUDIO_ENABLE == 1U)
+
+uint8_t USBD_AUDIO_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_AUDIO_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_AUDIO_EP0_RxReady(USBD_HandleTypeDef *pdev);
+uint8_t USBD_AUDIO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_AUDIO_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev);
+
+static void USBD_AUDIO_Start(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio);
+static void USBD_AUDIO_Stop(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio);
+static void USBD_AUDIO_SendFeedback(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio);
+
+/* Callbacks of the audio function, dispatched by the composite router */
+USBD_ClassTypeDef  USBD_AUDIO =
+{
+  USBD_AUDIO_Init,
+  USBD_AUDIO_DeInit,
+  USBD_AUDIO_Setup,
+  NULL, /*EP0_TxSent*/
+  USBD_AUDIO_EP0_RxReady,
+  USBD_AUDIO_DataIn,
+  USBD_AUDIO_DataOut,
+  USBD_AUDIO_SOF,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static USBD_AUDIO_ItfTypeDef *AUDIO_Itf(USBD_HandleTypeDef *pdev)
+{
+  return (USBD_AUDIO_ItfTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->AUDIO_ops;
+}
+
+static USBD_AUDIO_HandleTypeDef *AUDIO_Handle(USBD_HandleTypeDef *pdev)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  return (compHandle != NULL) ? (USBD_AUDIO_HandleTypeDef *)compHandle->audio : NULL;
+}
+
+/**
+  * @brief  USBD_AUDIO_Init
+  *         Initialize the audio interfaces, streaming stopped
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_AUDIO_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+
+  /* The composite layer has opened the endpoints */
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  compHandle->audio = USBD_malloc_Type(USBD_AUDIO_HandleTypeDef, 1U);
+
+  if (compHandle->audio == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  (void)memset(compHandle->audio, 0, sizeof(USBD_AUDIO_HandleTypeDef));
+  (void)AUDIO_Itf(pdev)->Init();
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_DeInit
+  *         DeInitialize the audio interfaces
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_AUDIO_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  /* The composite layer closes the endpoints */
+  if (compHandle->audio != NULL)
+  {
+    if (((USBD_AUDIO_HandleTypeDef *)compHandle->audio)->AltSetting != 0U)
+    {
+      (void)AUDIO_Itf(pdev)->Stop();
+    }
+    (void)AUDIO_Itf(pdev)->DeInit();
+    USBD_free(compHandle->audio);
+    compHandle->audio = NULL;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_Setup
+  *         Handle the standard interface requests, SET_INTERFACE starts and
+  *         stops the stream, and the sampling frequency of the endpoint
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AUDIO_Handle(pdev);
+  uint16_t status_info = 0U;
+  uint8_t ret = USBD_OK;
+
+  if (haudio == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS :
+      /* Sampling frequency of the data endpoint, the only control: one
+       * frequency is supported, a SET_CUR is taken and ignored */
+      if (((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_ENDPOINT) &&
+          (HIBYTE(req->wValue) == AUDIO_SAMPLING_FREQ_CONTROL) && (req->wLength == 3U))
+      {
+        if (req->bRequest == AUDIO_REQ_GET_CUR)
+        {
+          haudio->Control[0] = (uint8_t)AUDIO_FREQ;
+          haudio->Control[1] = (uint8_t)(AUDIO_FREQ >> 8);
+          haudio->Control[2] = (uint8_t)(AUDIO_FREQ >> 16);
+          USBD_CtlSendData(pdev, haudio->Control, 3U);
+          break;
+        }
+        if (req->bRequest == AUDIO_REQ_SET_CUR)
+        {
+          USBD_CtlPrepareRx(pdev, haudio->Control, 3U);
+          break;
+        }
+      }
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            /* The control interface has a single setting */
+            if (LOBYTE(req->wIndex) == USBD_COMP_ITF_AUDIO_AS)
+            {
+              USBD_CtlSendData(pdev, &haudio->AltSetting, 1U);
+            }
+            else
+            {
+              USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 1U);
+            }
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE :
+          if ((pdev->dev_state == USBD_STATE_CONFIGURED) &&
+              (((LOBYTE(req->wIndex) == USBD_COMP_ITF_AUDIO_AS) && (req->wValue <= 1U)) ||
+               (req->wValue == 0U)))
+          {
+            if ((LOBYTE(req->wIndex) == USBD_COMP_ITF_AUDIO_AS) &&
+                ((uint8_t)req->wValue != haudio->AltSetting))
+            {
+              haudio->AltSetting = (uint8_t)req->wValue;
+              if (haudio->AltSetting != 0U)
+              {
+                USBD_AUDIO_Start(pdev, haudio);
+              }
+              else
+              {
+                USBD_AUDIO_Stop(pdev, haudio);
+              }
+            }
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          /* Endpoint halt, cleared by the core */
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_AUDIO_EP0_RxReady
+  *         Data stage of SET_CUR, the frequency is fixed
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_AUDIO_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_DataIn
+  *         The host read the feedback, arm it again
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_AUDIO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AUDIO_Handle(pdev);
+
+  if (haudio == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  if (haudio->AltSetting != 0U)
+  {
+    USBD_AUDIO_SendFeedback(pdev, haudio);
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_DataOut
+  *         Samples received, queue them and take the next packet
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_AUDIO_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AUDIO_Handle(pdev);
+  uint16_t len;
+
+  if (haudio == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  if (haudio->AltSetting != 0U)
+  {
+    /* A partial sample frame is dropped, it would shift the channels */
+    len = (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum);
+    len -= (uint16_t)(len % AUDIO_FRAME_SIZE);
+    (void)AUDIO_Itf(pdev)->Receive(haudio->OutBuf, len);
+    USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, haudio->OutBuf, AUDIO_OUT_PACKET_SIZE);
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_SOF
+  *         Start of frame: one more frame for the feedback measurement
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AUDIO_Handle(pdev);
+  uint32_t played;
+  uint16_t level;
+
+  if ((haudio == NULL) || (haudio->AltSetting == 0U))
+  {
+    return USBD_OK;
+  }
+
+  AUDIO_Itf(pdev)->GetClock(&played, &level);
+  if (USBD_AUDIO_FeedbackFrame(&haudio->Fb, played, level) != 0U)
+  {
+    /* Taken by the next packet armed, the one in the packet memory
+     * still carries the previous value */
+    haudio->FbBuf[0] = (uint8_t)haudio->Fb.Feedback;
+    haudio->FbBuf[1] = (uint8_t)(haudio->Fb.Feedback >> 8);
+    haudio->FbBuf[2] = (uint8_t)(haudio->Fb.Feedback >> 16);
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_AUDIO_Start
+  *         Alternate setting 1: reset the feedback loop, arm both endpoints
+  * @param  pdev: device instance
+  * @param  haudio: audio handle
+  * @retval None
+  */
+static void USBD_AUDIO_Start(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio)
+{
+  uint32_t played;
+  uint16_t level;
+
+  (void)AUDIO_Itf(pdev)->Start();
+  AUDIO_Itf(pdev)->GetClock(&played, &level);
+  USBD_AUDIO_FeedbackInit(&haudio->Fb, AUDIO_FIFO_FRAMES / 2U, played);
+  haudio->FbBuf[0] = (uint8_t)haudio->Fb.Feedback;
+  haudio->FbBuf[1] = (uint8_t)(haudio->Fb.Feedback >> 8);
+  haudio->FbBuf[2] = (uint8_t)(haudio->Fb.Feedback >> 16);
+
+  USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, haudio->OutBuf, AUDIO_OUT_PACKET_SIZE);
+  USBD_AUDIO_SendFeedback(pdev, haudio);
+}
+
+/**
+  * @brief  USBD_AUDIO_Stop
+  *         Alternate setting 0: the host no longer sends samples
+  * @param  pdev: device instance
+  * @param  haudio: audio handle
+  * @retval None
+  */
+static void USBD_AUDIO_Stop(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio)
+{
+  USBD_LL_FlushEP(pdev, AUDIO_FB_EP);
+  USBD_LL_FlushEP(pdev, AUDIO_OUT_EP);
+  (void)AUDIO_Itf(pdev)->Stop();
+}
+
+/**
+  * @brief  USBD_AUDIO_SendFeedback
+  *         Copy the current feedback value to the packet memory
+  * @param  pdev: device instance
+  * @param  haudio: audio handle
+  * @retval None
+  */
+static void USBD_AUDIO_SendFeedback(USBD_HandleTypeDef *pdev, USBD_AUDIO_HandleTypeDef *haudio)
+{
+  USBD_LL_Transmit(pdev, AUDIO_FB_EP, haudio->FbBuf, AUDIO_FB_PACKET_SIZE);
+}
+
+/**
+  * @brief  USBD_AUDIO_FeedbackInit
+  *         Start the feedback loop at the nominal rate
+  * @param  fb: feedback state
+  * @param  target: FIFO level to hold, in sample frames
+  * @param  played: sample frames played so far
+  * @retval None
+  */
+void USBD_AUDIO_FeedbackInit(USBD_AUDIO_FeedbackTypeDef *fb, uint16_t target, uint32_t played)
+{
+  fb->Feedback = AUDIO_NOMINAL_FRAMES << 14;
+  fb->Rate = fb->Feedback;
+  fb->LastPlayed = played;
+  fb->Frames = 0U;
+  fb->Target = target;
+}
+
+/**
+  * @brief  USBD_AUDIO_FeedbackFrame
+  *         One frame elapsed. At the end of a window the frames played
+  *         give the device rate in samples per frame, averaged with the
+  *         previous windows, and the FIFO level adds the correction that
+  *         brings it back to the target. The result stays within half a
+  *         sample of the nominal rate, so that a packet never exceeds
+  *         AUDIO_OUT_PACKET_SIZE
+  * @param  fb: feedback state
+  * @param  played: sample frames played so far, wrapping
+  * @param  level: sample frames waiting in the FIFO
+  * @retval 1 when fb->Feedback changed, else 0
+  */
+uint8_t USBD_AUDIO_FeedbackFrame(USBD_AUDIO_FeedbackTypeDef *fb, uint32_t played, uint16_t level)
+{
+  int32_t measured;
+  int32_t value;
+
+  fb->Frames++;
+  if (fb->Frames < (1U << AUDIO_FB_WINDOW_LOG2))
+  {
+    return 0U;
+  }
+  fb->Frames = 0U;
+
+  measured = (int32_t)((played - fb->LastPlayed) << (14U - AUDIO_FB_WINDOW_LOG2));
+  fb->LastPlayed = played;
+
+  /* A quarter of each new window, the playback side may count its samples
+   * by whole DMA blocks */
+  fb->Rate = (uint32_t)((int32_t)fb->Rate + ((measured - (int32_t)fb->Rate) / 4));
+
+  value = (int32_t)fb->Rate +
+          (((int32_t)fb->Target - (int32_t)level) * (1 << (14U - AUDIO_FB_LEVEL_SHIFT)));
+
+  if (value > (int32_t)((AUDIO_NOMINAL_FRAMES << 14) + (1U << 13)))
+  {
+    value = (int32_t)((AUDIO_NOMINAL_FRAMES << 14) + (1U << 13));
+  }
+  else if (value < (int32_t)((AUDIO_NOMINAL_FRAMES << 14) - (1U << 13)))
+  {
+    value = (int32_t)((AUDIO_NOMINAL_FRAMES << 14) - (1U << 13));
+  }
+
+  fb->Feedback = (uint32_t)value;
+
+  return 1U;
+}
+
+/**
+  * @brief  USBD_AUDIO_RegisterInterface
+  * @param  Comp_iops: composite interface table
+  * @param  fops: audio callbacks
+  * @retval status
+  */
+uint8_t USBD_AUDIO_RegisterInterface(void *Comp_iops, USBD_AUDIO_ItfTypeDef *fops)
+{
+  uint8_t ret = USBD_FAIL;
+
+  if (fops != NULL)
+  {
+    ((USBD_Comp_ItfTypeDef *)Comp_iops)->AUDIO_ops = fops;
+    ret = USBD_OK;
+  }
+
+  return ret;
+}
+
+#endif /* AUDIO_ENABLE */
@@ -27,7 +27,6 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include  "usbd_ioreq.h"
-#include "..\..\Composite\Inc\Composite.h"
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
   * @{
   */
@@ -58,7 +57,6 @@ extern "C" {
 #define CDC_DATA_FS_MAX_PACKET_SIZE                 64U  /* Endpoint IN & OUT Packet size */
 #define CDC_CMD_PACKET_SIZE                         8U  /* Control Endpoint Packet size */
 
-#define USB_CDC_CONFIG_DESC_SIZ                     67U
 #define CDC_DATA_HS_IN_PACKET_SIZE                  CDC_DATA_HS_MAX_PACKET_SIZE
 #define CDC_DATA_HS_OUT_PACKET_SIZE                 CDC_DATA_HS_MAX_PACKET_SIZE
 
@@ -163,6 +161,10 @@ uint8_t  USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev);
   * @}
   */
 
+/* Composite handle, included last: the composite descriptor checks the
+ * CDC endpoint addresses defined above */
+#include "../../Composite/Inc/Composite.h"
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,75 +7,307 @@
 #ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_H_
 #define ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_H_
 
-#include "..\..\HID\Inc\usbd_hid.h"
-#include "..\..\CDC\Inc\usbd_cdc.h"
+#include "../../HID/Inc/usbd_hid.h"
+#include "../../CDC/Inc/usbd_cdc.h"
+#include "../../HID/Inc/usbd_hid_pointer.h"
+#include "../../MSC/Inc/usbd_msc.h"
+#include "../../STREAM/Inc/usbd_stream.h"
+#include "../../AUDIO/Inc/usbd_audio.h"
+#include "../../DFU/Inc/usbd_dfu.h"
+#include "Composite_desc.h"
 #include "usbd_ctlreq.h"
 #include  "usbd_ioreq.h"
 
-#define USB_COMPOSITE_CONFIG_DESC_SIZ                     92U
+/* HID class descriptor of an interface whose report descriptor is size bytes */
+#define COMP_HID_DESC(D, size) \
+  D(0x09U, HID_DESCRIPTOR_TYPE, 0x11U, 0x01U, 0x00U, 0x01U, 0x22U, LOBYTE(size), HIBYTE(size))
 
-typedef struct
+/* Keyboard: boot interface, LED reports on the OUT endpoint */
+#define COMP_KEYBOARD_CS(D)           COMP_HID_DESC(D, HID_KEYBOARD_REPORT_DESC_SIZE)
+#if (HID_USE_EPOUT == 1U)
+#define COMP_KEYBOARD_EPOUT(EP)       EP(HID_EPOUT_ADDR, USBD_EP_TYPE_INTR, HID_EPOUT_SIZE, HID_FS_BINTERVAL)
+#else
+#define COMP_KEYBOARD_EPOUT(EP)
+#endif /* HID_USE_EPOUT */
+#define COMP_KEYBOARD_EPS(EP)                                                   \
+  EP(HID_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_EPIN_SIZE, HID_FS_BINTERVAL)         \
+  COMP_KEYBOARD_EPOUT(EP)
+#define COMP_KEYBOARD_ITFS(ITF) \
+  ITF(KEYBOARD, 0, 0x03U, 0x01U, 0x01U, 0x05U, COMP_KEYBOARD_CS, COMP_KEYBOARD_EPS)
+
+/* CDC ACM: communication and data interfaces */
+#define COMP_CDC_CMD_CS(D)                                                      \
+  D(0x05U, 0x24U, 0x00U, 0x10U, 0x01U)                     /* Header */        \
+  D(0x05U, 0x24U, 0x01U, 0x00U, USBD_COMP_ITF_CDC_DATA)    /* Call management */ \
+  D(0x04U, 0x24U, 0x02U, 0x02U)                            /* ACM */           \
+  D(0x05U, 0x24U, 0x06U, USBD_COMP_ITF_CDC_CMD, USBD_COMP_ITF_CDC_DATA) /* Union */
+#define COMP_CDC_CMD_EPS(EP) \
+  EP(CDC_CMD_EP, USBD_EP_TYPE_INTR, CDC_CMD_PACKET_SIZE, CDC_FS_BINTERVAL)
+#define COMP_CDC_DATA_EPS(EP)                                                   \
+  EP(CDC_OUT_EP, USBD_EP_TYPE_BULK, CDC_DATA_FS_MAX_PACKET_SIZE, 0x00U)         \
+  EP(CDC_IN_EP, USBD_EP_TYPE_BULK, CDC_DATA_FS_MAX_PACKET_SIZE, 0x00U)
+#define COMP_CDC_ITFS(ITF)                                                      \
+  ITF(CDC_CMD, 0, 0x02U, 0x02U, 0x01U, 0x00U, COMP_CDC_CMD_CS, COMP_CDC_CMD_EPS) \
+  ITF(CDC_DATA, 0, 0x0AU, 0x00U, 0x00U, 0x06U, COMP_DESC_NONE, COMP_CDC_DATA_EPS)
+
+/* Consumer and system control */
+#define COMP_CONTROL_CS(D)            COMP_HID_DESC(D, HID_CONTROL_REPORT_DESC_SIZE)
+#define COMP_CONTROL_EPS(EP) \
+  EP(HID_CONTROL_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_CONTROL_EPIN_SIZE, HID_FS_BINTERVAL)
+#define COMP_CONTROL_ITFS(ITF) \
+  ITF(CONTROL, 0, 0x03U, 0x00U, 0x00U, 0x00U, COMP_CONTROL_CS, COMP_CONTROL_EPS)
+
+/* Pointer */
+#define COMP_POINTER_CS(D)            COMP_HID_DESC(D, HID_POINTER_REPORT_DESC_SIZE)
+#define COMP_POINTER_EPS(EP) \
+  EP(HID_POINTER_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_POINTER_EPIN_SIZE, HID_POINTER_FS_BINTERVAL)
+#define COMP_POINTER_ITFS(ITF) \
+  ITF(POINTER, 0, 0x03U, 0x00U, 0x00U, 0x00U, COMP_POINTER_CS, COMP_POINTER_EPS)
+#if (HID_POINTER_ENABLE == 1U)
+#define COMP_POINTER_FUNC(FUNC, ITF)  FUNC(ITF, USBD_HID_POINTER, COMP_POINTER_ITFS)
+#define COMP_POINTER_HANDLE(H)        H(USBD_HID_Pointer_HandleTypeDef, 1U)
+#else
+#define COMP_POINTER_FUNC(FUNC, ITF)
+#define COMP_POINTER_HANDLE(H)
+#endif /* HID_POINTER_ENABLE */
+
+/* Mass storage, SCSI transparent command set over bulk-only transport */
+#define COMP_MSC_EPS(EP)                                                        \
+  EP(MSC_EPOUT_ADDR, USBD_EP_TYPE_BULK, MSC_MAX_FS_PACKET, 0x00U)               \
+  EP(MSC_EPIN_ADDR, USBD_EP_TYPE_BULK, MSC_MAX_FS_PACKET, 0x00U)
+#define COMP_MSC_ITFS(ITF) \
+  ITF(MSC, 0, 0x08U, 0x06U, 0x50U, 0x00U, COMP_DESC_NONE, COMP_MSC_EPS)
+#if (MSC_ENABLE == 1U)
+#define COMP_MSC_FUNC(FUNC, ITF)      FUNC(ITF, USBD_MSC, COMP_MSC_ITFS)
+#define COMP_MSC_HANDLE(H)            H(USBD_MSC_HandleTypeDef, 1U)
+#else
+#define COMP_MSC_FUNC(FUNC, ITF)
+#define COMP_MSC_HANDLE(H)
+#endif /* MSC_ENABLE */
+
+/* Vendor stream: alternate setting 0 reserves no bandwidth, 1 runs the
+ * isochronous endpoints */
+#if (STREAM_OUT_ENABLE == 1U)
+#define COMP_STREAM_EPOUT(EP) \
+  EP(STREAM_EPOUT_ADDR, STREAM_EP_ATTR, STREAM_OUT_PACKET_SIZE, STREAM_BINTERVAL)
+#else
+#define COMP_STREAM_EPOUT(EP)
+#endif /* STREAM_OUT_ENABLE */
+#define COMP_STREAM_EPS(EP)                                                     \
+  EP(STREAM_EPIN_ADDR, STREAM_EP_ATTR, STREAM_IN_PACKET_SIZE, STREAM_BINTERVAL) \
+  COMP_STREAM_EPOUT(EP)
+#define COMP_STREAM_ITFS(ITF)                                                   \
+  ITF(STREAM, 0, 0xFFU, 0x00U, 0x00U, 0x00U, COMP_DESC_NONE, COMP_DESC_NONE)    \
+  ITF(STREAM, 1, 0xFFU, 0x00U, 0x00U, 0x00U, COMP_DESC_NONE, COMP_STREAM_EPS)
+#if (STREAM_ENABLE == 1U)
+#define COMP_STREAM_FUNC(FUNC, ITF)   FUNC(ITF, USBD_STREAM, COMP_STREAM_ITFS)
+#define COMP_STREAM_HANDLE(H)         H(USBD_STREAM_HandleTypeDef, 1U)
+#else
+#define COMP_STREAM_FUNC(FUNC, ITF)
+#define COMP_STREAM_HANDLE(H)
+#endif /* STREAM_ENABLE */
+
+/* Audio 1.0 speaker: USB streaming terminal to speaker terminal, and the
+ * streaming interface with its data and feedback endpoints */
+#define COMP_AUDIO_AC_CS(D)                                                     \
+  D(0x09U, AUDIO_CS_INTERFACE, 0x01U, 0x00U, 0x01U, 0x1EU, 0x00U, 0x01U,       \
+    USBD_COMP_ITF_AUDIO_AS)                                    /* Header */     \
+  D(0x0CU, AUDIO_CS_INTERFACE, 0x02U, AUDIO_TERMINAL_ID_IN, 0x01U, 0x01U, 0x00U, \
+    AUDIO_CHANNELS, LOBYTE(AUDIO_CHANNEL_CONFIG), HIBYTE(AUDIO_CHANNEL_CONFIG), \
+    0x00U, 0x00U)                                              /* Input terminal */ \
+  D(0x09U, AUDIO_CS_INTERFACE, 0x03U, AUDIO_TERMINAL_ID_OUT, 0x01U, 0x03U,     \
+    0x00U, AUDIO_TERMINAL_ID_IN, 0x00U)                        /* Output terminal */
+#define COMP_AUDIO_AS_CS(D)                                                     \
+  D(0x07U, AUDIO_CS_INTERFACE, 0x01U, AUDIO_TERMINAL_ID_IN, 0x01U, 0x01U, 0x00U) /* General, PCM */ \
+  D(0x0BU, AUDIO_CS_INTERFACE, 0x02U, 0x01U, AUDIO_CHANNELS, AUDIO_SAMPLE_SIZE, \
+    8U * AUDIO_SAMPLE_SIZE, 0x01U, (uint8_t)AUDIO_FREQ, (uint8_t)(AUDIO_FREQ >> 8), \
+    (uint8_t)(AUDIO_FREQ >> 16))                               /* Format type I */
+#define COMP_AUDIO_OUT_EP_CS(D) \
+  D(0x07U, AUDIO_CS_ENDPOINT, 0x01U, 0x01U, 0x00U, 0x00U, 0x00U) /* Sampling frequency control */
+#define COMP_AUDIO_AS_EPS(EP)                                                   \
+  EP(AUDIO_OUT_EP, USBD_EP_TYPE_ISOC | 0x04U, AUDIO_OUT_PACKET_SIZE, 0x01U,     \
+     0x00U, AUDIO_FB_EP, COMP_AUDIO_OUT_EP_CS)                                  \
+  EP(AUDIO_FB_EP, USBD_EP_TYPE_ISOC | 0x10U, AUDIO_FB_PACKET_SIZE, 0x01U,       \
+     AUDIO_FB_REFRESH, 0x00U, COMP_DESC_NONE)
+#define COMP_AUDIO_ITFS(ITF)                                                    \
+  ITF(AUDIO_AC, 0, 0x01U, AUDIO_SUBCLASS_AUDIOCONTROL, 0x00U, 0x00U, COMP_AUDIO_AC_CS, COMP_DESC_NONE) \
+  ITF(AUDIO_AS, 0, 0x01U, AUDIO_SUBCLASS_AUDIOSTREAMING, 0x00U, 0x00U, COMP_DESC_NONE, COMP_DESC_NONE) \
+  ITF(AUDIO_AS, 1, 0x01U, AUDIO_SUBCLASS_AUDIOSTREAMING, 0x00U, 0x00U, COMP_AUDIO_AS_CS, COMP_AUDIO_AS_EPS)
+#if (AUDIO_ENABLE == 1U)
+#define COMP_AUDIO_FUNC(IAD, ITF) \
+  IAD(ITF, USBD_AUDIO, AUDIO, 0x01U, 0x00U, 0x00U, 0x00U, COMP_AUDIO_ITFS)
+#define COMP_AUDIO_HANDLE(H)          H(USBD_AUDIO_HandleTypeDef, 1U)
+#else
+#define COMP_AUDIO_FUNC(IAD, ITF)
+#define COMP_AUDIO_HANDLE(H)
+#endif /* AUDIO_ENABLE */
+
+/* Firmware upgrade in DFU mode, on the control endpoint */
+#define COMP_DFU_CS(D)                                                          \
+  D(0x09U, DFU_FUNC_DESC_TYPE, DFU_ATTRIBUTES, LOBYTE(DFU_DETACH_TIMEOUT),     \
+    HIBYTE(DFU_DETACH_TIMEOUT), LOBYTE(DFU_XFER_SIZE), HIBYTE(DFU_XFER_SIZE),   \
+    0x10U, 0x01U)                                              /* Functional */
+#define COMP_DFU_ITFS(ITF) \
+  ITF(DFU, 0, 0xFEU, 0x01U, 0x02U, 0x00U, COMP_DFU_CS, COMP_DESC_NONE)
+#if (DFU_ENABLE == 1U)
+#define COMP_DFU_FUNC(FUNC, ITF)      FUNC(ITF, USBD_DFU, COMP_DFU_ITFS)
+#define COMP_DFU_HANDLE(H)            H(USBD_DFU_HandleTypeDef, 1U)
+#else
+#define COMP_DFU_FUNC(FUNC, ITF)
+#define COMP_DFU_HANDLE(H)
+#endif /* DFU_ENABLE */
+
+/**
+  * Functions of the configuration, in interface order. See Composite_desc.h.
+  * The HID class serves both the keyboard and the control interfaces
+  */
+#define USB_COMPOSITE_FUNCTIONS(FUNC, IAD, ITF)                                 \
+  FUNC(ITF, USBD_HID, COMP_KEYBOARD_ITFS)                                       \
+  IAD(ITF, USBD_CDC, CDC, 0x02U, 0x02U, 0x01U, 0x00U, COMP_CDC_ITFS)            \
+  FUNC(ITF, USBD_HID, COMP_CONTROL_ITFS)                                        \
+  COMP_POINTER_FUNC(FUNC, ITF)                                                  \
+  COMP_MSC_FUNC(FUNC, ITF)                                                      \
+  COMP_STREAM_FUNC(FUNC, ITF)                                                   \
+  COMP_AUDIO_FUNC(IAD, ITF)                                                     \
+  COMP_DFU_FUNC(FUNC, ITF)
+
+/**
+  * Handles of the functions and the CDC application buffers, taken from the
+  * arena of usbd_conf.c when the configuration is set and released together
+  * when it is cleared: type and count of each. The arena is sized from this
+  * list
+  */
+#define USB_COMPOSITE_HANDLES(H)                                                \
+  H(USBD_Composite_HandleTypeDef, 1U)                                           \
+  H(USBD_HID_HandleTypeDef, HID_NUM_INSTANCES)                                  \
+  H(USBD_CDC_HandleTypeDef, 1U)                                                 \
+  H(uint8_t, USBD_CDC_RX_DATA_SIZE)                                             \
+  H(uint8_t, USBD_CDC_TX_DATA_SIZE)                                             \
+  COMP_POINTER_HANDLE(H)                                                        \
+  COMP_MSC_HANDLE(H)                                                            \
+  COMP_STREAM_HANDLE(H)                                                         \
+  COMP_AUDIO_HANDLE(H)                                                          \
+  COMP_DFU_HANDLE(H)
+
+/* Interface numbers */
+enum
 {
-	void *hid;
-	void *cdc;
-}USBD_Composite_HandleTypeDef;
+  USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_ITFS, COMP_DESC_IAD_ENUM, COMP_DESC_ITF_ENUM)
+};
 
-typedef struct _USBD_Comp_Itf
+/* Function numbers */
+enum
 {
-	void *CDC_ops;
-	void *HID_ops;
-} USBD_Comp_ItfTypeDef;
+  USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_ID_ENUM, COMP_DESC_IAD_ID_ENUM, COMP_DESC_NONE)
+};
 
-extern USBD_ClassTypeDef USBD_COMP;
-#define USBD_COMP_CLASS    &USBD_COMP
-/********************CDC**************************/
-extern uint8_t  USBD_CDC_Init(USBD_HandleTypeDef *pdev,
-                              uint8_t cfgidx);
+/* Interface owners */
+enum
+{
+  USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_OWN_ENUM, COMP_DESC_IAD_OWN_ENUM, COMP_DESC_NONE)
+};
 
-extern uint8_t  USBD_CDC_DeInit(USBD_HandleTypeDef *pdev,
-                                uint8_t cfgidx);
+#define USB_COMPOSITE_NUM_FUNC                            COMP_DESC_NUM_FUNC
+#define USB_COMPOSITE_NUM_ITF                             COMP_DESC_NUM_ITF
+#define USB_COMPOSITE_NUM_EP                              COMP_DESC_NUM_EP
+#define USB_COMPOSITE_CONFIG_DESC_SIZ                     COMP_DESC_LENGTH
 
-extern uint8_t  USBD_CDC_Setup(USBD_HandleTypeDef *pdev,
-                               USBD_SetupReqTypedef *req);
+#if COMP_DESC_BAD_FUNCTION
+#error "FUNC takes a single interface, IAD two or more"
+#endif
 
-extern uint8_t  USBD_CDC_DataIn(USBD_HandleTypeDef *pdev,
-                                uint8_t epnum);
+#if !COMP_DESC_EP_UNIQUE || COMP_DESC_EP0_USED
+#error "Every function endpoint needs its own address, EP0 excluded"
+#endif
 
-extern uint8_t  USBD_CDC_DataOut(USBD_HandleTypeDef *pdev,
-                                 uint8_t epnum);
+/* The eight endpoint numbers are all taken, the stream OUT endpoint borrows
+ * the pointer's number 4 */
+#if (STREAM_ENABLE == 1U) && (STREAM_OUT_ENABLE == 1U) && (HID_POINTER_ENABLE == 1U)
+#error "STREAM_OUT_ENABLE 1 needs HID_POINTER_ENABLE 0, both use endpoint number 4"
+#elif COMP_DESC_ISO_SHARED
+#error "An isochronous endpoint needs an endpoint number of its own"
+#endif
 
-extern uint8_t  USBD_CDC_EP0_RxReady(USBD_HandleTypeDef *pdev);
+#if COMP_DESC_EP_ABOVE_7
+#error "The peripheral has 8 endpoint registers, endpoint numbers go up to 7"
+#endif
 
-extern uint8_t  *USBD_CDC_GetFSCfgDesc(uint16_t *length);
+/* Packet memory of the FS peripheral: the buffer table of its 8 endpoint
+ * registers at offset 0 (BTABLE_ADDRESS), the EP0 buffers, then the
+ * endpoint buffers in descriptor order, packed without gaps */
+#define USBD_PMA_SIZE                                     1024U
+#define USBD_PMA_BTABLE_SIZE                              (8U * 8U)
+#define USB_COMPOSITE_PMA_END \
+  (USBD_PMA_BTABLE_SIZE + (2U * USB_MAX_EP0_SIZE) + COMP_DESC_PMA_SIZE)
 
-extern uint8_t  *USBD_CDC_GetHSCfgDesc(uint16_t *length);
+#if (USB_COMPOSITE_PMA_END > USBD_PMA_SIZE)
+#error "The endpoint buffers overflow the 1 KB packet memory"
+#endif
 
-extern uint8_t  *USBD_CDC_GetOtherSpeedCfgDesc(uint16_t *length);
+/* The core rejects interface requests above USBD_MAX_NUM_INTERFACES */
+#if (USB_COMPOSITE_NUM_ITF > USBD_MAX_NUM_INTERFACES)
+#error "USBD_MAX_NUM_INTERFACES must cover every interface of the composite device"
+#endif
 
-extern uint8_t  *USBD_CDC_GetOtherSpeedCfgDesc(uint16_t *length);
+typedef struct
+{
+	void *hid[HID_NUM_INSTANCES];
+	void *cdc;
+	void *pointer;
+	void *msc;
+	void *stream;
+	void *audio;
+	void *dfu;
+}USBD_Composite_HandleTypeDef;
 
-//extern uint8_t  *USBD_CDC_GetDeviceQualifierDescriptor(uint16_t *length);
-/*********************************************************/
-/********************HID**********************************/
-extern uint8_t  USBD_HID_Init(USBD_HandleTypeDef *pdev,
-                              uint8_t cfgidx);
+typedef struct _USBD_Comp_Itf
+{
+	void *CDC_ops;
+	void *HID_ops;
+	void *MSC_ops;
+	void *STREAM_ops;
+	void *AUDIO_ops;
+	void *DFU_ops;
+} USBD_Comp_ItfTypeDef;
 
-extern uint8_t  USBD_HID_DeInit(USBD_HandleTypeDef *pdev,
-                                uint8_t cfgidx);
+/* One function of the composite device: its class callbacks and the
+ * interfaces it owns. Requests and transfers are routed to the owner, the
+ * table and the endpoint owners are generated from USB_COMPOSITE_FUNCTIONS */
+typedef struct
+{
+	USBD_ClassTypeDef *Class;
+	uint8_t FirstItf;
+	uint8_t NumItf;
+} USBD_Composite_FunctionTypeDef;
 
-extern uint8_t  USBD_HID_Setup(USBD_HandleTypeDef *pdev,
-                               USBD_SetupReqTypedef *req);
+/* Packet memory layout, offsets from offsetof. Members cannot overlap and
+ * USB_COMPOSITE_PMA_END is checked against the packet memory size */
+typedef struct
+{
+	uint8_t Btable[USBD_PMA_BTABLE_SIZE];
+	uint8_t Ep0Out[USB_MAX_EP0_SIZE];
+	uint8_t Ep0In[USB_MAX_EP0_SIZE];
+	COMP_DESC_PMA_MEMBERS
+} USBD_Composite_PmaTypeDef;
 
-extern uint8_t  *USBD_HID_GetFSCfgDesc(uint16_t *length);
+#define USB_COMPOSITE_PMA_EP0_OUT     ((uint16_t)offsetof(USBD_Composite_PmaTypeDef, Ep0Out))
+#define USB_COMPOSITE_PMA_EP0_IN      ((uint16_t)offsetof(USBD_Composite_PmaTypeDef, Ep0In))
 
-extern uint8_t  *USBD_HID_GetHSCfgDesc(uint16_t *length);
+/* Endpoint of the configuration, opened in this order */
+typedef struct
+{
+	uint8_t  Addr;
+	uint8_t  Type;     /* USBD_EP_TYPE_xxx */
+	uint16_t Size;
+	uint16_t Pma[2];   /* packet buffers, the second for isochronous endpoints only */
+} USBD_Composite_EpTypeDef;
 
-extern uint8_t  *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length);
+extern USBD_ClassTypeDef USBD_COMP;
+#define USBD_COMP_CLASS    &USBD_COMP
 
-extern uint8_t  *USBD_HID_GetDeviceQualifierDesc(uint16_t *length);
+extern const USBD_Composite_EpTypeDef USBD_Composite_Endpoints[USB_COMPOSITE_NUM_EP];
+extern const USBD_Composite_FunctionTypeDef USBD_Composite_Functions[USB_COMPOSITE_NUM_FUNC];
 
-extern uint8_t  USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
-/*********************************************************/
 uint8_t  USBD_Composite_RegisterInterface(USBD_HandleTypeDef   *pdev,
 									USBD_Comp_ItfTypeDef *fops);
 #endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_H_ */
@@ -0,0 +1,223 @@
+/*
+ * Composite_desc.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Configuration descriptor built from an X-macro list of functions, in the
+ *  way of usbd_hid_report.h. USB_COMPOSITE_FUNCTIONS(FUNC, IAD, ITF) lists
+ *  FUNC(ITF, driver, interfaces) for a single interface function and
+ *  IAD(ITF, driver, name, class, subclass, protocol, iFunction, interfaces)
+ *  for a function made of several interfaces, preceded by its interface
+ *  association descriptor. driver is the USBD_ClassTypeDef serving the
+ *  function, functions may share one. An interface list gives
+ *  ITF(name, alt, class, subclass, protocol, iInterface, cs, endpoints), cs
+ *  lists the class specific descriptors as D(bLength, bytes after bLength)
+ *  and the endpoint list gives EP(address, bmAttributes, wMaxPacketSize,
+ *  bInterval). An audio class endpoint takes three more arguments,
+ *  EP(address, bmAttributes, wMaxPacketSize, bInterval, bRefresh,
+ *  bSynchAddress, cs), for the 9 byte endpoint descriptor followed by its
+ *  class specific descriptors. alt is a plain digit, 0 to 3: the alternate
+ *  settings of an interface follow its setting 0 under the same name, and an
+ *  endpoint belongs to a single alternate setting.
+ *
+ *  Interfaces are numbered in list order as USBD_COMP_ITF_<name>, functions
+ *  as USBD_COMP_FUNC_<name>, a FUNC taking the name of its interface. The
+ *  same list expands to the descriptor bytes, to wTotalLength, to the number
+ *  of interfaces and endpoints, to the endpoint table used to open the
+ *  endpoints, to the packet memory layout and to the function, interface and
+ *  endpoint owner tables that route requests and transfers. Counts and lengths are plain
+ *  integer expressions usable in #if. Endpoint addresses are plain literals
+ *  such as 0x81U: they also name the packet memory buffers.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_DESC_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_DESC_H_
+
+#include  <stddef.h>
+#include  "usbd_def.h"
+
+#define COMP_DESC_TYPE_IAD            0x0BU
+
+#define COMP_DESC_ONE(...)            + 1U
+#define COMP_DESC_NONE(...)
+
+/* Keep the arguments for alternate setting 0 only */
+#define COMP_DESC_ALT0_0(...)         __VA_ARGS__
+#define COMP_DESC_ALT0_1(...)
+#define COMP_DESC_ALT0_2(...)
+#define COMP_DESC_ALT0_3(...)
+#define COMP_DESC_ITF_ONE(name, alt, ...) COMP_DESC_ALT0_##alt(+ 1U)
+
+/* std for a 7 byte endpoint, ext for the audio form: the extra arguments
+ * push ext into the place of std */
+#define COMP_DESC_EP_PICK_(refresh, synch, cs, pick, ...) pick
+#define COMP_DESC_EP_PICK(std, ext, ...) COMP_DESC_EP_PICK_(__VA_ARGS__, ext, ext, std)
+
+/* Walk every interface of the list, IADs left out */
+#define COMP_DESC_FUNC_ITFS(ITF, drv, itfs)                             itfs(ITF)
+#define COMP_DESC_IAD_ITFS(ITF, drv, name, cls, sub, proto, istr, itfs) itfs(ITF)
+#define COMP_DESC_FOR_ITF(ITF)        USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_ITFS, COMP_DESC_IAD_ITFS, ITF)
+
+/* Interface numbers, an IAD takes the number of its first interface */
+#define COMP_DESC_ITF_ENUM(name, alt, cls, sub, proto, istr, cs, eps) \
+  COMP_DESC_ALT0_##alt(USBD_COMP_ITF_##name,)
+#define COMP_DESC_IAD_ENUM(ITF, drv, name, cls, sub, proto, istr, itfs) \
+  USBD_COMP_IAD_##name, USBD_COMP_IAD_##name##_NEXT = USBD_COMP_IAD_##name - 1, itfs(ITF)
+
+/* Descriptor bytes */
+#define COMP_DESC_EP_STD_BYTES(addr, type, size, interval, ...) \
+  0x07U, USB_DESC_TYPE_ENDPOINT, (addr), (type), LOBYTE(size), HIBYTE(size), (interval),
+#define COMP_DESC_EP_EXT_BYTES(addr, type, size, interval, refresh, synch, cs) \
+  0x09U, USB_DESC_TYPE_ENDPOINT, (addr), (type), LOBYTE(size), HIBYTE(size), (interval), \
+  (refresh), (synch), cs(COMP_DESC_CS_BYTES)
+#define COMP_DESC_EP_BYTES(addr, type, size, interval, ...) \
+  COMP_DESC_EP_PICK(COMP_DESC_EP_STD_BYTES, COMP_DESC_EP_EXT_BYTES, __VA_ARGS__) \
+  (addr, type, size, interval, __VA_ARGS__)
+#define COMP_DESC_CS_BYTES(...)       __VA_ARGS__,
+#define COMP_DESC_ITF_BYTES(name, alt, cls, sub, proto, istr, cs, eps) \
+  0x09U, USB_DESC_TYPE_INTERFACE, USBD_COMP_ITF_##name, (alt),      \
+  (uint8_t)(0U eps(COMP_DESC_ONE)), (cls), (sub), (proto), (istr),  \
+  cs(COMP_DESC_CS_BYTES) eps(COMP_DESC_EP_BYTES)
+#define COMP_DESC_IAD_BYTES(ITF, drv, name, cls, sub, proto, istr, itfs) \
+  0x08U, COMP_DESC_TYPE_IAD, USBD_COMP_IAD_##name,                  \
+  (uint8_t)(0U itfs(COMP_DESC_ITF_ONE)), (cls), (sub), (proto), (istr), \
+  itfs(ITF)
+#define COMP_DESC_BYTES \
+  USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_ITFS, COMP_DESC_IAD_BYTES, COMP_DESC_ITF_BYTES)
+
+/* Lengths and counts */
+#define COMP_DESC_CS_LEN(len, ...)    + (len)
+#define COMP_DESC_EP_STD_LEN(...)     + 7U
+#define COMP_DESC_EP_EXT_LEN(addr, type, size, interval, refresh, synch, cs) \
+  + 9U cs(COMP_DESC_CS_LEN)
+#define COMP_DESC_EP_LEN(addr, type, size, interval, ...) \
+  COMP_DESC_EP_PICK(COMP_DESC_EP_STD_LEN, COMP_DESC_EP_EXT_LEN, __VA_ARGS__) \
+  (addr, type, size, interval, __VA_ARGS__)
+#define COMP_DESC_ITF_LEN(name, alt, cls, sub, proto, istr, cs, eps) \
+  + 9U cs(COMP_DESC_CS_LEN) eps(COMP_DESC_EP_LEN)
+#define COMP_DESC_IAD_LEN(...)        + 8U
+#define COMP_DESC_ITF_NUM_EP(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_ONE)
+
+#define COMP_DESC_LENGTH \
+  (9U USB_COMPOSITE_FUNCTIONS(COMP_DESC_NONE, COMP_DESC_IAD_LEN, COMP_DESC_NONE) \
+   COMP_DESC_FOR_ITF(COMP_DESC_ITF_LEN))
+#define COMP_DESC_NUM_ITF             (0U COMP_DESC_FOR_ITF(COMP_DESC_ITF_ONE))
+#define COMP_DESC_NUM_EP              (0U COMP_DESC_FOR_ITF(COMP_DESC_ITF_NUM_EP))
+
+/* FUNC takes a single interface, IAD two or more */
+#define COMP_DESC_FUNC_BAD(ITF, drv, itfs) || ((0U itfs(COMP_DESC_ITF_ONE)) != 1U)
+#define COMP_DESC_IAD_BAD(ITF, drv, name, cls, sub, proto, istr, itfs) || ((0U itfs(COMP_DESC_ITF_ONE)) < 2U)
+#define COMP_DESC_BAD_FUNCTION \
+  (0 USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_BAD, COMP_DESC_IAD_BAD, COMP_DESC_NONE))
+
+/* One bit per endpoint, OUT in the low half: endpoints are unique when the
+ * sum of their bits equals the or of their bits. EP0 is the core's */
+#define COMP_DESC_EP_BIT(addr)        (1UL << (((addr) & 0x0FU) + ((((addr) & 0x80U) != 0U) ? 16U : 0U)))
+#define COMP_DESC_EP_SUM(addr, ...)   + COMP_DESC_EP_BIT(addr)
+#define COMP_DESC_EP_OR(addr, ...)    | COMP_DESC_EP_BIT(addr)
+#define COMP_DESC_ITF_EP_SUM(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_EP_SUM)
+#define COMP_DESC_ITF_EP_OR(name, alt, cls, sub, proto, istr, cs, eps)  eps(COMP_DESC_EP_OR)
+#define COMP_DESC_EP_BITS             (0UL COMP_DESC_FOR_ITF(COMP_DESC_ITF_EP_OR))
+#define COMP_DESC_EP_UNIQUE \
+  ((0UL COMP_DESC_FOR_ITF(COMP_DESC_ITF_EP_SUM)) == COMP_DESC_EP_BITS)
+#define COMP_DESC_EP0_USED \
+  ((COMP_DESC_EP_BITS & (COMP_DESC_EP_BIT(0x00U) | COMP_DESC_EP_BIT(0x80U))) != 0UL)
+/* Endpoint numbers above 7 */
+#define COMP_DESC_EP_ABOVE_7          ((COMP_DESC_EP_BITS & 0xFF00FF00UL) != 0UL)
+
+/* An isochronous endpoint takes both packet buffers of its endpoint
+ * register, no other endpoint may share its number. Endpoints are counted
+ * per number, a nibble each, once all of them and once the isochronous
+ * ones only */
+#define COMP_DESC_EP_ISO(type)        (((type) & 0x03U) == USBD_EP_TYPE_ISOC)
+#define COMP_DESC_EP_NIB(addr)        (1ULL << (4U * ((addr) & 0x0FU)))
+#define COMP_DESC_EP_NIB_SUM(addr, ...) + COMP_DESC_EP_NIB(addr)
+#define COMP_DESC_EP_ISO_NIB_SUM(addr, type, ...) \
+  + (COMP_DESC_EP_ISO(type) ? COMP_DESC_EP_NIB(addr) : 0ULL)
+#define COMP_DESC_ITF_NIB_SUM(name, alt, cls, sub, proto, istr, cs, eps)     eps(COMP_DESC_EP_NIB_SUM)
+#define COMP_DESC_ITF_ISO_NIB_SUM(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_EP_ISO_NIB_SUM)
+#define COMP_DESC_EP_NIBS             (0ULL COMP_DESC_FOR_ITF(COMP_DESC_ITF_NIB_SUM))
+#define COMP_DESC_ISO_NIBS            (0ULL COMP_DESC_FOR_ITF(COMP_DESC_ITF_ISO_NIB_SUM))
+#define COMP_DESC_ISO_SHARED_AT(num) \
+  ((((COMP_DESC_ISO_NIBS >> (4U * (num))) & 0xFULL) != 0ULL) && \
+   (((COMP_DESC_EP_NIBS >> (4U * (num))) & 0xFULL) != 1ULL))
+#define COMP_DESC_ISO_SHARED \
+  (COMP_DESC_ISO_SHARED_AT(1) || COMP_DESC_ISO_SHARED_AT(2) || COMP_DESC_ISO_SHARED_AT(3) || \
+   COMP_DESC_ISO_SHARED_AT(4) || COMP_DESC_ISO_SHARED_AT(5) || COMP_DESC_ISO_SHARED_AT(6) || \
+   COMP_DESC_ISO_SHARED_AT(7))
+
+/* Packet memory of an endpoint: a buffer of its packet size rounded to a
+ * halfword, or to 32 bytes for an OUT endpoint above 62 bytes, the unit its
+ * receive counter then counts in. An isochronous endpoint takes two */
+#define COMP_DESC_PMA_BUF(addr, size) \
+  (((((addr) & 0x80U) == 0U) && ((size) > 62U)) ? (((size) + 31U) & ~31U) : (((size) + 1U) & ~1U))
+#define COMP_DESC_PMA_LEN(addr, type, size) \
+  ((COMP_DESC_EP_ISO(type) ? 2U : 1U) * COMP_DESC_PMA_BUF(addr, size))
+#define COMP_DESC_EP_PMA_SUM(addr, type, size, ...) + COMP_DESC_PMA_LEN(addr, type, size)
+#define COMP_DESC_ITF_PMA_SUM(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_EP_PMA_SUM)
+#define COMP_DESC_PMA_SIZE            (0U COMP_DESC_FOR_ITF(COMP_DESC_ITF_PMA_SUM))
+
+/* Members of USBD_Composite_PmaTypeDef, one per endpoint, Ep_<address> */
+#define COMP_DESC_CAT_(a, b)          a##b
+#define COMP_DESC_CAT(a, b)           COMP_DESC_CAT_(a, b)
+#define COMP_DESC_PMA_NAME(addr)      COMP_DESC_CAT(Ep_, addr)
+#define COMP_DESC_EP_PMA_MEMBER(addr, type, size, ...) \
+  uint8_t COMP_DESC_PMA_NAME(addr)[COMP_DESC_PMA_LEN(addr, type, size)];
+#define COMP_DESC_ITF_PMA_MEMBERS(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_EP_PMA_MEMBER)
+#define COMP_DESC_PMA_MEMBERS         COMP_DESC_FOR_ITF(COMP_DESC_ITF_PMA_MEMBERS)
+#define COMP_DESC_PMA_AT(addr)        ((uint16_t)offsetof(USBD_Composite_PmaTypeDef, COMP_DESC_PMA_NAME(addr)))
+
+/* Endpoint table entries, in descriptor order. The type leaves out the
+ * synchronisation and usage bits of an isochronous endpoint */
+#define COMP_DESC_EP_ENTRY(addr, type, size, interval, ...)                  \
+  { (addr), (type) & 0x03U, (size),                                           \
+    { COMP_DESC_PMA_AT(addr),                                                 \
+      COMP_DESC_EP_ISO(type) ? (uint16_t)(COMP_DESC_PMA_AT(addr) + COMP_DESC_PMA_BUF(addr, size)) : 0U } },
+#define COMP_DESC_ITF_EP_TABLE(name, alt, cls, sub, proto, istr, cs, eps) eps(COMP_DESC_EP_ENTRY)
+#define COMP_DESC_EP_TABLE            COMP_DESC_FOR_ITF(COMP_DESC_ITF_EP_TABLE)
+
+/* Function numbers, in list order */
+#define COMP_DESC_ITF_FUNC_ID(name, alt, ...) COMP_DESC_ALT0_##alt(USBD_COMP_FUNC_##name)
+#define COMP_DESC_FUNC_ID_ENUM(ITF, drv, itfs) itfs(COMP_DESC_ITF_FUNC_ID),
+#define COMP_DESC_IAD_ID_ENUM(ITF, drv, name, cls, sub, proto, istr, itfs) USBD_COMP_FUNC_##name,
+#define COMP_DESC_NUM_FUNC \
+  (0U USB_COMPOSITE_FUNCTIONS(COMP_DESC_ONE, COMP_DESC_ONE, COMP_DESC_NONE))
+
+/* Function table entries: driver and interface range */
+#define COMP_DESC_ITF_FIRST(name, alt, ...) COMP_DESC_ALT0_##alt(USBD_COMP_ITF_##name)
+#define COMP_DESC_FUNC_ENTRY(ITF, drv, itfs) \
+  { &(drv), itfs(COMP_DESC_ITF_FIRST), 1U },
+#define COMP_DESC_IAD_ENTRY(ITF, drv, name, cls, sub, proto, istr, itfs) \
+  { &(drv), USBD_COMP_IAD_##name, (uint8_t)(0U itfs(COMP_DESC_ITF_ONE)) },
+#define COMP_DESC_FUNC_TABLE \
+  USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_ENTRY, COMP_DESC_IAD_ENTRY, COMP_DESC_NONE)
+
+/* Owner of an interface, its function number plus one. The enumerators
+ * USBD_COMP_OWN_<interface> carry it: an IAD sets it once and each of its
+ * interfaces takes the previous value again, as USBD_COMP_IAD_<name>_NEXT */
+#define COMP_DESC_ITF_OWN_FUNC(name, alt, ...) \
+  COMP_DESC_ALT0_##alt(USBD_COMP_OWN_##name = USBD_COMP_FUNC_##name + 1,)
+#define COMP_DESC_ITF_OWN_SAME(name, alt, ...) \
+  COMP_DESC_ALT0_##alt(USBD_COMP_OWN_##name##_NEXT, USBD_COMP_OWN_##name = USBD_COMP_OWN_##name##_NEXT - 1,)
+#define COMP_DESC_FUNC_OWN_ENUM(ITF, drv, itfs) itfs(COMP_DESC_ITF_OWN_FUNC)
+#define COMP_DESC_IAD_OWN_ENUM(ITF, drv, name, cls, sub, proto, istr, itfs) \
+  USBD_COMP_OWN_IAD_##name = USBD_COMP_FUNC_##name + 1, itfs(COMP_DESC_ITF_OWN_SAME)
+/* Owners of the interfaces, one entry per interface in number order */
+#define COMP_DESC_ITF_OWNER(name, alt, ...) COMP_DESC_ALT0_##alt((uint8_t)USBD_COMP_OWN_##name,)
+#define COMP_DESC_ITF_OWNERS          { COMP_DESC_FOR_ITF(COMP_DESC_ITF_OWNER) }
+
+/* Owner of an endpoint, its function number plus one, 0 when no function
+ * uses it. The endpoint bit is passed down in place of ITF */
+#define COMP_DESC_FUNC_EP_OWNER(bit, drv, itfs) \
+  + ((((0UL itfs(COMP_DESC_ITF_EP_OR)) & (bit)) != 0UL) ? (itfs(COMP_DESC_ITF_FUNC_ID) + 1U) : 0U)
+#define COMP_DESC_IAD_EP_OWNER(bit, drv, name, cls, sub, proto, istr, itfs) \
+  + ((((0UL itfs(COMP_DESC_ITF_EP_OR)) & (bit)) != 0UL) ? (USBD_COMP_FUNC_##name + 1U) : 0U)
+#define COMP_DESC_EP_OWNER(addr) \
+  (uint8_t)(0U USB_COMPOSITE_FUNCTIONS(COMP_DESC_FUNC_EP_OWNER, COMP_DESC_IAD_EP_OWNER, COMP_DESC_EP_BIT(addr)))
+/* Owners of endpoints 0 to 7 of a direction, 0x00U or 0x80U */
+#define COMP_DESC_EP_OWNERS(dir)                                               \
+  { COMP_DESC_EP_OWNER((dir) | 0U), COMP_DESC_EP_OWNER((dir) | 1U),            \
+    COMP_DESC_EP_OWNER((dir) | 2U), COMP_DESC_EP_OWNER((dir) | 3U),            \
+    COMP_DESC_EP_OWNER((dir) | 4U), COMP_DESC_EP_OWNER((dir) | 5U),            \
+    COMP_DESC_EP_OWNER((dir) | 6U), COMP_DESC_EP_OWNER((dir) | 7U) }
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_COMPOSITE_INC_COMPOSITE_DESC_H_ */
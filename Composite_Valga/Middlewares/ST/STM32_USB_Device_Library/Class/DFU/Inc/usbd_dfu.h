@@ -0,0 +1,147 @@
+/*
+ * usbd_dfu.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Device Firmware Upgrade 1.1 function, DFU mode interface on the control
+ *  endpoint only. A download is received into two transfer buffers in turn:
+ *  while one is programmed from the main loop (USBD_DFU_Process) the host
+ *  sends the next block into the other, and the pages are erased ahead of
+ *  the write pointer. The image goes to a USBD_DFU_MediaTypeDef registered
+ *  by the application (usbd_dfu_if.c), which addresses it by offset and
+ *  marks it complete only once every block is programmed and verified.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_DFU_INC_USBD_DFU_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_DFU_INC_USBD_DFU_H_
+
+#include  "usbd_ioreq.h"
+
+/* 0 removes the firmware upgrade interface from the composite device */
+#ifndef DFU_ENABLE
+#define DFU_ENABLE                    1U
+#endif /* DFU_ENABLE */
+
+/* Bytes of one DNLOAD or UPLOAD block, a multiple of DFU_ROW_SIZE. Each of
+ * the two transfer buffers holds one */
+#ifndef DFU_XFER_SIZE
+#define DFU_XFER_SIZE                 1024U
+#endif /* DFU_XFER_SIZE */
+
+/* Erase and fast programming units of the media, and the largest image */
+#define DFU_PAGE_SIZE                 0x1000U
+#define DFU_ROW_SIZE                  0x200U
+#ifndef DFU_IMAGE_MAX_SIZE
+#define DFU_IMAGE_MAX_SIZE            0x40000U
+#endif /* DFU_IMAGE_MAX_SIZE */
+
+/* Pages erased ahead of the block being programmed, while the host is
+ * between blocks */
+#define DFU_ERASE_AHEAD               2U
+
+/* bwPollTimeout while both buffers wait for the flash, and while the image
+ * is marked complete, in ms */
+#define DFU_BUSY_POLL_MS              5U
+#define DFU_MANIFEST_POLL_MS          10U
+
+#if ((DFU_XFER_SIZE % DFU_ROW_SIZE) != 0U) || ((DFU_IMAGE_MAX_SIZE % DFU_PAGE_SIZE) != 0U)
+#error "DFU blocks are whole rows, the image area whole pages"
+#endif
+
+/* Requests */
+#define DFU_DETACH                    0x00U
+#define DFU_DNLOAD                    0x01U
+#define DFU_UPLOAD                    0x02U
+#define DFU_GETSTATUS                 0x03U
+#define DFU_CLRSTATUS                 0x04U
+#define DFU_GETSTATE                  0x05U
+#define DFU_ABORT                     0x06U
+
+/* bState */
+#define DFU_STATE_IDLE                0x02U
+#define DFU_STATE_DNLOAD_SYNC         0x03U
+#define DFU_STATE_DNLOAD_BUSY         0x04U
+#define DFU_STATE_DNLOAD_IDLE         0x05U
+#define DFU_STATE_MANIFEST_SYNC       0x06U
+#define DFU_STATE_MANIFEST            0x07U
+#define DFU_STATE_UPLOAD_IDLE         0x09U
+#define DFU_STATE_ERROR               0x0AU
+
+/* bStatus */
+#define DFU_ERROR_NONE                0x00U
+#define DFU_ERROR_WRITE               0x03U
+#define DFU_ERROR_ERASE               0x04U
+#define DFU_ERROR_VERIFY              0x07U
+#define DFU_ERROR_ADDRESS             0x08U
+#define DFU_ERROR_NOTDONE             0x09U
+#define DFU_ERROR_STALLEDPKT          0x0FU
+
+/* bmAttributes: download, upload, back to dfuIDLE after manifestation */
+#define DFU_ATTRIBUTES                0x07U
+#define DFU_DETACH_TIMEOUT            0x00FFU
+#define DFU_FUNC_DESC_TYPE            0x21U
+
+typedef struct
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  /* Drop the complete mark of the stored image, before its first page is
+   * erased */
+  int8_t (* Invalidate)(void);
+  /* Erase the page at offset */
+  int8_t (* Erase)(uint32_t offset);
+  /* Program len bytes, whole rows, to erased pages at offset */
+  int8_t (* Write)(const uint8_t *src, uint32_t offset, uint32_t len);
+  int8_t (* Read)(uint8_t *dest, uint32_t offset, uint32_t len);
+  /* Mark the image of len bytes and CRC-32 crc complete */
+  int8_t (* Commit)(uint32_t len, uint32_t crc);
+  /* Length of the complete image, 0 when there is none */
+  uint32_t (* GetLength)(void);
+}
+USBD_DFU_MediaTypeDef;
+
+typedef struct
+{
+  uint32_t             ImageSize;    /* bytes of the last image completed */
+  uint32_t             UpdateMs;     /* first block to complete mark */
+  uint32_t             BusyPolls;    /* GETSTATUS answered dfuDNBUSY */
+}
+USBD_DFU_StatsTypeDef;
+
+typedef struct
+{
+  /* Written from the USB interrupt */
+  uint8_t              State;
+  uint8_t              Status;
+  uint8_t              RxBuf;        /* buffer of the next DNLOAD */
+  uint16_t             RxLen;        /* DNLOAD data stage in progress */
+  uint8_t              StatusBuf[6];
+  uint32_t             RxOffset;     /* image bytes received */
+  uint32_t             UploadOffset;
+  volatile uint8_t     Session;      /* started downloads */
+  volatile uint8_t     Manifest;     /* 1 requested, 2 done */
+  volatile uint32_t    ImageLen;     /* bytes to mark complete */
+  /* Written from the USB interrupt when received, cleared from the main
+   * loop when programmed: a buffer is free while its length is 0 */
+  volatile uint16_t    Len[2];
+  uint32_t             Offset[2];
+  /* Written from the main loop */
+  volatile uint8_t     Error;        /* bStatus for the next GETSTATUS */
+  uint8_t              ProgSession;
+  uint8_t              ProgBuf;      /* next buffer to program */
+  uint8_t              Active;       /* 0 drops the blocks left of the download */
+  uint32_t             EraseOffset;  /* first page not erased */
+  uint32_t             WriteOffset;  /* end of the rows programmed */
+  uint32_t             Crc;
+  uint32_t             StartTick;
+  USBD_DFU_StatsTypeDef Stats;
+  uint32_t             Buf[2][DFU_XFER_SIZE / 4U]; /* On 32-bit boundary */
+}
+USBD_DFU_HandleTypeDef;
+
+extern USBD_ClassTypeDef  USBD_DFU;
+
+uint8_t  USBD_DFU_RegisterMedia(void *Comp_iops, USBD_DFU_MediaTypeDef *fops);
+void     USBD_DFU_Process(USBD_HandleTypeDef *pdev);
+uint8_t  USBD_DFU_GetStats(USBD_HandleTypeDef *pdev, USBD_DFU_StatsTypeDef *stats);
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_DFU_INC_USBD_DFU_H_ */
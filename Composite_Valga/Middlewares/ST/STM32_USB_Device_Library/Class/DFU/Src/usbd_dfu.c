@@ -0,0 +1,662 @@
+/*
+ * usbd_dfu.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  The USB interrupt only moves blocks: a DNLOAD lands in the free transfer
+ *  buffer and GETSTATUS answers dfuDNLOAD-IDLE at once as long as the other
+ *  buffer is free, so the host sends the next block while the previous one
+ *  is programmed. USBD_DFU_Process, from the main loop, programs the oldest
+ *  full buffer, verifies it and frees it, and between blocks erases the
+ *  pages ahead of the write pointer. Each buffer has one writer at a time:
+ *  its length is set by the interrupt and cleared by the main loop.
+ */
+
+#include "../Inc/usbd_dfu.h"
+#include "usbd_ctlreq.h"
+#include "../../Composite/Inc/Composite.h"
+
+/* The interface number exists with the function only */
+#if (DFU_ENABLE == 1U)
+
+uint8_t USBD_DFU_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_DFU_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_DFU_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_DFU_EP0_RxReady(USBD_HandleTypeDef *pdev);
+
+static uint8_t DFU_Download(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req);
+static uint8_t DFU_Upload(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req);
+static void DFU_GetStatus(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu);
+static uint8_t DFU_Stall(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req, uint8_t status);
+static void DFU_Program(USBD_DFU_MediaTypeDef *media, USBD_DFU_HandleTypeDef *hdfu, uint8_t i);
+static uint32_t DFU_Crc32(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+/* Callbacks of the firmware upgrade function, dispatched by the composite router */
+USBD_ClassTypeDef  USBD_DFU =
+{
+  USBD_DFU_Init,
+  USBD_DFU_DeInit,
+  USBD_DFU_Setup,
+  NULL, /*EP0_TxSent*/
+  USBD_DFU_EP0_RxReady,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static USBD_DFU_MediaTypeDef *DFU_Media(USBD_HandleTypeDef *pdev)
+{
+  return (USBD_DFU_MediaTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->DFU_ops;
+}
+
+static USBD_DFU_HandleTypeDef *DFU_Handle(USBD_HandleTypeDef *pdev)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  return (compHandle != NULL) ? (USBD_DFU_HandleTypeDef *)compHandle->dfu : NULL;
+}
+
+/**
+  * @brief  USBD_DFU_Init
+  *         Initialize the firmware upgrade interface, in dfuIDLE
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_DFU_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+
+  /* No endpoint, the requests come on the control pipe */
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  compHandle->dfu = USBD_malloc_Type(USBD_DFU_HandleTypeDef, 1U);
+
+  if (compHandle->dfu == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  (void)memset(compHandle->dfu, 0, sizeof(USBD_DFU_HandleTypeDef));
+  ((USBD_DFU_HandleTypeDef *)compHandle->dfu)->State = DFU_STATE_IDLE;
+  (void)DFU_Media(pdev)->Init();
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_DFU_DeInit
+  *         DeInitialize the firmware upgrade interface. A download left
+  *         unfinished is never marked complete
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_DFU_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  if (compHandle->dfu != NULL)
+  {
+    (void)DFU_Media(pdev)->DeInit();
+    USBD_free(compHandle->dfu);
+    compHandle->dfu = NULL;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_DFU_Setup
+  *         Handle the DFU class requests and the standard interface requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+uint8_t USBD_DFU_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_DFU_HandleTypeDef *hdfu = DFU_Handle(pdev);
+  uint16_t status_info = 0U;
+  uint8_t ret = USBD_OK;
+
+  if (hdfu == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS :
+      switch (req->bRequest)
+      {
+        case DFU_DNLOAD:
+          ret = DFU_Download(pdev, hdfu, req);
+          break;
+
+        case DFU_UPLOAD:
+          ret = DFU_Upload(pdev, hdfu, req);
+          break;
+
+        case DFU_GETSTATUS:
+          DFU_GetStatus(pdev, hdfu);
+          break;
+
+        case DFU_CLRSTATUS:
+          if (hdfu->State != DFU_STATE_ERROR)
+          {
+            ret = DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+            break;
+          }
+          hdfu->State = DFU_STATE_IDLE;
+          hdfu->Status = DFU_ERROR_NONE;
+          break;
+
+        case DFU_GETSTATE:
+          USBD_CtlSendData(pdev, &hdfu->State, 1U);
+          break;
+
+        case DFU_ABORT:
+          /* Blocks already received are still programmed, the image is
+           * not marked complete */
+          if ((hdfu->State == DFU_STATE_DNLOAD_BUSY) || (hdfu->State == DFU_STATE_MANIFEST) ||
+              (hdfu->State == DFU_STATE_ERROR))
+          {
+            ret = DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+            break;
+          }
+          hdfu->State = DFU_STATE_IDLE;
+          break;
+
+        default:
+          /* DFU_DETACH: the interface is in DFU mode already */
+          ret = DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE :
+          if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (req->wValue != 0U))
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_DFU_EP0_RxReady
+  *         Data stage of DNLOAD: the buffer is full, hand it to the main loop
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_DFU_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  USBD_DFU_HandleTypeDef *hdfu = DFU_Handle(pdev);
+
+  if ((hdfu == NULL) || (hdfu->RxLen == 0U))
+  {
+    return USBD_OK;
+  }
+
+  hdfu->Offset[hdfu->RxBuf] = hdfu->RxOffset;
+  hdfu->RxOffset += hdfu->RxLen;
+  hdfu->Len[hdfu->RxBuf] = hdfu->RxLen;
+  hdfu->RxBuf ^= 1U;
+  hdfu->RxLen = 0U;
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  DFU_Download
+  *         DNLOAD: receive the next block into the free buffer, an empty one
+  *         ends the download
+  * @param  pdev: device instance
+  * @param  hdfu: DFU handle
+  * @param  req: DNLOAD request
+  * @retval status
+  */
+static uint8_t DFU_Download(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req)
+{
+  if (req->wLength == 0U)
+  {
+    if ((hdfu->State != DFU_STATE_DNLOAD_IDLE) || (hdfu->RxOffset == 0U))
+    {
+      return DFU_Stall(pdev, hdfu, req, DFU_ERROR_NOTDONE);
+    }
+    hdfu->ImageLen = hdfu->RxOffset;
+    hdfu->Manifest = 1U;
+    hdfu->State = DFU_STATE_MANIFEST_SYNC;
+    return USBD_OK;
+  }
+
+  if (hdfu->State == DFU_STATE_IDLE)
+  {
+    /* The main loop is done with the last download before a new one. The
+     * session count is set before any buffer is filled */
+    if ((hdfu->Len[0] != 0U) || (hdfu->Len[1] != 0U) || (hdfu->Manifest == 1U))
+    {
+      return DFU_Stall(pdev, hdfu, req, DFU_ERROR_NOTDONE);
+    }
+    hdfu->Session++;
+    hdfu->Manifest = 0U;
+    hdfu->RxBuf = 0U;
+    hdfu->RxOffset = 0U;
+  }
+  else if (hdfu->State != DFU_STATE_DNLOAD_IDLE)
+  {
+    return DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+  }
+
+  /* Only the last block may be short, the others keep the rows aligned */
+  if ((req->wLength > DFU_XFER_SIZE) || ((hdfu->RxOffset % DFU_ROW_SIZE) != 0U) ||
+      ((hdfu->RxOffset + req->wLength) > DFU_IMAGE_MAX_SIZE))
+  {
+    return DFU_Stall(pdev, hdfu, req, DFU_ERROR_ADDRESS);
+  }
+
+  /* GETSTATUS reported the buffer free */
+  if (hdfu->Len[hdfu->RxBuf] != 0U)
+  {
+    return DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+  }
+
+  hdfu->RxLen = req->wLength;
+  hdfu->State = DFU_STATE_DNLOAD_SYNC;
+  USBD_CtlPrepareRx(pdev, (uint8_t *)hdfu->Buf[hdfu->RxBuf], req->wLength);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  DFU_Upload
+  *         UPLOAD: next block of the complete image, a short one ends it
+  * @param  pdev: device instance
+  * @param  hdfu: DFU handle
+  * @param  req: UPLOAD request
+  * @retval status
+  */
+static uint8_t DFU_Upload(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req)
+{
+  uint32_t avail;
+  uint16_t len;
+
+  if (hdfu->State == DFU_STATE_IDLE)
+  {
+    /* The buffers are the main loop's until the last download is done */
+    if ((hdfu->Len[0] != 0U) || (hdfu->Len[1] != 0U) || (hdfu->Manifest == 1U))
+    {
+      return DFU_Stall(pdev, hdfu, req, DFU_ERROR_NOTDONE);
+    }
+    hdfu->UploadOffset = 0U;
+    hdfu->State = DFU_STATE_UPLOAD_IDLE;
+  }
+  else if (hdfu->State != DFU_STATE_UPLOAD_IDLE)
+  {
+    return DFU_Stall(pdev, hdfu, req, DFU_ERROR_STALLEDPKT);
+  }
+
+  len = MIN(req->wLength, DFU_XFER_SIZE);
+  avail = DFU_Media(pdev)->GetLength() - hdfu->UploadOffset;
+  if (len > avail)
+  {
+    len = (uint16_t)avail;
+  }
+
+  if ((len != 0U) &&
+      (DFU_Media(pdev)->Read((uint8_t *)hdfu->Buf[0], hdfu->UploadOffset, len) != USBD_OK))
+  {
+    return DFU_Stall(pdev, hdfu, req, DFU_ERROR_ADDRESS);
+  }
+
+  hdfu->UploadOffset += len;
+  if (len < req->wLength)
+  {
+    hdfu->State = DFU_STATE_IDLE;
+  }
+  USBD_CtlSendData(pdev, (uint8_t *)hdfu->Buf[0], len);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  DFU_GetStatus
+  *         GETSTATUS: the download goes on at once while a buffer is free,
+  *         the host polls again when both wait for the flash
+  * @param  pdev: device instance
+  * @param  hdfu: DFU handle
+  * @retval None
+  */
+static void DFU_GetStatus(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu)
+{
+  uint32_t poll = 0U;
+
+  if (hdfu->Error != DFU_ERROR_NONE)
+  {
+    hdfu->State = DFU_STATE_ERROR;
+    hdfu->Status = hdfu->Error;
+    hdfu->Error = DFU_ERROR_NONE;
+  }
+
+  switch (hdfu->State)
+  {
+    case DFU_STATE_DNLOAD_SYNC:
+    case DFU_STATE_DNLOAD_BUSY:
+      if (hdfu->Len[hdfu->RxBuf] == 0U)
+      {
+        hdfu->State = DFU_STATE_DNLOAD_IDLE;
+      }
+      else
+      {
+        hdfu->State = DFU_STATE_DNLOAD_BUSY;
+        hdfu->Stats.BusyPolls++;
+        poll = DFU_BUSY_POLL_MS;
+      }
+      break;
+
+    case DFU_STATE_MANIFEST_SYNC:
+    case DFU_STATE_MANIFEST:
+      /* Manifestation tolerant: back to dfuIDLE once the image is marked */
+      if (hdfu->Manifest == 2U)
+      {
+        hdfu->State = DFU_STATE_IDLE;
+      }
+      else
+      {
+        hdfu->State = DFU_STATE_MANIFEST;
+        poll = DFU_MANIFEST_POLL_MS;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  hdfu->StatusBuf[0] = hdfu->Status;
+  hdfu->StatusBuf[1] = (uint8_t)poll;
+  hdfu->StatusBuf[2] = (uint8_t)(poll >> 8);
+  hdfu->StatusBuf[3] = (uint8_t)(poll >> 16);
+  hdfu->StatusBuf[4] = hdfu->State;
+  hdfu->StatusBuf[5] = 0U;
+  USBD_CtlSendData(pdev, hdfu->StatusBuf, 6U);
+}
+
+/**
+  * @brief  DFU_Stall
+  *         Request not valid in this state: stall it and enter dfuERROR
+  * @param  pdev: device instance
+  * @param  hdfu: DFU handle
+  * @param  req: request
+  * @param  status: bStatus reported
+  * @retval USBD_FAIL
+  */
+static uint8_t DFU_Stall(USBD_HandleTypeDef *pdev, USBD_DFU_HandleTypeDef *hdfu, USBD_SetupReqTypedef *req, uint8_t status)
+{
+  USBD_CtlError(pdev, req);
+  hdfu->State = DFU_STATE_ERROR;
+  hdfu->Status = status;
+
+  return USBD_FAIL;
+}
+
+/**
+  * @brief  USBD_DFU_Process
+  *         Program the oldest block received, or erase a page ahead, or
+  *         mark the image complete. Call from the main loop: the flash
+  *         stalls every fetch while it programs or erases
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_DFU_Process(USBD_HandleTypeDef *pdev)
+{
+  USBD_DFU_HandleTypeDef *hdfu = DFU_Handle(pdev);
+  USBD_DFU_MediaTypeDef *media;
+  uint8_t i;
+
+  if (hdfu == NULL)
+  {
+    return;
+  }
+
+  media = DFU_Media(pdev);
+
+  /* The lengths are read before the session: a download starts with both
+   * buffers free, a block seen is never taken for one of the previous one */
+  if (((hdfu->Len[0] != 0U) || (hdfu->Len[1] != 0U)) &&
+      (hdfu->ProgSession != hdfu->Session))
+  {
+    /* A new download: the stored image is no longer complete before any
+     * of its pages is erased */
+    hdfu->ProgSession = hdfu->Session;
+    hdfu->ProgBuf = 0U;
+    hdfu->EraseOffset = 0U;
+    hdfu->WriteOffset = 0U;
+    hdfu->Crc = 0xFFFFFFFFU;
+    hdfu->StartTick = HAL_GetTick();
+    hdfu->Active = 1U;
+    if (media->Invalidate() != USBD_OK)
+    {
+      hdfu->Active = 0U;
+      hdfu->Error = DFU_ERROR_ERASE;
+    }
+    return;
+  }
+
+  /* Blocks are programmed in the order received */
+  i = hdfu->ProgBuf;
+  if (hdfu->Len[i] != 0U)
+  {
+    if (hdfu->Active != 0U)
+    {
+      DFU_Program(media, hdfu, i);
+    }
+    hdfu->Len[i] = 0U;
+    hdfu->ProgBuf = i ^ 1U;
+    return;
+  }
+
+  if (hdfu->Manifest == 1U)
+  {
+    /* Every block is programmed and verified */
+    if (hdfu->Active != 0U)
+    {
+      if (media->Commit(hdfu->ImageLen, ~hdfu->Crc) == USBD_OK)
+      {
+        hdfu->Stats.ImageSize = hdfu->ImageLen;
+        hdfu->Stats.UpdateMs = HAL_GetTick() - hdfu->StartTick;
+      }
+      else
+      {
+        hdfu->Error = DFU_ERROR_WRITE;
+      }
+      hdfu->Active = 0U;
+    }
+    hdfu->Manifest = 2U;
+    return;
+  }
+
+  /* Between blocks: erase ahead of the write pointer */
+  if ((hdfu->Active != 0U) && (hdfu->EraseOffset < DFU_IMAGE_MAX_SIZE) &&
+      (hdfu->EraseOffset < (hdfu->WriteOffset + (DFU_ERASE_AHEAD * DFU_PAGE_SIZE))))
+  {
+    if (media->Erase(hdfu->EraseOffset) != USBD_OK)
+    {
+      hdfu->Active = 0U;
+      hdfu->Error = DFU_ERROR_ERASE;
+      return;
+    }
+    hdfu->EraseOffset += DFU_PAGE_SIZE;
+  }
+}
+
+/**
+  * @brief  DFU_Program
+  *         Erase up to the end of the block if not done ahead, program it in
+  *         whole rows, the tail of the last one left erased, and verify it
+  * @param  media: DFU media
+  * @param  hdfu: DFU handle
+  * @param  i: buffer to program
+  * @retval None
+  */
+static void DFU_Program(USBD_DFU_MediaTypeDef *media, USBD_DFU_HandleTypeDef *hdfu, uint8_t i)
+{
+  uint8_t *buf = (uint8_t *)hdfu->Buf[i];
+  uint8_t check[64];
+  uint32_t offset = hdfu->Offset[i];
+  uint32_t len = hdfu->Len[i];
+  uint32_t rows = (len + DFU_ROW_SIZE - 1U) & ~(DFU_ROW_SIZE - 1U);
+  uint32_t n;
+
+  while (hdfu->EraseOffset < (offset + rows))
+  {
+    if (media->Erase(hdfu->EraseOffset) != USBD_OK)
+    {
+      hdfu->Active = 0U;
+      hdfu->Error = DFU_ERROR_ERASE;
+      return;
+    }
+    hdfu->EraseOffset += DFU_PAGE_SIZE;
+  }
+
+  (void)memset(&buf[len], 0xFF, rows - len);
+  if (media->Write(buf, offset, rows) != USBD_OK)
+  {
+    hdfu->Active = 0U;
+    hdfu->Error = DFU_ERROR_WRITE;
+    return;
+  }
+
+  for (n = 0U; n < len; n += sizeof(check))
+  {
+    if ((media->Read(check, offset + n, MIN(sizeof(check), len - n)) != USBD_OK) ||
+        (memcmp(check, &buf[n], MIN(sizeof(check), len - n)) != 0))
+    {
+      hdfu->Active = 0U;
+      hdfu->Error = DFU_ERROR_VERIFY;
+      return;
+    }
+  }
+
+  hdfu->Crc = DFU_Crc32(hdfu->Crc, buf, len);
+  hdfu->WriteOffset = offset + rows;
+}
+
+/**
+  * @brief  DFU_Crc32
+  *         CRC-32 (IEEE 802.3, reflected), a nibble at a time
+  * @param  crc: running value, 0xFFFFFFFF to start
+  * @param  buf: data
+  * @param  len: data length
+  * @retval running value, inverted at the end
+  */
+static uint32_t DFU_Crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+  static const uint32_t table[16] =
+  {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+    0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+    0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+  };
+
+  while (len-- != 0U)
+  {
+    crc ^= *buf++;
+    crc = (crc >> 4) ^ table[crc & 0x0FU];
+    crc = (crc >> 4) ^ table[crc & 0x0FU];
+  }
+
+  return crc;
+}
+
+/**
+  * @brief  USBD_DFU_GetStats
+  *         Copy the statistics of the last download
+  * @param  pdev: device instance
+  * @param  stats: destination
+  * @retval status, USBD_FAIL when the device is not configured
+  */
+uint8_t USBD_DFU_GetStats(USBD_HandleTypeDef *pdev, USBD_DFU_StatsTypeDef *stats)
+{
+  USBD_DFU_HandleTypeDef *hdfu = DFU_Handle(pdev);
+
+  if (hdfu == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  *stats = hdfu->Stats;
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_DFU_RegisterMedia
+  * @param  Comp_iops: composite interface table
+  * @param  fops: DFU media callbacks
+  * @retval status
+  */
+uint8_t USBD_DFU_RegisterMedia(void *Comp_iops, USBD_DFU_MediaTypeDef *fops)
+{
+  uint8_t ret = USBD_FAIL;
+
+  if (fops != NULL)
+  {
+    ((USBD_Comp_ItfTypeDef *)Comp_iops)->DFU_ops = fops;
+    ret = USBD_OK;
+  }
+
+  return ret;
+}
+
+#endif /* DFU_ENABLE */
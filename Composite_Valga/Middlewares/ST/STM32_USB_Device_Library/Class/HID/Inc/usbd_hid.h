@@ -26,7 +26,11 @@ extern "C" {
 #endif
 
 /* Includes ------------------------------------------------------------------*/
+#ifndef HID_TYPING_HOST_TOOL
 #include  "usbd_ioreq.h"
+#endif /* HID_TYPING_HOST_TOOL */
+#include  "usbd_hid_report.h"
+#include  "usbd_hid_unicode.h"
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
   * @{
@@ -41,12 +45,27 @@ extern "C" {
 /** @defgroup USBD_HID_Exported_Defines
   * @{
   */
+/* Interface numbers are assigned by the composite descriptor, Composite.h */
+#define HID_ITF_NBR                   USBD_COMP_ITF_KEYBOARD
 #define HID_EPIN_ADDR                 0x83U
-#define HID_EPIN_SIZE                 0x08U//0x04U
+#define HID_EPIN_SIZE                 HID_RD_EP_SIZE(HID_KEYBOARD_REPORT_SIZE)
+
+/* Interrupt OUT endpoint for host output reports, 0 keeps them on EP0 only */
+#ifndef HID_USE_EPOUT
+#define HID_USE_EPOUT                 1U
+#endif /* HID_USE_EPOUT */
+
+#define HID_EPOUT_ADDR                0x03U
+#define HID_EPOUT_SIZE                HID_RD_EP_SIZE(HID_LED_REPORT_SIZE)
+
+/* Consumer and system control interface, polled apart from the keyboard */
+#define HID_CONTROL_ITF_NBR           USBD_COMP_ITF_CONTROL
+#define HID_CONTROL_EPIN_ADDR         0x85U
+#define HID_CONTROL_EPIN_SIZE         HID_RD_EP_SIZE(HID_RD_MAX(HID_CONSUMER_REPORT_SIZE, HID_SYSTEM_REPORT_SIZE))
 
-#define USB_HID_CONFIG_DESC_SIZ       34U
 #define USB_HID_DESC_SIZ              9U
-#define HID_KEYBOARD_REPORT_DESC_SIZE    187U//74U
+#define HID_KEYBOARD_REPORT_DESC_SIZE HID_RD_LENGTH(HID_KEYBOARD_REPORT_DESC)
+#define HID_CONTROL_REPORT_DESC_SIZE  HID_RD_LENGTH(HID_CONTROL_REPORT_DESC)
 
 #define HID_DESCRIPTOR_TYPE           0x21U
 #define HID_REPORT_DESC               0x22U
@@ -67,6 +86,153 @@ extern "C" {
 
 #define HID_REQ_SET_REPORT            0x09U
 #define HID_REQ_GET_REPORT            0x01U
+
+/* SET_PROTOCOL values, the device starts in report protocol */
+#define HID_PROTOCOL_BOOT             0x00U
+#define HID_PROTOCOL_REPORT           0x01U
+
+/* SET_IDLE duration unit in ms, a duration of 0 means report on change only */
+#define HID_IDLE_RATE_UNIT_MS         4U
+
+/* Report type in the high byte of wValue for GET_REPORT/SET_REPORT */
+#define HID_REPORT_TYPE_INPUT         0x01U
+#define HID_REPORT_TYPE_OUTPUT        0x02U
+#define HID_REPORT_TYPE_FEATURE       0x03U
+
+/* Report IDs of the collections in HID_KEYBOARD_ReportDesc and HID_CONTROL_ReportDesc */
+#define HID_REPORT_ID_KEYBOARD        0x01U
+#define HID_REPORT_ID_CONSUMER        0x02U
+#define HID_REPORT_ID_SYSTEM          0x03U
+#define HID_REPORT_ID_FEATURE_1       0x04U
+#define HID_REPORT_ID_FEATURE_2       0x05U
+
+/* Keyboard input report: modifier bits, reserved byte, 5 keys */
+#define HID_KEYBOARD_INPUT_FIELDS(I, IN)                               \
+  I(HID_RD_USAGE_PAGE, 1, 0x07)             /* Keyboard/Keypad */     \
+  I(HID_RD_USAGE_MIN, 1, 0xE0)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0xE7)                                        \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 1, 0x01)                                      \
+  IN(HID_KEYBOARD_MODIFIERS, HID_RD_DATA_VAR_ABS, 1, 8)               \
+  IN(HID_KEYBOARD_RESERVED, HID_RD_CNST, 8, 1)                        \
+  I(HID_RD_USAGE_MIN, 1, 0x00)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0x65)                                        \
+  I(HID_RD_LOGICAL_MAX, 1, 0x65)                                      \
+  IN(HID_KEYBOARD_KEYS, HID_RD_DATA_ARR_ABS, HID_RD_SAME(8), 5)
+
+/* Keyboard output report: LEDs */
+#define HID_KEYBOARD_OUTPUT_FIELDS(I, OUT)                             \
+  I(HID_RD_USAGE_PAGE, 1, 0x08)             /* LEDs */                \
+  I(HID_RD_USAGE_MIN, 1, 0x01)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0x05)                                        \
+  I(HID_RD_LOGICAL_MAX, 1, 0x01)                                      \
+  OUT(HID_KEYBOARD_LEDS, HID_RD_DATA_VAR_ABS, 1, 5)                   \
+  OUT(HID_KEYBOARD_LED_PADDING, HID_RD_CNST, 3, 1)
+
+/* Vendor feature reports HID_REPORT_ID_FEATURE_1 and _2, same layout */
+#define HID_FEATURE_FIELDS(I, FEAT)                                    \
+  I(HID_RD_LOGICAL_MIN, 1, 0x01)                                      \
+  I(HID_RD_LOGICAL_MAX, 1, 0x0A)                                      \
+  I(HID_RD_USAGE, 1, 0x20)                                            \
+  FEAT(HID_FEATURE_USAGE_20, HID_RD_CNST_VAR_ABS, 8, 1)               \
+  I(HID_RD_USAGE, 1, 0x23)                                            \
+  FEAT(HID_FEATURE_USAGE_23, HID_RD_CNST_VAR_ABS, HID_RD_SAME(8), HID_RD_SAME(1)) \
+  I(HID_RD_LOGICAL_MAX, 1, 0x4F)                                      \
+  I(HID_RD_USAGE, 1, 0x21)                                            \
+  FEAT(HID_FEATURE_USAGE_21, HID_RD_CNST_VAR_ABS, HID_RD_SAME(8), HID_RD_SAME(1)) \
+  I(HID_RD_LOGICAL_MAX, 1, 0x30)                                      \
+  I(HID_RD_USAGE, 1, 0x22)                                            \
+  FEAT(HID_FEATURE_USAGE_22, HID_RD_CNST_VAR_ABS, HID_RD_SAME(8), HID_RD_SAME(1)) \
+  I(HID_RD_USAGE, 1, 0x24)                                            \
+  FEAT(HID_FEATURE_USAGE_24, HID_RD_CNST_VAR_ABS, HID_RD_SAME(8), 3)
+
+/* Consumer control input report: one usage */
+#define HID_CONSUMER_INPUT_FIELDS(I, IN)                               \
+  I(HID_RD_USAGE_MIN, 1, 0x00)                                        \
+  I(HID_RD_USAGE_MAX, 2, 0x023C)                                      \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 2, 0x023C)                                    \
+  IN(HID_CONSUMER_USAGE, HID_RD_DATA_ARR_ABS, 16, 1)
+
+/* System control input report: power down, sleep, wake up bits */
+#define HID_SYSTEM_INPUT_FIELDS(I, IN)                                 \
+  I(HID_RD_USAGE_MIN, 1, 0x81)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0x83)                                        \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 1, 0x01)                                      \
+  IN(HID_SYSTEM_CONTROLS, HID_RD_DATA_VAR_ABS, 1, 3)                  \
+  IN(HID_SYSTEM_PADDING, HID_RD_CNST, HID_RD_SAME(1), 5)
+
+/* Report descriptor of the keyboard interface */
+#define HID_KEYBOARD_REPORT_DESC(I, IN, OUT, FEAT)                     \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x06)                  /* Keyboard */            \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_REPORT_ID_KEYBOARD)                      \
+  HID_KEYBOARD_INPUT_FIELDS(I, IN)                                    \
+  HID_KEYBOARD_OUTPUT_FIELDS(I, OUT)                                  \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_USAGE_PAGE, 2, 0xFF01)           /* Vendor */              \
+  I(HID_RD_USAGE, 1, 0x01)                                            \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_REPORT_ID_FEATURE_1)                     \
+  HID_FEATURE_FIELDS(I, FEAT)                                         \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_USAGE_PAGE, 2, 0xFF01)           /* Vendor */              \
+  I(HID_RD_USAGE, 1, 0x01)                                            \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_REPORT_ID_FEATURE_2)                     \
+  HID_FEATURE_FIELDS(I, FEAT)                                         \
+  I(HID_RD_END_COLLECTION, 0, 0)
+
+/* Report descriptor of the consumer and system control interface */
+#define HID_CONTROL_REPORT_DESC(I, IN, OUT, FEAT)                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x0C)             /* Consumer */            \
+  I(HID_RD_USAGE, 1, 0x01)                  /* Consumer Control */    \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_REPORT_ID_CONSUMER)                      \
+  HID_CONSUMER_INPUT_FIELDS(I, IN)                                    \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x80)                  /* System Control */      \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_REPORT_ID_SYSTEM)                        \
+  HID_SYSTEM_INPUT_FIELDS(I, IN)                                      \
+  I(HID_RD_END_COLLECTION, 0, 0)
+
+/* Report sizes including the report ID byte */
+#define HID_KEYBOARD_REPORT_SIZE      HID_RD_REPORT_BYTES(HID_KEYBOARD_INPUT_FIELDS)
+#define HID_CONSUMER_REPORT_SIZE      HID_RD_REPORT_BYTES(HID_CONSUMER_INPUT_FIELDS)
+#define HID_SYSTEM_REPORT_SIZE        HID_RD_REPORT_BYTES(HID_SYSTEM_INPUT_FIELDS)
+#define HID_LED_REPORT_SIZE           HID_RD_REPORT_BYTES(HID_KEYBOARD_OUTPUT_FIELDS)
+#define HID_FEATURE_REPORT_SIZE       HID_RD_REPORT_BYTES(HID_FEATURE_FIELDS)
+#define HID_NUM_FEATURE_REPORTS       2U
+
+/* Boot protocol reports carry no report ID: modifiers, reserved, 6 keys */
+#define HID_BOOT_KEYBOARD_REPORT_SIZE 8U
+#define HID_BOOT_LED_REPORT_SIZE      1U
+
+/* Every channel is queued in HID_EPIN_SIZE frames */
+#if (HID_CONSUMER_REPORT_SIZE > HID_EPIN_SIZE) || (HID_SYSTEM_REPORT_SIZE > HID_EPIN_SIZE)
+#error "Control reports must fit the HID report queue frames"
+#endif
+/* The boot report is the report without its ID byte */
+#if (HID_KEYBOARD_REPORT_SIZE - 1U) > HID_BOOT_KEYBOARD_REPORT_SIZE
+#error "Keyboard report does not fit the boot protocol report"
+#endif
+#if (HID_KEYBOARD_REPORT_DESC_SIZE > 0xFFFFU) || (HID_CONTROL_REPORT_DESC_SIZE > 0xFFFFU)
+#error "Report descriptor longer than wDescriptorLength"
+#endif
+#if !HID_RD_FIELDS_VALID(HID_KEYBOARD_INPUT_FIELDS) || !HID_RD_FIELDS_VALID(HID_KEYBOARD_OUTPUT_FIELDS) || \
+    !HID_RD_FIELDS_VALID(HID_FEATURE_FIELDS) || !HID_RD_FIELDS_VALID(HID_CONSUMER_INPUT_FIELDS) ||       \
+    !HID_RD_FIELDS_VALID(HID_SYSTEM_INPUT_FIELDS)
+#error "Report fields are 1 to 32 bits, 255 at most"
+#endif
+
+/* Pending reports held per channel while the IN endpoint is busy */
+#ifndef HID_REPORT_QUEUE_DEPTH
+#define HID_REPORT_QUEUE_DEPTH        4U
+#endif /* HID_REPORT_QUEUE_DEPTH */
 /**
   * @}
   */
@@ -75,6 +241,48 @@ extern "C" {
 /** @defgroup USBD_CORE_Exported_TypesDefinitions
   * @{
   */
+/* Bit offset of every report field, HID_<FIELD>_BIT */
+enum
+{
+  HID_KEYBOARD_INPUT_ID_LAST = 7,
+  HID_KEYBOARD_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+enum
+{
+  HID_KEYBOARD_OUTPUT_ID_LAST = 7,
+  HID_KEYBOARD_OUTPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+enum
+{
+  HID_FEATURE_ID_LAST = 7,
+  HID_FEATURE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+enum
+{
+  HID_CONSUMER_INPUT_ID_LAST = 7,
+  HID_CONSUMER_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+enum
+{
+  HID_SYSTEM_INPUT_ID_LAST = 7,
+  HID_SYSTEM_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+/* HID_<FIELD>_Set/Get/SetAll/GetAll */
+HID_KEYBOARD_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+HID_KEYBOARD_OUTPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+HID_FEATURE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+HID_CONSUMER_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+HID_SYSTEM_INPUT_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+
+/* The host tools only use the report layout, the key codes and the typing
+   engine (HID_TYPING_HOST_TOOL) */
+#ifndef HID_TYPING_HOST_TOOL
+
 typedef enum
 {
   HID_IDLE = 0,
@@ -82,13 +290,88 @@ typedef enum
 }
 HID_StateTypeDef;
 
+/* One report channel per input collection, served round-robin */
+typedef enum
+{
+  HID_CHANNEL_KEYBOARD = 0U,
+  HID_CHANNEL_CONSUMER,
+  HID_CHANNEL_SYSTEM,
+  HID_NUM_CHANNELS
+}
+HID_ChannelTypeDef;
+
+/* Each instance has its own interface, endpoints and handle so the host
+   polls them independently */
+typedef enum
+{
+  HID_INSTANCE_KEYBOARD = 0U,  /* keyboard, LEDs, feature reports */
+  HID_INSTANCE_CONTROL,        /* consumer and system control */
+  HID_NUM_INSTANCES
+}
+HID_InstanceTypeDef;
 
 typedef struct
 {
+  uint8_t              ItfNum;
+  uint8_t              EpInAddr;
+  uint8_t              EpInSize;
+  uint8_t              EpOutAddr;     /* 0: no interrupt OUT endpoint */
+  uint8_t              Boot;          /* boot interface, SET_PROTOCOL allowed */
+  uint8_t              FirstChannel;  /* channels served by the instance */
+  uint8_t              LastChannel;
+  const uint8_t        *ReportDesc;
+  uint16_t             ReportDescSize;
+  const uint8_t        *HidDesc;
+}
+USBD_HID_InstanceTypeDef;
+
+typedef struct
+{
+  uint8_t              Report[HID_REPORT_QUEUE_DEPTH][HID_EPIN_SIZE];
+  uint8_t              Head;
+  uint8_t              Tail;
+  uint8_t              Count;
+}
+USBD_HID_ReportQueueTypeDef;
+
+typedef struct
+{
+  uint32_t             Sent;        /* reports handed to the IN endpoint */
+  uint32_t             Suppressed;  /* duplicates dropped by the idle engine */
+  uint32_t             IdleRepeats; /* reports re-sent on idle period expiry */
+}
+USBD_HID_StatsTypeDef;
+
+struct _USBD_HID_Handle;
+
+/* Turns a queued report (report ID first) into what goes on the wire,
+   returns NULL when the report does not exist in the current protocol */
+typedef uint8_t *(*USBD_HID_EncodeTypeDef)(struct _USBD_HID_Handle *hhid,
+                                           uint8_t ch,
+                                           uint8_t *frame,
+                                           uint16_t *len);
+
+typedef struct _USBD_HID_Handle
+{
+  const USBD_HID_InstanceTypeDef *Inst;
   uint32_t             Protocol;
+  USBD_HID_EncodeTypeDef Encode;    /* selected by SET_PROTOCOL */
   uint32_t             IdleState;
   uint32_t             AltSetting;
   HID_StateTypeDef     state;
+  USBD_HID_ReportQueueTypeDef Queue[HID_NUM_CHANNELS];
+  uint8_t              LastChannel;
+  uint8_t              LastReport[HID_NUM_CHANNELS][HID_EPIN_SIZE];
+  uint8_t              LedState;
+  uint8_t              FeatureReport[HID_NUM_FEATURE_REPORTS][HID_FEATURE_REPORT_SIZE];
+  uint8_t              CtlReport[HID_FEATURE_REPORT_SIZE];
+  uint8_t              CtlReportType;
+  uint8_t              CtlReportLength;
+  uint8_t              OutReport[HID_EPOUT_SIZE];
+  uint8_t              BootReport[HID_BOOT_KEYBOARD_REPORT_SIZE];
+  uint8_t              IdleRate[HID_NUM_CHANNELS];   /* SET_IDLE duration, 4 ms units */
+  uint16_t             IdleCount[HID_NUM_CHANNELS];  /* ms left before a repeat */
+  USBD_HID_StatsTypeDef Stats;
 }
 USBD_HID_HandleTypeDef;
 /**
@@ -97,7 +380,9 @@ USBD_HID_HandleTypeDef;
 
 typedef struct _USBD_HID_Itf
 {
-  int8_t (* HID_interface_Ops)(void);
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  int8_t (* OutEvent)(uint8_t report_type, uint8_t *pbuf, uint16_t length);
 } USBD_HID_ItfTypeDef;
 
 
@@ -126,8 +411,28 @@ uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev,
                             uint8_t *report,
                             uint16_t len);
 
+uint8_t USBD_HID_SendConsumerReport(USBD_HandleTypeDef *pdev,
+                                    uint16_t usage);
+
+uint8_t USBD_HID_SendSystemReport(USBD_HandleTypeDef *pdev,
+                                  uint8_t controls);
+
 uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev);
 
+uint8_t USBD_HID_GetLedState(USBD_HandleTypeDef *pdev);
+
+uint8_t USBD_HID_GetStats(USBD_HandleTypeDef *pdev,
+                          USBD_HID_StatsTypeDef *stats);
+
+uint8_t  USBD_HID_RegisterInterface(void *Comp_iops,
+                                    USBD_HID_ItfTypeDef *fops);
+
+uint8_t USBD_HID_GetInstanceByItf(uint8_t itf);
+
+uint8_t USBD_HID_GetInstanceByEp(uint8_t ep_addr);
+
+#endif /* HID_TYPING_HOST_TOOL */
+
 /**
   * @}
   */
@@ -363,6 +668,88 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev);
 #define MODIFERKEYS_RIGHT_ALT 0x40U
 #define MODIFERKEYS_RIGHT_GUI 0x80U
 
+/*Consumer Control usages (report ID 2)*/
+#define CONSUMER_NONE 0x0000U
+#define CONSUMER_SCAN_NEXT_TRACK 0x00B5U
+#define CONSUMER_SCAN_PREVIOUS_TRACK 0x00B6U
+#define CONSUMER_STOP 0x00B7U
+#define CONSUMER_PLAY_PAUSE 0x00CDU
+#define CONSUMER_MUTE 0x00E2U
+#define CONSUMER_VOLUME_INCREMENT 0x00E9U
+#define CONSUMER_VOLUME_DECREMENT 0x00EAU
+#define CONSUMER_AL_CALCULATOR 0x0192U
+#define CONSUMER_AC_HOME 0x0223U
+
+/*System Control bits (report ID 3)*/
+#define SYSTEM_NONE 0x00U
+#define SYSTEM_POWER_DOWN 0x01U
+#define SYSTEM_SLEEP 0x02U
+#define SYSTEM_WAKE_UP 0x04U
+
+/*Keyboard LED bits (output report ID 1)*/
+#define LED_NUM_LOCK 0x01U
+#define LED_CAPS_LOCK 0x02U
+#define LED_SCROLL_LOCK 0x04U
+#define LED_COMPOSE 0x08U
+#define LED_KANA 0x10U
+
+/* Text the typing engine sees ahead of the character being typed, enough for
+   a whole UTF-8 character and for the keys packed in one report */
+#ifndef HID_TYPING_WINDOW_SIZE
+#define HID_TYPING_WINDOW_SIZE        8U
+#endif /* HID_TYPING_WINDOW_SIZE */
+
+/* Distinct keys pressed by one report while typing, 1 to 5, the whole key
+   array by default. More than one relies on the host handling the new keys
+   of a report in array order, as Windows, Linux and macOS do; 1 sends one
+   key per report for hosts that sort them */
+#ifndef HID_TYPING_KEYS_PER_REPORT
+#define HID_TYPING_KEYS_PER_REPORT    5U
+#endif /* HID_TYPING_KEYS_PER_REPORT */
+
+#if (HID_TYPING_KEYS_PER_REPORT < 1U) || (HID_TYPING_KEYS_PER_REPORT > (HID_KEYBOARD_REPORT_SIZE - 3U))
+#error "HID_TYPING_KEYS_PER_REPORT must fit the key array of the keyboard report"
+#endif
+#if (HID_TYPING_WINDOW_SIZE < 4U) || (HID_TYPING_WINDOW_SIZE < HID_TYPING_KEYS_PER_REPORT) || (HID_TYPING_WINDOW_SIZE > 255U)
+#error "HID_TYPING_WINDOW_SIZE must hold a UTF-8 character and the keys of a report"
+#endif
+
+/* Returned by a typing source at the end of the text */
+#define HID_STREAM_END                0xFFFFFFFFU
+
+/* Typing source, called from the USB interrupt: copy up to Len bytes of the
+   text to Buf and return their number, 0 if none is available yet, or
+   HID_STREAM_END when the text is finished */
+typedef uint32_t (*HIDLOP_PullTypeDef)(void *Ctx, uint8_t *Buf, uint32_t Len);
+
+typedef enum
+{
+	HID_TYPING_REPORT,   /* Report holds the next keyboard report */
+	HID_TYPING_WAIT,     /* nothing to send until more text is pulled */
+	HID_TYPING_DONE      /* text finished, every key released */
+}HID_TypingStatusTypeDef;
+
+/* Typing engine, usbd_hid_typing.c: the text seen through the window and
+   the last keyboard report built from it */
+typedef struct
+{
+HIDLOP_PullTypeDef Pull;
+void *PullCtx;
+uint8_t Window[HID_TYPING_WINDOW_SIZE];
+uint8_t WindowCount;
+uint8_t SourceEnd;
+const HID_UnicodeSeqTypeDef *Seq;
+uint8_t SeqStep;
+uint8_t SeqBytes;
+uint8_t Report[HID_KEYBOARD_REPORT_SIZE];
+}HID_TypingTypeDef;
+
+void HID_Typing_Start(HID_TypingTypeDef *Typing, HIDLOP_PullTypeDef Pull, void *Ctx);
+HID_TypingStatusTypeDef HID_Typing_Next(HID_TypingTypeDef *Typing);
+void HID_Typing_SetLocks(uint8_t leds);
+
+#ifndef HID_TYPING_HOST_TOOL
+
 typedef enum
 {
 	LOP_IDLE,
@@ -376,11 +763,15 @@ HIDLOP_FSM HID_StateMachine;
 uint8_t *TxBuffer;
 uint32_t MessageSize;
 uint32_t RemainingSize;
+HID_TypingTypeDef Typing;
 void (*TransferCompletedCallBack)(void *ptr);
 void (*SendNextChar)(USBD_HandleTypeDef *pdev,struct __HIDLOP_TransHandler *hTransf);
 }HIDLOP_TransferHandler;
 
 HIDLOP_FSM SendMessageHID (USBD_HandleTypeDef *pdev, uint8_t *Buffer, uint32_t SizeOfMsg);
+HIDLOP_FSM SendStreamHID (USBD_HandleTypeDef *pdev, HIDLOP_PullTypeDef Pull, void *Ctx);
+
+#endif /* HID_TYPING_HOST_TOOL */
 
 /*************************************************************************/
 
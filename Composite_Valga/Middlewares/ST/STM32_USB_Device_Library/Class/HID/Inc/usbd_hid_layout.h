@@ -0,0 +1,44 @@
+/*
+ * usbd_hid_layout.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  ASCII to keyboard usage tables. Plain C with no USB library dependency so
+ *  the host tools can build the same tables.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_LAYOUT_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_LAYOUT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+  HID_LAYOUT_US = 0U,
+  HID_LAYOUT_ES,
+  HID_NUM_LAYOUTS
+}
+HID_LayoutTypeDef;
+
+/* Table entry: modifier bits in the high byte, key usage in the low byte,
+   0 when the character cannot be typed with a single key (dead keys) */
+#define HID_LAYOUT_MOD(entry)         ((uint8_t)((entry) >> 8))
+#define HID_LAYOUT_USAGE(entry)       ((uint8_t)((entry) & 0xFFU))
+
+/* Printable ASCII range covered by the tables */
+#define HID_LAYOUT_FIRST_CHAR         0x20U
+#define HID_LAYOUT_LAST_CHAR          0x7EU
+#define HID_LAYOUT_NUM_CHARS          (HID_LAYOUT_LAST_CHAR - HID_LAYOUT_FIRST_CHAR + 1U)
+
+extern const uint16_t HID_LayoutTable[HID_NUM_LAYOUTS][HID_LAYOUT_NUM_CHARS];
+
+uint16_t HID_Layout_Lookup(uint8_t layout, uint8_t ascii);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_LAYOUT_H_ */
@@ -0,0 +1,93 @@
+/*
+ * usbd_hid_macro.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Keyboard macro bytecode and its playback engine. The bytecode is built
+ *  by Tools/hidmacro and kept in flash as a const array. The format part of
+ *  this header is shared with the host tool (HID_MACRO_HOST_TOOL).
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_MACRO_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_MACRO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Program layout: 'H' 'M' version flags, then the opcodes below, ended by
+ * HID_MACRO_OP_END. Multi-byte operands are little endian.
+ *
+ *  END                         stop playback
+ *  REPORT   len id data[len-1] send a raw report frame (keyboard, consumer, system)
+ *  KEY      mods usage         press usage with mods + held modifiers, then release
+ *  DELAY    ms_lo ms_hi        wait, counted in SOF frames (1 ms)
+ *  HOLD     mods               add to the held modifiers and report them
+ *  RELEASE  mods               remove from the held modifiers and report them
+ *  LAYOUT   layout             host layout used by CHAR (HID_LayoutTypeDef)
+ *  CHAR     ascii              type a character through the active layout
+ */
+#define HID_MACRO_MAGIC_0             'H'
+#define HID_MACRO_MAGIC_1             'M'
+#define HID_MACRO_VERSION             0x01U
+#define HID_MACRO_HEADER_SIZE         4U
+
+#define HID_MACRO_OP_END              0x00U
+#define HID_MACRO_OP_REPORT           0x01U
+#define HID_MACRO_OP_KEY              0x02U
+#define HID_MACRO_OP_DELAY            0x03U
+#define HID_MACRO_OP_HOLD             0x04U
+#define HID_MACRO_OP_RELEASE          0x05U
+#define HID_MACRO_OP_LAYOUT           0x06U
+#define HID_MACRO_OP_CHAR             0x07U
+
+/* Largest REPORT frame, report ID included */
+#define HID_MACRO_MAX_FRAME           8U
+
+#ifndef HID_MACRO_HOST_TOOL
+
+#include "usbd_def.h"
+
+typedef enum
+{
+  HID_MACRO_IDLE = 0U,
+  HID_MACRO_RUNNING,
+}
+HID_MacroStateTypeDef;
+
+typedef struct
+{
+  const uint8_t        *Program;
+  uint32_t             Length;
+  uint32_t             Pc;
+  uint16_t             Delay;          /* ms left in the current DELAY */
+  uint8_t              Held;           /* modifiers held by HOLD */
+  uint8_t              Layout;
+  uint8_t              ReleasePending; /* KEY/CHAR pressed, release frame not sent yet */
+  HID_MacroStateTypeDef State;
+}
+HID_MacroTypeDef;
+
+uint8_t USBD_HID_Macro_Play(USBD_HandleTypeDef *pdev,
+                            const uint8_t *program,
+                            uint32_t length);
+
+void USBD_HID_Macro_Stop(USBD_HandleTypeDef *pdev);
+
+uint8_t USBD_HID_Macro_IsBusy(void);
+
+void USBD_HID_Macro_DataIn(USBD_HandleTypeDef *pdev);
+
+void USBD_HID_Macro_SOF(USBD_HandleTypeDef *pdev);
+
+void USBD_HID_Macro_CompletedCallback(const uint8_t *program);
+
+#endif /* HID_MACRO_HOST_TOOL */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_MACRO_H_ */
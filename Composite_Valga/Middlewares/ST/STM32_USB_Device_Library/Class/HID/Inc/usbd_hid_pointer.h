@@ -0,0 +1,193 @@
+/*
+ * usbd_hid_pointer.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Pointer function (relative mouse and absolute digitiser) on its own HID
+ *  interface and interrupt endpoint, polled every frame.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_POINTER_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_POINTER_H_
+
+#include <stdint.h>
+
+/* Logical ranges of the report descriptor */
+#define HID_POINTER_DELTA_MAX         32767
+#define HID_POINTER_WHEEL_MAX         127
+#define HID_POINTER_ABSOLUTE_MAX      32767U
+
+/*
+ * Motion accumulator, shared with the host test (HID_POINTER_HOST_TOOL).
+ * HID_Pointer_Add keeps the motion that is not reported yet without
+ * wrapping around, HID_Pointer_Take removes what fits in a report field
+ * and leaves the remainder for the next poll.
+ */
+static inline int32_t HID_Pointer_Add(int32_t acc, int32_t delta)
+{
+  int64_t sum = (int64_t)acc + delta;
+
+  if (sum > INT32_MAX)
+  {
+    return INT32_MAX;
+  }
+  if (sum < -INT32_MAX)
+  {
+    return -INT32_MAX;
+  }
+  return (int32_t)sum;
+}
+
+static inline int32_t HID_Pointer_Take(int32_t *acc, int32_t max)
+{
+  int32_t value = *acc;
+
+  if (value > max)
+  {
+    value = max;
+  }
+  else if (value < -max)
+  {
+    value = -max;
+  }
+
+  *acc -= value;
+  return value;
+}
+
+#ifndef HID_POINTER_HOST_TOOL
+
+#include  "usbd_ioreq.h"
+#include  "usbd_hid_report.h"
+
+/* 0 removes the pointer interface from the composite device */
+#ifndef HID_POINTER_ENABLE
+#define HID_POINTER_ENABLE            1U
+#endif /* HID_POINTER_ENABLE */
+
+#define HID_POINTER_ITF_NBR           USBD_COMP_ITF_POINTER
+#define HID_POINTER_EPIN_ADDR         0x84U
+#define HID_POINTER_EPIN_SIZE         HID_RD_EP_SIZE(HID_RD_MAX(HID_POINTER_RELATIVE_REPORT_SIZE, HID_POINTER_ABSOLUTE_REPORT_SIZE))
+#define HID_POINTER_FS_BINTERVAL      0x01U
+
+#define HID_POINTER_REPORT_ID_RELATIVE  0x01U
+#define HID_POINTER_REPORT_ID_ABSOLUTE  0x02U
+
+/* Relative report: 5 buttons, X/Y deltas, wheel */
+#define HID_POINTER_RELATIVE_FIELDS(I, IN)                             \
+  I(HID_RD_USAGE_PAGE, 1, 0x09)             /* Button */              \
+  I(HID_RD_USAGE_MIN, 1, 0x01)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0x05)                                        \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 1, 0x01)                                      \
+  IN(HID_POINTER_REL_BUTTONS, HID_RD_DATA_VAR_ABS, 1, 5)              \
+  IN(HID_POINTER_REL_PADDING, HID_RD_CNST, 3, 1)                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x30)                  /* X */                   \
+  I(HID_RD_USAGE, 1, 0x31)                  /* Y */                   \
+  I(HID_RD_LOGICAL_MIN, 2, -HID_POINTER_DELTA_MAX)                    \
+  I(HID_RD_LOGICAL_MAX, 2, HID_POINTER_DELTA_MAX)                     \
+  IN(HID_POINTER_REL_XY, HID_RD_DATA_VAR_REL, 16, 2)                  \
+  I(HID_RD_USAGE, 1, 0x38)                  /* Wheel */               \
+  I(HID_RD_LOGICAL_MIN, 1, -HID_POINTER_WHEEL_MAX)                    \
+  I(HID_RD_LOGICAL_MAX, 1, HID_POINTER_WHEEL_MAX)                     \
+  IN(HID_POINTER_REL_WHEEL, HID_RD_DATA_VAR_REL, 8, 1)
+
+/* Absolute report: 5 buttons, X/Y positions */
+#define HID_POINTER_ABSOLUTE_FIELDS(I, IN)                             \
+  I(HID_RD_USAGE_PAGE, 1, 0x09)             /* Button */              \
+  I(HID_RD_USAGE_MIN, 1, 0x01)                                        \
+  I(HID_RD_USAGE_MAX, 1, 0x05)                                        \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 1, 0x01)                                      \
+  IN(HID_POINTER_ABS_BUTTONS, HID_RD_DATA_VAR_ABS, 1, 5)              \
+  IN(HID_POINTER_ABS_PADDING, HID_RD_CNST, 3, 1)                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x30)                  /* X */                   \
+  I(HID_RD_USAGE, 1, 0x31)                  /* Y */                   \
+  I(HID_RD_LOGICAL_MIN, 1, 0x00)                                      \
+  I(HID_RD_LOGICAL_MAX, 2, HID_POINTER_ABSOLUTE_MAX)                  \
+  IN(HID_POINTER_ABS_XY, HID_RD_DATA_VAR_ABS, 16, 2)
+
+#define HID_POINTER_REPORT_DESC(I, IN, OUT, FEAT)                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x02)                  /* Mouse */               \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_POINTER_REPORT_ID_RELATIVE)              \
+  I(HID_RD_USAGE, 1, 0x01)                  /* Pointer */             \
+  I(HID_RD_COLLECTION, 1, HID_RD_PHYSICAL)                            \
+  HID_POINTER_RELATIVE_FIELDS(I, IN)                                  \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_USAGE_PAGE, 1, 0x01)             /* Generic Desktop */     \
+  I(HID_RD_USAGE, 1, 0x02)                  /* Mouse */               \
+  I(HID_RD_COLLECTION, 1, HID_RD_APPLICATION)                         \
+  I(HID_RD_REPORT_ID, 1, HID_POINTER_REPORT_ID_ABSOLUTE)              \
+  I(HID_RD_USAGE, 1, 0x01)                  /* Pointer */             \
+  I(HID_RD_COLLECTION, 1, HID_RD_PHYSICAL)                            \
+  HID_POINTER_ABSOLUTE_FIELDS(I, IN)                                  \
+  I(HID_RD_END_COLLECTION, 0, 0)                                      \
+  I(HID_RD_END_COLLECTION, 0, 0)
+
+#define HID_POINTER_REPORT_DESC_SIZE  HID_RD_LENGTH(HID_POINTER_REPORT_DESC)
+#define HID_POINTER_RELATIVE_REPORT_SIZE HID_RD_REPORT_BYTES(HID_POINTER_RELATIVE_FIELDS)
+#define HID_POINTER_ABSOLUTE_REPORT_SIZE HID_RD_REPORT_BYTES(HID_POINTER_ABSOLUTE_FIELDS)
+#if !HID_RD_FIELDS_VALID(HID_POINTER_RELATIVE_FIELDS) || !HID_RD_FIELDS_VALID(HID_POINTER_ABSOLUTE_FIELDS)
+#error "Report fields are 1 to 32 bits, 255 at most"
+#endif
+
+/* Button bits */
+#define POINTER_BUTTON_LEFT           0x01U
+#define POINTER_BUTTON_RIGHT          0x02U
+#define POINTER_BUTTON_MIDDLE         0x04U
+#define POINTER_BUTTON_BACK           0x08U
+#define POINTER_BUTTON_FORWARD        0x10U
+
+/* Bit offset and accessors of every report field */
+enum
+{
+  HID_POINTER_RELATIVE_ID_LAST = 7,
+  HID_POINTER_RELATIVE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+enum
+{
+  HID_POINTER_ABSOLUTE_ID_LAST = 7,
+  HID_POINTER_ABSOLUTE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_ENUM)
+};
+
+HID_POINTER_RELATIVE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+HID_POINTER_ABSOLUTE_FIELDS(HID_RD_NO_ITEM, HID_RD_FIELD_SETTER)
+
+typedef struct
+{
+  int32_t              AccX;         /* relative motion not reported yet */
+  int32_t              AccY;
+  int32_t              AccWheel;
+  uint16_t             AbsX;
+  uint16_t             AbsY;
+  uint8_t              AbsPending;   /* new absolute position to report */
+  uint8_t              AbsButtons;
+  uint8_t              Buttons;      /* current relative buttons */
+  uint8_t              ButtonsLatch; /* buttons pressed since the last report */
+  uint8_t              ButtonsSent;
+  uint8_t              Busy;         /* report loaded on the IN endpoint */
+  uint8_t              Report[HID_POINTER_EPIN_SIZE];
+  uint32_t             Protocol;
+  uint32_t             IdleState;
+  uint32_t             AltSetting;
+}
+USBD_HID_Pointer_HandleTypeDef;
+
+extern USBD_ClassTypeDef  USBD_HID_POINTER;
+
+uint8_t USBD_HID_Pointer_Move(USBD_HandleTypeDef *pdev,
+                              int32_t dx, int32_t dy, int32_t wheel);
+
+uint8_t USBD_HID_Pointer_SetButtons(USBD_HandleTypeDef *pdev, uint8_t buttons);
+
+uint8_t USBD_HID_Pointer_MoveTo(USBD_HandleTypeDef *pdev,
+                                uint16_t x, uint16_t y, uint8_t buttons);
+
+#endif /* HID_POINTER_HOST_TOOL */
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_POINTER_H_ */
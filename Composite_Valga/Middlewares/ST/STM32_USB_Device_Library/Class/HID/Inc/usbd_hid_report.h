@@ -0,0 +1,230 @@
+/*
+ * usbd_hid_report.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Report descriptors built from X-macro lists. A descriptor is a list of
+ *  items, I(tag, data bytes, value), and of fields, IN/OUT/FEAT(name, flags,
+ *  size, count), given to the list as macro arguments. The same list expands
+ *  to the descriptor bytes, to its length, to the size of each report and to
+ *  the bit offset and accessors of each field, so none of them is maintained by
+ *  hand. Lengths and sizes are plain integer expressions usable in #if.
+ *
+ *  Report Size and Report Count are global items: a field whose size or count
+ *  is the one the previous field of the descriptor left writes it
+ *  HID_RD_SAME(n) and the item is not repeated. Plain sizes and counts are
+ *  never parenthesized, the parentheses are what marks HID_RD_SAME.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_REPORT_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_REPORT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Short item prefixes, size bits cleared */
+#define HID_RD_USAGE_PAGE             0x04U
+#define HID_RD_USAGE                  0x08U
+#define HID_RD_USAGE_MIN              0x18U
+#define HID_RD_USAGE_MAX              0x28U
+#define HID_RD_LOGICAL_MIN            0x14U
+#define HID_RD_LOGICAL_MAX            0x24U
+#define HID_RD_REPORT_SIZE            0x74U
+#define HID_RD_REPORT_ID              0x84U
+#define HID_RD_REPORT_COUNT           0x94U
+#define HID_RD_INPUT                  0x80U
+#define HID_RD_OUTPUT                 0x90U
+#define HID_RD_FEATURE                0xB0U
+#define HID_RD_COLLECTION             0xA0U
+#define HID_RD_END_COLLECTION         0xC0U
+
+/* Collection types */
+#define HID_RD_PHYSICAL               0x00U
+#define HID_RD_APPLICATION            0x01U
+
+/* Main item data */
+#define HID_RD_DATA_ARR_ABS           0x00U
+#define HID_RD_CNST                   0x01U
+#define HID_RD_DATA_VAR_ABS           0x02U
+#define HID_RD_CNST_VAR_ABS           0x03U
+#define HID_RD_DATA_VAR_REL           0x06U
+
+/* Item bytes, the data size is a literal 0, 1 or 2 */
+#define HID_RD_ITEM_BYTES(tag, n, v)  HID_RD_ITEM_BYTES_##n(tag, v)
+#define HID_RD_ITEM_BYTES_0(tag, v)   (uint8_t)(tag),
+#define HID_RD_ITEM_BYTES_1(tag, v)   (uint8_t)((tag) | 1U), (uint8_t)(v),
+#define HID_RD_ITEM_BYTES_2(tag, v)   (uint8_t)((tag) | 2U), (uint8_t)(v), (uint8_t)((uint16_t)(v) >> 8),
+
+/* Size or count already held by the global item */
+#define HID_RD_SAME(n)                (n)
+
+/* 1 for a HID_RD_SAME(n) argument, 0 for a plain value */
+#define HID_RD_IS_SAME(x)             HID_RD_SECOND(HID_RD_SAME_PROBE x, 0, ~)
+#define HID_RD_SAME_PROBE(n)          ~, 1
+#define HID_RD_SECOND(...)            HID_RD_SECOND_(__VA_ARGS__)
+#define HID_RD_SECOND_(a, b, ...)     b
+#define HID_RD_CAT(a, b)              HID_RD_CAT_(a, b)
+#define HID_RD_CAT_(a, b)             a##b
+
+/* Global item of a field, left out for HID_RD_SAME */
+#define HID_RD_GLOBAL_BYTES(tag, x)   HID_RD_CAT(HID_RD_GLOBAL_BYTES_, HID_RD_IS_SAME(x))(tag, x)
+#define HID_RD_GLOBAL_BYTES_0(tag, x) HID_RD_ITEM_BYTES_1(tag, x)
+#define HID_RD_GLOBAL_BYTES_1(tag, x)
+#define HID_RD_GLOBAL_LEN(x)          (2U - (2U * HID_RD_IS_SAME(x)))
+
+/* A field sets its report size and count then adds the main item */
+#define HID_RD_FIELD_BYTES(main, flags, size, count) \
+  HID_RD_GLOBAL_BYTES(HID_RD_REPORT_SIZE, size)      \
+  HID_RD_GLOBAL_BYTES(HID_RD_REPORT_COUNT, count)    \
+  HID_RD_ITEM_BYTES_1(main, flags)
+#define HID_RD_INPUT_BYTES(name, flags, size, count)   HID_RD_FIELD_BYTES(HID_RD_INPUT, flags, size, count)
+#define HID_RD_OUTPUT_BYTES(name, flags, size, count)  HID_RD_FIELD_BYTES(HID_RD_OUTPUT, flags, size, count)
+#define HID_RD_FEATURE_BYTES(name, flags, size, count) HID_RD_FIELD_BYTES(HID_RD_FEATURE, flags, size, count)
+
+/* Lengths and sizes */
+#define HID_RD_ITEM_LEN(tag, n, v)                     + 1U + (n)
+#define HID_RD_FIELD_LEN(name, flags, size, count)     + 2U + HID_RD_GLOBAL_LEN(size) + HID_RD_GLOBAL_LEN(count)
+#define HID_RD_NO_ITEM(tag, n, v)
+#define HID_RD_FIELD_BITS(name, flags, size, count)    + ((size) * (count))
+
+/**
+  * Descriptor bytes and length of a descriptor list(I, IN, OUT, FEAT)
+  */
+#define HID_RD_BYTES(desc)            desc(HID_RD_ITEM_BYTES, HID_RD_INPUT_BYTES, HID_RD_OUTPUT_BYTES, HID_RD_FEATURE_BYTES)
+#define HID_RD_LENGTH(desc)           (0U desc(HID_RD_ITEM_LEN, HID_RD_FIELD_LEN, HID_RD_FIELD_LEN, HID_RD_FIELD_LEN))
+
+/**
+  * Bytes of a report with its ID byte, from the field list(I, F) of the report
+  */
+#define HID_RD_REPORT_BYTES(fields)   (1U + (((0U fields(HID_RD_NO_ITEM, HID_RD_FIELD_BITS)) + 7U) / 8U))
+
+/**
+  * Nonzero when every field of a list fits the one byte Report Size/Count
+  * items and the 32 bit accessors. Check it with #if next to the list
+  */
+#define HID_RD_FIELD_VALID(name, flags, size, count) \
+  && ((size) >= 1U) && ((size) <= 32U) && ((count) >= 1U) && ((count) <= 255U)
+#define HID_RD_FIELDS_VALID(fields)   (1 fields(HID_RD_NO_ITEM, HID_RD_FIELD_VALID))
+
+/* Endpoint size for a report, PMA buffers are halfword aligned */
+#define HID_RD_EP_SIZE(bytes)         (((bytes) + 1U) & ~1U)
+
+#define HID_RD_MAX(a, b)              (((a) > (b)) ? (a) : (b))
+
+/**
+  * Field offsets: NAME_BIT is the first bit of field NAME in its report,
+  * the report ID takes the first byte. Use inside an enum after a
+  * <report>_ID_LAST = 7 entry
+  */
+#define HID_RD_FIELD_ENUM(name, flags, size, count) \
+  name##_BIT, name##_LAST = name##_BIT + ((size) * (count)) - 1,
+
+/**
+  * Field accessors: NAME_Set/NAME_Get access element index of field NAME,
+  * NAME_SetAll/NAME_GetAll the whole field, first element in the low bits.
+  * With constant arguments they fold to plain byte loads and stores
+  */
+#define HID_RD_FIELD_SETTER(name, flags, size, count)                          \
+  static inline void name##_Set(uint8_t *report, uint8_t index, uint32_t value) \
+  {                                                                             \
+    HID_Report_SetBits(report, (uint16_t)(name##_BIT + (index * (size))),       \
+                       (size), value);                                          \
+  }                                                                             \
+  static inline uint32_t name##_Get(const uint8_t *report, uint8_t index)       \
+  {                                                                             \
+    return HID_Report_GetBits(report, (uint16_t)(name##_BIT + (index * (size))), \
+                              (size));                                          \
+  }                                                                             \
+  static inline void name##_SetAll(uint8_t *report, uint32_t value)             \
+  {                                                                             \
+    HID_Report_SetBits(report, (uint16_t)name##_BIT, (size) * (count), value);  \
+  }                                                                             \
+  static inline uint32_t name##_GetAll(const uint8_t *report)                   \
+  {                                                                             \
+    return HID_Report_GetBits(report, (uint16_t)name##_BIT, (size) * (count));  \
+  }
+
+/**
+  * @brief  HID_Report_SetBits
+  *         Write a little endian field into a report, a byte at a time. The
+  *         bits around the field are kept
+  * @param  report: report buffer, ID byte included
+  * @param  bit: first bit of the field
+  * @param  size: bits of the field
+  * @param  value: value, truncated to size bits, bits above 32 are cleared
+  * @retval None
+  */
+static inline void HID_Report_SetBits(uint8_t *report, uint16_t bit, uint16_t size,
+                                      uint32_t value)
+{
+  uint8_t *p = &report[bit / 8U];
+  uint8_t shift = (uint8_t)(bit & 7U);
+  uint8_t n;
+  uint8_t mask;
+
+  if ((shift == 0U) && ((size & 7U) == 0U))
+  {
+    /* Byte aligned, plain stores */
+    for (; size != 0U; size = (uint16_t)(size - 8U))
+    {
+      *p = (uint8_t)value;
+      p++;
+      value >>= 8;
+    }
+  }
+  else
+  {
+    for (; size != 0U; size = (uint16_t)(size - n))
+    {
+      n = ((8U - shift) < size) ? (uint8_t)(8U - shift) : (uint8_t)size;
+      mask = (uint8_t)(((1U << n) - 1U) << shift);
+      *p = (uint8_t)((*p & (uint8_t)~mask) | ((value << shift) & mask));
+      p++;
+      value >>= n;
+      shift = 0U;
+    }
+  }
+}
+
+/**
+  * @brief  HID_Report_GetBits
+  *         Read a little endian field from a report, its first 32 bits, a
+  *         byte at a time
+  * @param  report: report buffer, ID byte included
+  * @param  bit: first bit of the field
+  * @param  size: bits of the field
+  * @retval field value
+  */
+static inline uint32_t HID_Report_GetBits(const uint8_t *report, uint16_t bit, uint16_t size)
+{
+  const uint8_t *p = &report[bit / 8U];
+  uint8_t shift = (uint8_t)(bit & 7U);
+  uint32_t value = 0U;
+  uint16_t got;
+
+  if (size > 32U)
+  {
+    size = 32U;
+  }
+
+  for (got = 0U; got < size; got += (uint16_t)(8U - shift), shift = 0U)
+  {
+    value |= (uint32_t)(*p >> shift) << got;
+    p++;
+  }
+
+  if (size < 32U)
+  {
+    value &= (1U << size) - 1U;
+  }
+
+  return value;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_REPORT_H_ */
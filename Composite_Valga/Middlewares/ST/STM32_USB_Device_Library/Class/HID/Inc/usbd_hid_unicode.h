@@ -0,0 +1,86 @@
+/*
+ * usbd_hid_unicode.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  UTF-8 text to keyboard sequences using the Unicode input method of the
+ *  host. Plain C with no USB library dependency so it also builds on a PC.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_UNICODE_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_UNICODE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+  HID_UNICODE_WINDOWS = 0U, /* Alt + keypad '+' + hex, needs EnableHexNumpad */
+  HID_UNICODE_LINUX,        /* Ctrl+Shift+U, hex, space (IBus / GTK) */
+  HID_UNICODE_MACOS,        /* Option + 4 hex digits, "Unicode Hex Input" layout */
+  HID_NUM_UNICODE_HOSTS
+}
+HID_UnicodeHostTypeDef;
+
+#ifndef HID_UNICODE_DEFAULT_HOST
+#define HID_UNICODE_DEFAULT_HOST      HID_UNICODE_WINDOWS
+#endif /* HID_UNICODE_DEFAULT_HOST */
+
+/* Compiled sequences kept, a power of two: each code point has one slot and
+ * replaces the one hashed there before it */
+#ifndef HID_UNICODE_CACHE_SIZE
+#define HID_UNICODE_CACHE_SIZE        32U
+#endif /* HID_UNICODE_CACHE_SIZE */
+
+#if ((HID_UNICODE_CACHE_SIZE & (HID_UNICODE_CACHE_SIZE - 1U)) != 0U) || \
+    (HID_UNICODE_CACHE_SIZE > 65536U)
+#error "HID_UNICODE_CACHE_SIZE must be a power of two, 65536 at most"
+#endif
+
+/* Longest sequence: macOS surrogate pair, 8 digits pressed and released */
+#define HID_UNICODE_MAX_STEPS         18U
+
+/* Replacement character for invalid UTF-8 and code points the host can't take */
+#define HID_UNICODE_REPLACEMENT       0xFFFDU
+
+/* Each step is one keyboard report, same entry format as HID_LayoutTable:
+   modifier bits in the high byte, key usage (0 = none) in the low byte */
+typedef struct
+{
+  uint8_t              Length;
+  uint16_t             Step[HID_UNICODE_MAX_STEPS];
+}
+HID_UnicodeSeqTypeDef;
+
+typedef struct
+{
+  uint32_t             Chars;       /* characters typed through the engine */
+  uint32_t             Reports;     /* steps of those characters */
+  uint32_t             Hits;        /* sequences found in the cache */
+  uint32_t             Misses;      /* sequences compiled */
+}
+HID_UnicodeStatsTypeDef;
+
+uint8_t HID_Unicode_Decode(const uint8_t *s, uint32_t len, uint32_t *cp);
+
+uint8_t HID_Unicode_Compile(uint8_t host, uint32_t cp, HID_UnicodeSeqTypeDef *seq);
+
+const HID_UnicodeSeqTypeDef *HID_Unicode_Get(uint32_t cp);
+
+void HID_Unicode_SetHost(uint8_t host);
+
+uint8_t HID_Unicode_GetHost(void);
+
+void HID_Unicode_SetNumLock(uint8_t on);
+
+void HID_Unicode_CountReports(uint8_t reports);
+
+void HID_Unicode_GetStats(HID_UnicodeStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_HID_INC_USBD_HID_UNICODE_H_ */
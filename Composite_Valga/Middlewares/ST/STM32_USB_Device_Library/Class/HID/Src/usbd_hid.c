@@ -44,9 +44,11 @@
 EndBSPDependencies */
 
 /* Includes ------------------------------------------------------------------*/
-#include "..\Inc\usbd_hid.h"
+#include "../Inc/usbd_hid.h"
 #include "usbd_ctlreq.h"
-#include "..\..\Composite\Inc\Composite.h"
+#include "../../Composite/Inc/Composite.h"
+#include "../Inc/usbd_hid_macro.h"
+#include "../Inc/usbd_hid_unicode.h"
 
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
@@ -100,15 +102,43 @@ EndBSPDependencies */
  uint8_t  USBD_HID_Setup(USBD_HandleTypeDef *pdev,
                                USBD_SetupReqTypedef *req);
 
- uint8_t  *USBD_HID_GetFSCfgDesc(uint16_t *length);
+ uint8_t  USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
 
- uint8_t  *USBD_HID_GetHSCfgDesc(uint16_t *length);
+ uint8_t  USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
 
- uint8_t  *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length);
+ uint8_t  USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev);
 
- uint8_t  *USBD_HID_GetDeviceQualifierDesc(uint16_t *length);
+ uint8_t  USBD_HID_SOF(USBD_HandleTypeDef *pdev);
 
- uint8_t  USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_GetChannel(uint8_t report_id);
+
+static uint8_t USBD_HID_GetInstanceByReq(USBD_SetupReqTypedef *req);
+
+static USBD_HID_HandleTypeDef *USBD_HID_GetHandle(USBD_HandleTypeDef *pdev,
+                                                  uint8_t inst);
+
+static uint8_t USBD_HID_HasChannel(USBD_HID_HandleTypeDef *hhid, uint8_t ch);
+
+static uint8_t USBD_HID_GetReport(USBD_HandleTypeDef *pdev,
+                                  USBD_HID_HandleTypeDef *hhid,
+                                  USBD_SetupReqTypedef *req);
+
+static void USBD_HID_ProcessOutReport(USBD_HandleTypeDef *pdev,
+                                      USBD_HID_HandleTypeDef *hhid,
+                                      uint8_t report_type,
+                                      uint8_t *pbuf,
+                                      uint16_t length);
+
+static void USBD_HID_ServiceQueues(USBD_HandleTypeDef *pdev,
+                                   USBD_HID_HandleTypeDef *hhid);
+
+static void USBD_HID_SetProtocol(USBD_HID_HandleTypeDef *hhid, uint8_t protocol);
+
+static uint8_t *USBD_HID_EncodeReport(USBD_HID_HandleTypeDef *hhid, uint8_t ch,
+                                      uint8_t *frame, uint16_t *len);
+
+static uint8_t *USBD_HID_EncodeBoot(USBD_HID_HandleTypeDef *hhid, uint8_t ch,
+                                    uint8_t *frame, uint16_t *len);
 /**
   * @}
   */
@@ -117,394 +147,92 @@ EndBSPDependencies */
   * @{
   */
 
+/* Report length sent for each channel, indexed by HID_ChannelTypeDef */
+static const uint8_t HID_ChannelReportSize[HID_NUM_CHANNELS] =
+{
+  HID_KEYBOARD_REPORT_SIZE,
+  HID_CONSUMER_REPORT_SIZE,
+  HID_SYSTEM_REPORT_SIZE,
+};
+
 USBD_ClassTypeDef  USBD_HID =
 {
   USBD_HID_Init,
   USBD_HID_DeInit,
   USBD_HID_Setup,
   NULL, /*EP0_TxSent*/
-  NULL, /*EP0_RxReady*/
+  USBD_HID_EP0_RxReady, /*EP0_RxReady*/
   USBD_HID_DataIn, /*DataIn*/
-  NULL, /*DataOut*/
-  NULL, /*SOF */
+  USBD_HID_DataOut, /*DataOut*/
+  USBD_HID_SOF, /*SOF */
+  NULL,
+  NULL,
+  NULL, /* Descriptors come from the composite device */
+  NULL,
   NULL,
   NULL,
-  USBD_HID_GetHSCfgDesc,
-  USBD_HID_GetFSCfgDesc,
-  USBD_HID_GetOtherSpeedCfgDesc,
-  USBD_HID_GetDeviceQualifierDesc,
 };
 
-/* USB HID device FS Configuration Descriptor */
-__ALIGN_BEGIN static uint8_t USBD_HID_CfgFSDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIGN_END =
+/* HID descriptors, same as in the configuration descriptor */
+__ALIGN_BEGIN static const uint8_t USBD_HID_Desc[USB_HID_DESC_SIZ]  __ALIGN_END  =
 {
-  0x09, /* bLength: Configuration Descriptor size */
-  USB_DESC_TYPE_CONFIGURATION, /* bDescriptorType: Configuration */
-  USB_HID_CONFIG_DESC_SIZ,
-  /* wTotalLength: Bytes returned */
-  0x00,
-  0x01,         /*bNumInterfaces: 1 interface*/
-  0x01,         /*bConfigurationValue: Configuration value*/
-  0x00,         /*iConfiguration: Index of string descriptor describing
-  the configuration*/
-  0xE0,         /*bmAttributes: bus powered and Support Remote Wake-up */
-  0x32,         /*MaxPower 100 mA: this current is used for detecting Vbus*/
-
-  /************** Descriptor of Joystick Mouse interface ****************/
-  /* 09 */
-  0x09,         /*bLength: Interface Descriptor size*/
-  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
-  0x00,         /*bInterfaceNumber: Number of Interface*/
-  0x00,         /*bAlternateSetting: Alternate setting*/
-  0x01,         /*bNumEndpoints*/
-  0x03,         /*bInterfaceClass: HID*/
-  0x01,         /*bInterfaceSubClass : 1=BOOT, 0=no boot*/
-  0x01,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
-  0,            /*iInterface: Index of string descriptor*/
-  /******************** Descriptor of Joystick Mouse HID ********************/
-  /* 18 */
-  0x09,         /*bLength: HID Descriptor size*/
-  HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
-  0x11,         /*bcdHID: HID Class Spec release number*/
-  0x01,
-  0x00,         /*bCountryCode: Hardware target country*/
-  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
-  0x22,         /*bDescriptorType*/
-  HID_KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
-  0x00,
-  /******************** Descriptor of Mouse endpoint ********************/
-  /* 27 */
-  0x07,          /*bLength: Endpoint Descriptor size*/
-  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
-
-  HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
-  0x03,          /*bmAttributes: Interrupt endpoint*/
-  HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
-  0x00,
-  HID_FS_BINTERVAL,          /*bInterval: Polling Interval */
-  /* 34 */
+  COMP_KEYBOARD_CS(COMP_DESC_CS_BYTES)
 };
 
-/* USB HID device HS Configuration Descriptor */
-__ALIGN_BEGIN static uint8_t USBD_HID_CfgHSDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIGN_END =
+__ALIGN_BEGIN static const uint8_t USBD_HID_Control_Desc[USB_HID_DESC_SIZ]  __ALIGN_END  =
 {
-  0x09, /* bLength: Configuration Descriptor size */
-  USB_DESC_TYPE_CONFIGURATION, /* bDescriptorType: Configuration */
-  USB_HID_CONFIG_DESC_SIZ,
-  /* wTotalLength: Bytes returned */
-  0x00,
-  0x01,         /*bNumInterfaces: 1 interface*/
-  0x01,         /*bConfigurationValue: Configuration value*/
-  0x00,         /*iConfiguration: Index of string descriptor describing
-  the configuration*/
-  0xE0,         /*bmAttributes: bus powered and Support Remote Wake-up */
-  0x32,         /*MaxPower 100 mA: this current is used for detecting Vbus*/
-
-  /************** Descriptor of Joystick Mouse interface ****************/
-  /* 09 */
-  0x09,         /*bLength: Interface Descriptor size*/
-  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
-  0x00,         /*bInterfaceNumber: Number of Interface*/
-  0x00,         /*bAlternateSetting: Alternate setting*/
-  0x01,         /*bNumEndpoints*/
-  0x03,         /*bInterfaceClass: HID*/
-  0x01,         /*bInterfaceSubClass : 1=BOOT, 0=no boot*/
-  0x02,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
-  0,            /*iInterface: Index of string descriptor*/
-  /******************** Descriptor of Joystick Mouse HID ********************/
-  /* 18 */
-  0x09,         /*bLength: HID Descriptor size*/
-  HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
-  0x11,         /*bcdHID: HID Class Spec release number*/
-  0x01,
-  0x00,         /*bCountryCode: Hardware target country*/
-  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
-  0x22,         /*bDescriptorType*/
-  HID_KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
-  0x00,
-  /******************** Descriptor of Mouse endpoint ********************/
-  /* 27 */
-  0x07,          /*bLength: Endpoint Descriptor size*/
-  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
-
-  HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
-  0x03,          /*bmAttributes: Interrupt endpoint*/
-  HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
-  0x00,
-  HID_HS_BINTERVAL,          /*bInterval: Polling Interval */
-  /* 34 */
+  COMP_CONTROL_CS(COMP_DESC_CS_BYTES)
 };
 
-/* USB HID device Other Speed Configuration Descriptor */
-__ALIGN_BEGIN static uint8_t USBD_HID_OtherSpeedCfgDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIGN_END =
+__ALIGN_BEGIN static const uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SIZE]  __ALIGN_END =
 {
-  0x09, /* bLength: Configuration Descriptor size */
-  USB_DESC_TYPE_CONFIGURATION, /* bDescriptorType: Configuration */
-  USB_HID_CONFIG_DESC_SIZ,
-  /* wTotalLength: Bytes returned */
-  0x00,
-  0x01,         /*bNumInterfaces: 1 interface*/
-  0x01,         /*bConfigurationValue: Configuration value*/
-  0x00,         /*iConfiguration: Index of string descriptor describing
-  the configuration*/
-  0xE0,         /*bmAttributes: bus powered and Support Remote Wake-up */
-  0x32,         /*MaxPower 100 mA: this current is used for detecting Vbus*/
-
-  /************** Descriptor of Joystick Mouse interface ****************/
-  /* 09 */
-  0x09,         /*bLength: Interface Descriptor size*/
-  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
-  0x00,         /*bInterfaceNumber: Number of Interface*/
-  0x00,         /*bAlternateSetting: Alternate setting*/
-  0x01,         /*bNumEndpoints*/
-  0x03,         /*bInterfaceClass: HID*/
-  0x01,         /*bInterfaceSubClass : 1=BOOT, 0=no boot*/
-  0x02,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
-  0,            /*iInterface: Index of string descriptor*/
-  /******************** Descriptor of Joystick Mouse HID ********************/
-  /* 18 */
-  0x09,         /*bLength: HID Descriptor size*/
-  HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
-  0x11,         /*bcdHID: HID Class Spec release number*/
-  0x01,
-  0x00,         /*bCountryCode: Hardware target country*/
-  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
-  0x22,         /*bDescriptorType*/
-  HID_KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
-  0x00,
-  /******************** Descriptor of Mouse endpoint ********************/
-  /* 27 */
-  0x07,          /*bLength: Endpoint Descriptor size*/
-  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
-
-  HID_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
-  0x03,          /*bmAttributes: Interrupt endpoint*/
-  HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
-  0x00,
-  HID_FS_BINTERVAL,          /*bInterval: Polling Interval */
-  /* 34 */
+  HID_RD_BYTES(HID_KEYBOARD_REPORT_DESC)
 };
 
-
-/* USB HID device Configuration Descriptor */
-__ALIGN_BEGIN static uint8_t USBD_HID_Desc[USB_HID_DESC_SIZ]  __ALIGN_END  =
+__ALIGN_BEGIN static const uint8_t HID_CONTROL_ReportDesc[HID_CONTROL_REPORT_DESC_SIZE]  __ALIGN_END =
 {
-  /* 18 */
-  0x09,         /*bLength: HID Descriptor size*/
-  HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
-  0x11,         /*bcdHID: HID Class Spec release number*/
-  0x01,
-  0x00,         /*bCountryCode: Hardware target country*/
-  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
-  0x22,         /*bDescriptorType*/
-  HID_KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
-  0x00,
+  HID_RD_BYTES(HID_CONTROL_REPORT_DESC)
 };
 
-/* USB Standard Device Descriptor */
-__ALIGN_BEGIN static uint8_t USBD_HID_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC]  __ALIGN_END =
+/* Interface, endpoints and channels of every HID instance */
+static const USBD_HID_InstanceTypeDef USBD_HID_Instances[HID_NUM_INSTANCES] =
 {
-  USB_LEN_DEV_QUALIFIER_DESC,
-  USB_DESC_TYPE_DEVICE_QUALIFIER,
-  0x00,
-  0x02,
-  0x00,
-  0x00,
-  0x00,
-  0x40,
-  0x01,
-  0x00,
+  {
+    HID_ITF_NBR,
+    HID_EPIN_ADDR,
+    HID_EPIN_SIZE,
+#if (HID_USE_EPOUT == 1U)
+    HID_EPOUT_ADDR,
+#else
+    0U,
+#endif /* HID_USE_EPOUT */
+    1U,
+    HID_CHANNEL_KEYBOARD,
+    HID_CHANNEL_KEYBOARD,
+    HID_KEYBOARD_ReportDesc,
+    HID_KEYBOARD_REPORT_DESC_SIZE,
+    USBD_HID_Desc,
+  },
+  {
+    HID_CONTROL_ITF_NBR,
+    HID_CONTROL_EPIN_ADDR,
+    HID_CONTROL_EPIN_SIZE,
+    0U,
+    0U,
+    HID_CHANNEL_CONSUMER,
+    HID_CHANNEL_SYSTEM,
+    HID_CONTROL_ReportDesc,
+    HID_CONTROL_REPORT_DESC_SIZE,
+    USBD_HID_Control_Desc,
+  },
 };
 
-__ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SIZE]  __ALIGN_END =
+/* Instance serving each channel, indexed by HID_ChannelTypeDef */
+static const uint8_t HID_ChannelInstance[HID_NUM_CHANNELS] =
 {
-	     0x05    ,//bSize: 0x01, bType: Global, bTag: Usage Page
-	     0x01    ,//Usage Page(Generic Desktop Controls )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x06    ,//Usage(Keyboard)
-	     0xA1    ,//bSize: 0x01, bType: Main, bTag: Collection
-	     0x01    ,//Collection(Application )
-	     0x85    ,//bSize: 0x01, bType: Global, bTag: Report ID
-	     0x01    ,//Report ID(0x1 )
-	     0x05    ,//bSize: 0x01, bType: Global, bTag: Usage Page
-	     0x07    ,//Usage Page(Keyboard/Keypad )
-	     0x19    ,//bSize: 0x01, bType: Local, bTag: Usage Minimum
-	     0xE0    ,//Usage Minimum(0xE0 )
-	     0x29    ,//bSize: 0x01, bType: Local, bTag: Usage Maximum
-	     0xE7    ,//Usage Maximum(0xE7 )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x00    ,//Logical Minimum(0x0 )
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x01    ,//Logical Maximum(0x1 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x01    ,//Report Size(0x1 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x08    ,//Report Count(0x8 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x02    ,//Input(Data, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x08    ,//Report Size(0x8 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x01    ,//Report Count(0x1 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x01    ,//Input(Constant, Array, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0x05    ,//bSize: 0x01, bType: Global, bTag: Usage Page
-	     0x07    ,//Usage Page(Keyboard/Keypad )
-	     0x19    ,//bSize: 0x01, bType: Local, bTag: Usage Minimum
-	     0x00    ,//Usage Minimum(0x0 )
-	     0x29    ,//bSize: 0x01, bType: Local, bTag: Usage Maximum
-	     0x65    ,//Usage Maximum(0x65 )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x00    ,//Logical Minimum(0x0 )
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x65    ,//Logical Maximum(0x65 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x08    ,//Report Size(0x8 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x05    ,//Report Count(0x5 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x00    ,//Input(Data, Array, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0xC0    ,//bSize: 0x00, bType: Main, bTag: End Collection
-	     0x05    ,//bSize: 0x01, bType: Global, bTag: Usage Page
-	     0x0C    ,//Usage Page(Consumer )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x01    ,//Usage(Consumer Control)
-	     0xA1    ,//bSize: 0x01, bType: Main, bTag: Collection
-	     0x01    ,//Collection(Application )
-	     0x85    ,//bSize: 0x01, bType: Global, bTag: Report ID
-	     0x02    ,//Report ID(0x2 )
-	     0x19    ,//bSize: 0x01, bType: Local, bTag: Usage Minimum
-	     0x00    ,//Usage Minimum(0x0 )
-	     0x2A    ,//bSize: 0x02, bType: Local, bTag: Usage Maximum
-	     0x3C,
-	     0x02 ,//Usage Maximum(0x23C )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x00    ,//Logical Minimum(0x0 )
-	     0x26    ,//bSize: 0x02, bType: Global, bTag: Logical Maximum
-	     0x3C,
-	     0x02 ,//Logical Maximum(0x23C )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x01    ,//Report Count(0x1 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x10    ,//Report Size(0x10 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x00    ,//Input(Data, Array, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0xC0    ,//bSize: 0x00, bType: Main, bTag: End Collection
-	     0x05    ,//bSize: 0x01, bType: Global, bTag: Usage Page
-	     0x01    ,//Usage Page(Generic Desktop Controls )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x80    ,//Usage(System Control)
-	     0xA1    ,//bSize: 0x01, bType: Main, bTag: Collection
-	     0x01    ,//Collection(Application )
-	     0x85    ,//bSize: 0x01, bType: Global, bTag: Report ID
-	     0x03    ,//Report ID(0x3 )
-	     0x19    ,//bSize: 0x01, bType: Local, bTag: Usage Minimum
-	     0x81    ,//Usage Minimum(0x81 )
-	     0x29    ,//bSize: 0x01, bType: Local, bTag: Usage Maximum
-	     0x83    ,//Usage Maximum(0x83 )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x00    ,//Logical Minimum(0x0 )
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x01    ,//Logical Maximum(0x1 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x01    ,//Report Size(0x1 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x03    ,//Report Count(0x3 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x02    ,//Input(Data, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x05    ,//Report Count(0x5 )
-	     0x81    ,//bSize: 0x01, bType: Main, bTag: Input
-	     0x01    ,//Input(Constant, Array, Absolute, No Wrap, Linear, Preferred State, No Null Position, Bit Field)
-	     0xC0    ,//bSize: 0x00, bType: Main, bTag: End Collection
-	     0x06    ,//bSize: 0x02, bType: Global, bTag: Usage Page
-	     0x01,
-	     0xFF ,//Usage Page(Undefined )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x01    ,//Usage(1)
-	     0xA1    ,//bSize: 0x01, bType: Main, bTag: Collection
-	     0x01    ,//Collection(Application )
-	     0x85    ,//bSize: 0x01, bType: Global, bTag: Report ID
-	     0x04    ,//Report ID(0x4 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x01    ,//Report Count(0x1 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x08    ,//Report Size(0x8 )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x01    ,//Logical Minimum(0x1 )
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x0A    ,//Logical Maximum(0xA )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x20    ,//Usage(32)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x23    ,//Usage(35)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x4F    ,//Logical Maximum(0x4F )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x21    ,//Usage(33)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x30    ,//Logical Maximum(0x30 )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x22    ,//Usage(34)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x03    ,//Report Count(0x3 )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x24    ,//Usage(36)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0xC0    ,//bSize: 0x00, bType: Main, bTag: End Collection
-	     0x06    ,//bSize: 0x02, bType: Global, bTag: Usage Page
-	     0x01,
-	     0xFF ,//Usage Page(Undefined )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x01    ,//Usage(1)
-	     0xA1    ,//bSize: 0x01, bType: Main, bTag: Collection
-	     0x01    ,//Collection(Application )
-	     0x85    ,//bSize: 0x01, bType: Global, bTag: Report ID
-	     0x05    ,//Report ID(0x5 )
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x01    ,//Report Count(0x1 )
-	     0x75    ,//bSize: 0x01, bType: Global, bTag: Report Size
-	     0x08    ,//Report Size(0x8 )
-	     0x15    ,//bSize: 0x01, bType: Global, bTag: Logical Minimum
-	     0x01    ,//Logical Minimum(0x1 )
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x0A    ,//Logical Maximum(0xA )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x20    ,//Usage(32)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x23    ,//Usage(35)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x4F    ,//Logical Maximum(0x4F )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x21    ,//Usage(33)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x25    ,//bSize: 0x01, bType: Global, bTag: Logical Maximum
-	     0x30    ,//Logical Maximum(0x30 )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x22    ,//Usage(34)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0x95    ,//bSize: 0x01, bType: Global, bTag: Report Count
-	     0x03    ,//Report Count(0x3 )
-	     0x09    ,//bSize: 0x01, bType: Local, bTag: Usage
-	     0x24    ,//Usage(36)
-	     0xB1    ,//bSize: 0x01, bType: Main, bTag: Feature
-	     0x03    ,//Feature(Constant, Variable, Absolute, No Wrap, Linear, Preferred State, No Null Position, Non VolatileBit Field)
-	     0xC0    //bSize: 0x00, bType: Main, bTag: End Collection
+  HID_INSTANCE_KEYBOARD,
+  HID_INSTANCE_CONTROL,
+  HID_INSTANCE_CONTROL,
 };
 //{
 //  0x05,   0x01,
@@ -574,21 +302,72 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
 {
   USBD_Composite_HandleTypeDef *compHandle;
   USBD_HID_HandleTypeDef *hhid;
-  /* Open EP IN */
-  USBD_LL_OpenEP(pdev, HID_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_EPIN_SIZE);
-  pdev->ep_in[HID_EPIN_ADDR & 0xFU].is_used = 1U;
+  const USBD_HID_InstanceTypeDef *inst;
+  uint8_t ch;
+  uint8_t i;
 
   //pdev->pClassData = USBD_malloc(sizeof(USBD_HID_HandleTypeDef));
   compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
-  compHandle->hid = USBD_malloc_HID(sizeof(USBD_HID_HandleTypeDef));
-  hhid = (USBD_HID_HandleTypeDef *)compHandle->hid;
+  hhid = USBD_malloc_Type(USBD_HID_HandleTypeDef, HID_NUM_INSTANCES);
 
-  if (compHandle->hid== NULL)
+  if (hhid == NULL)
   {
     return USBD_FAIL;
   }
 
-  hhid->state = HID_IDLE;
+  for (i = 0U; i < HID_NUM_INSTANCES; i++, hhid++)
+  {
+    inst = &USBD_HID_Instances[i];
+    compHandle->hid[i] = hhid;
+
+    /* The composite layer has opened the endpoints */
+    hhid->Inst = inst;
+    hhid->state = HID_IDLE;
+    USBD_HID_SetProtocol(hhid, HID_PROTOCOL_REPORT);
+
+    for (ch = 0U; ch < HID_NUM_CHANNELS; ch++)
+    {
+      hhid->Queue[ch].Head = 0U;
+      hhid->Queue[ch].Tail = 0U;
+      hhid->Queue[ch].Count = 0U;
+    }
+    /* Start the round-robin on the first channel of the instance */
+    hhid->LastChannel = inst->LastChannel;
+
+    (void)memset(hhid->LastReport, 0, sizeof(hhid->LastReport));
+    (void)memset(hhid->FeatureReport, 0, sizeof(hhid->FeatureReport));
+    hhid->LastReport[HID_CHANNEL_KEYBOARD][0] = HID_REPORT_ID_KEYBOARD;
+    hhid->LastReport[HID_CHANNEL_CONSUMER][0] = HID_REPORT_ID_CONSUMER;
+    hhid->LastReport[HID_CHANNEL_SYSTEM][0] = HID_REPORT_ID_SYSTEM;
+    hhid->FeatureReport[0][0] = HID_REPORT_ID_FEATURE_1;
+    hhid->FeatureReport[1][0] = HID_REPORT_ID_FEATURE_2;
+    hhid->LedState = 0U;
+    hhid->CtlReportLength = 0U;
+
+    /* Report on change only until the host sets an idle rate */
+    hhid->IdleState = 0U;
+    (void)memset(hhid->IdleRate, 0, sizeof(hhid->IdleRate));
+    (void)memset(hhid->IdleCount, 0, sizeof(hhid->IdleCount));
+    (void)memset(&hhid->Stats, 0, sizeof(hhid->Stats));
+  }
+
+  /* Nothing known of the host locks until its first LED report */
+  HID_Typing_SetLocks(LED_NUM_LOCK);
+
+  if (((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops != NULL)
+  {
+    ((USBD_HID_ItfTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops)->Init();
+  }
+
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    hhid = (USBD_HID_HandleTypeDef *)compHandle->hid[i];
+    if (hhid->Inst->EpOutAddr != 0U)
+    {
+      /* Prepare Out endpoint to receive the first output report */
+      USBD_LL_PrepareReceive(pdev, hhid->Inst->EpOutAddr, hhid->OutReport, HID_EPOUT_SIZE);
+    }
+  }
 
   return USBD_OK;
 }
@@ -605,15 +384,22 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
 {
   USBD_Composite_HandleTypeDef *compHandle;
   compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
-  /* Close HID EPs */
-  USBD_LL_CloseEP(pdev, HID_EPIN_ADDR);
-  pdev->ep_in[HID_EPIN_ADDR & 0xFU].is_used = 0U;
+  uint8_t i;
 
-  /* FRee allocated memory */
-  if (compHandle->hid != NULL)
+  /* The composite layer closes the endpoints */
+
+  /* FRee allocated memory, one block for every instance */
+  if (compHandle->hid[0] != NULL)
   {
-    USBD_free(compHandle->hid);
-    compHandle->hid = NULL;
+    if (((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops != NULL)
+    {
+      ((USBD_HID_ItfTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops)->DeInit();
+    }
+    USBD_free(compHandle->hid[0]);
+    for (i = 0U; i < HID_NUM_INSTANCES; i++)
+    {
+      compHandle->hid[i] = NULL;
+    }
   }
 
   return USBD_OK;
@@ -629,13 +415,19 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
  uint8_t  USBD_HID_Setup(USBD_HandleTypeDef *pdev,
                                USBD_SetupReqTypedef *req)
 {
-  USBD_Composite_HandleTypeDef *compHandle;
-  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
-  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *) compHandle->hid;
+  USBD_HID_HandleTypeDef *hhid;
   uint16_t len = 0U;
-  uint8_t *pbuf = NULL;
+  const uint8_t *pbuf = NULL;
   uint16_t status_info = 0U;
   USBD_StatusTypeDef ret = USBD_OK;
+  uint8_t ch;
+
+  hhid = USBD_HID_GetHandle(pdev, USBD_HID_GetInstanceByReq(req));
+  if (hhid == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
 
   switch (req->bmRequest & USB_REQ_TYPE_MASK)
   {
@@ -643,19 +435,94 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
       switch (req->bRequest)
       {
         case HID_REQ_SET_PROTOCOL:
-          hhid->Protocol = (uint8_t)(req->wValue);
+          if (hhid->Inst->Boot != 0U)
+          {
+            USBD_HID_SetProtocol(hhid, (uint8_t)(req->wValue));
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         case HID_REQ_GET_PROTOCOL:
-          USBD_CtlSendData(pdev, (uint8_t *)(void *)&hhid->Protocol, 1U);
+          if (hhid->Inst->Boot != 0U)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&hhid->Protocol, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         case HID_REQ_SET_IDLE:
-          hhid->IdleState = (uint8_t)(req->wValue >> 8);
+          /* Report ID 0 applies the duration to every report */
+          ch = USBD_HID_GetChannel(LOBYTE(req->wValue));
+          if (LOBYTE(req->wValue) == 0U)
+          {
+            hhid->IdleState = HIBYTE(req->wValue);
+            for (ch = hhid->Inst->FirstChannel; ch <= hhid->Inst->LastChannel; ch++)
+            {
+              hhid->IdleRate[ch] = HIBYTE(req->wValue);
+              hhid->IdleCount[ch] = (uint16_t)(hhid->IdleRate[ch] * HID_IDLE_RATE_UNIT_MS);
+            }
+          }
+          else if (USBD_HID_HasChannel(hhid, ch) != 0U)
+          {
+            hhid->IdleRate[ch] = HIBYTE(req->wValue);
+            hhid->IdleCount[ch] = (uint16_t)(hhid->IdleRate[ch] * HID_IDLE_RATE_UNIT_MS);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         case HID_REQ_GET_IDLE:
-          USBD_CtlSendData(pdev, (uint8_t *)(void *)&hhid->IdleState, 1U);
+          ch = USBD_HID_GetChannel(LOBYTE(req->wValue));
+          if (LOBYTE(req->wValue) == 0U)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&hhid->IdleState, 1U);
+          }
+          else if (USBD_HID_HasChannel(hhid, ch) != 0U)
+          {
+            USBD_CtlSendData(pdev, &hhid->IdleRate[ch], 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case HID_REQ_GET_REPORT:
+          if (USBD_HID_GetReport(pdev, hhid, req) != USBD_OK)
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case HID_REQ_SET_REPORT:
+          /* The data stage ends in USBD_HID_EP0_RxReady */
+          hhid->CtlReportType = (uint8_t)(req->wValue >> 8);
+          hhid->CtlReportLength = (uint8_t)MIN(req->wLength, sizeof(hhid->CtlReport));
+          /* Output and feature reports only exist on the keyboard interface */
+          if ((req->wLength == 0U) || (req->wLength > sizeof(hhid->CtlReport)) ||
+              (hhid->CtlReportType == HID_REPORT_TYPE_INPUT) ||
+              (hhid->Inst != &USBD_HID_Instances[HID_INSTANCE_KEYBOARD]))
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          else
+          {
+            USBD_CtlPrepareRx(pdev, hhid->CtlReport, hhid->CtlReportLength);
+          }
           break;
 
         default:
@@ -682,12 +549,12 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
         case USB_REQ_GET_DESCRIPTOR:
           if (req->wValue >> 8 == HID_REPORT_DESC)
           {
-            len = MIN(HID_KEYBOARD_REPORT_DESC_SIZE, req->wLength);
-            pbuf = HID_KEYBOARD_ReportDesc;
+            len = MIN(hhid->Inst->ReportDescSize, req->wLength);
+            pbuf = hhid->Inst->ReportDesc;
           }
           else if (req->wValue >> 8 == HID_DESCRIPTOR_TYPE)
           {
-            pbuf = USBD_HID_Desc;
+            pbuf = hhid->Inst->HidDesc;
             len = MIN(USB_HID_DESC_SIZ, req->wLength);
           }
           else
@@ -723,6 +590,10 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
           }
           break;
 
+        case USB_REQ_CLEAR_FEATURE:
+          /* Endpoint halt, cleared by the core */
+          break;
+
         default:
           USBD_CtlError(pdev, req);
           ret = USBD_FAIL;
@@ -741,33 +612,507 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
 
 /**
   * @brief  USBD_HID_SendReport
-  *         Send HID Report
+  *         Queue a HID Report on the channel selected by its report ID
   * @param  pdev: device instance
-  * @param  buff: pointer to report
+  * @param  buff: pointer to report, report ID in the first byte
   * @retval status
   */
 uint8_t USBD_HID_SendReport(USBD_HandleTypeDef  *pdev,
                             uint8_t *report,
                             uint16_t len)
+{
+  USBD_HID_HandleTypeDef     *hhid;
+  USBD_HID_ReportQueueTypeDef *queue;
+  uint8_t frame[HID_EPIN_SIZE];
+  uint8_t *last;
+  uint8_t ret = USBD_OK;
+  uint32_t primask;
+  uint8_t ch;
+
+  ch = USBD_HID_GetChannel(report[0]);
+  if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (ch >= HID_NUM_CHANNELS))
+  {
+    return USBD_FAIL;
+  }
+
+  /* Each channel belongs to one instance, with its own endpoint */
+  hhid = USBD_HID_GetHandle(pdev, HID_ChannelInstance[ch]);
+  if (hhid == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  len = MIN(len, HID_ChannelReportSize[ch]);
+  queue = &hhid->Queue[ch];
+
+  (void)memset(frame, 0, HID_EPIN_SIZE);
+  (void)memcpy(frame, report, len);
+
+  /* DataIn runs from the USB interrupt and drains the same queues */
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  /* What the host will have seen last once the queue drains */
+  if (queue->Count != 0U)
+  {
+    last = queue->Report[(queue->Head + HID_REPORT_QUEUE_DEPTH - 1U) % HID_REPORT_QUEUE_DEPTH];
+  }
+  else
+  {
+    last = hhid->LastReport[ch];
+  }
+
+  if (memcmp(frame, last, HID_EPIN_SIZE) == 0)
+  {
+    /* Unchanged input, the idle engine repeats it when the idle period expires */
+    hhid->Stats.Suppressed++;
+  }
+  else if (queue->Count < HID_REPORT_QUEUE_DEPTH)
+  {
+    (void)memcpy(queue->Report[queue->Head], frame, HID_EPIN_SIZE);
+    queue->Head = (uint8_t)((queue->Head + 1U) % HID_REPORT_QUEUE_DEPTH);
+    queue->Count++;
+
+    if (hhid->state == HID_IDLE)
+    {
+      USBD_HID_ServiceQueues(pdev, hhid);
+    }
+  }
+  else
+  {
+    ret = USBD_BUSY;
+  }
+
+  __set_PRIMASK(primask);
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_HID_SendConsumerReport
+  *         Queue a Consumer Control report, CONSUMER_NONE releases the key
+  * @param  pdev: device instance
+  * @param  usage: consumer page usage
+  * @retval status
+  */
+uint8_t USBD_HID_SendConsumerReport(USBD_HandleTypeDef *pdev,
+                                    uint16_t usage)
+{
+  uint8_t report[HID_CONSUMER_REPORT_SIZE] = {HID_REPORT_ID_CONSUMER};
+
+  HID_CONSUMER_USAGE_Set(report, 0U, usage);
+
+  return USBD_HID_SendReport(pdev, report, HID_CONSUMER_REPORT_SIZE);
+}
+
+/**
+  * @brief  USBD_HID_SendSystemReport
+  *         Queue a System Control report, SYSTEM_NONE releases the controls
+  * @param  pdev: device instance
+  * @param  controls: SYSTEM_POWER_DOWN | SYSTEM_SLEEP | SYSTEM_WAKE_UP
+  * @retval status
+  */
+uint8_t USBD_HID_SendSystemReport(USBD_HandleTypeDef *pdev,
+                                  uint8_t controls)
+{
+  uint8_t report[HID_SYSTEM_REPORT_SIZE] = {HID_REPORT_ID_SYSTEM};
+
+  HID_SYSTEM_CONTROLS_SetAll(report, controls);
+
+  return USBD_HID_SendReport(pdev, report, HID_SYSTEM_REPORT_SIZE);
+}
+
+/**
+  * @brief  USBD_HID_GetStats
+  *         Sum the sent/suppressed report counters of all instances
+  * @param  pdev: device instance
+  * @param  stats: destination
+  * @retval status
+  */
+uint8_t USBD_HID_GetStats(USBD_HandleTypeDef *pdev,
+                          USBD_HID_StatsTypeDef *stats)
+{
+  USBD_HID_HandleTypeDef *hhid;
+  uint8_t i;
+
+  if ((USBD_HID_GetHandle(pdev, 0U) == NULL) || (stats == NULL))
+  {
+    return USBD_FAIL;
+  }
+
+  (void)memset(stats, 0, sizeof(USBD_HID_StatsTypeDef));
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    hhid = USBD_HID_GetHandle(pdev, i);
+    stats->Sent += hhid->Stats.Sent;
+    stats->Suppressed += hhid->Stats.Suppressed;
+    stats->IdleRepeats += hhid->Stats.IdleRepeats;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_GetChannel
+  *         Map an input report ID to its channel
+  * @param  report_id: report ID
+  * @retval channel, HID_NUM_CHANNELS if the ID has no input report
+  */
+static uint8_t USBD_HID_GetChannel(uint8_t report_id)
+{
+  switch (report_id)
+  {
+    case HID_REPORT_ID_KEYBOARD:
+      return HID_CHANNEL_KEYBOARD;
+
+    case HID_REPORT_ID_CONSUMER:
+      return HID_CHANNEL_CONSUMER;
+
+    case HID_REPORT_ID_SYSTEM:
+      return HID_CHANNEL_SYSTEM;
+
+    default:
+      return HID_NUM_CHANNELS;
+  }
+}
+
+/**
+  * @brief  USBD_HID_HasChannel
+  * @param  hhid: HID handle
+  * @param  ch: channel
+  * @retval 1 if the channel is served by the instance of hhid
+  */
+static uint8_t USBD_HID_HasChannel(USBD_HID_HandleTypeDef *hhid, uint8_t ch)
+{
+  return ((ch >= hhid->Inst->FirstChannel) && (ch <= hhid->Inst->LastChannel)) ? 1U : 0U;
+}
+
+/**
+  * @brief  USBD_HID_GetHandle
+  * @param  pdev: device instance
+  * @param  inst: HID_INSTANCE_KEYBOARD, HID_INSTANCE_CONTROL
+  * @retval handle of the instance, NULL if unknown or not configured
+  */
+static USBD_HID_HandleTypeDef *USBD_HID_GetHandle(USBD_HandleTypeDef *pdev,
+                                                  uint8_t inst)
 {
   USBD_Composite_HandleTypeDef *compHandle;
   compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
-  USBD_HID_HandleTypeDef     *hhid = (USBD_HID_HandleTypeDef *)compHandle->hid;
 
-  if (pdev->dev_state == USBD_STATE_CONFIGURED)
+  if ((compHandle == NULL) || (inst >= HID_NUM_INSTANCES))
   {
-    if (hhid->state == HID_IDLE)
+    return NULL;
+  }
+
+  return (USBD_HID_HandleTypeDef *)compHandle->hid[inst];
+}
+
+/**
+  * @brief  USBD_HID_GetInstanceByItf
+  * @param  itf: interface number
+  * @retval HID instance owning the interface, HID_NUM_INSTANCES if none
+  */
+uint8_t USBD_HID_GetInstanceByItf(uint8_t itf)
+{
+  uint8_t i;
+
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    if (USBD_HID_Instances[i].ItfNum == itf)
+    {
+      break;
+    }
+  }
+
+  return i;
+}
+
+/**
+  * @brief  USBD_HID_GetInstanceByEp
+  * @param  ep_addr: endpoint address, direction bit included
+  * @retval HID instance owning the endpoint, HID_NUM_INSTANCES if none
+  */
+uint8_t USBD_HID_GetInstanceByEp(uint8_t ep_addr)
+{
+  uint8_t i;
+
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    if ((USBD_HID_Instances[i].EpInAddr == ep_addr) ||
+        ((USBD_HID_Instances[i].EpOutAddr == ep_addr) && (ep_addr != 0U)))
     {
-      hhid->state = HID_BUSY;
-      USBD_LL_Transmit(pdev,
-                       HID_EPIN_ADDR,
-                       report,
-                       len);
+      break;
     }
   }
+
+  return i;
+}
+
+/**
+  * @brief  USBD_HID_GetInstanceByReq
+  *         Interface requests carry the interface number in wIndex,
+  *         endpoint requests the endpoint address
+  * @param  req: usb request
+  * @retval HID instance addressed by the request, HID_NUM_INSTANCES if none
+  */
+static uint8_t USBD_HID_GetInstanceByReq(USBD_SetupReqTypedef *req)
+{
+  if ((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_ENDPOINT)
+  {
+    return USBD_HID_GetInstanceByEp(LOBYTE(req->wIndex));
+  }
+
+  return USBD_HID_GetInstanceByItf(LOBYTE(req->wIndex));
+}
+
+/**
+  * @brief  USBD_HID_GetLedState
+  *         return the keyboard LED state last set by the host
+  * @param  pdev: device instance
+  * @retval LED_NUM_LOCK | LED_CAPS_LOCK | ... bit mask
+  */
+uint8_t USBD_HID_GetLedState(USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef *hhid = USBD_HID_GetHandle(pdev, HID_INSTANCE_KEYBOARD);
+
+  return (hhid != NULL) ? hhid->LedState : 0U;
+}
+
+/**
+  * @brief  USBD_HID_GetReport
+  *         Answer a GET_REPORT request: input reports return the last report
+  *         sent on their channel, output and feature reports their stored copy
+  * @param  pdev: device instance
+  * @param  hhid: HID handle
+  * @param  req: usb request, report type and ID in wValue
+  * @retval status
+  */
+static uint8_t USBD_HID_GetReport(USBD_HandleTypeDef *pdev,
+                                  USBD_HID_HandleTypeDef *hhid,
+                                  USBD_SetupReqTypedef *req)
+{
+  uint8_t type = HIBYTE(req->wValue);
+  uint8_t id = LOBYTE(req->wValue);
+  uint8_t *pbuf = NULL;
+  uint16_t len = 0U;
+  uint8_t ch;
+
+  /* Boot protocol has a single unnumbered keyboard report */
+  if ((hhid->Protocol == HID_PROTOCOL_BOOT) && (id == 0U))
+  {
+    id = HID_REPORT_ID_KEYBOARD;
+  }
+
+  switch (type)
+  {
+    case HID_REPORT_TYPE_INPUT:
+      ch = USBD_HID_GetChannel(id);
+      if (USBD_HID_HasChannel(hhid, ch) != 0U)
+      {
+        pbuf = hhid->Encode(hhid, ch, hhid->LastReport[ch], &len);
+      }
+      break;
+
+    case HID_REPORT_TYPE_OUTPUT:
+      if (hhid->Inst != &USBD_HID_Instances[HID_INSTANCE_KEYBOARD])
+      {
+        /* Output and feature reports only exist on the keyboard interface */
+      }
+      else if ((id == HID_REPORT_ID_KEYBOARD) && (hhid->Protocol == HID_PROTOCOL_BOOT))
+      {
+        hhid->CtlReport[0] = hhid->LedState;
+        pbuf = hhid->CtlReport;
+        len = HID_BOOT_LED_REPORT_SIZE;
+      }
+      else if (id == HID_REPORT_ID_KEYBOARD)
+      {
+        hhid->CtlReport[0] = HID_REPORT_ID_KEYBOARD;
+        hhid->CtlReport[1] = hhid->LedState;
+        pbuf = hhid->CtlReport;
+        len = HID_LED_REPORT_SIZE;
+      }
+      break;
+
+    case HID_REPORT_TYPE_FEATURE:
+      if ((hhid->Inst == &USBD_HID_Instances[HID_INSTANCE_KEYBOARD]) &&
+          ((id == HID_REPORT_ID_FEATURE_1) || (id == HID_REPORT_ID_FEATURE_2)))
+      {
+        pbuf = hhid->FeatureReport[id - HID_REPORT_ID_FEATURE_1];
+        len = HID_FEATURE_REPORT_SIZE;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  if (pbuf == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  USBD_CtlSendData(pdev, pbuf, MIN(len, req->wLength));
+
   return USBD_OK;
 }
 
+/**
+  * @brief  USBD_HID_ProcessOutReport
+  *         Store a report received from the host and notify the application
+  * @param  pdev: device instance
+  * @param  hhid: HID handle
+  * @param  report_type: HID_REPORT_TYPE_OUTPUT or HID_REPORT_TYPE_FEATURE
+  * @param  pbuf: report, report ID in the first byte
+  * @param  length: report length
+  * @retval None
+  */
+static void USBD_HID_ProcessOutReport(USBD_HandleTypeDef *pdev,
+                                      USBD_HID_HandleTypeDef *hhid,
+                                      uint8_t report_type,
+                                      uint8_t *pbuf,
+                                      uint16_t length)
+{
+  if (length == 0U)
+  {
+    return;
+  }
+
+  if ((report_type == HID_REPORT_TYPE_OUTPUT) &&
+      (hhid->Protocol == HID_PROTOCOL_BOOT) && (length == HID_BOOT_LED_REPORT_SIZE))
+  {
+    hhid->LedState = pbuf[0];
+    HID_Typing_SetLocks(hhid->LedState);
+  }
+  else if ((report_type == HID_REPORT_TYPE_OUTPUT) &&
+      (pbuf[0] == HID_REPORT_ID_KEYBOARD) && (length >= HID_LED_REPORT_SIZE))
+  {
+    hhid->LedState = (uint8_t)HID_KEYBOARD_LEDS_GetAll(pbuf);
+    HID_Typing_SetLocks(hhid->LedState);
+  }
+  else if ((report_type == HID_REPORT_TYPE_FEATURE) &&
+           ((pbuf[0] == HID_REPORT_ID_FEATURE_1) || (pbuf[0] == HID_REPORT_ID_FEATURE_2)))
+  {
+    (void)memcpy(hhid->FeatureReport[pbuf[0] - HID_REPORT_ID_FEATURE_1], pbuf,
+                 MIN(length, HID_FEATURE_REPORT_SIZE));
+  }
+
+  if (((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops != NULL)
+  {
+    ((USBD_HID_ItfTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->HID_ops)->OutEvent(report_type,
+                                                                                          pbuf,
+                                                                                          length);
+  }
+}
+
+/**
+  * @brief  USBD_HID_ServiceQueues
+  *         Fair arbiter: send the oldest report of the next non-empty channel
+  *         of the instance after the one served last, so a report never waits
+  *         behind more than one report of every other channel
+  * @param  pdev: device instance
+  * @param  hhid: HID handle, IN endpoint must be idle
+  * @retval None
+  */
+static void USBD_HID_ServiceQueues(USBD_HandleTypeDef *pdev,
+                                   USBD_HID_HandleTypeDef *hhid)
+{
+  const USBD_HID_InstanceTypeDef *inst = hhid->Inst;
+  USBD_HID_ReportQueueTypeDef *queue;
+  uint8_t ch = hhid->LastChannel;
+  uint8_t *pbuf;
+  uint16_t len;
+  uint8_t i;
+
+  for (i = inst->FirstChannel; i <= inst->LastChannel; i++)
+  {
+    ch = (ch < inst->LastChannel) ? (uint8_t)(ch + 1U) : inst->FirstChannel;
+    queue = &hhid->Queue[ch];
+
+    while (queue->Count != 0U)
+    {
+      /* Keep a copy for GET_REPORT(Input) and the idle repeats */
+      (void)memcpy(hhid->LastReport[ch], queue->Report[queue->Tail], HID_EPIN_SIZE);
+      hhid->IdleCount[ch] = (uint16_t)(hhid->IdleRate[ch] * HID_IDLE_RATE_UNIT_MS);
+
+      pbuf = hhid->Encode(hhid, ch, queue->Report[queue->Tail], &len);
+      if (pbuf != NULL)
+      {
+        hhid->state = HID_BUSY;
+        hhid->LastChannel = ch;
+        hhid->Stats.Sent++;
+
+        /* The report is copied to packet memory before Transmit returns */
+        USBD_LL_Transmit(pdev, inst->EpInAddr, pbuf, len);
+      }
+
+      queue->Tail = (uint8_t)((queue->Tail + 1U) % HID_REPORT_QUEUE_DEPTH);
+      queue->Count--;
+
+      if (pbuf != NULL)
+      {
+        return;
+      }
+    }
+  }
+}
+
+/**
+  * @brief  USBD_HID_SetProtocol
+  *         Select the report encoding for the protocol requested by the host,
+  *         so the per-report path does not test the protocol
+  * @param  hhid: HID handle
+  * @param  protocol: HID_PROTOCOL_BOOT or HID_PROTOCOL_REPORT
+  * @retval None
+  */
+static void USBD_HID_SetProtocol(USBD_HID_HandleTypeDef *hhid, uint8_t protocol)
+{
+  hhid->Protocol = protocol;
+  hhid->Encode = (protocol == HID_PROTOCOL_BOOT) ? USBD_HID_EncodeBoot : USBD_HID_EncodeReport;
+}
+
+/**
+  * @brief  USBD_HID_EncodeReport
+  *         Report protocol: the queued report goes out as is
+  * @param  hhid: HID handle
+  * @param  ch: channel of the report
+  * @param  frame: queued report, report ID first
+  * @param  len: length to send
+  * @retval buffer to send
+  */
+static uint8_t *USBD_HID_EncodeReport(USBD_HID_HandleTypeDef *hhid, uint8_t ch,
+                                      uint8_t *frame, uint16_t *len)
+{
+  UNUSED(hhid);
+
+  *len = HID_ChannelReportSize[ch];
+  return frame;
+}
+
+/**
+  * @brief  USBD_HID_EncodeBoot
+  *         Boot protocol: only the keyboard exists, sent without its report ID
+  *         as the fixed 8 byte boot keyboard report
+  * @param  hhid: HID handle
+  * @param  ch: channel of the report
+  * @param  frame: queued report, report ID first
+  * @param  len: length to send
+  * @retval buffer to send, NULL for consumer and system reports
+  */
+static uint8_t *USBD_HID_EncodeBoot(USBD_HID_HandleTypeDef *hhid, uint8_t ch,
+                                    uint8_t *frame, uint16_t *len)
+{
+  if (ch != HID_CHANNEL_KEYBOARD)
+  {
+    *len = 0U;
+    return NULL;
+  }
+
+  (void)memcpy(hhid->BootReport, &frame[1], HID_KEYBOARD_REPORT_SIZE - 1U);
+  hhid->BootReport[HID_BOOT_KEYBOARD_REPORT_SIZE - 1U] = 0U;
+  *len = HID_BOOT_KEYBOARD_REPORT_SIZE;
+  return hhid->BootReport;
+}
+
 /**
   * @brief  USBD_HID_GetPollingInterval
   *         return polling interval from endpoint descriptor
@@ -796,77 +1141,186 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev)
   return ((uint32_t)(polling_interval));
 }
 
+ extern HIDLOP_TransferHandler hHIDTransfer;
+
 /**
-  * @brief  USBD_HID_GetCfgFSDesc
-  *         return FS configuration descriptor
-  * @param  speed : current device speed
-  * @param  length : pointer data length
-  * @retval pointer to descriptor buffer
+  * @brief  USBD_HID_DataIn
+  *         handle data IN Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
   */
- uint8_t  *USBD_HID_GetFSCfgDesc(uint16_t *length)
+ uint8_t  USBD_HID_DataIn(USBD_HandleTypeDef *pdev,
+                                uint8_t epnum)
 {
-  *length = sizeof(USBD_HID_CfgFSDesc);
-  return USBD_HID_CfgFSDesc;
+  USBD_HID_HandleTypeDef *hhid;
+
+  hhid = USBD_HID_GetHandle(pdev, USBD_HID_GetInstanceByEp(epnum | 0x80U));
+  if (hhid == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  /* Ensure that the FIFO is empty before a new transfer, this condition could
+  be caused by  a new transfer before the end of the previous transfer */
+  hhid->state = HID_IDLE;
+
+  /* Arbitrate among what is already pending before the typing engine refills
+  the keyboard channel, otherwise a text burst would always win the slot */
+  USBD_HID_ServiceQueues(pdev, hhid);
+
+  if ((hHIDTransfer.HID_StateMachine == LOP_BUSY) &&
+      (hhid->Inst == &USBD_HID_Instances[HID_INSTANCE_KEYBOARD]) &&
+      (hhid->Queue[HID_CHANNEL_KEYBOARD].Count < HID_REPORT_QUEUE_DEPTH))
+  {
+    hHIDTransfer.SendNextChar(pdev, &hHIDTransfer);
+  }
+
+  /* Macro frames only go out on the keyboard channel */
+  if (hhid->Inst == &USBD_HID_Instances[HID_INSTANCE_KEYBOARD])
+  {
+    USBD_HID_Macro_DataIn(pdev);
+  }
+
+  return USBD_OK;
 }
 
 /**
-  * @brief  USBD_HID_GetCfgHSDesc
-  *         return HS configuration descriptor
-  * @param  speed : current device speed
-  * @param  length : pointer data length
-  * @retval pointer to descriptor buffer
+  * @brief  USBD_HID_SOF
+  *         Idle engine, one tick per frame: re-send the last report of a
+  *         channel whose idle period expired without a change
+  * @param  pdev: device instance
+  * @retval status
   */
- uint8_t  *USBD_HID_GetHSCfgDesc(uint16_t *length)
+ uint8_t  USBD_HID_SOF(USBD_HandleTypeDef *pdev)
 {
-  *length = sizeof(USBD_HID_CfgHSDesc);
-  return USBD_HID_CfgHSDesc;
+  USBD_HID_HandleTypeDef *hhid;
+  USBD_HID_ReportQueueTypeDef *queue;
+  uint8_t ch;
+  uint8_t i;
+
+  if (USBD_HID_GetHandle(pdev, 0U) == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    hhid = USBD_HID_GetHandle(pdev, i);
+
+    for (ch = hhid->Inst->FirstChannel; ch <= hhid->Inst->LastChannel; ch++)
+    {
+      /* Duration 0: report on change only */
+      if ((hhid->IdleRate[ch] == 0U) || (--hhid->IdleCount[ch] != 0U))
+      {
+        continue;
+      }
+
+      hhid->IdleCount[ch] = (uint16_t)(hhid->IdleRate[ch] * HID_IDLE_RATE_UNIT_MS);
+      queue = &hhid->Queue[ch];
+
+      /* A pending report restarts the period when it is sent anyway */
+      if (queue->Count == 0U)
+      {
+        (void)memcpy(queue->Report[queue->Head], hhid->LastReport[ch], HID_EPIN_SIZE);
+        queue->Head = (uint8_t)((queue->Head + 1U) % HID_REPORT_QUEUE_DEPTH);
+        queue->Count++;
+        hhid->Stats.IdleRepeats++;
+      }
+    }
+  }
+
+  USBD_HID_Macro_SOF(pdev);
+
+  /* Start a text, or resume one whose source had nothing to give: no DataIn
+  is coming while the keyboard has nothing queued */
+  hhid = USBD_HID_GetHandle(pdev, HID_INSTANCE_KEYBOARD);
+  if ((hHIDTransfer.HID_StateMachine == LOP_BUSY) && (hhid->state == HID_IDLE) &&
+      (hhid->Queue[HID_CHANNEL_KEYBOARD].Count == 0U))
+  {
+    hHIDTransfer.SendNextChar(pdev, &hHIDTransfer);
+  }
+
+  for (i = 0U; i < HID_NUM_INSTANCES; i++)
+  {
+    hhid = USBD_HID_GetHandle(pdev, i);
+    if (hhid->state == HID_IDLE)
+    {
+      USBD_HID_ServiceQueues(pdev, hhid);
+    }
+  }
+
+  return USBD_OK;
 }
 
 /**
-  * @brief  USBD_HID_GetOtherSpeedCfgDesc
-  *         return other speed configuration descriptor
-  * @param  speed : current device speed
-  * @param  length : pointer data length
-  * @retval pointer to descriptor buffer
+  * @brief  USBD_HID_DataOut
+  *         handle output reports received on the interrupt OUT endpoint
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
   */
- uint8_t  *USBD_HID_GetOtherSpeedCfgDesc(uint16_t *length)
+ uint8_t  USBD_HID_DataOut(USBD_HandleTypeDef *pdev,
+                                 uint8_t epnum)
 {
-  *length = sizeof(USBD_HID_OtherSpeedCfgDesc);
-  return USBD_HID_OtherSpeedCfgDesc;
-}
+  USBD_HID_HandleTypeDef *hhid;
 
- extern HIDLOP_TransferHandler hHIDTransfer;
+  hhid = USBD_HID_GetHandle(pdev, USBD_HID_GetInstanceByEp(epnum));
+  if (hhid == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  USBD_HID_ProcessOutReport(pdev, hhid, HID_REPORT_TYPE_OUTPUT, hhid->OutReport,
+                            (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum));
+
+  /* Re-arm the endpoint for the next output report */
+  USBD_LL_PrepareReceive(pdev, hhid->Inst->EpOutAddr, hhid->OutReport, HID_EPOUT_SIZE);
+
+  return USBD_OK;
+}
 
 /**
-  * @brief  USBD_HID_DataIn
-  *         handle data IN Stage
+  * @brief  USBD_HID_EP0_RxReady
+  *         handle the data stage of a SET_REPORT request
   * @param  pdev: device instance
-  * @param  epnum: endpoint index
   * @retval status
   */
- uint8_t  USBD_HID_DataIn(USBD_HandleTypeDef *pdev,
-                                uint8_t epnum)
+ uint8_t  USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev)
 {
-  USBD_Composite_HandleTypeDef *compHandle;
-  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
-  /* Ensure that the FIFO is empty before a new transfer, this condition could
-  be caused by  a new transfer before the end of the previous transfer */
-  ((USBD_HID_HandleTypeDef *)compHandle->hid)->state = HID_IDLE;
-  hHIDTransfer.SendNextChar(pdev, &hHIDTransfer);
+  USBD_HID_HandleTypeDef *hhid;
+
+  hhid = USBD_HID_GetHandle(pdev, USBD_HID_GetInstanceByReq(&pdev->request));
+
+  if ((hhid != NULL) && (hhid->CtlReportLength != 0U))
+  {
+    USBD_HID_ProcessOutReport(pdev, hhid, hhid->CtlReportType, hhid->CtlReport,
+                              hhid->CtlReportLength);
+    hhid->CtlReportLength = 0U;
+  }
+
   return USBD_OK;
 }
 
 
 /**
-* @brief  DeviceQualifierDescriptor
-*         return Device Qualifier descriptor
-* @param  length : pointer data length
-* @retval pointer to descriptor buffer
-*/
- uint8_t  *USBD_HID_GetDeviceQualifierDesc(uint16_t *length)
+* @brief  USBD_HID_RegisterInterface
+  * @param  Comp_iops: composite interface callbacks
+  * @param  fops: HID Interface callback
+  * @retval status
+  */
+uint8_t  USBD_HID_RegisterInterface(void   *Comp_iops,
+                                    USBD_HID_ItfTypeDef *fops)
 {
-  *length = sizeof(USBD_HID_DeviceQualifierDesc);
-  return USBD_HID_DeviceQualifierDesc;
+  uint8_t  ret = USBD_FAIL;
+
+  if (fops != NULL)
+  {
+    ((USBD_Comp_ItfTypeDef *)Comp_iops)->HID_ops = fops;
+    ret = USBD_OK;
+  }
+
+  return ret;
 }
 
 /**
@@ -878,7 +1332,7 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev)
   * @}
   */
 
- static void Ascii2Keyboard(uint8_t *KeyBoardBuff, uint8_t AsciiVal);
+ static uint32_t HID_PullMessage(void *Ctx, uint8_t *Buf, uint32_t Len);
  __weak void SendNextCharCallBack(USBD_HandleTypeDef *pdev, HIDLOP_TransferHandler *hTransf);
  __weak void TransferCompletedCallBack(void *ptr);
 
@@ -891,22 +1345,25 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev)
  	.TransferCompletedCallBack = TransferCompletedCallBack,
  	.SendNextChar = SendNextCharCallBack
  };
- uint8_t BufferSend[8] ={1,0,0,0,0,0,0,0};
 
 
  __weak void SendNextCharCallBack(USBD_HandleTypeDef *pdev, HIDLOP_TransferHandler *hTransf)
  {
-	 if(hTransf->RemainingSize == 0)
+	 switch(HID_Typing_Next(&hTransf->Typing))
 	 {
-		 hTransf->HID_StateMachine = LOP_IDLE;
-		 hTransf->MessageSize = 0;
-		 hTransf->TransferCompletedCallBack(NULL);
-	 }
-	 else
-	 {
-		 Ascii2Keyboard(BufferSend, hTransf->TxBuffer[hTransf->MessageSize - hTransf->RemainingSize]);
-		 USBD_HID_SendReport(pdev, BufferSend, 8);
-		 hTransf->RemainingSize--;
+		 case HID_TYPING_REPORT:
+			 USBD_HID_SendReport(pdev, hTransf->Typing.Report, HID_KEYBOARD_REPORT_SIZE);
+			 break;
+
+		 case HID_TYPING_DONE:
+			 hTransf->HID_StateMachine = LOP_IDLE;
+			 hTransf->MessageSize = 0;
+			 hTransf->TransferCompletedCallBack(NULL);
+			 break;
+
+		 default:
+			 /* Source starved, the SOF handler calls again */
+			 break;
 	 }
  }
 
@@ -917,161 +1374,63 @@ uint32_t USBD_HID_GetPollingInterval(USBD_HandleTypeDef *pdev)
 
  HIDLOP_FSM SendMessageHID (USBD_HandleTypeDef *pdev, uint8_t *Buffer, uint32_t SizeOfMsg)
  {
- 	if(hHIDTransfer.HID_StateMachine != LOP_IDLE)
+ 	if((hHIDTransfer.HID_StateMachine != LOP_IDLE) || USBD_HID_Macro_IsBusy())
  		return LOP_BUSY;
  	if(!SizeOfMsg)
  		return LOP_IDLE;
- 	else if(SizeOfMsg == 1)
- 	{
- 		Ascii2Keyboard(BufferSend, Buffer[0]);
- 		USBD_HID_SendReport(pdev, BufferSend, 8);
- 		return LOP_IDLE;
- 	}
  	else
  	{
- 		hHIDTransfer.HID_StateMachine = LOP_BUSY;
+ 		/* The buffer is read through the same window as any other source */
  		hHIDTransfer.TxBuffer = Buffer;
  		hHIDTransfer.MessageSize = SizeOfMsg;
- 		Ascii2Keyboard(BufferSend, Buffer[0]);
- 		USBD_HID_SendReport(pdev, BufferSend, 8);
- 		hHIDTransfer.RemainingSize = SizeOfMsg - 1;
- 		return LOP_OK;
+ 		hHIDTransfer.RemainingSize = SizeOfMsg;
+ 		return SendStreamHID(pdev, HID_PullMessage, &hHIDTransfer);
  	}
  }
 
- static void Ascii2Keyboard(uint8_t *KeyBoardBuff, uint8_t AsciiVal)
+ /**
+   * @brief  SendStreamHID
+   *         Type a text of any length pulled from a source while typing. The
+   *         engine keeps HID_TYPING_WINDOW_SIZE bytes of it, so the memory used
+   *         does not depend on the text. Typing starts on the next SOF
+   * @param  pdev: device instance
+   * @param  Pull: source, called from the USB interrupt
+   * @param  Ctx: passed to Pull
+   * @retval LOP_OK if started, LOP_BUSY if a text or a macro is being typed
+   */
+ HIDLOP_FSM SendStreamHID (USBD_HandleTypeDef *pdev, HIDLOP_PullTypeDef Pull, void *Ctx)
  {
- 	const uint8_t ascii2kbNumbers [10] = {KEY_0_CPARENTHESIS, KEY_1_EXCLAMATION_MARK, KEY_2_AT,
- 		KEY_3_NUMBER_SIGN, KEY_4_DOLLAR, KEY_5_PERCENT, KEY_6_CARET, KEY_7_AMPERSAND,
- 		KEY_8_ASTERISK, KEY_9_OPARENTHESIS};
- 		if((AsciiVal >= 65) && (AsciiVal <= 90))
- 		{
- 			KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 			KeyBoardBuff[4] = AsciiVal - 61;
- 		}
- 		else if((AsciiVal >= 97) && (AsciiVal <= 122))
- 		{
- 			KeyBoardBuff[2] = 0x00;
- 			KeyBoardBuff[4] = AsciiVal - 93;
- 		}
- 		else if((AsciiVal >= 48) && (AsciiVal <= 57))
- 		{
- 			KeyBoardBuff[2] = 0x00;
- 			KeyBoardBuff[4] = ascii2kbNumbers[AsciiVal - 48];
- 		}
- 		else if((AsciiVal == 0x0D) || (AsciiVal == 0x0A))
- 		{
- 			KeyBoardBuff[2] = 0x00;
- 			KeyBoardBuff[4] = KEY_ENTER;
- 			hHIDTransfer.RemainingSize = 0;
- 		}
- 		else
- 			switch(AsciiVal)
- 			{
- 				case(' '):
- 					KeyBoardBuff[2] = 0x00;
- 					KeyBoardBuff[4] = KEY_SPACEBAR;
- 						break;
- 				case('!'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[1];
- 						break;
- 				case('@'):
- 					KeyBoardBuff[2] = KEY_RIGHTALT;
- 					KeyBoardBuff[4] = KEY_Q;
- 						break;
- 				case('#'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[3];
- 						break;
- 				case('$'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[4];
- 						break;
- 				case('%'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[5];
- 						break;
- 				case('&'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[6];
- 						break;
- 				case('/'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[7];
- 						break;
- 				case('('):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[8];
- 						break;
- 				case(')'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[9];
- 						break;
- 				case('='):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 					KeyBoardBuff[4] = ascii2kbNumbers[0];
- 						break;
- 				case('-'):
- 					KeyBoardBuff[2] = 0x00;
- 				//KeyBoardBuff[4] = KEY_MINUS_UNDERSCORE;
- 				KeyBoardBuff[4] = KEY_SLASH_QUESTION;
- 						break;
- 				case('_'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				//KeyBoardBuff[4] = KEY_MINUS_UNDERSCORE;
- 				KeyBoardBuff[4] = KEY_SLASH_QUESTION;
- 						break;
- 				case('"'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = ascii2kbNumbers[2];
- 						break;
- 				case('?'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = KEY_EQUAL_PLUS;
- 						break;
- 				case('['):
- 					KeyBoardBuff[2] = 0x00;
- 				KeyBoardBuff[4] = KEY_OBRACKET_AND_OBRACE;
- 						break;
- 				case('{'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = KEY_OBRACKET_AND_OBRACE;
- 						break;
- 				case(']'):
- 					KeyBoardBuff[2] = 0x00;
- 				KeyBoardBuff[4] = KEY_CBRACKET_AND_CBRACE;
- 						break;
- 				case('}'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = KEY_CBRACKET_AND_CBRACE;
- 						break;
- 				case('*'):
- 					KeyBoardBuff[2] = 0x00;
- 				KeyBoardBuff[4] = KEY_KEYPAD_ASTERIKS;
- 						break;
- 				case('+'):
- 					KeyBoardBuff[2] = 0x00;
- 				KeyBoardBuff[4] = KEY_KEYPAD_PLUS;
- 						break;
- 				case('.'):
- 					KeyBoardBuff[2] = 0x00;
- 				KeyBoardBuff[4] = KEY_DOT_GREATER;
- 						break;
- 				case(':'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = KEY_DOT_GREATER;
- 						break;
- 				case(';'):
- 					KeyBoardBuff[2] = KEY_LEFTSHIFT;
- 				KeyBoardBuff[4] = KEY_COMMA_AND_LESS;
- 						break;
- 				default:
- 					KeyBoardBuff[2] = 0x00;
- 					KeyBoardBuff[4] = KEY_KEYPAD_PERCENT;
- 						break;
-
- 			}
+ 	UNUSED(pdev);
+
+ 	if((hHIDTransfer.HID_StateMachine != LOP_IDLE) || USBD_HID_Macro_IsBusy() || (Pull == NULL))
+ 		return LOP_BUSY;
+
+ 	HID_Typing_Start(&hHIDTransfer.Typing, Pull, Ctx);
+ 	/* Single characters go through the same path so the key gets released */
+ 	__DMB();
+ 	hHIDTransfer.HID_StateMachine = LOP_BUSY;
+ 	return LOP_OK;
+ }
+
+ /**
+   * @brief  HID_PullMessage
+   *         Source of SendMessageHID, reads the caller buffer in place
+   * @param  Ctx: transfer handler
+   * @param  Buf: destination
+   * @param  Len: room in Buf
+   * @retval bytes copied, HID_STREAM_END after the last one
+   */
+ static uint32_t HID_PullMessage(void *Ctx, uint8_t *Buf, uint32_t Len)
+ {
+ 	HIDLOP_TransferHandler *hTransf = (HIDLOP_TransferHandler *)Ctx;
+ 	uint32_t n = MIN(Len, hTransf->RemainingSize);
+
+ 	if(n == 0U)
+ 		return HID_STREAM_END;
+
+ 	(void)memcpy(Buf, &hTransf->TxBuffer[hTransf->MessageSize - hTransf->RemainingSize], n);
+ 	hTransf->RemainingSize -= n;
+ 	return n;
  }
 
 /**
@@ -0,0 +1,89 @@
+/*
+ * usbd_hid_layout.c
+ *
+ *  Created on: 19 oct. 2026
+ */
+
+#include "../Inc/usbd_hid_layout.h"
+
+/* Modifier bits as sent in byte 1 of the keyboard report */
+#define S   (0x02U << 8)  /* Left Shift */
+#define AG  (0x40U << 8)  /* Right Alt (AltGr) */
+
+const uint16_t HID_LayoutTable[HID_NUM_LAYOUTS][HID_LAYOUT_NUM_CHARS] =
+{
+  /* HID_LAYOUT_US */
+  {
+    0x2C,     S|0x1E, S|0x34, S|0x20, S|0x21, S|0x22, S|0x24, 0x34,    /*  !"#$%&' */
+    S|0x26,   S|0x27, S|0x25, S|0x2E, 0x36,   0x2D,   0x37,   0x38,    /* ()*+,-./ */
+    0x27,     0x1E,   0x1F,   0x20,   0x21,   0x22,   0x23,   0x24,    /* 01234567 */
+    0x25,     0x26,   S|0x33, 0x33,   S|0x36, 0x2E,   S|0x37, S|0x38,  /* 89:;<=>? */
+    S|0x1F,   S|0x04, S|0x05, S|0x06, S|0x07, S|0x08, S|0x09, S|0x0A,  /* @ABCDEFG */
+    S|0x0B,   S|0x0C, S|0x0D, S|0x0E, S|0x0F, S|0x10, S|0x11, S|0x12,  /* HIJKLMNO */
+    S|0x13,   S|0x14, S|0x15, S|0x16, S|0x17, S|0x18, S|0x19, S|0x1A,  /* PQRSTUVW */
+    S|0x1B,   S|0x1C, S|0x1D, 0x2F,   0x31,   0x30,   S|0x23, S|0x2D,  /* XYZ[\]^_ */
+    0x35,     0x04,   0x05,   0x06,   0x07,   0x08,   0x09,   0x0A,    /* `abcdefg */
+    0x0B,     0x0C,   0x0D,   0x0E,   0x0F,   0x10,   0x11,   0x12,    /* hijklmno */
+    0x13,     0x14,   0x15,   0x16,   0x17,   0x18,   0x19,   0x1A,    /* pqrstuvw */
+    0x1B,     0x1C,   0x1D,   S|0x2F, S|0x31, S|0x30, S|0x35,          /* xyz{|}~  */
+  },
+  /* HID_LAYOUT_ES, ^ ` ~ are dead keys */
+  {
+    0x2C,     S|0x1E, S|0x1F, AG|0x20, S|0x21, S|0x22, S|0x23, 0x2D,   /*  !"#$%&' */
+    S|0x25,   S|0x26, S|0x30, 0x30,    0x36,   0x38,   0x37,   S|0x24, /* ()*+,-./ */
+    0x27,     0x1E,   0x1F,   0x20,    0x21,   0x22,   0x23,   0x24,   /* 01234567 */
+    0x25,     0x26,   S|0x37, S|0x36,  0x64,   S|0x27, S|0x64, S|0x2D, /* 89:;<=>? */
+    AG|0x1F,  S|0x04, S|0x05, S|0x06,  S|0x07, S|0x08, S|0x09, S|0x0A, /* @ABCDEFG */
+    S|0x0B,   S|0x0C, S|0x0D, S|0x0E,  S|0x0F, S|0x10, S|0x11, S|0x12, /* HIJKLMNO */
+    S|0x13,   S|0x14, S|0x15, S|0x16,  S|0x17, S|0x18, S|0x19, S|0x1A, /* PQRSTUVW */
+    S|0x1B,   S|0x1C, S|0x1D, AG|0x2F, AG|0x35, AG|0x30, 0x00,  S|0x38, /* XYZ[\]^_ */
+    0x00,     0x04,   0x05,   0x06,    0x07,   0x08,   0x09,   0x0A,   /* `abcdefg */
+    0x0B,     0x0C,   0x0D,   0x0E,    0x0F,   0x10,   0x11,   0x12,   /* hijklmno */
+    0x13,     0x14,   0x15,   0x16,    0x17,   0x18,   0x19,   0x1A,   /* pqrstuvw */
+    0x1B,     0x1C,   0x1D,   AG|0x34, AG|0x1E, AG|0x32, 0x00,         /* xyz{|}~  */
+  },
+};
+
+#undef S
+#undef AG
+
+/**
+  * @brief  HID_Layout_Lookup
+  *         Key and modifiers typing a character on the given host layout
+  * @param  layout: HID_LAYOUT_US, HID_LAYOUT_ES
+  * @param  ascii: character, printable or \n \r \t \b ESC
+  * @retval table entry, 0 if the character has no single key
+  */
+uint16_t HID_Layout_Lookup(uint8_t layout, uint8_t ascii)
+{
+  if (layout >= HID_NUM_LAYOUTS)
+  {
+    return 0U;
+  }
+
+  switch (ascii)
+  {
+    case '\r':
+    case '\n':
+      return 0x28U; /* Enter */
+
+    case '\t':
+      return 0x2BU; /* Tab */
+
+    case '\b':
+      return 0x2AU; /* Backspace */
+
+    case 0x1BU:
+      return 0x29U; /* Escape */
+
+    default:
+      break;
+  }
+
+  if ((ascii < HID_LAYOUT_FIRST_CHAR) || (ascii > HID_LAYOUT_LAST_CHAR))
+  {
+    return 0U;
+  }
+
+  return HID_LayoutTable[layout][ascii - HID_LAYOUT_FIRST_CHAR];
+}
@@ -0,0 +1,329 @@
+/*
+ * usbd_hid_macro.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Playback of precompiled keyboard macros (see usbd_hid_macro.h). Frames go
+ *  through USBD_HID_SendReport so they share the fair arbiter with the other
+ *  channels; the engine advances on HID DataIn and counts delays in SOFs.
+ */
+
+#include "../Inc/usbd_hid_macro.h"
+#include "../Inc/usbd_hid.h"
+#include "../Inc/usbd_hid_layout.h"
+
+static void HID_Macro_Step(USBD_HandleTypeDef *pdev);
+static uint8_t HID_Macro_SendKey(USBD_HandleTypeDef *pdev, uint8_t mods, uint8_t usage);
+static void HID_Macro_Finish(void);
+
+extern HIDLOP_TransferHandler hHIDTransfer;
+
+static HID_MacroTypeDef hHIDMacro;
+
+/* Operand bytes following each opcode, REPORT adds its own length */
+static const uint8_t HID_Macro_OperandSize[] =
+{
+  0U, /* END */
+  1U, /* REPORT */
+  2U, /* KEY */
+  2U, /* DELAY */
+  1U, /* HOLD */
+  1U, /* RELEASE */
+  1U, /* LAYOUT */
+  1U, /* CHAR */
+};
+
+/**
+  * @brief  USBD_HID_Macro_Play
+  *         Start playing a macro program
+  * @param  pdev: device instance
+  * @param  program: bytecode, usually a const array in flash
+  * @param  length: program size in bytes
+  * @retval USBD_OK, USBD_BUSY if a macro or a text is being typed,
+  *         USBD_FAIL if the header is not valid
+  */
+uint8_t USBD_HID_Macro_Play(USBD_HandleTypeDef *pdev,
+                            const uint8_t *program,
+                            uint32_t length)
+{
+  uint32_t primask;
+
+  if ((program == NULL) || (length <= HID_MACRO_HEADER_SIZE) ||
+      (program[0] != HID_MACRO_MAGIC_0) || (program[1] != HID_MACRO_MAGIC_1) ||
+      (program[2] != HID_MACRO_VERSION))
+  {
+    return USBD_FAIL;
+  }
+
+  /* Both engines press keys on the keyboard channel */
+  if ((hHIDMacro.State != HID_MACRO_IDLE) || (hHIDTransfer.HID_StateMachine != LOP_IDLE))
+  {
+    return USBD_BUSY;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  hHIDMacro.Program = program;
+  hHIDMacro.Length = length;
+  hHIDMacro.Pc = HID_MACRO_HEADER_SIZE;
+  hHIDMacro.Delay = 0U;
+  hHIDMacro.Held = 0U;
+  hHIDMacro.Layout = HID_LAYOUT_US;
+  hHIDMacro.ReleasePending = 0U;
+  hHIDMacro.State = HID_MACRO_RUNNING;
+
+  HID_Macro_Step(pdev);
+
+  __set_PRIMASK(primask);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Macro_Stop
+  *         Abort playback and release every key
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_HID_Macro_Stop(USBD_HandleTypeDef *pdev)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if (hHIDMacro.State != HID_MACRO_IDLE)
+  {
+    hHIDMacro.State = HID_MACRO_IDLE;
+    hHIDMacro.Held = 0U;
+    (void)HID_Macro_SendKey(pdev, 0U, 0U);
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  USBD_HID_Macro_IsBusy
+  * @retval 1 while a macro is playing
+  */
+uint8_t USBD_HID_Macro_IsBusy(void)
+{
+  return (hHIDMacro.State != HID_MACRO_IDLE) ? 1U : 0U;
+}
+
+/**
+  * @brief  USBD_HID_Macro_DataIn
+  *         A report went out, queue the next frame. Called from the USB interrupt
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_HID_Macro_DataIn(USBD_HandleTypeDef *pdev)
+{
+  if ((hHIDMacro.State == HID_MACRO_RUNNING) && (hHIDMacro.Delay == 0U))
+  {
+    HID_Macro_Step(pdev);
+  }
+}
+
+/**
+  * @brief  USBD_HID_Macro_SOF
+  *         Count delays and retry a frame the queue had no room for.
+  *         Called from the USB interrupt every frame
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_HID_Macro_SOF(USBD_HandleTypeDef *pdev)
+{
+  if (hHIDMacro.State != HID_MACRO_RUNNING)
+  {
+    return;
+  }
+
+  if (hHIDMacro.Delay != 0U)
+  {
+    hHIDMacro.Delay--;
+  }
+
+  if (hHIDMacro.Delay == 0U)
+  {
+    HID_Macro_Step(pdev);
+  }
+}
+
+/**
+  * @brief  HID_Macro_Step
+  *         Execute opcodes until one frame is queued, a delay starts, the
+  *         keyboard queue is full or the program ends
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void HID_Macro_Step(USBD_HandleTypeDef *pdev)
+{
+  const uint8_t *op;
+  uint16_t entry;
+  uint8_t status;
+  uint8_t yield;
+  uint32_t size;
+
+  while (hHIDMacro.State == HID_MACRO_RUNNING)
+  {
+    if (hHIDMacro.ReleasePending != 0U)
+    {
+      status = HID_Macro_SendKey(pdev, 0U, 0U);
+      if (status == USBD_OK)
+      {
+        hHIDMacro.ReleasePending = 0U;
+      }
+      break;
+    }
+
+    op = &hHIDMacro.Program[hHIDMacro.Pc];
+
+    if (op[0] >= sizeof(HID_Macro_OperandSize))
+    {
+      HID_Macro_Finish();
+      break;
+    }
+
+    size = 1U + HID_Macro_OperandSize[op[0]];
+    if (op[0] == HID_MACRO_OP_REPORT)
+    {
+      size += op[1];
+    }
+
+    /* Truncated program */
+    if ((hHIDMacro.Pc + size) > hHIDMacro.Length)
+    {
+      HID_Macro_Finish();
+      break;
+    }
+
+    status = USBD_OK;
+    /* One frame or one delay per call keeps the interrupt short */
+    yield = 1U;
+
+    switch (op[0])
+    {
+      case HID_MACRO_OP_REPORT:
+        if ((op[1] == 0U) || (op[1] > HID_MACRO_MAX_FRAME))
+        {
+          status = USBD_FAIL;
+        }
+        else
+        {
+          status = USBD_HID_SendReport(pdev, (uint8_t *)&op[2], op[1]);
+        }
+        break;
+
+      case HID_MACRO_OP_KEY:
+        status = HID_Macro_SendKey(pdev, op[1], op[2]);
+        hHIDMacro.ReleasePending = (status == USBD_OK) ? 1U : 0U;
+        break;
+
+      case HID_MACRO_OP_DELAY:
+        hHIDMacro.Delay = (uint16_t)(op[1] | ((uint16_t)op[2] << 8));
+        break;
+
+      case HID_MACRO_OP_HOLD:
+        status = HID_Macro_SendKey(pdev, op[1], 0U);
+        if (status == USBD_OK)
+        {
+          hHIDMacro.Held |= op[1];
+        }
+        break;
+
+      case HID_MACRO_OP_RELEASE:
+        hHIDMacro.Held &= (uint8_t)~op[1];
+        status = HID_Macro_SendKey(pdev, 0U, 0U);
+        if (status == USBD_BUSY)
+        {
+          hHIDMacro.Held |= op[1];
+        }
+        break;
+
+      case HID_MACRO_OP_LAYOUT:
+        hHIDMacro.Layout = op[1];
+        yield = 0U;
+        break;
+
+      case HID_MACRO_OP_CHAR:
+        entry = HID_Layout_Lookup(hHIDMacro.Layout, op[1]);
+        /* Characters the layout cannot type are skipped */
+        if (entry != 0U)
+        {
+          status = HID_Macro_SendKey(pdev, HID_LAYOUT_MOD(entry), HID_LAYOUT_USAGE(entry));
+          hHIDMacro.ReleasePending = (status == USBD_OK) ? 1U : 0U;
+        }
+        else
+        {
+          yield = 0U;
+        }
+        break;
+
+      default: /* HID_MACRO_OP_END */
+        HID_Macro_Finish();
+        return;
+    }
+
+    if (status == USBD_BUSY)
+    {
+      /* Queue full, the same opcode is retried on the next DataIn or SOF */
+      break;
+    }
+    if (status != USBD_OK)
+    {
+      HID_Macro_Finish();
+      break;
+    }
+
+    hHIDMacro.Pc += size;
+
+    if (yield != 0U)
+    {
+      break;
+    }
+  }
+}
+
+/**
+  * @brief  HID_Macro_SendKey
+  *         Queue a keyboard frame with the held modifiers
+  * @param  pdev: device instance
+  * @param  mods: modifiers added to the held ones
+  * @param  usage: key usage, 0 for none
+  * @retval USBD_SendReport status
+  */
+static uint8_t HID_Macro_SendKey(USBD_HandleTypeDef *pdev, uint8_t mods, uint8_t usage)
+{
+  uint8_t report[HID_KEYBOARD_REPORT_SIZE] = {HID_REPORT_ID_KEYBOARD, 0U, 0U, 0U, 0U, 0U, 0U, 0U};
+
+  report[1] = (uint8_t)(hHIDMacro.Held | mods);
+  report[3] = usage;
+
+  return USBD_HID_SendReport(pdev, report, HID_KEYBOARD_REPORT_SIZE);
+}
+
+/**
+  * @brief  HID_Macro_Finish
+  *         End of program or invalid opcode
+  * @retval None
+  */
+static void HID_Macro_Finish(void)
+{
+  const uint8_t *program = hHIDMacro.Program;
+
+  hHIDMacro.State = HID_MACRO_IDLE;
+  USBD_HID_Macro_CompletedCallback(program);
+}
+
+/**
+  * @brief  USBD_HID_Macro_CompletedCallback
+  *         Called from the USB interrupt when a program ends
+  * @param  program: the program that was playing
+  * @retval None
+  */
+__weak void USBD_HID_Macro_CompletedCallback(const uint8_t *program)
+{
+  UNUSED(program);
+}
@@ -0,0 +1,430 @@
+/*
+ * usbd_hid_pointer.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Motion from the application is accumulated at any rate and merged into
+ *  one report per host poll. Each report carries as much of the accumulated
+ *  motion as the report fields can hold, the rest stays for the next poll,
+ *  so motion is delayed at worst but never lost. A button pressed and
+ *  released between two polls is still reported as a click.
+ */
+
+#include "../Inc/usbd_hid_pointer.h"
+#include "usbd_ctlreq.h"
+#include "../../Composite/Inc/Composite.h"
+
+uint8_t USBD_HID_Pointer_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_HID_Pointer_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_HID_Pointer_Setup(USBD_HandleTypeDef *pdev,
+                               USBD_SetupReqTypedef *req);
+uint8_t USBD_HID_Pointer_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+static void USBD_HID_Pointer_Load(USBD_HandleTypeDef *pdev,
+                                  USBD_HID_Pointer_HandleTypeDef *hptr);
+
+/* USB HID pointer Descriptor, same as in the configuration descriptor */
+__ALIGN_BEGIN static const uint8_t USBD_HID_Pointer_Desc[USB_HID_DESC_SIZ]  __ALIGN_END  =
+{
+  COMP_POINTER_CS(COMP_DESC_CS_BYTES)
+};
+
+__ALIGN_BEGIN static const uint8_t HID_POINTER_ReportDesc[HID_POINTER_REPORT_DESC_SIZE]  __ALIGN_END =
+{
+  HID_RD_BYTES(HID_POINTER_REPORT_DESC)
+};
+
+/* Callbacks of the pointer function, dispatched by the composite router */
+USBD_ClassTypeDef  USBD_HID_POINTER =
+{
+  USBD_HID_Pointer_Init,
+  USBD_HID_Pointer_DeInit,
+  USBD_HID_Pointer_Setup,
+  NULL, /*EP0_TxSent*/
+  NULL, /*EP0_RxReady*/
+  USBD_HID_Pointer_DataIn, /*DataIn*/
+  NULL, /*DataOut*/
+  NULL, /*SOF */
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+/**
+  * @brief  USBD_HID_Pointer_Init
+  *         Initialize the pointer interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  USBD_HID_Pointer_HandleTypeDef *hptr;
+
+  /* The composite layer has opened the endpoint */
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  compHandle->pointer = USBD_malloc_Type(USBD_HID_Pointer_HandleTypeDef, 1U);
+
+  if (compHandle->pointer == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+  (void)memset(hptr, 0, sizeof(USBD_HID_Pointer_HandleTypeDef));
+  hptr->Protocol = 1U;
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_DeInit
+  *         DeInitialize the pointer interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  if (compHandle->pointer != NULL)
+  {
+    USBD_free(compHandle->pointer);
+    compHandle->pointer = NULL;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_Setup
+  *         Handle the requests addressed to the pointer interface
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_Setup(USBD_HandleTypeDef *pdev,
+                               USBD_SetupReqTypedef *req)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_HID_Pointer_HandleTypeDef *hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+  uint16_t len = 0U;
+  const uint8_t *pbuf = NULL;
+  uint16_t status_info = 0U;
+  USBD_StatusTypeDef ret = USBD_OK;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS :
+      switch (req->bRequest)
+      {
+        case HID_REQ_SET_PROTOCOL:
+          hptr->Protocol = (uint8_t)(req->wValue);
+          break;
+
+        case HID_REQ_GET_PROTOCOL:
+          USBD_CtlSendData(pdev, (uint8_t *)(void *)&hptr->Protocol, 1U);
+          break;
+
+        case HID_REQ_SET_IDLE:
+          /* Relative motion is only reported on change */
+          hptr->IdleState = (uint8_t)(req->wValue >> 8);
+          break;
+
+        case HID_REQ_GET_IDLE:
+          USBD_CtlSendData(pdev, (uint8_t *)(void *)&hptr->IdleState, 1U);
+          break;
+
+        case HID_REQ_GET_REPORT:
+          /* No pending motion, only the buttons */
+          if ((HIBYTE(req->wValue) == HID_REPORT_TYPE_INPUT) &&
+              (LOBYTE(req->wValue) == HID_POINTER_REPORT_ID_RELATIVE))
+          {
+            (void)memset(hptr->Report, 0, sizeof(hptr->Report));
+            hptr->Report[0] = HID_POINTER_REPORT_ID_RELATIVE;
+            HID_POINTER_REL_BUTTONS_SetAll(hptr->Report, hptr->ButtonsSent);
+            USBD_CtlSendData(pdev, hptr->Report,
+                             MIN(HID_POINTER_RELATIVE_REPORT_SIZE, req->wLength));
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_DESCRIPTOR:
+          if (req->wValue >> 8 == HID_REPORT_DESC)
+          {
+            len = MIN(HID_POINTER_REPORT_DESC_SIZE, req->wLength);
+            pbuf = HID_POINTER_ReportDesc;
+          }
+          else if (req->wValue >> 8 == HID_DESCRIPTOR_TYPE)
+          {
+            pbuf = USBD_HID_Pointer_Desc;
+            len = MIN(USB_HID_DESC_SIZ, req->wLength);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+            break;
+          }
+          USBD_CtlSendData(pdev, pbuf, len);
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&hptr->AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            hptr->AltSetting = (uint8_t)(req->wValue);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          /* Endpoint halt, cleared by the core */
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_DataIn
+  *         The host took the loaded report, load the next one if any
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_HID_Pointer_HandleTypeDef *hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+
+  hptr->Busy = 0U;
+  USBD_HID_Pointer_Load(pdev, hptr);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_Move
+  *         Add relative motion, may be called at any rate from any context
+  * @param  pdev: device instance
+  * @param  dx: horizontal motion
+  * @param  dy: vertical motion
+  * @param  wheel: wheel detents
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_Move(USBD_HandleTypeDef *pdev,
+                              int32_t dx, int32_t dy, int32_t wheel)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_HID_Pointer_HandleTypeDef *hptr;
+  uint32_t primask;
+
+  if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (compHandle->pointer == NULL))
+  {
+    return USBD_FAIL;
+  }
+  hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  hptr->AccX = HID_Pointer_Add(hptr->AccX, dx);
+  hptr->AccY = HID_Pointer_Add(hptr->AccY, dy);
+  hptr->AccWheel = HID_Pointer_Add(hptr->AccWheel, wheel);
+  USBD_HID_Pointer_Load(pdev, hptr);
+
+  __set_PRIMASK(primask);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_SetButtons
+  *         Set the relative pointer buttons
+  * @param  pdev: device instance
+  * @param  buttons: POINTER_BUTTON_LEFT | POINTER_BUTTON_RIGHT | ...
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_SetButtons(USBD_HandleTypeDef *pdev, uint8_t buttons)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_HID_Pointer_HandleTypeDef *hptr;
+  uint32_t primask;
+
+  if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (compHandle->pointer == NULL))
+  {
+    return USBD_FAIL;
+  }
+  hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  hptr->Buttons = buttons;
+  hptr->ButtonsLatch |= buttons;
+  USBD_HID_Pointer_Load(pdev, hptr);
+
+  __set_PRIMASK(primask);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_MoveTo
+  *         Report an absolute position, the latest one wins
+  * @param  pdev: device instance
+  * @param  x: 0..HID_POINTER_ABSOLUTE_MAX
+  * @param  y: 0..HID_POINTER_ABSOLUTE_MAX
+  * @param  buttons: POINTER_BUTTON_LEFT | ...
+  * @retval status
+  */
+uint8_t USBD_HID_Pointer_MoveTo(USBD_HandleTypeDef *pdev,
+                                uint16_t x, uint16_t y, uint8_t buttons)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_HID_Pointer_HandleTypeDef *hptr;
+  uint32_t primask;
+
+  if ((pdev->dev_state != USBD_STATE_CONFIGURED) || (compHandle->pointer == NULL))
+  {
+    return USBD_FAIL;
+  }
+  hptr = (USBD_HID_Pointer_HandleTypeDef *)compHandle->pointer;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  hptr->AbsX = (uint16_t)MIN(x, HID_POINTER_ABSOLUTE_MAX);
+  hptr->AbsY = (uint16_t)MIN(y, HID_POINTER_ABSOLUTE_MAX);
+  hptr->AbsButtons = buttons;
+  hptr->AbsPending = 1U;
+  USBD_HID_Pointer_Load(pdev, hptr);
+
+  __set_PRIMASK(primask);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Pointer_Load
+  *         Build the next report from the accumulated state and load it on
+  *         the IN endpoint, nothing is sent when nothing changed.
+  *         Called from the USB interrupt or with interrupts disabled
+  * @param  pdev: device instance
+  * @param  hptr: pointer handle
+  * @retval None
+  */
+static void USBD_HID_Pointer_Load(USBD_HandleTypeDef *pdev,
+                                  USBD_HID_Pointer_HandleTypeDef *hptr)
+{
+  uint8_t buttons;
+  int32_t dx;
+  int32_t dy;
+  uint16_t size;
+
+  if (hptr->Busy != 0U)
+  {
+    return;
+  }
+
+  buttons = (uint8_t)(hptr->Buttons | hptr->ButtonsLatch);
+
+  if (hptr->AbsPending != 0U)
+  {
+    hptr->Report[0] = HID_POINTER_REPORT_ID_ABSOLUTE;
+    HID_POINTER_ABS_BUTTONS_SetAll(hptr->Report, hptr->AbsButtons);
+    HID_POINTER_ABS_XY_Set(hptr->Report, 0U, hptr->AbsX);
+    HID_POINTER_ABS_XY_Set(hptr->Report, 1U, hptr->AbsY);
+    hptr->AbsPending = 0U;
+    size = HID_POINTER_ABSOLUTE_REPORT_SIZE;
+  }
+  else if ((hptr->AccX != 0) || (hptr->AccY != 0) || (hptr->AccWheel != 0) ||
+           (buttons != hptr->ButtonsSent))
+  {
+    dx = HID_Pointer_Take(&hptr->AccX, HID_POINTER_DELTA_MAX);
+    dy = HID_Pointer_Take(&hptr->AccY, HID_POINTER_DELTA_MAX);
+
+    hptr->Report[0] = HID_POINTER_REPORT_ID_RELATIVE;
+    HID_POINTER_REL_BUTTONS_SetAll(hptr->Report, buttons);
+    HID_POINTER_REL_XY_Set(hptr->Report, 0U, (uint32_t)dx);
+    HID_POINTER_REL_XY_Set(hptr->Report, 1U, (uint32_t)dy);
+    HID_POINTER_REL_WHEEL_Set(hptr->Report, 0U,
+                              (uint32_t)HID_Pointer_Take(&hptr->AccWheel, HID_POINTER_WHEEL_MAX));
+
+    /* A release seen only through the latch goes out with the next report */
+    hptr->ButtonsSent = buttons;
+    hptr->ButtonsLatch = 0U;
+    size = HID_POINTER_RELATIVE_REPORT_SIZE;
+  }
+  else
+  {
+    return;
+  }
+
+  hptr->Busy = 1U;
+  USBD_LL_Transmit(pdev, HID_POINTER_EPIN_ADDR, hptr->Report, size);
+}
@@ -0,0 +1,417 @@
+/*
+ * usbd_hid_typing.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Typing engine of SendMessageHID and SendStreamHID. The text is pulled
+ *  from its source into a small lookahead window and turned into one
+ *  keyboard report per call, usbd_hid.c sends it. Plain C with no USB
+ *  library dependency so the host tools run the same engine
+ *  (HID_TYPING_HOST_TOOL).
+ */
+
+#include "../Inc/usbd_hid.h"
+
+#include <string.h>
+
+static void HID_FillWindow(HID_TypingTypeDef *Typing);
+static uint8_t HID_KeyHeld(const HID_TypingTypeDef *Typing, uint8_t Key);
+static uint32_t HID_TypeKeys(HID_TypingTypeDef *Typing);
+static uint32_t HID_TypeUnicode(HID_TypingTypeDef *Typing, uint8_t *Sent);
+static void HID_ReleaseKeys(HID_TypingTypeDef *Typing);
+static void HID_ApplyLocks(uint8_t *KeyBoardBuff, uint8_t AsciiVal);
+static void Ascii2Keyboard(uint8_t *KeyBoardBuff, uint8_t AsciiVal);
+
+/* Modifiers toggled on letters for the host Caps Lock state, set when the
+   LED report changes so the next report already follows it */
+static const uint8_t TypingCaseFlip[2] = {0x00U, MODIFERKEYS_LEFT_SHIFT};
+static uint8_t TypingCaseMap = 0U;
+
+/**
+  * @brief  HID_Typing_Start
+  *         Start a text, nothing is pulled before the first HID_Typing_Next
+  * @param  Typing: engine state
+  * @param  Pull: source of the text
+  * @param  Ctx: passed to Pull
+  * @retval None
+  */
+void HID_Typing_Start(HID_TypingTypeDef *Typing, HIDLOP_PullTypeDef Pull, void *Ctx)
+{
+  Typing->Pull = Pull;
+  Typing->PullCtx = Ctx;
+  Typing->WindowCount = 0U;
+  Typing->SourceEnd = 0U;
+  Typing->Seq = NULL;
+  Typing->SeqStep = 0U;
+  Typing->SeqBytes = 0U;
+  (void)memset(Typing->Report, 0, sizeof(Typing->Report));
+  Typing->Report[0] = HID_REPORT_ID_KEYBOARD;
+}
+
+/**
+  * @brief  HID_Typing_Next
+  *         Build the next keyboard report of the text
+  * @param  Typing: engine state
+  * @retval HID_TYPING_REPORT: send Typing->Report
+  *         HID_TYPING_WAIT: the source has nothing yet, call again later
+  *         HID_TYPING_DONE: the text is typed and every key released
+  */
+HID_TypingStatusTypeDef HID_Typing_Next(HID_TypingTypeDef *Typing)
+{
+  uint32_t used;
+  uint8_t sent = 1U;
+
+  HID_FillWindow(Typing);
+
+  if (Typing->WindowCount == 0U)
+  {
+    if (Typing->SourceEnd == 0U)
+    {
+      return HID_TYPING_WAIT;
+    }
+    /* Release the last key before reporting the end of the text */
+    if (Typing->Report[3] != 0x00U)
+    {
+      HID_ReleaseKeys(Typing);
+      return HID_TYPING_REPORT;
+    }
+    Typing->Pull = NULL;
+    return HID_TYPING_DONE;
+  }
+
+  if (Typing->Window[0] < 0x80U)
+  {
+    used = HID_TypeKeys(Typing);
+  }
+  else
+  {
+    used = HID_TypeUnicode(Typing, &sent);
+  }
+
+  if (used != 0U)
+  {
+    Typing->WindowCount -= (uint8_t)used;
+    (void)memmove(Typing->Window, &Typing->Window[used], Typing->WindowCount);
+  }
+
+  return (sent != 0U) ? HID_TYPING_REPORT : HID_TYPING_WAIT;
+}
+
+/**
+  * @brief  HID_Typing_SetLocks
+  *         Select the case mapping for the host Caps Lock LED and the Unicode
+  *         digits for its Num Lock LED. Called from the LED output report, a
+  *         change applies from the next character without extra reports
+  * @param  leds: LED_NUM_LOCK | LED_CAPS_LOCK ...
+  * @retval None
+  */
+void HID_Typing_SetLocks(uint8_t leds)
+{
+  TypingCaseMap = ((leds & LED_CAPS_LOCK) != 0U) ? 1U : 0U;
+  HID_Unicode_SetNumLock(leds & LED_NUM_LOCK);
+}
+
+/**
+  * @brief  HID_FillWindow
+  *         Top up the lookahead window from the source
+  * @param  Typing: engine state
+  * @retval None
+  */
+static void HID_FillWindow(HID_TypingTypeDef *Typing)
+{
+  uint32_t n;
+
+  /* A source may give its text in pieces, e.g. one receive buffer a call */
+  while ((Typing->SourceEnd == 0U) && (Typing->WindowCount < HID_TYPING_WINDOW_SIZE))
+  {
+    n = Typing->Pull(Typing->PullCtx, &Typing->Window[Typing->WindowCount],
+                     HID_TYPING_WINDOW_SIZE - Typing->WindowCount);
+    if (n == HID_STREAM_END)
+    {
+      Typing->SourceEnd = 1U;
+    }
+    else if (n == 0U)
+    {
+      break;
+    }
+    else
+    {
+      Typing->WindowCount += (uint8_t)n;
+    }
+  }
+}
+
+/**
+  * @brief  HID_KeyHeld
+  * @param  Typing: engine state
+  * @param  Key: usage of a key
+  * @retval 1 if the last report still presses the key
+  */
+static uint8_t HID_KeyHeld(const HID_TypingTypeDef *Typing, uint8_t Key)
+{
+  return ((Key != 0x00U) &&
+          (memchr(&Typing->Report[3], Key, HID_KEYBOARD_REPORT_SIZE - 3U) != NULL)) ? 1U : 0U;
+}
+
+/**
+  * @brief  HID_ReleaseKeys
+  *         Make the next report release every key and modifier
+  * @param  Typing: engine state
+  * @retval None
+  */
+static void HID_ReleaseKeys(HID_TypingTypeDef *Typing)
+{
+  (void)memset(&Typing->Report[1], 0, HID_KEYBOARD_REPORT_SIZE - 1U);
+}
+
+/**
+  * @brief  HID_TypeKeys
+  *         Press the keys of the next characters of the window. A key still
+  *         pressed by the previous report would not be seen again, so it is
+  *         released first and the character only consumed on the next call.
+  *         Up to HID_TYPING_KEYS_PER_REPORT following characters with the
+  *         same modifiers and distinct keys are pressed by the same report
+  * @param  Typing: engine state, the window starts with an ASCII byte
+  * @retval characters consumed, 0 if a release was built instead
+  */
+static uint32_t HID_TypeKeys(HID_TypingTypeDef *Typing)
+{
+  const uint8_t *text = Typing->Window;
+  uint8_t report[HID_KEYBOARD_REPORT_SIZE] = {HID_REPORT_ID_KEYBOARD, 0, 0, 0, 0, 0, 0, 0};
+  uint8_t next[HID_KEYBOARD_REPORT_SIZE];
+  uint32_t n;
+
+  Ascii2Keyboard(report, text[0]);
+  HID_ApplyLocks(report, text[0]);
+  if (HID_KeyHeld(Typing, report[3]) != 0U)
+  {
+    HID_ReleaseKeys(Typing);
+    return 0U;
+  }
+
+  for (n = 1U; (n < HID_TYPING_KEYS_PER_REPORT) && (n < Typing->WindowCount) && (text[n] < 0x80U); n++)
+  {
+    (void)memset(next, 0, sizeof(next));
+    Ascii2Keyboard(next, text[n]);
+    HID_ApplyLocks(next, text[n]);
+    if ((report[3] == 0x00U) || (next[3] == 0x00U) || (next[1] != report[1]) ||
+        (HID_KeyHeld(Typing, next[3]) != 0U) || (memchr(&report[3], next[3], n) != NULL))
+    {
+      break;
+    }
+    report[3U + n] = next[3];
+  }
+
+  (void)memcpy(Typing->Report, report, HID_KEYBOARD_REPORT_SIZE);
+  return n;
+}
+
+/**
+  * @brief  HID_TypeUnicode
+  *         Build the next report of the host input method sequence of a UTF-8
+  *         character, the sequence comes from the compiled-sequence cache
+  * @param  Typing: engine state, the window starts with the first byte of
+  *         the character
+  * @param  Sent: set to 0 when no report was built
+  * @retval bytes of the window consumed, 0 while the sequence is not finished
+  */
+static uint32_t HID_TypeUnicode(HID_TypingTypeDef *Typing, uint8_t *Sent)
+{
+  uint32_t cp;
+  uint16_t step;
+
+  if (Typing->Seq == NULL)
+  {
+    Typing->SeqBytes = HID_Unicode_Decode(Typing->Window, Typing->WindowCount, &cp);
+    if (Typing->SeqBytes == 0U)
+    {
+      /* Character cut by the end of the text, drop it. Otherwise the rest
+         has not been pulled yet, wait for it */
+      *Sent = 0U;
+      return (Typing->SourceEnd != 0U) ? Typing->WindowCount : 0U;
+    }
+    Typing->Seq = HID_Unicode_Get(cp);
+    Typing->SeqStep = 0U;
+
+    /* Same as a repeated key: the first step may press the key of the
+       previous character, e.g. Ctrl+Shift+U after 'u' */
+    if (HID_KeyHeld(Typing, (uint8_t)(Typing->Seq->Step[0] & 0xFFU)) != 0U)
+    {
+      HID_ReleaseKeys(Typing);
+      return 0U;
+    }
+  }
+
+  /* Consecutive steps always differ, none of them is dropped as a duplicate */
+  step = Typing->Seq->Step[Typing->SeqStep++];
+  HID_ReleaseKeys(Typing);
+  Typing->Report[1] = (uint8_t)(step >> 8);
+  Typing->Report[3] = (uint8_t)(step & 0xFFU);
+
+  if (Typing->SeqStep < Typing->Seq->Length)
+  {
+    return 0U;
+  }
+
+  HID_Unicode_CountReports(Typing->Seq->Length);
+  Typing->Seq = NULL;
+  return Typing->SeqBytes;
+}
+
+/**
+  * @brief  HID_ApplyLocks
+  *         Invert Shift on letters while the host has Caps Lock on. macOS
+  *         ignores Shift under Caps Lock, lowercase stays uppercase there
+  * @param  KeyBoardBuff: report built by Ascii2Keyboard
+  * @param  AsciiVal: character of the report
+  * @retval None
+  */
+static void HID_ApplyLocks(uint8_t *KeyBoardBuff, uint8_t AsciiVal)
+{
+  if (((AsciiVal | 0x20U) >= 'a') && ((AsciiVal | 0x20U) <= 'z'))
+  {
+    HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff,
+        HID_KEYBOARD_MODIFIERS_GetAll(KeyBoardBuff) ^ TypingCaseFlip[TypingCaseMap]);
+  }
+}
+
+/**
+  * @brief  Ascii2Keyboard
+  *         Key and modifiers of an ASCII character, unknown ones as keypad '%'
+  * @param  KeyBoardBuff: keyboard report
+  * @param  AsciiVal: character
+  * @retval None
+  */
+ static void Ascii2Keyboard(uint8_t *KeyBoardBuff, uint8_t AsciiVal)
+ {
+ 	const uint8_t ascii2kbNumbers [10] = {KEY_0_CPARENTHESIS, KEY_1_EXCLAMATION_MARK, KEY_2_AT,
+ 		KEY_3_NUMBER_SIGN, KEY_4_DOLLAR, KEY_5_PERCENT, KEY_6_CARET, KEY_7_AMPERSAND,
+ 		KEY_8_ASTERISK, KEY_9_OPARENTHESIS};
+ 		if((AsciiVal >= 65) && (AsciiVal <= 90))
+ 		{
+ 			HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 			HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, AsciiVal - 61);
+ 		}
+ 		else if((AsciiVal >= 97) && (AsciiVal <= 122))
+ 		{
+ 			HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 			HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, AsciiVal - 93);
+ 		}
+ 		else if((AsciiVal >= 48) && (AsciiVal <= 57))
+ 		{
+ 			HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 			HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[AsciiVal - 48]);
+ 		}
+ 		else if((AsciiVal == 0x0D) || (AsciiVal == 0x0A))
+ 		{
+ 			HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 			HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_ENTER);
+ 		}
+ 		else
+ 			switch(AsciiVal)
+ 			{
+ 				case(' '):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_SPACEBAR);
+ 						break;
+ 				case('!'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[1]);
+ 						break;
+ 				case('@'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_RIGHT_ALT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_Q);
+ 						break;
+ 				case('#'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[3]);
+ 						break;
+ 				case('$'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[4]);
+ 						break;
+ 				case('%'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[5]);
+ 						break;
+ 				case('&'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[6]);
+ 						break;
+ 				case('/'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[7]);
+ 						break;
+ 				case('('):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[8]);
+ 						break;
+ 				case(')'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[9]);
+ 						break;
+ 				case('='):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[0]);
+ 						break;
+ 				case('-'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				//HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_MINUS_UNDERSCORE);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_SLASH_QUESTION);
+ 						break;
+ 				case('_'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				//HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_MINUS_UNDERSCORE);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_SLASH_QUESTION);
+ 						break;
+ 				case('"'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, ascii2kbNumbers[2]);
+ 						break;
+ 				case('?'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_EQUAL_PLUS);
+ 						break;
+ 				case('['):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_OBRACKET_AND_OBRACE);
+ 						break;
+ 				case('{'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_OBRACKET_AND_OBRACE);
+ 						break;
+ 				case(']'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_CBRACKET_AND_CBRACE);
+ 						break;
+ 				case('}'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_CBRACKET_AND_CBRACE);
+ 						break;
+ 				case('*'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_KEYPAD_ASTERIKS);
+ 						break;
+ 				case('+'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_KEYPAD_PLUS);
+ 						break;
+ 				case('.'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_DOT_GREATER);
+ 						break;
+ 				case(':'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_DOT_GREATER);
+ 						break;
+ 				case(';'):
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, MODIFERKEYS_LEFT_SHIFT);
+ 				HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_COMMA_AND_LESS);
+ 						break;
+ 				default:
+ 					HID_KEYBOARD_MODIFIERS_SetAll(KeyBoardBuff, 0x00);
+ 					HID_KEYBOARD_KEYS_Set(KeyBoardBuff, 0U, KEY_KEYPAD_PERCENT);
+ 						break;
+
+ 			}
+ }
@@ -0,0 +1,334 @@
+/*
+ * usbd_hid_unicode.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  None of the supported hosts can take a code point in a single report, so
+ *  every non-ASCII character becomes a short sequence of reports driving the
+ *  host input method. Text tends to repeat the same few accented letters,
+ *  the compiled sequences are cached in a direct-mapped table: one slot per
+ *  code point hash, a lookup is one compare.
+ */
+
+#include "../Inc/usbd_hid_unicode.h"
+
+#include <string.h>
+
+/* Modifier bits as sent in byte 1 of the keyboard report */
+#define MOD_CTRL                      (0x01U << 8)
+#define MOD_SHIFT                     (0x02U << 8)
+#define MOD_ALT                       (0x04U << 8)
+
+#define USAGE_A                       0x04U
+#define USAGE_U                       0x18U
+#define USAGE_1                       0x1EU
+#define USAGE_0                       0x27U
+#define USAGE_SPACE                   0x2CU
+#define USAGE_KEYPAD_PLUS             0x57U
+#define USAGE_KEYPAD_1                0x59U
+#define USAGE_KEYPAD_0                0x62U
+
+/* Fibonacci hashing, the high bits of the product spread neighbouring code
+ * points (accented Latin, Cyrillic and Han runs) over the whole table */
+#define HID_UNICODE_SLOT(cp)          ((((cp) * 0x9E3779B1U) >> 16) & (HID_UNICODE_CACHE_SIZE - 1U))
+
+typedef struct
+{
+  uint32_t             Tag;         /* ~code point, 0: free entry */
+  HID_UnicodeSeqTypeDef Seq;
+}
+HID_UnicodeCacheEntryTypeDef;
+
+static HID_UnicodeCacheEntryTypeDef HID_UnicodeCache[HID_UNICODE_CACHE_SIZE];
+static uint8_t HID_UnicodeHost = HID_UNICODE_DEFAULT_HOST;
+static uint8_t HID_UnicodeKeypad = 1U;
+static HID_UnicodeStatsTypeDef HID_UnicodeStats;
+
+static void HID_Unicode_AddHex(HID_UnicodeSeqTypeDef *seq, uint16_t mods,
+                               uint32_t value, uint8_t digits, uint8_t keypad);
+
+/**
+  * @brief  HID_Unicode_Decode
+  *         Decode one UTF-8 character
+  * @param  s: text
+  * @param  len: bytes available in s
+  * @param  cp: decoded code point, HID_UNICODE_REPLACEMENT if malformed
+  * @retval bytes consumed, 0 if the character is cut by the end of s
+  */
+uint8_t HID_Unicode_Decode(const uint8_t *s, uint32_t len, uint32_t *cp)
+{
+  uint32_t value;
+  uint32_t min;
+  uint8_t n;
+  uint8_t i;
+
+  if (len == 0U)
+  {
+    return 0U;
+  }
+
+  if (s[0] < 0x80U)
+  {
+    *cp = s[0];
+    return 1U;
+  }
+  else if ((s[0] & 0xE0U) == 0xC0U)
+  {
+    n = 2U;
+    value = s[0] & 0x1FU;
+    min = 0x80U;
+  }
+  else if ((s[0] & 0xF0U) == 0xE0U)
+  {
+    n = 3U;
+    value = s[0] & 0x0FU;
+    min = 0x800U;
+  }
+  else if ((s[0] & 0xF8U) == 0xF0U)
+  {
+    n = 4U;
+    value = s[0] & 0x07U;
+    min = 0x10000U;
+  }
+  else
+  {
+    /* Stray continuation byte or invalid lead byte */
+    *cp = HID_UNICODE_REPLACEMENT;
+    return 1U;
+  }
+
+  for (i = 1U; i < n; i++)
+  {
+    if (i >= len)
+    {
+      return 0U;
+    }
+    if ((s[i] & 0xC0U) != 0x80U)
+    {
+      /* Resync on the byte that broke the sequence */
+      *cp = HID_UNICODE_REPLACEMENT;
+      return i;
+    }
+    value = (value << 6) | (s[i] & 0x3FU);
+  }
+
+  /* Overlong forms, surrogates and values past U+10FFFF */
+  if ((value < min) || (value > 0x10FFFFU) ||
+      ((value >= 0xD800U) && (value <= 0xDFFFU)))
+  {
+    value = HID_UNICODE_REPLACEMENT;
+  }
+
+  *cp = value;
+  return n;
+}
+
+/**
+  * @brief  HID_Unicode_Compile
+  *         Build the keyboard sequence entering a code point on a host. The
+  *         Windows digits go to the keypad only while Num Lock is on
+  * @param  host: HID_UNICODE_WINDOWS, HID_UNICODE_LINUX, HID_UNICODE_MACOS
+  * @param  cp: code point
+  * @param  seq: compiled sequence, ends with every key released
+  * @retval 0 on success, 1 if the host can't take the code point
+  */
+uint8_t HID_Unicode_Compile(uint8_t host, uint32_t cp, HID_UnicodeSeqTypeDef *seq)
+{
+  uint32_t hi;
+  uint32_t lo;
+  uint8_t digits;
+
+  seq->Length = 0U;
+
+  if (cp > 0x10FFFFU)
+  {
+    return 1U;
+  }
+
+  switch (host)
+  {
+    case HID_UNICODE_WINDOWS:
+      /* The hex numpad entry only takes the basic multilingual plane */
+      if (cp > 0xFFFFU)
+      {
+        return 1U;
+      }
+      seq->Step[seq->Length++] = MOD_ALT;
+      seq->Step[seq->Length++] = MOD_ALT | USAGE_KEYPAD_PLUS;
+      seq->Step[seq->Length++] = MOD_ALT;
+      HID_Unicode_AddHex(seq, MOD_ALT, cp, 4U, HID_UnicodeKeypad);
+      break;
+
+    case HID_UNICODE_LINUX:
+      digits = (cp > 0xFFFFFU) ? 6U : ((cp > 0xFFFFU) ? 5U : 4U);
+      seq->Step[seq->Length++] = MOD_CTRL | MOD_SHIFT | USAGE_U;
+      seq->Step[seq->Length++] = 0U;
+      HID_Unicode_AddHex(seq, 0U, cp, digits, 0U);
+      seq->Step[seq->Length++] = USAGE_SPACE;
+      break;
+
+    case HID_UNICODE_MACOS:
+      seq->Step[seq->Length++] = MOD_ALT;
+      if (cp > 0xFFFFU)
+      {
+        /* UTF-16 surrogate pair, one group of 4 digits each */
+        hi = 0xD800U + ((cp - 0x10000U) >> 10);
+        lo = 0xDC00U + ((cp - 0x10000U) & 0x3FFU);
+        HID_Unicode_AddHex(seq, MOD_ALT, hi, 4U, 0U);
+        HID_Unicode_AddHex(seq, MOD_ALT, lo, 4U, 0U);
+      }
+      else
+      {
+        HID_Unicode_AddHex(seq, MOD_ALT, cp, 4U, 0U);
+      }
+      break;
+
+    default:
+      return 1U;
+  }
+
+  seq->Step[seq->Length++] = 0U;
+
+  return 0U;
+}
+
+/**
+  * @brief  HID_Unicode_Get
+  *         Sequence of a code point for the current host, from its cache
+  *         slot or compiled into it over the code point there. The sequence
+  *         stays valid until the next call
+  * @param  cp: code point
+  * @retval sequence, never NULL: U+FFFD or '?' replace what can't be typed
+  */
+const HID_UnicodeSeqTypeDef *HID_Unicode_Get(uint32_t cp)
+{
+  HID_UnicodeCacheEntryTypeDef *entry = &HID_UnicodeCache[HID_UNICODE_SLOT(cp)];
+
+  HID_UnicodeStats.Chars++;
+
+  if (entry->Tag == ~cp)
+  {
+    HID_UnicodeStats.Hits++;
+    return &entry->Seq;
+  }
+
+  HID_UnicodeStats.Misses++;
+  entry->Tag = ~cp;
+
+  if ((HID_Unicode_Compile(HID_UnicodeHost, cp, &entry->Seq) != 0U) &&
+      (HID_Unicode_Compile(HID_UnicodeHost, HID_UNICODE_REPLACEMENT, &entry->Seq) != 0U))
+  {
+    /* Unknown host: a question mark on a US layout */
+    entry->Seq.Step[0] = MOD_SHIFT | 0x38U;
+    entry->Seq.Step[1] = 0U;
+    entry->Seq.Length = 2U;
+  }
+
+  return &entry->Seq;
+}
+
+/**
+  * @brief  HID_Unicode_SetHost
+  *         Select the host input method, empties the cache
+  * @param  host: HID_UNICODE_WINDOWS, HID_UNICODE_LINUX, HID_UNICODE_MACOS
+  * @retval None
+  */
+void HID_Unicode_SetHost(uint8_t host)
+{
+  HID_UnicodeHost = host;
+  (void)memset(HID_UnicodeCache, 0, sizeof(HID_UnicodeCache));
+}
+
+/**
+  * @brief  HID_Unicode_GetHost
+  * @retval host input method in use
+  */
+uint8_t HID_Unicode_GetHost(void)
+{
+  return HID_UnicodeHost;
+}
+
+/**
+  * @brief  HID_Unicode_SetNumLock
+  *         Follow the host Num Lock LED: with it off the keypad digits move the
+  *         cursor, so the Windows sequences type them on the top row. Cached
+  *         sequences are dropped, the one being typed stays valid
+  * @param  on: Num Lock LED state
+  * @retval None
+  */
+void HID_Unicode_SetNumLock(uint8_t on)
+{
+  uint8_t keypad = (on != 0U) ? 1U : 0U;
+  uint32_t i;
+
+  if (keypad == HID_UnicodeKeypad)
+  {
+    return;
+  }
+
+  HID_UnicodeKeypad = keypad;
+  for (i = 0U; i < HID_UNICODE_CACHE_SIZE; i++)
+  {
+    HID_UnicodeCache[i].Tag = 0U;
+  }
+}
+
+/**
+  * @brief  HID_Unicode_CountReports
+  *         Account the reports sent for a character
+  * @param  reports: number of reports
+  * @retval None
+  */
+void HID_Unicode_CountReports(uint8_t reports)
+{
+  HID_UnicodeStats.Reports += reports;
+}
+
+/**
+  * @brief  HID_Unicode_GetStats
+  *         Copy the engine counters, Reports / Chars is the cost per character
+  * @param  stats: destination
+  * @retval None
+  */
+void HID_Unicode_GetStats(HID_UnicodeStatsTypeDef *stats)
+{
+  *stats = HID_UnicodeStats;
+}
+
+/**
+  * @brief  HID_Unicode_AddHex
+  *         Append the hex digits of a value, each pressed then released
+  * @param  seq: sequence
+  * @param  mods: modifiers held during the digits
+  * @param  value: value to type
+  * @param  digits: number of digits, leading zeros included
+  * @param  keypad: 1 to type 0-9 on the keypad, 0 on the top row
+  * @retval None
+  */
+static void HID_Unicode_AddHex(HID_UnicodeSeqTypeDef *seq, uint16_t mods,
+                               uint32_t value, uint8_t digits, uint8_t keypad)
+{
+  uint8_t nibble;
+  uint8_t usage;
+
+  while (digits-- != 0U)
+  {
+    nibble = (uint8_t)((value >> (4U * digits)) & 0xFU);
+
+    if (nibble >= 0xAU)
+    {
+      usage = (uint8_t)(USAGE_A + nibble - 0xAU);
+    }
+    else if (nibble == 0U)
+    {
+      usage = (keypad != 0U) ? USAGE_KEYPAD_0 : USAGE_0;
+    }
+    else
+    {
+      usage = (uint8_t)(((keypad != 0U) ? USAGE_KEYPAD_1 : USAGE_1) + nibble - 1U);
+    }
+
+    seq->Step[seq->Length++] = mods | usage;
+    seq->Step[seq->Length++] = mods;
+  }
+}
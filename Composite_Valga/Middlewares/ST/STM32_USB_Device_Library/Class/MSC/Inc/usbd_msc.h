@@ -0,0 +1,135 @@
+/*
+ * usbd_msc.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Mass storage function, bulk-only transport. The block device behind it is
+ *  a USBD_StorageTypeDef registered by the application (usbd_storage_if.c,
+ *  a RAM disk by default).
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_H_
+
+#include  "usbd_ioreq.h"
+
+/* 0 removes the mass storage interface from the composite device */
+#ifndef MSC_ENABLE
+#define MSC_ENABLE                    1U
+#endif /* MSC_ENABLE */
+
+#define MSC_EPIN_ADDR                 0x86U
+#define MSC_EPOUT_ADDR                0x06U
+#define MSC_MAX_FS_PACKET             64U
+
+/* Bytes of one data stage buffer, two of them overlap media and bus. Media
+ * blocks must divide it */
+#ifndef MSC_MEDIA_PACKET
+#define MSC_MEDIA_PACKET              512U
+#endif /* MSC_MEDIA_PACKET */
+
+#if ((MSC_MEDIA_PACKET % MSC_MAX_FS_PACKET) != 0U)
+#error "MSC_MEDIA_PACKET must be a multiple of the bulk packet size"
+#endif
+
+#define MSC_BOT_GET_MAX_LUN           0xFEU
+#define MSC_BOT_RESET                 0xFFU
+
+#define MSC_BOT_CBW_SIGNATURE         0x43425355U
+#define MSC_BOT_CSW_SIGNATURE         0x53425355U
+#define MSC_BOT_CBW_LENGTH            31U
+#define MSC_BOT_CSW_LENGTH            13U
+
+/* CSW status */
+#define MSC_CSW_CMD_PASSED            0x00U
+#define MSC_CSW_CMD_FAILED            0x01U
+#define MSC_CSW_PHASE_ERROR           0x02U
+
+/* Transport states */
+#define MSC_BOT_IDLE                  0U    /* waiting for a CBW */
+#define MSC_BOT_DATA_OUT              1U    /* receiving media data */
+#define MSC_BOT_DATA_IN               2U    /* sending media data */
+#define MSC_BOT_LAST_DATA_IN          3U    /* sending a command response */
+#define MSC_BOT_STALLED               4U    /* CSW waits for the host to clear the halt */
+
+/* Transport status */
+#define MSC_BOT_STATUS_NORMAL         0U
+#define MSC_BOT_STATUS_RECOVERY       1U    /* reset done, no CSW owed */
+#define MSC_BOT_STATUS_ERROR          2U    /* invalid CBW, stalled until reset */
+
+typedef struct
+{
+  uint32_t             dSignature;
+  uint32_t             dTag;
+  uint32_t             dDataLength;
+  uint8_t              bmFlags;
+  uint8_t              bLUN;
+  uint8_t              bCBLength;
+  uint8_t              CB[16];
+}
+USBD_MSC_BOT_CBWTypeDef;
+
+typedef struct
+{
+  uint32_t             dSignature;
+  uint32_t             dTag;
+  uint32_t             dDataResidue;
+  uint8_t              bStatus;
+}
+USBD_MSC_BOT_CSWTypeDef;
+
+typedef struct
+{
+  uint8_t              Key;
+  uint8_t              ASC;
+}
+USBD_MSC_SenseTypeDef;
+
+typedef struct
+{
+  uint32_t             ReadBlocks;
+  uint32_t             WriteBlocks;
+  uint32_t             MediaErrors;
+}
+USBD_MSC_StatsTypeDef;
+
+/* Block device, same calls as the ST storage interface. Return 0 on success */
+typedef struct _USBD_STORAGE
+{
+  int8_t (* Init)(uint8_t lun);
+  int8_t (* GetCapacity)(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+  int8_t (* IsReady)(uint8_t lun);
+  int8_t (* IsWriteProtected)(uint8_t lun);
+  int8_t (* Read)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+  int8_t (* Write)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+  int8_t (* GetMaxLun)(void);
+  int8_t *pInquiry;
+}
+USBD_StorageTypeDef;
+
+typedef struct
+{
+  USBD_MSC_BOT_CBWTypeDef Cbw;
+  USBD_MSC_BOT_CSWTypeDef Csw;
+  USBD_MSC_SenseTypeDef Sense;
+  uint8_t              BotState;
+  uint8_t              BotStatus;
+  uint8_t              MaxLun;
+  uint8_t              AltSetting;
+  uint32_t             BlkNbr;       /* media geometry of the current command */
+  uint16_t             BlkSize;
+  uint8_t              MediaError;   /* a block of the current command failed */
+  uint8_t              Cur;          /* data buffer on the bus */
+  uint32_t             BlkAddr;      /* next block to read from or write to the media */
+  uint32_t             BlkLeft;      /* blocks still to read from the media */
+  uint32_t             XferLeft;     /* bytes still to move on the bus */
+  uint16_t             BufLen[2];    /* bytes held by each data buffer */
+  USBD_MSC_StatsTypeDef Stats;
+  uint8_t              Buf[2][MSC_MEDIA_PACKET];
+}
+USBD_MSC_HandleTypeDef;
+
+extern USBD_ClassTypeDef  USBD_MSC;
+
+uint8_t  USBD_MSC_RegisterStorage(void *Comp_iops, USBD_StorageTypeDef *fops);
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_H_ */
@@ -0,0 +1,58 @@
+/*
+ * usbd_msc_scsi.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  SCSI commands carried by the bulk-only transport, and the transport calls
+ *  the commands use to start their data stage.
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_SCSI_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_SCSI_H_
+
+#include  "usbd_msc.h"
+
+#define SCSI_TEST_UNIT_READY                        0x00U
+#define SCSI_REQUEST_SENSE                          0x03U
+#define SCSI_INQUIRY                                0x12U
+#define SCSI_MODE_SENSE6                            0x1AU
+#define SCSI_START_STOP_UNIT                        0x1BU
+#define SCSI_ALLOW_MEDIUM_REMOVAL                   0x1EU
+#define SCSI_READ_FORMAT_CAPACITIES                 0x23U
+#define SCSI_READ_CAPACITY10                        0x25U
+#define SCSI_READ10                                 0x28U
+#define SCSI_WRITE10                                0x2AU
+#define SCSI_VERIFY10                               0x2FU
+#define SCSI_MODE_SENSE10                           0x5AU
+
+/* Sense keys */
+#define SCSI_NO_SENSE                               0x00U
+#define SCSI_NOT_READY                              0x02U
+#define SCSI_MEDIUM_ERROR                           0x03U
+#define SCSI_ILLEGAL_REQUEST                        0x05U
+#define SCSI_DATA_PROTECT                           0x07U
+
+/* Additional sense codes */
+#define SCSI_ASC_WRITE_FAULT                        0x03U
+#define SCSI_ASC_UNRECOVERED_READ_ERROR             0x11U
+#define SCSI_ASC_INVALID_COMMAND                    0x20U
+#define SCSI_ASC_ADDRESS_OUT_OF_RANGE               0x21U
+#define SCSI_ASC_INVALID_CDB                        0x24U
+#define SCSI_ASC_WRITE_PROTECTED                    0x27U
+#define SCSI_ASC_MEDIUM_NOT_PRESENT                 0x3AU
+
+#define SCSI_STANDARD_INQUIRY_LEN                   36U
+#define SCSI_REQUEST_SENSE_LEN                      18U
+
+int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+
+void SCSI_SenseCode(USBD_MSC_HandleTypeDef *hmsc, uint8_t key, uint8_t asc);
+
+/* Transport, usbd_msc.c */
+void MSC_BOT_SendData(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                      uint16_t len);
+
+int8_t MSC_BOT_StartRead(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+
+void MSC_BOT_StartWrite(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_MSC_INC_USBD_MSC_SCSI_H_ */
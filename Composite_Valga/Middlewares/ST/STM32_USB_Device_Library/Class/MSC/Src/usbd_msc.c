@@ -0,0 +1,681 @@
+/*
+ * usbd_msc.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Bulk-only transport. Media data moves through two buffers: on READ(10)
+ *  the next buffer is read from the media while the previous one is on the
+ *  bus, on WRITE(10) the next chunk is already being received while the
+ *  previous one is written to the media. The CSW is queued from the
+ *  completion of the last data packet and the next CBW receive is armed
+ *  with it, so a command costs no transfer beyond its CBW, data and CSW.
+ */
+
+#include "../Inc/usbd_msc.h"
+#include "../Inc/usbd_msc_scsi.h"
+#include "usbd_ctlreq.h"
+#include "../../Composite/Inc/Composite.h"
+
+uint8_t USBD_MSC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_MSC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_MSC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_MSC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+static void MSC_BOT_ReceiveCBW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static void MSC_BOT_DecodeCBW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static void MSC_BOT_SendCSW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                            uint8_t status);
+static void MSC_BOT_Abort(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static void MSC_BOT_Reset(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static void MSC_BOT_ClearFeature(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                                 uint8_t epnum);
+static void MSC_BOT_Fetch(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                          uint8_t b);
+static void MSC_BOT_ReadNext(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static void MSC_BOT_WriteNext(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+
+/* Callbacks of the mass storage function, dispatched by the composite router */
+USBD_ClassTypeDef  USBD_MSC =
+{
+  USBD_MSC_Init,
+  USBD_MSC_DeInit,
+  USBD_MSC_Setup,
+  NULL, /*EP0_TxSent*/
+  NULL, /*EP0_RxReady*/
+  USBD_MSC_DataIn,
+  USBD_MSC_DataOut,
+  NULL, /*SOF */
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static USBD_StorageTypeDef *MSC_Storage(USBD_HandleTypeDef *pdev)
+{
+  return (USBD_StorageTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->MSC_ops;
+}
+
+/**
+  * @brief  USBD_MSC_Init
+  *         Initialize the mass storage interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_MSC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  USBD_MSC_HandleTypeDef *hmsc;
+
+  /* The composite layer has opened the endpoints */
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  compHandle->msc = USBD_malloc_Type(USBD_MSC_HandleTypeDef, 1U);
+
+  if (compHandle->msc == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  hmsc = (USBD_MSC_HandleTypeDef *)compHandle->msc;
+  (void)memset(hmsc, 0, sizeof(USBD_MSC_HandleTypeDef));
+
+  /* Init the media */
+  (void)MSC_Storage(pdev)->Init(0U);
+  hmsc->MaxLun = (uint8_t)MSC_Storage(pdev)->GetMaxLun();
+  hmsc->BotState = MSC_BOT_IDLE;
+  hmsc->BotStatus = MSC_BOT_STATUS_NORMAL;
+
+  MSC_BOT_ReceiveCBW(pdev, hmsc);
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_DeInit
+  *         DeInitialize the mass storage interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_MSC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  /* The composite layer closes the endpoints */
+  if (compHandle->msc != NULL)
+  {
+    USBD_free(compHandle->msc);
+    compHandle->msc = NULL;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_Setup
+  *         Handle the bulk-only class requests and the endpoint halts
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+uint8_t USBD_MSC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_MSC_HandleTypeDef *hmsc = (USBD_MSC_HandleTypeDef *)compHandle->msc;
+  uint16_t status_info = 0U;
+  uint8_t ret = USBD_OK;
+
+  if (hmsc == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS :
+      switch (req->bRequest)
+      {
+        case MSC_BOT_GET_MAX_LUN :
+          if ((req->wValue == 0U) && (req->wLength == 1U) &&
+              ((req->bmRequest & 0x80U) == 0x80U))
+          {
+            USBD_CtlSendData(pdev, &hmsc->MaxLun, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case MSC_BOT_RESET :
+          if ((req->wValue == 0U) && (req->wLength == 0U) &&
+              ((req->bmRequest & 0x80U) != 0x80U))
+          {
+            MSC_BOT_Reset(pdev, hmsc);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, &hmsc->AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            hmsc->AltSetting = (uint8_t)(req->wValue);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          /* The core has cleared the halt already */
+          if (req->wValue == USB_FEATURE_EP_HALT)
+          {
+            MSC_BOT_ClearFeature(pdev, hmsc, (uint8_t)req->wIndex);
+          }
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_MSC_DataIn
+  *         handle data IN Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_MSC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_MSC_HandleTypeDef *hmsc = (USBD_MSC_HandleTypeDef *)compHandle->msc;
+
+  if (hmsc == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  switch (hmsc->BotState)
+  {
+    case MSC_BOT_DATA_IN:
+      MSC_BOT_ReadNext(pdev, hmsc);
+      break;
+
+    case MSC_BOT_LAST_DATA_IN:
+      MSC_BOT_SendCSW(pdev, hmsc, MSC_CSW_CMD_PASSED);
+      break;
+
+    default:
+      /* CSW sent, the next CBW receive is armed already */
+      break;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_MSC_DataOut
+  *         handle data OUT Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_MSC_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  USBD_MSC_HandleTypeDef *hmsc = (USBD_MSC_HandleTypeDef *)compHandle->msc;
+
+  if (hmsc == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  switch (hmsc->BotState)
+  {
+    case MSC_BOT_IDLE:
+      MSC_BOT_DecodeCBW(pdev, hmsc);
+      break;
+
+    case MSC_BOT_DATA_OUT:
+      MSC_BOT_WriteNext(pdev, hmsc);
+      break;
+
+    default:
+      break;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  MSC_BOT_SendData
+  *         Send a command response held in the first data buffer, cut to
+  *         what the host asked for
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @param  len: response length
+  * @retval None
+  */
+void MSC_BOT_SendData(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                      uint16_t len)
+{
+  len = (uint16_t)MIN(hmsc->Cbw.dDataLength, len);
+
+  if (len == 0U)
+  {
+    /* Nothing the host takes, the CSW follows the CBW */
+    return;
+  }
+
+  hmsc->Csw.dDataResidue -= len;
+  hmsc->BotState = MSC_BOT_LAST_DATA_IN;
+  USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, hmsc->Buf[0], len);
+}
+
+/**
+  * @brief  MSC_BOT_StartRead
+  *         Start the data stage of a READ(10). BlkAddr, BlkLeft and XferLeft
+  *         describe the command. The first buffer goes on the bus as soon as
+  *         it is read, the second one is read while the first is sent
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval 0 when the data stage started, -1 when the first read failed
+  */
+int8_t MSC_BOT_StartRead(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  hmsc->MediaError = 0U;
+  hmsc->Cur = 0U;
+  hmsc->BufLen[1] = 0U;
+
+  MSC_BOT_Fetch(pdev, hmsc, 0U);
+  if (hmsc->MediaError != 0U)
+  {
+    return -1;
+  }
+
+  hmsc->BotState = MSC_BOT_DATA_IN;
+  USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, hmsc->Buf[0], hmsc->BufLen[0]);
+
+  if (hmsc->BlkLeft != 0U)
+  {
+    MSC_BOT_Fetch(pdev, hmsc, 1U);
+  }
+
+  return 0;
+}
+
+/**
+  * @brief  MSC_BOT_StartWrite
+  *         Start the data stage of a WRITE(10). BlkAddr and XferLeft
+  *         describe the command
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+void MSC_BOT_StartWrite(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  hmsc->MediaError = 0U;
+  hmsc->Cur = 0U;
+  hmsc->BufLen[0] = (uint16_t)MIN(hmsc->XferLeft, MSC_MEDIA_PACKET);
+  hmsc->BotState = MSC_BOT_DATA_OUT;
+
+  USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, hmsc->Buf[0], hmsc->BufLen[0]);
+}
+
+/**
+  * @brief  MSC_BOT_ReceiveCBW
+  *         Arm the OUT endpoint for the next CBW. The whole packet is taken
+  *         so that an oversized one cannot overrun the buffer
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_ReceiveCBW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, hmsc->Buf[0], MSC_MAX_FS_PACKET);
+}
+
+/**
+  * @brief  MSC_BOT_DecodeCBW
+  *         Check the CBW just received and run its command
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_DecodeCBW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint32_t len = USBD_LL_GetRxDataSize(pdev, MSC_EPOUT_ADDR);
+
+  (void)memcpy(&hmsc->Cbw, hmsc->Buf[0], MSC_BOT_CBW_LENGTH);
+  hmsc->Csw.dTag = hmsc->Cbw.dTag;
+  hmsc->Csw.dDataResidue = hmsc->Cbw.dDataLength;
+
+  if ((len != MSC_BOT_CBW_LENGTH) ||
+      (hmsc->Cbw.dSignature != MSC_BOT_CBW_SIGNATURE) ||
+      (hmsc->Cbw.bLUN > hmsc->MaxLun) ||
+      (hmsc->Cbw.bCBLength < 1U) || (hmsc->Cbw.bCBLength > 16U))
+  {
+    /* Not meaningful, both endpoints stay halted until a reset recovery */
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+    hmsc->BotStatus = MSC_BOT_STATUS_ERROR;
+    MSC_BOT_Abort(pdev, hmsc);
+    return;
+  }
+
+  hmsc->BotStatus = MSC_BOT_STATUS_NORMAL;
+
+  if (SCSI_ProcessCmd(pdev, hmsc) != 0)
+  {
+    if (hmsc->Cbw.dDataLength == 0U)
+    {
+      MSC_BOT_SendCSW(pdev, hmsc, MSC_CSW_CMD_FAILED);
+    }
+    else
+    {
+      /* The CSW goes out once the host has cleared the halt */
+      hmsc->Csw.bStatus = MSC_CSW_CMD_FAILED;
+      hmsc->BotState = MSC_BOT_STALLED;
+      MSC_BOT_Abort(pdev, hmsc);
+    }
+  }
+  else if (hmsc->BotState == MSC_BOT_IDLE)
+  {
+    /* No data stage */
+    MSC_BOT_SendCSW(pdev, hmsc, MSC_CSW_CMD_PASSED);
+  }
+}
+
+/**
+  * @brief  MSC_BOT_SendCSW
+  *         Send the CSW and arm the receive of the next CBW with it, unless
+  *         the OUT endpoint is still halted: clearing that halt arms it
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @param  status: CSW status
+  * @retval None
+  */
+static void MSC_BOT_SendCSW(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                            uint8_t status)
+{
+  hmsc->Csw.dSignature = MSC_BOT_CSW_SIGNATURE;
+  hmsc->Csw.bStatus = status;
+  hmsc->BotState = MSC_BOT_IDLE;
+
+  USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, (uint8_t *)(void *)&hmsc->Csw,
+                   MSC_BOT_CSW_LENGTH);
+
+  if (USBD_LL_IsStallEP(pdev, MSC_EPOUT_ADDR) == 0U)
+  {
+    MSC_BOT_ReceiveCBW(pdev, hmsc);
+  }
+}
+
+/**
+  * @brief  MSC_BOT_Abort
+  *         Halt the data stage. The OUT endpoint is halted too when the
+  *         host still has data to send or the CBW was invalid, and takes
+  *         no CBW until that halt is cleared
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_Abort(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  if ((hmsc->BotStatus == MSC_BOT_STATUS_ERROR) ||
+      (((hmsc->Cbw.bmFlags & 0x80U) == 0U) && (hmsc->Cbw.dDataLength != 0U)))
+  {
+    USBD_LL_StallEP(pdev, MSC_EPOUT_ADDR);
+  }
+
+  USBD_LL_StallEP(pdev, MSC_EPIN_ADDR);
+}
+
+/**
+  * @brief  MSC_BOT_Reset
+  *         Bulk-only mass storage reset
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_Reset(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  hmsc->BotState = MSC_BOT_IDLE;
+  hmsc->BotStatus = MSC_BOT_STATUS_RECOVERY;
+
+  USBD_LL_ClearStallEP(pdev, MSC_EPIN_ADDR);
+  USBD_LL_ClearStallEP(pdev, MSC_EPOUT_ADDR);
+  MSC_BOT_ReceiveCBW(pdev, hmsc);
+}
+
+/**
+  * @brief  MSC_BOT_ClearFeature
+  *         The host cleared an endpoint halt. After an invalid CBW the
+  *         endpoints are halted again until a reset recovery. Otherwise
+  *         clearing the OUT halt arms the CBW receive, the endpoint being
+  *         valid again, and clearing the IN halt releases the CSW of a
+  *         failed data stage
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @param  epnum: endpoint address
+  * @retval None
+  */
+static void MSC_BOT_ClearFeature(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                                 uint8_t epnum)
+{
+  if (hmsc->BotStatus == MSC_BOT_STATUS_ERROR)
+  {
+    USBD_LL_StallEP(pdev, MSC_EPIN_ADDR);
+    USBD_LL_StallEP(pdev, MSC_EPOUT_ADDR);
+  }
+  else if (epnum == MSC_EPOUT_ADDR)
+  {
+    MSC_BOT_ReceiveCBW(pdev, hmsc);
+  }
+  else if ((epnum == MSC_EPIN_ADDR) && (hmsc->BotState == MSC_BOT_STALLED))
+  {
+    MSC_BOT_SendCSW(pdev, hmsc, hmsc->Csw.bStatus);
+  }
+}
+
+/**
+  * @brief  MSC_BOT_Fetch
+  *         Read the next blocks of a READ(10) into a data buffer. After a
+  *         media error the buffer is left empty
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @param  b: data buffer
+  * @retval None
+  */
+static void MSC_BOT_Fetch(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc,
+                          uint8_t b)
+{
+  uint16_t n = (uint16_t)MIN(hmsc->BlkLeft, MSC_MEDIA_PACKET / hmsc->BlkSize);
+
+  hmsc->BufLen[b] = 0U;
+
+  if (hmsc->MediaError != 0U)
+  {
+    return;
+  }
+
+  if (MSC_Storage(pdev)->Read(hmsc->Cbw.bLUN, hmsc->Buf[b], hmsc->BlkAddr, n) != 0)
+  {
+    hmsc->MediaError = 1U;
+    hmsc->Stats.MediaErrors++;
+    SCSI_SenseCode(hmsc, SCSI_MEDIUM_ERROR, SCSI_ASC_UNRECOVERED_READ_ERROR);
+    return;
+  }
+
+  hmsc->BufLen[b] = (uint16_t)(n * hmsc->BlkSize);
+  hmsc->BlkAddr += n;
+  hmsc->BlkLeft -= n;
+  hmsc->Stats.ReadBlocks += n;
+}
+
+/**
+  * @brief  MSC_BOT_ReadNext
+  *         A READ(10) buffer has been sent: send the other one, which was
+  *         read meanwhile, and refill the one just freed
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_ReadNext(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  hmsc->XferLeft -= hmsc->BufLen[hmsc->Cur];
+  hmsc->Csw.dDataResidue -= hmsc->BufLen[hmsc->Cur];
+
+  if (hmsc->XferLeft == 0U)
+  {
+    MSC_BOT_SendCSW(pdev, hmsc, MSC_CSW_CMD_PASSED);
+    return;
+  }
+
+  hmsc->Cur ^= 1U;
+
+  if (hmsc->BufLen[hmsc->Cur] == 0U)
+  {
+    /* The media failed, end the data stage here */
+    hmsc->Csw.bStatus = MSC_CSW_CMD_FAILED;
+    hmsc->BotState = MSC_BOT_STALLED;
+    MSC_BOT_Abort(pdev, hmsc);
+    return;
+  }
+
+  USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, hmsc->Buf[hmsc->Cur], hmsc->BufLen[hmsc->Cur]);
+
+  if (hmsc->BlkLeft != 0U)
+  {
+    MSC_BOT_Fetch(pdev, hmsc, hmsc->Cur ^ 1U);
+  }
+}
+
+/**
+  * @brief  MSC_BOT_WriteNext
+  *         A WRITE(10) chunk has been received: arm the receive of the next
+  *         one into the other buffer, then write this one to the media. A
+  *         media error does not stop the data stage, the rest of the data
+  *         is taken and the CSW reports the failure
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval None
+  */
+static void MSC_BOT_WriteNext(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t b = hmsc->Cur;
+  uint32_t len = MIN(USBD_LL_GetRxDataSize(pdev, MSC_EPOUT_ADDR), hmsc->XferLeft);
+  uint16_t n = (uint16_t)(len / hmsc->BlkSize);
+
+  hmsc->XferLeft -= len;
+  hmsc->Csw.dDataResidue -= len;
+
+  if (hmsc->XferLeft != 0U)
+  {
+    hmsc->Cur ^= 1U;
+    hmsc->BufLen[hmsc->Cur] = (uint16_t)MIN(hmsc->XferLeft, MSC_MEDIA_PACKET);
+    USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, hmsc->Buf[hmsc->Cur],
+                           hmsc->BufLen[hmsc->Cur]);
+  }
+
+  if ((hmsc->MediaError == 0U) && (n != 0U))
+  {
+    if (MSC_Storage(pdev)->Write(hmsc->Cbw.bLUN, hmsc->Buf[b], hmsc->BlkAddr, n) != 0)
+    {
+      hmsc->MediaError = 1U;
+      hmsc->Stats.MediaErrors++;
+      SCSI_SenseCode(hmsc, SCSI_MEDIUM_ERROR, SCSI_ASC_WRITE_FAULT);
+    }
+    else
+    {
+      hmsc->Stats.WriteBlocks += n;
+    }
+  }
+  hmsc->BlkAddr += n;
+
+  if (hmsc->XferLeft == 0U)
+  {
+    MSC_BOT_SendCSW(pdev, hmsc, (hmsc->MediaError != 0U) ? MSC_CSW_CMD_FAILED
+                                                           : MSC_CSW_CMD_PASSED);
+  }
+}
+
+/**
+  * @brief  USBD_MSC_RegisterStorage
+  * @param  Comp_iops: composite interface table
+  * @param  fops: storage callbacks
+  * @retval status
+  */
+uint8_t USBD_MSC_RegisterStorage(void *Comp_iops, USBD_StorageTypeDef *fops)
+{
+  uint8_t ret = USBD_FAIL;
+
+  if (fops != NULL)
+  {
+    ((USBD_Comp_ItfTypeDef *)Comp_iops)->MSC_ops = fops;
+    ret = USBD_OK;
+  }
+
+  return ret;
+}
@@ -0,0 +1,337 @@
+/*
+ * usbd_msc_scsi.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  SCSI block commands of the mass storage function. Responses are built in
+ *  the first data buffer of the transport, READ(10) and WRITE(10) hand the
+ *  media range over to the pipelined data stage of usbd_msc.c.
+ */
+
+#include "../Inc/usbd_msc_scsi.h"
+#include "../../Composite/Inc/Composite.h"
+
+static int8_t SCSI_TestUnitReady(USBD_StorageTypeDef *storage, USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_RequestSense(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_Inquiry(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                           USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_ModeSense(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                             USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_ReadFormatCapacity(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                                      USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_ReadCapacity10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                                  USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_Read10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                          USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_Write10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                           USBD_MSC_HandleTypeDef *hmsc);
+static int8_t SCSI_CheckRange(USBD_StorageTypeDef *storage, USBD_MSC_HandleTypeDef *hmsc);
+
+/**
+  * @brief  SCSI_ProcessCmd
+  *         Run the command of the CBW in hmsc
+  * @param  pdev: device instance
+  * @param  hmsc: mass storage handle
+  * @retval 0 on success, -1 with the sense data set on failure
+  */
+int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  USBD_StorageTypeDef *storage;
+  storage = (USBD_StorageTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->MSC_ops;
+
+  switch (hmsc->Cbw.CB[0])
+  {
+    case SCSI_TEST_UNIT_READY:
+      return SCSI_TestUnitReady(storage, hmsc);
+
+    case SCSI_REQUEST_SENSE:
+      return SCSI_RequestSense(pdev, hmsc);
+
+    case SCSI_INQUIRY:
+      return SCSI_Inquiry(pdev, storage, hmsc);
+
+    case SCSI_MODE_SENSE6:
+    case SCSI_MODE_SENSE10:
+      return SCSI_ModeSense(pdev, storage, hmsc);
+
+    case SCSI_START_STOP_UNIT:
+    case SCSI_ALLOW_MEDIUM_REMOVAL:
+      return 0;
+
+    case SCSI_READ_FORMAT_CAPACITIES:
+      return SCSI_ReadFormatCapacity(pdev, storage, hmsc);
+
+    case SCSI_READ_CAPACITY10:
+      return SCSI_ReadCapacity10(pdev, storage, hmsc);
+
+    case SCSI_READ10:
+      return SCSI_Read10(pdev, storage, hmsc);
+
+    case SCSI_WRITE10:
+      return SCSI_Write10(pdev, storage, hmsc);
+
+    case SCSI_VERIFY10:
+      /* Written data is not read back, there is nothing to compare */
+      if ((hmsc->Cbw.CB[1] & 0x02U) != 0U)
+      {
+        SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+        return -1;
+      }
+      return SCSI_CheckRange(storage, hmsc);
+
+    default:
+      SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_COMMAND);
+      return -1;
+  }
+}
+
+/**
+  * @brief  SCSI_SenseCode
+  *         Record the sense data returned by the next REQUEST SENSE
+  * @param  hmsc: mass storage handle
+  * @param  key: sense key
+  * @param  asc: additional sense code
+  * @retval None
+  */
+void SCSI_SenseCode(USBD_MSC_HandleTypeDef *hmsc, uint8_t key, uint8_t asc)
+{
+  hmsc->Sense.Key = key;
+  hmsc->Sense.ASC = asc;
+}
+
+static int8_t SCSI_TestUnitReady(USBD_StorageTypeDef *storage, USBD_MSC_HandleTypeDef *hmsc)
+{
+  if (storage->IsReady(hmsc->Cbw.bLUN) != 0)
+  {
+    SCSI_SenseCode(hmsc, SCSI_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int8_t SCSI_RequestSense(USBD_HandleTypeDef *pdev, USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t *buf = hmsc->Buf[0];
+
+  (void)memset(buf, 0, SCSI_REQUEST_SENSE_LEN);
+  buf[0] = 0x70U;                                 /* current errors */
+  buf[2] = hmsc->Sense.Key;
+  buf[7] = SCSI_REQUEST_SENSE_LEN - 8U;           /* additional length */
+  buf[12] = hmsc->Sense.ASC;
+
+  SCSI_SenseCode(hmsc, SCSI_NO_SENSE, 0U);
+  MSC_BOT_SendData(pdev, hmsc, MIN(SCSI_REQUEST_SENSE_LEN, hmsc->Cbw.CB[4]));
+
+  return 0;
+}
+
+static int8_t SCSI_Inquiry(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                           USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint16_t alloc = (uint16_t)((hmsc->Cbw.CB[3] << 8) | hmsc->Cbw.CB[4]);
+
+  if ((hmsc->Cbw.CB[1] & 0x01U) != 0U)
+  {
+    /* Vital product data: only the list of supported pages, itself */
+    if (hmsc->Cbw.CB[2] != 0x00U)
+    {
+      SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+      return -1;
+    }
+    (void)memset(hmsc->Buf[0], 0, 5U);
+    hmsc->Buf[0][3] = 1U;
+    MSC_BOT_SendData(pdev, hmsc, MIN(5U, alloc));
+    return 0;
+  }
+
+  (void)memcpy(hmsc->Buf[0],
+               &storage->pInquiry[hmsc->Cbw.bLUN * SCSI_STANDARD_INQUIRY_LEN],
+               SCSI_STANDARD_INQUIRY_LEN);
+  MSC_BOT_SendData(pdev, hmsc, MIN(SCSI_STANDARD_INQUIRY_LEN, alloc));
+
+  return 0;
+}
+
+static int8_t SCSI_ModeSense(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                             USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t *buf = hmsc->Buf[0];
+  uint8_t wp = (storage->IsWriteProtected(hmsc->Cbw.bLUN) != 0) ? 0x80U : 0x00U;
+
+  /* Header only, no block descriptor and no page */
+  if (hmsc->Cbw.CB[0] == SCSI_MODE_SENSE6)
+  {
+    buf[0] = 0x03U;
+    buf[1] = 0x00U;
+    buf[2] = wp;
+    buf[3] = 0x00U;
+    MSC_BOT_SendData(pdev, hmsc, MIN(4U, hmsc->Cbw.CB[4]));
+  }
+  else
+  {
+    (void)memset(buf, 0, 8U);
+    buf[1] = 0x06U;
+    buf[3] = wp;
+    MSC_BOT_SendData(pdev, hmsc,
+                     MIN(8U, (uint16_t)((hmsc->Cbw.CB[7] << 8) | hmsc->Cbw.CB[8])));
+  }
+
+  return 0;
+}
+
+static int8_t SCSI_ReadFormatCapacity(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                                      USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t *buf = hmsc->Buf[0];
+
+  if (storage->GetCapacity(hmsc->Cbw.bLUN, &hmsc->BlkNbr, &hmsc->BlkSize) != 0)
+  {
+    SCSI_SenseCode(hmsc, SCSI_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  (void)memset(buf, 0, 12U);
+  buf[3] = 0x08U;                                 /* capacity list length */
+  buf[4] = (uint8_t)(hmsc->BlkNbr >> 24);
+  buf[5] = (uint8_t)(hmsc->BlkNbr >> 16);
+  buf[6] = (uint8_t)(hmsc->BlkNbr >> 8);
+  buf[7] = (uint8_t)(hmsc->BlkNbr);
+  buf[8] = 0x02U;                                 /* formatted media */
+  buf[10] = (uint8_t)(hmsc->BlkSize >> 8);
+  buf[11] = (uint8_t)(hmsc->BlkSize);
+  MSC_BOT_SendData(pdev, hmsc,
+                   MIN(12U, (uint16_t)((hmsc->Cbw.CB[7] << 8) | hmsc->Cbw.CB[8])));
+
+  return 0;
+}
+
+static int8_t SCSI_ReadCapacity10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                                  USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t *buf = hmsc->Buf[0];
+  uint32_t last;
+
+  if (storage->GetCapacity(hmsc->Cbw.bLUN, &hmsc->BlkNbr, &hmsc->BlkSize) != 0)
+  {
+    SCSI_SenseCode(hmsc, SCSI_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  last = hmsc->BlkNbr - 1U;
+  buf[0] = (uint8_t)(last >> 24);
+  buf[1] = (uint8_t)(last >> 16);
+  buf[2] = (uint8_t)(last >> 8);
+  buf[3] = (uint8_t)(last);
+  buf[4] = (uint8_t)(hmsc->BlkSize >> 24);
+  buf[5] = (uint8_t)(hmsc->BlkSize >> 16);
+  buf[6] = (uint8_t)(hmsc->BlkSize >> 8);
+  buf[7] = (uint8_t)(hmsc->BlkSize);
+  MSC_BOT_SendData(pdev, hmsc, 8U);
+
+  return 0;
+}
+
+/**
+  * @brief  SCSI_CheckRange
+  *         Check that the media is there and that the block range of a
+  *         10-byte CDB lies on it. Leaves the range in BlkAddr and BlkLeft
+  * @param  storage: block device
+  * @param  hmsc: mass storage handle
+  * @retval 0 on success, -1 with the sense data set on failure
+  */
+static int8_t SCSI_CheckRange(USBD_StorageTypeDef *storage, USBD_MSC_HandleTypeDef *hmsc)
+{
+  uint8_t *cb = hmsc->Cbw.CB;
+
+  if ((storage->IsReady(hmsc->Cbw.bLUN) != 0) ||
+      (storage->GetCapacity(hmsc->Cbw.bLUN, &hmsc->BlkNbr, &hmsc->BlkSize) != 0))
+  {
+    SCSI_SenseCode(hmsc, SCSI_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  /* A data buffer holds whole blocks */
+  if ((hmsc->BlkSize == 0U) || (hmsc->BlkSize > MSC_MEDIA_PACKET) ||
+      ((MSC_MEDIA_PACKET % hmsc->BlkSize) != 0U))
+  {
+    SCSI_SenseCode(hmsc, SCSI_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+    return -1;
+  }
+
+  hmsc->BlkAddr = ((uint32_t)cb[2] << 24) | ((uint32_t)cb[3] << 16) |
+                  ((uint32_t)cb[4] << 8) | (uint32_t)cb[5];
+  hmsc->BlkLeft = ((uint32_t)cb[7] << 8) | (uint32_t)cb[8];
+
+  if ((hmsc->BlkAddr > hmsc->BlkNbr) || (hmsc->BlkLeft > (hmsc->BlkNbr - hmsc->BlkAddr)))
+  {
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_ADDRESS_OUT_OF_RANGE);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int8_t SCSI_Read10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                          USBD_MSC_HandleTypeDef *hmsc)
+{
+  if ((hmsc->Cbw.bmFlags & 0x80U) == 0U)
+  {
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+    return -1;
+  }
+
+  if (SCSI_CheckRange(storage, hmsc) != 0)
+  {
+    return -1;
+  }
+
+  hmsc->XferLeft = hmsc->BlkLeft * hmsc->BlkSize;
+  if (hmsc->Cbw.dDataLength != hmsc->XferLeft)
+  {
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+    return -1;
+  }
+
+  if (hmsc->XferLeft == 0U)
+  {
+    return 0;
+  }
+
+  return MSC_BOT_StartRead(pdev, hmsc);
+}
+
+static int8_t SCSI_Write10(USBD_HandleTypeDef *pdev, USBD_StorageTypeDef *storage,
+                           USBD_MSC_HandleTypeDef *hmsc)
+{
+  if ((hmsc->Cbw.bmFlags & 0x80U) != 0U)
+  {
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+    return -1;
+  }
+
+  if (SCSI_CheckRange(storage, hmsc) != 0)
+  {
+    return -1;
+  }
+
+  if (storage->IsWriteProtected(hmsc->Cbw.bLUN) != 0)
+  {
+    SCSI_SenseCode(hmsc, SCSI_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED);
+    return -1;
+  }
+
+  hmsc->XferLeft = hmsc->BlkLeft * hmsc->BlkSize;
+  if (hmsc->Cbw.dDataLength != hmsc->XferLeft)
+  {
+    SCSI_SenseCode(hmsc, SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+    return -1;
+  }
+
+  if (hmsc->XferLeft != 0U)
+  {
+    MSC_BOT_StartWrite(pdev, hmsc);
+  }
+
+  return 0;
+}
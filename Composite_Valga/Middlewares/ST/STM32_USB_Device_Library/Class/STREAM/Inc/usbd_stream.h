@@ -0,0 +1,90 @@
+/*
+ * usbd_stream.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Vendor streaming function: one isochronous IN endpoint, and optionally one
+ *  isochronous OUT endpoint, carrying a packet per frame with bandwidth
+ *  reserved by the host. Alternate setting 0 has no endpoint, the stream
+ *  runs while the host selects alternate setting 1. Data comes from a
+ *  USBD_STREAM_ItfTypeDef registered by the application (usbd_stream_if.c).
+ */
+#ifndef ST_STM32_USB_DEVICE_LIBRARY_CLASS_STREAM_INC_USBD_STREAM_H_
+#define ST_STM32_USB_DEVICE_LIBRARY_CLASS_STREAM_INC_USBD_STREAM_H_
+
+#include  "usbd_ioreq.h"
+
+/* 0 removes the streaming interface from the composite device */
+#ifndef STREAM_ENABLE
+#define STREAM_ENABLE                 1U
+#endif /* STREAM_ENABLE */
+
+/* 1 adds the isochronous OUT endpoint. No endpoint number is left for it, it
+ * takes the pointer's and needs HID_POINTER_ENABLE 0 (checked in Composite.h) */
+#ifndef STREAM_OUT_ENABLE
+#define STREAM_OUT_ENABLE             0U
+#endif /* STREAM_OUT_ENABLE */
+
+#define STREAM_EPIN_ADDR              0x87U
+#define STREAM_EPOUT_ADDR             0x04U
+
+/* Asynchronous data endpoints, one packet every frame */
+#define STREAM_EP_ATTR                (USBD_EP_TYPE_ISOC | 0x04U)
+#define STREAM_BINTERVAL              0x01U
+
+/* Bytes per frame. Each isochronous endpoint takes twice its packet size in
+ * the 1 KB packet memory, shared with every other endpoint */
+#ifndef STREAM_IN_PACKET_SIZE
+#define STREAM_IN_PACKET_SIZE         192U
+#endif /* STREAM_IN_PACKET_SIZE */
+
+#ifndef STREAM_OUT_PACKET_SIZE
+#define STREAM_OUT_PACKET_SIZE        64U
+#endif /* STREAM_OUT_PACKET_SIZE */
+
+#if (STREAM_IN_PACKET_SIZE > 1023U) || (STREAM_OUT_PACKET_SIZE > 1023U)
+#error "A full speed isochronous packet holds 1023 bytes at most"
+#endif
+
+typedef struct
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  /* Next IN packet into buf, at most max bytes. Returns its length, 0 when
+   * no data is ready. Called from the USB interrupt */
+  uint16_t (* Fill)(uint8_t *buf, uint16_t max);
+  /* OUT packet of len bytes, called from the USB interrupt */
+  int8_t (* Receive)(uint8_t *buf, uint16_t len);
+}
+USBD_STREAM_ItfTypeDef;
+
+typedef struct
+{
+  uint32_t             InPackets;    /* packets taken by the host */
+  uint32_t             Underruns;    /* frames without data ready, sent empty */
+  uint32_t             Missed;       /* packets the host did not take in their frame */
+  uint32_t             OutPackets;   /* packets received */
+  uint32_t             OutMissed;    /* frames without an OUT packet */
+}
+USBD_STREAM_StatsTypeDef;
+
+typedef struct
+{
+  uint8_t              AltSetting;
+  uint8_t              InBusy;       /* a packet sits in the packet memory */
+  uint8_t              OutSeen;      /* an OUT packet came since the last SOF */
+  uint16_t             InLen;        /* length of the packet ready in InBuf */
+  USBD_STREAM_StatsTypeDef Stats;
+  uint8_t              InBuf[STREAM_IN_PACKET_SIZE];
+#if (STREAM_OUT_ENABLE == 1U)
+  uint8_t              OutBuf[STREAM_OUT_PACKET_SIZE];
+#endif /* STREAM_OUT_ENABLE */
+}
+USBD_STREAM_HandleTypeDef;
+
+extern USBD_ClassTypeDef  USBD_STREAM;
+
+uint8_t  USBD_STREAM_RegisterInterface(void *Comp_iops, USBD_STREAM_ItfTypeDef *fops);
+uint8_t  USBD_STREAM_GetStats(USBD_HandleTypeDef *pdev, USBD_STREAM_StatsTypeDef *stats);
+
+#endif /* ST_STM32_USB_DEVICE_LIBRARY_CLASS_STREAM_INC_USBD_STREAM_H_ */
@@ -0,0 +1,440 @@
+/*
+ * usbd_stream.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  The next IN packet is always prepared in InBuf: once a packet has been
+ *  copied to the packet memory the application is asked for the following
+ *  one, so the transfer complete callback only has to hand over a ready
+ *  buffer. When nothing was ready the SOF asks again, and a frame that goes
+ *  by without data is counted as an underrun. The isochronous endpoints use
+ *  both packet buffers of the USB peripheral, see usbd_conf.c.
+ */
+
+#include "../Inc/usbd_stream.h"
+#include "usbd_ctlreq.h"
+#include "../../Composite/Inc/Composite.h"
+
+uint8_t USBD_STREAM_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_STREAM_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+uint8_t USBD_STREAM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+uint8_t USBD_STREAM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_STREAM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_STREAM_SOF(USBD_HandleTypeDef *pdev);
+uint8_t USBD_STREAM_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t USBD_STREAM_IsoOUTIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
+
+static void USBD_STREAM_Start(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr);
+static void USBD_STREAM_Stop(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr);
+static void USBD_STREAM_SendNext(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr);
+
+/* Callbacks of the streaming function, dispatched by the composite router */
+USBD_ClassTypeDef  USBD_STREAM =
+{
+  USBD_STREAM_Init,
+  USBD_STREAM_DeInit,
+  USBD_STREAM_Setup,
+  NULL, /*EP0_TxSent*/
+  NULL, /*EP0_RxReady*/
+  USBD_STREAM_DataIn,
+  USBD_STREAM_DataOut,
+  USBD_STREAM_SOF,
+  USBD_STREAM_IsoINIncomplete,
+  USBD_STREAM_IsoOUTIncomplete,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static USBD_STREAM_ItfTypeDef *STREAM_Itf(USBD_HandleTypeDef *pdev)
+{
+  return (USBD_STREAM_ItfTypeDef *)((USBD_Comp_ItfTypeDef *)pdev->pUserData)->STREAM_ops;
+}
+
+static USBD_STREAM_HandleTypeDef *STREAM_Handle(USBD_HandleTypeDef *pdev)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  return (compHandle != NULL) ? (USBD_STREAM_HandleTypeDef *)compHandle->stream : NULL;
+}
+
+/**
+  * @brief  USBD_STREAM_Init
+  *         Initialize the streaming interface, stream stopped
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_STREAM_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+
+  /* The composite layer has opened the endpoints, isochronous endpoints
+   * stay disabled until the first packet */
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+  compHandle->stream = USBD_malloc_Type(USBD_STREAM_HandleTypeDef, 1U);
+
+  if (compHandle->stream == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  (void)memset(compHandle->stream, 0, sizeof(USBD_STREAM_HandleTypeDef));
+  (void)STREAM_Itf(pdev)->Init();
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_DeInit
+  *         DeInitialize the streaming interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+uint8_t USBD_STREAM_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  USBD_Composite_HandleTypeDef *compHandle;
+  compHandle = (USBD_Composite_HandleTypeDef *)pdev->pClassData;
+
+  /* The composite layer closes the endpoints */
+  if (compHandle->stream != NULL)
+  {
+    (void)STREAM_Itf(pdev)->DeInit();
+    USBD_free(compHandle->stream);
+    compHandle->stream = NULL;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_Setup
+  *         Handle the standard interface requests, SET_INTERFACE starts and
+  *         stops the stream
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+uint8_t USBD_STREAM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+  uint16_t status_info = 0U;
+  uint8_t ret = USBD_OK;
+
+  if (hstr == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, (uint8_t *)(void *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlSendData(pdev, &hstr->AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE :
+          if ((pdev->dev_state == USBD_STATE_CONFIGURED) && (req->wValue <= 1U))
+          {
+            if ((uint8_t)req->wValue != hstr->AltSetting)
+            {
+              hstr->AltSetting = (uint8_t)req->wValue;
+              if (hstr->AltSetting != 0U)
+              {
+                USBD_STREAM_Start(pdev, hstr);
+              }
+              else
+              {
+                USBD_STREAM_Stop(pdev, hstr);
+              }
+            }
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          /* Endpoint halt, cleared by the core */
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  USBD_STREAM_DataIn
+  *         The host took the packet: hand over the one prepared meanwhile
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_STREAM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if (hstr == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  hstr->InBusy = 0U;
+  hstr->Stats.InPackets++;
+
+  if (hstr->AltSetting != 0U)
+  {
+    USBD_STREAM_SendNext(pdev, hstr);
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_DataOut
+  *         OUT packet received, pass it on and take the next one
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_STREAM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+#if (STREAM_OUT_ENABLE == 1U)
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if (hstr == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  hstr->OutSeen = 1U;
+  hstr->Stats.OutPackets++;
+  (void)STREAM_Itf(pdev)->Receive(hstr->OutBuf,
+                                  (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum));
+
+  if (hstr->AltSetting != 0U)
+  {
+    USBD_LL_PrepareReceive(pdev, STREAM_EPOUT_ADDR, hstr->OutBuf, STREAM_OUT_PACKET_SIZE);
+  }
+
+  return USBD_OK;
+#else
+  return USBD_FAIL;
+#endif /* STREAM_OUT_ENABLE */
+}
+
+/**
+  * @brief  USBD_STREAM_SOF
+  *         Start of frame: retry a packet the application did not have
+  *         ready, account for the frames without data
+  * @param  pdev: device instance
+  * @retval status
+  */
+uint8_t USBD_STREAM_SOF(USBD_HandleTypeDef *pdev)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if ((hstr == NULL) || (hstr->AltSetting == 0U))
+  {
+    return USBD_OK;
+  }
+
+  if (hstr->InBusy == 0U)
+  {
+    USBD_STREAM_SendNext(pdev, hstr);
+    if (hstr->InBusy == 0U)
+    {
+      hstr->Stats.Underruns++;
+    }
+  }
+
+#if (STREAM_OUT_ENABLE == 1U)
+  if (hstr->OutSeen == 0U)
+  {
+    hstr->Stats.OutMissed++;
+  }
+  hstr->OutSeen = 0U;
+#endif /* STREAM_OUT_ENABLE */
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_IsoINIncomplete
+  *         The packet of the last frame is still in the packet memory, it
+  *         goes out one frame late
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_STREAM_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if ((hstr != NULL) && (hstr->AltSetting != 0U))
+  {
+    hstr->Stats.Missed++;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_IsoOUTIncomplete
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+uint8_t USBD_STREAM_IsoOUTIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if ((hstr != NULL) && (hstr->AltSetting != 0U))
+  {
+    hstr->Stats.OutMissed++;
+  }
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_Start
+  *         Alternate setting 1: queue the first packet, arm the OUT endpoint
+  * @param  pdev: device instance
+  * @param  hstr: stream handle
+  * @retval None
+  */
+static void USBD_STREAM_Start(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr)
+{
+  hstr->InBusy = 0U;
+  hstr->InLen = 0U;
+  USBD_STREAM_SendNext(pdev, hstr);
+
+#if (STREAM_OUT_ENABLE == 1U)
+  /* No OUT packet is owed for the frame the stream starts in */
+  hstr->OutSeen = 1U;
+  USBD_LL_PrepareReceive(pdev, STREAM_EPOUT_ADDR, hstr->OutBuf, STREAM_OUT_PACKET_SIZE);
+#endif /* STREAM_OUT_ENABLE */
+}
+
+/**
+  * @brief  USBD_STREAM_Stop
+  *         Alternate setting 0: the host no longer polls, drop what is queued
+  * @param  pdev: device instance
+  * @param  hstr: stream handle
+  * @retval None
+  */
+static void USBD_STREAM_Stop(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr)
+{
+  USBD_LL_FlushEP(pdev, STREAM_EPIN_ADDR);
+#if (STREAM_OUT_ENABLE == 1U)
+  USBD_LL_FlushEP(pdev, STREAM_EPOUT_ADDR);
+#endif /* STREAM_OUT_ENABLE */
+  hstr->InBusy = 0U;
+  hstr->InLen = 0U;
+}
+
+/**
+  * @brief  USBD_STREAM_SendNext
+  *         Copy the prepared packet to the packet memory, then prepare the
+  *         following one while this one waits for the host
+  * @param  pdev: device instance
+  * @param  hstr: stream handle
+  * @retval None
+  */
+static void USBD_STREAM_SendNext(USBD_HandleTypeDef *pdev, USBD_STREAM_HandleTypeDef *hstr)
+{
+  if (hstr->InLen == 0U)
+  {
+    hstr->InLen = STREAM_Itf(pdev)->Fill(hstr->InBuf, STREAM_IN_PACKET_SIZE);
+    if (hstr->InLen == 0U)
+    {
+      return;
+    }
+  }
+
+  /* The peripheral driver copies InBuf to the packet memory right away */
+  hstr->InBusy = 1U;
+  USBD_LL_Transmit(pdev, STREAM_EPIN_ADDR, hstr->InBuf, hstr->InLen);
+
+  hstr->InLen = STREAM_Itf(pdev)->Fill(hstr->InBuf, STREAM_IN_PACKET_SIZE);
+}
+
+/**
+  * @brief  USBD_STREAM_GetStats
+  *         Copy the stream statistics
+  * @param  pdev: device instance
+  * @param  stats: destination
+  * @retval status, USBD_FAIL when the device is not configured
+  */
+uint8_t USBD_STREAM_GetStats(USBD_HandleTypeDef *pdev, USBD_STREAM_StatsTypeDef *stats)
+{
+  USBD_STREAM_HandleTypeDef *hstr = STREAM_Handle(pdev);
+
+  if (hstr == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  *stats = hstr->Stats;
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  USBD_STREAM_RegisterInterface
+  * @param  Comp_iops: composite interface table
+  * @param  fops: stream callbacks
+  * @retval status
+  */
+uint8_t USBD_STREAM_RegisterInterface(void *Comp_iops, USBD_STREAM_ItfTypeDef *fops)
+{
+  uint8_t ret = USBD_FAIL;
+
+  if (fops != NULL)
+  {
+    ((USBD_Comp_ItfTypeDef *)Comp_iops)->STREAM_ops = fops;
+    ret = USBD_OK;
+  }
+
+  return ret;
+}
@@ -78,11 +78,11 @@ extern "C" {
   */
 
 USBD_StatusTypeDef  USBD_CtlSendData(USBD_HandleTypeDef *pdev,
-                                     uint8_t *pbuf,
+                                     const uint8_t *pbuf,
                                      uint16_t len);
 
 USBD_StatusTypeDef  USBD_CtlContinueSendData(USBD_HandleTypeDef  *pdev,
-                                             uint8_t *pbuf,
+                                             const uint8_t *pbuf,
                                              uint16_t len);
 
 USBD_StatusTypeDef USBD_CtlPrepareRx(USBD_HandleTypeDef  *pdev,
@@ -311,6 +311,12 @@ USBD_StatusTypeDef  USBD_StdEPReq(USBD_HandleTypeDef *pdev,
                   USBD_LL_ClearStallEP(pdev, ep_addr);
                 }
                 USBD_CtlSendStatus(pdev);
+
+                /* Let the class resume after the halt, e.g. the MSC status */
+                if ((ep_addr & 0x7FU) != 0x00U)
+                {
+                  (void)pdev->pClass->Setup(pdev, req);
+                }
               }
               break;
 
@@ -406,7 +412,7 @@ static void USBD_GetDescriptor(USBD_HandleTypeDef *pdev,
                                USBD_SetupReqTypedef *req)
 {
   uint16_t len = 0U;
-  uint8_t *pbuf = NULL;
+  const uint8_t *pbuf = NULL;
   uint8_t err = 0U;
 
   switch (req->wValue >> 8)
@@ -432,12 +438,10 @@ static void USBD_GetDescriptor(USBD_HandleTypeDef *pdev,
       if (pdev->dev_speed == USBD_SPEED_HIGH)
       {
         pbuf = pdev->pClass->GetHSConfigDescriptor(&len);
-        pbuf[1] = USB_DESC_TYPE_CONFIGURATION;
       }
       else
       {
         pbuf = pdev->pClass->GetFSConfigDescriptor(&len);
-        pbuf[1] = USB_DESC_TYPE_CONFIGURATION;
       }
       break;
 
@@ -552,7 +556,6 @@ static void USBD_GetDescriptor(USBD_HandleTypeDef *pdev,
       if (pdev->dev_speed == USBD_SPEED_HIGH)
       {
         pbuf = pdev->pClass->GetOtherSpeedConfigDescriptor(&len);
-        pbuf[1] = USB_DESC_TYPE_OTHER_SPEED_CONFIGURATION;
       }
       else
       {
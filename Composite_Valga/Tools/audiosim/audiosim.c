@@ -0,0 +1,282 @@
+/*
+ * audiosim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test of the audio rate feedback: usbd_audio.c and the FIFO of
+ *  usbd_audio_if.c run unchanged between two clocks that drift apart. The
+ *  host clock gives the frames: one SOF and one OUT packet each, sized from
+ *  the feedback value the host last read, every 2^AUDIO_FB_REFRESH frames.
+ *  The device clock takes the samples through AUDIO_Play_FS, by DMA blocks,
+ *  at a rate offset from the host by a fixed or a slowly swept amount.
+ *  Once the FIFO is primed no packet may overrun it and the playback may
+ *  not run dry, the samples must come out in order, and the FIFO level at
+ *  SOF, the latency, must stay within a quarter of the FIFO of its target,
+ *  less one DMA block below.
+ *
+ *  Build (Linux):
+ *    M=../../Middlewares/ST/STM32_USB_Device_Library
+ *    gcc -O2 -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER -DAUDIO_ENABLE=1 \
+ *        -DSTREAM_ENABLE=0 -DMSC_ENABLE=0 -I../../Core/Inc \
+ *        -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -I../../USB_Device/Target \
+ *        -I../../USB_Device/App -I$M/Core/Inc -Wno-int-to-pointer-cast \
+ *        -Wno-pointer-to-int-cast -o audiosim audiosim.c ../usbsim/usbsim.c \
+ *        $M/Class/AUDIO/Src/usbd_audio.c ../../USB_Device/App/usbd_audio_if.c \
+ *        $M/Core/Src/usbd_core.c $M/Core/Src/usbd_ctlreq.c \
+ *        $M/Core/Src/usbd_ioreq.c -lm
+ *
+ *  Usage:
+ *    audiosim [seconds]      per case, 120 by default
+ *  Exit status is 0 when every case passes.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usbsim/usbsim.h"
+#include "usbd_audio_if.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
+
+/* Frames left to the loop before the level is held to its bound */
+#define SETTLE_FRAMES                 4000U
+#define LEVEL_BOUND                   (AUDIO_FIFO_FRAMES / 4U)
+
+typedef struct
+{
+  const char *Name;
+  double   Ppm;         /* device clock against the host clock */
+  double   SweepPpm;    /* added, a sine of SweepPeriod seconds */
+  double   SweepPeriod;
+  uint16_t Block;       /* sample frames per playback DMA block */
+}
+AudioCase;
+
+static const AudioCase Cases[] =
+{
+  { "same clock, 1 ms blocks",   0.0,     0.0,   0.0, 48U  },
+  { "+100 ppm, 16 frames",       100.0,   0.0,   0.0, 16U  },
+  { "-100 ppm, 16 frames",      -100.0,   0.0,   0.0, 16U  },
+  { "+500 ppm, 48 frames",       500.0,   0.0,   0.0, 48U  },
+  { "-500 ppm, 48 frames",      -500.0,   0.0,   0.0, 48U  },
+  { "+1000 ppm, 96 frames",      1000.0,  0.0,   0.0, 96U  },
+  { "-1000 ppm, 1 frame",       -1000.0,  0.0,   0.0, 1U   },
+  { "sweep +-500 ppm, 30 s",     0.0,     500.0, 30.0, 32U },
+  { "+300 sweep +-700 ppm, 20 s", 300.0,  700.0, 20.0, 64U },
+};
+
+static USBD_HandleTypeDef Dev;
+static USBD_Composite_HandleTypeDef CompHandle;
+static USBD_Comp_ItfTypeDef CompItf;
+
+static uint32_t NextSent;     /* sample frame numbers, host side */
+static uint32_t NextPlayed;
+static unsigned Errors;
+
+static void Fail(const AudioCase *c, uint32_t frame, const char *what)
+{
+  if (Errors < 10U)
+  {
+    fprintf(stderr, "  %s: %s at frame %u\n", c->Name, what, frame);
+  }
+  Errors++;
+}
+
+static void SetInterface(uint16_t alt)
+{
+  USBD_SetupReqTypedef req;
+
+  req.bmRequest = USB_REQ_TYPE_STANDARD | USB_REQ_RECIPIENT_INTERFACE;
+  req.bRequest = USB_REQ_SET_INTERFACE;
+  req.wValue = alt;
+  req.wIndex = USBD_COMP_ITF_AUDIO_AS;
+  req.wLength = 0U;
+  (void)USBD_AUDIO.Setup(&Dev, &req);
+}
+
+/* Host: one OUT packet of frames sample frames, numbered */
+static uint8_t SendPacket(const AudioCase *c, uint32_t frame, uint32_t frames)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(AUDIO_OUT_EP);
+  int16_t sample[AUDIO_CHANNELS];
+
+  if (!ep->Armed || ((frames * AUDIO_FRAME_SIZE) > ep->Len))
+  {
+    Fail(c, frame, "OUT packet larger than armed");
+    return 0U;
+  }
+
+  for (uint32_t i = 0U; i < frames; i++)
+  {
+    for (uint32_t ch = 0U; ch < AUDIO_CHANNELS; ch++)
+    {
+      sample[ch] = (int16_t)(NextSent ^ (ch * 0x5555U));
+    }
+    (void)memcpy(&ep->Buf[i * AUDIO_FRAME_SIZE], sample, AUDIO_FRAME_SIZE);
+    NextSent++;
+  }
+
+  ep->Armed = 0U;
+  ep->RxSize = frames * AUDIO_FRAME_SIZE;
+  (void)USBD_AUDIO.DataOut(&Dev, AUDIO_OUT_EP & 0x0FU);
+  return 1U;
+}
+
+/* Device: one DMA block, the samples taken must follow the last ones */
+static void PlayBlock(const AudioCase *c, uint32_t frame)
+{
+  static int16_t buf[96U * AUDIO_CHANNELS];
+  uint16_t n = AUDIO_Play_FS(buf, c->Block);
+
+  for (uint16_t i = 0U; i < n; i++)
+  {
+    if (NextPlayed == 0xFFFFFFFFU)
+    {
+      /* First sample out, the priming dropped nothing */
+      NextPlayed = (uint16_t)buf[0];
+    }
+    if (buf[i * AUDIO_CHANNELS] != (int16_t)NextPlayed)
+    {
+      Fail(c, frame, "samples out of order");
+      NextPlayed = (uint16_t)buf[i * AUDIO_CHANNELS];
+    }
+    NextPlayed++;
+  }
+}
+
+static void RunCase(const AudioCase *c, uint32_t seconds)
+{
+  USBSIM_EpTypeDef *fb = USBSIM_Ep(AUDIO_FB_EP);
+  uint32_t frames = seconds * 1000U;
+  uint32_t over0, under0, over1, under1;
+  uint32_t feedback = AUDIO_NOMINAL_FRAMES << 14;
+  uint64_t hostAcc = 0U;
+  double nextBlock;
+  double offset;
+  uint32_t played;
+  uint16_t level;
+  uint16_t minLevel = 0xFFFFU;
+  uint16_t maxLevel = 0U;
+  uint32_t fbMin = 0xFFFFFFFFU;
+  uint32_t fbMax = 0U;
+
+  AUDIO_GetErrors_FS(&over0, &under0);
+  NextSent = 0U;
+  NextPlayed = 0xFFFFFFFFU;
+  SetInterface(1U);
+  nextBlock = 0.0;
+
+  for (uint32_t frame = 0U; frame < frames; frame++)
+  {
+    double now = frame * 1e-3;
+
+    /* Device clock: the blocks due before this SOF */
+    while (nextBlock <= now)
+    {
+      PlayBlock(c, frame);
+      offset = c->Ppm;
+      if (c->SweepPeriod > 0.0)
+      {
+        offset += c->SweepPpm * sin(2.0 * M_PI * nextBlock / c->SweepPeriod);
+      }
+      nextBlock += c->Block / (AUDIO_FREQ * (1.0 + (offset * 1e-6)));
+    }
+
+    (void)USBD_AUDIO.SOF(&Dev);
+
+    /* Level as the device sees it, before the packet of the frame: the
+     * playback blocks add their own sawtooth */
+    USBD_Audio_Interface_fops_FS.GetClock(&played, &level);
+    if (frame >= SETTLE_FRAMES)
+    {
+      minLevel = (level < minLevel) ? level : minLevel;
+      maxLevel = (level > maxLevel) ? level : maxLevel;
+      if ((level + LEVEL_BOUND + c->Block < AUDIO_FIFO_FRAMES / 2U) ||
+          (level > AUDIO_FIFO_FRAMES / 2U + LEVEL_BOUND))
+      {
+        Fail(c, frame, "FIFO level out of bounds");
+      }
+    }
+
+    /* 10.14 samples per frame, the fraction carried over */
+    hostAcc += feedback;
+    if (!SendPacket(c, frame, (uint32_t)(hostAcc >> 14)))
+    {
+      break;
+    }
+    hostAcc &= (1U << 14) - 1U;
+
+    if (((frame & ((1U << AUDIO_FB_REFRESH) - 1U)) == 0U) && fb->Armed)
+    {
+      feedback = fb->Buf[0] | ((uint32_t)fb->Buf[1] << 8) | ((uint32_t)fb->Buf[2] << 16);
+      fb->Armed = 0U;
+      (void)USBD_AUDIO.DataIn(&Dev, AUDIO_FB_EP & 0x0FU);
+      if (frame >= SETTLE_FRAMES)
+      {
+        fbMin = (feedback < fbMin) ? feedback : fbMin;
+        fbMax = (feedback > fbMax) ? feedback : fbMax;
+      }
+    }
+  }
+
+  SetInterface(0U);
+  AUDIO_GetErrors_FS(&over1, &under1);
+  if (over1 != over0)
+  {
+    Fail(c, frames, "FIFO overrun");
+  }
+  if (under1 != under0)
+  {
+    Fail(c, frames, "playback underrun");
+  }
+  if (NextPlayed == 0xFFFFFFFFU)
+  {
+    Fail(c, frames, "nothing played");
+  }
+
+  printf("%-28s level %3u..%3u frames, latency %.2f..%.2f ms, feedback %.4f..%.4f, "
+         "%u over, %u under\n",
+         c->Name, minLevel, maxLevel, minLevel * 1000.0 / AUDIO_FREQ,
+         maxLevel * 1000.0 / AUDIO_FREQ, fbMin / 16384.0, fbMax / 16384.0,
+         over1 - over0, under1 - under0);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 120U;
+
+  if (seconds < (2U * SETTLE_FRAMES / 1000U))
+  {
+    seconds = 2U * SETTLE_FRAMES / 1000U;
+  }
+
+  USBSIM_Reset();
+  Dev.dev_state = USBD_STATE_CONFIGURED;
+  Dev.pClassData = &CompHandle;
+  Dev.pUserData = &CompItf;
+  (void)USBD_AUDIO_RegisterInterface(&CompItf, &USBD_Audio_Interface_fops_FS);
+  if (USBD_AUDIO.Init(&Dev, 0U) != USBD_OK)
+  {
+    fprintf(stderr, "audio handle not allocated\n");
+    return 1;
+  }
+
+  for (size_t i = 0U; i < sizeof(Cases) / sizeof(Cases[0]); i++)
+  {
+    RunCase(&Cases[i], seconds);
+  }
+
+  (void)USBD_AUDIO.DeInit(&Dev, 0U);
+
+  if (Errors != 0U)
+  {
+    printf("FAIL: %u errors\n", Errors);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
@@ -0,0 +1,866 @@
+/*
+ * dfusim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test of the firmware upgrade function: usbd_dfu.c runs unchanged
+ *  behind a host that downloads images the way dfu-util does, DNLOAD then
+ *  GETSTATUS until dfuDNLOAD-IDLE, on a simulated flash media laid out as
+ *  the staging area of usbd_dfu_if.c: the image pages, then the page of
+ *  the complete mark, length and CRC-32 first, the magic last.
+ *
+ *  The flash behaves as the single bank one does: a row is programmed only
+ *  once erased, and the CPU stalls for each page erase and each fast
+ *  programmed row. The USB interrupt runs between two flash operations and
+ *  takes one stage of the control transfer, the host sends the next one a
+ *  packet later. The tick counts microseconds, the media times are round
+ *  figures: 22 ms a page, 4 ms a row.
+ *
+ *  Cases: images of several sizes, each marked complete with its CRC and
+ *  read back by UPLOAD, the 256 KB one timed against the flash alone; an
+ *  image larger than the staging area, stalled with errADDRESS; a page
+ *  erase failing mid-download; downloads cut off by an ABORT, by the cable
+ *  and by a power loss at every flash operation in turn. None of these
+ *  may leave a complete mark, and the next download must succeed.
+ *
+ *  Build (Linux):
+ *    M=../../Middlewares/ST/STM32_USB_Device_Library
+ *    gcc -O2 -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER -I../../Core/Inc \
+ *        -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -I../../USB_Device/Target \
+ *        -I../../USB_Device/App -I$M/Core/Inc -Wno-int-to-pointer-cast \
+ *        -Wno-pointer-to-int-cast -o dfusim dfusim.c ../usbsim/usbsim.c \
+ *        $M/Class/DFU/Src/usbd_dfu.c $M/Core/Src/usbd_core.c \
+ *        $M/Core/Src/usbd_ctlreq.c $M/Core/Src/usbd_ioreq.c
+ *
+ *  Usage:
+ *    dfusim
+ *  Exit status is 0 when every case passes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usbsim/usbsim.h"
+#include "usbd_dfu_if.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
+
+#define FLASH_ERASE_US                22000U
+#define FLASH_ROW_US                  4000U
+#define FLASH_DWORD_US                100U
+#define BUS_US_PER_PACKET             53U
+#define FRAME_US                      1000U
+
+#define SIM_FLASH_MARK                DFU_IMAGE_MAX_SIZE
+#define SIM_FLASH_SIZE                (DFU_IMAGE_MAX_SIZE + DFU_PAGE_SIZE)
+#define NO_FAILURE                    0xFFFFFFFFU
+
+/* Host side of a control transfer */
+#define HOST_OK                       0U
+#define HOST_STALL                    1U
+#define HOST_BABBLE                   2U
+#define HOST_DEAD                     3U      /* the device lost its power */
+
+#define STAGE_SETUP                   0U
+#define STAGE_DATA                    1U
+#define STAGE_STATUS                  2U
+#define STAGE_DONE                    3U
+
+/* The update may take this much longer than the flash operations alone */
+#define UPDATE_SLACK                  1.10
+
+typedef struct
+{
+  uint8_t  Setup[8];
+  uint8_t  *Data;
+  uint16_t Len;
+  uint16_t Done;
+  uint8_t  Stage;
+  uint8_t  Result;
+  uint32_t DueAt;       /* the host sends the next stage */
+}
+HostXfer;
+
+static int8_t Flash_Init(void);
+static int8_t Flash_DeInit(void);
+static int8_t Flash_Invalidate(void);
+static int8_t Flash_Erase(uint32_t offset);
+static int8_t Flash_Write(const uint8_t *src, uint32_t offset, uint32_t len);
+static int8_t Flash_Read(uint8_t *dest, uint32_t offset, uint32_t len);
+static int8_t Flash_Commit(uint32_t len, uint32_t crc);
+static uint32_t Flash_GetLength(void);
+
+/* RAM stand-in of the staging area of usbd_dfu_if.c */
+static USBD_DFU_MediaTypeDef SimFlash =
+{
+  Flash_Init,
+  Flash_DeInit,
+  Flash_Invalidate,
+  Flash_Erase,
+  Flash_Write,
+  Flash_Read,
+  Flash_Commit,
+  Flash_GetLength
+};
+
+static USBD_HandleTypeDef Dev;
+static USBD_Composite_HandleTypeDef CompHandle;
+static USBD_Comp_ItfTypeDef CompItf;
+static const char *CaseName;
+static unsigned Errors;
+
+static uint32_t Now;
+static uint32_t HostReady;    /* the host is done with its last transfer */
+static HostXfer Xfer;
+static uint8_t Status;        /* bStatus of the last GETSTATUS */
+static uint8_t Idle;
+
+static uint8_t Flash[SIM_FLASH_SIZE];
+static uint32_t FlashOps;
+static uint32_t FlashUs;
+static uint32_t PowerOps = NO_FAILURE;  /* operations before the power fails */
+static uint8_t PowerLost;
+static uint32_t FailErase = NO_FAILURE; /* page offset whose erase fails */
+static uint8_t EraseFailed;
+
+static uint8_t Image[DFU_IMAGE_MAX_SIZE + DFU_XFER_SIZE];
+static uint8_t Back[DFU_IMAGE_MAX_SIZE];
+
+static void Fail(const char *what)
+{
+  if (Errors < 20U)
+  {
+    fprintf(stderr, "  %s: %s\n", CaseName, what);
+  }
+  Errors++;
+}
+
+static uint32_t GetLE32(const uint8_t *p)
+{
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void PutLE32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+/* CRC-32, bit by bit, apart from the one of usbd_dfu.c */
+static uint32_t Crc32(const uint8_t *p, uint32_t len)
+{
+  uint32_t crc = 0xFFFFFFFFU;
+
+  while (len-- != 0U)
+  {
+    crc ^= *p++;
+    for (uint8_t k = 0U; k < 8U; k++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+
+  return ~crc;
+}
+
+static void Advance(uint32_t us)
+{
+  Now += us;
+  USBSIM_Tick = Now / 1000U;
+}
+
+static void HostStage(void);
+
+/* The USB interrupt, once the flash is done with an operation */
+static void Interrupt(void)
+{
+  if (!PowerLost && (Xfer.Stage != STAGE_DONE) && (Xfer.DueAt <= Now))
+  {
+    HostStage();
+  }
+}
+
+/* One flash operation, the CPU stalled for it. 0 when the power fails
+ * during it */
+static uint8_t FlashOp(uint32_t us)
+{
+  if (PowerLost)
+  {
+    return 0U;
+  }
+  if (PowerOps == 0U)
+  {
+    PowerLost = 1U;
+    return 0U;
+  }
+  if (PowerOps != NO_FAILURE)
+  {
+    PowerOps--;
+  }
+  FlashOps++;
+  FlashUs += us;
+  Advance(us);
+  return 1U;
+}
+
+static uint8_t Erased(const uint8_t *p, uint32_t len)
+{
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    if (p[i] != 0xFFU)
+    {
+      return 0U;
+    }
+  }
+  return 1U;
+}
+
+/* Simulated flash: an operation cut by the power loss is half done */
+static int8_t Flash_Init(void)
+{
+  return 0;
+}
+
+static int8_t Flash_DeInit(void)
+{
+  return 0;
+}
+
+static int8_t Flash_ErasePage(uint32_t offset)
+{
+  if (!FlashOp(FLASH_ERASE_US))
+  {
+    (void)memset(&Flash[offset], 0xFF, DFU_PAGE_SIZE / 2U);
+    return -1;
+  }
+  if (offset == FailErase)
+  {
+    EraseFailed = 1U;
+    Interrupt();
+    return -1;
+  }
+  (void)memset(&Flash[offset], 0xFF, DFU_PAGE_SIZE);
+  Interrupt();
+  return 0;
+}
+
+static int8_t Flash_Invalidate(void)
+{
+  if (Erased(&Flash[SIM_FLASH_MARK], 16U))
+  {
+    return 0;
+  }
+  return Flash_ErasePage(SIM_FLASH_MARK);
+}
+
+static int8_t Flash_Erase(uint32_t offset)
+{
+  if (((offset % DFU_PAGE_SIZE) != 0U) || (offset >= DFU_IMAGE_MAX_SIZE))
+  {
+    Fail("page erased outside the image area");
+    return -1;
+  }
+  return Flash_ErasePage(offset);
+}
+
+static int8_t Flash_Write(const uint8_t *src, uint32_t offset, uint32_t len)
+{
+  if (((offset % DFU_ROW_SIZE) != 0U) || ((len % DFU_ROW_SIZE) != 0U) ||
+      ((offset + len) > DFU_IMAGE_MAX_SIZE))
+  {
+    Fail("rows programmed outside the image area");
+    return -1;
+  }
+
+  for (uint32_t n = 0U; n < len; n += DFU_ROW_SIZE)
+  {
+    if (!Erased(&Flash[offset + n], DFU_ROW_SIZE))
+    {
+      Fail("row programmed without an erase");
+      return -1;
+    }
+    if (EraseFailed)
+    {
+      Fail("row programmed after an erase failed");
+    }
+    if (!FlashOp(FLASH_ROW_US))
+    {
+      (void)memcpy(&Flash[offset + n], &src[n], DFU_ROW_SIZE / 2U);
+      return -1;
+    }
+    (void)memcpy(&Flash[offset + n], &src[n], DFU_ROW_SIZE);
+    Interrupt();
+  }
+
+  return 0;
+}
+
+static int8_t Flash_Read(uint8_t *dest, uint32_t offset, uint32_t len)
+{
+  if ((offset + len) > DFU_IMAGE_MAX_SIZE)
+  {
+    return -1;
+  }
+  (void)memcpy(dest, &Flash[offset], len);
+  return 0;
+}
+
+/* Two double words, as DFU_Commit_FS programs them */
+static int8_t Flash_Commit(uint32_t len, uint32_t crc)
+{
+  uint8_t mark[16];
+
+  PutLE32(&mark[0], len);
+  PutLE32(&mark[4], crc);
+  PutLE32(&mark[8], DFU_MARK_MAGIC);
+  PutLE32(&mark[12], ~DFU_MARK_MAGIC);
+
+  if (!Erased(&Flash[SIM_FLASH_MARK], 16U))
+  {
+    Fail("complete mark programmed without an erase");
+    return -1;
+  }
+  for (uint32_t n = 0U; n < 16U; n += 8U)
+  {
+    if (!FlashOp(FLASH_DWORD_US))
+    {
+      (void)memcpy(&Flash[SIM_FLASH_MARK + n], &mark[n], 4U);
+      return -1;
+    }
+    (void)memcpy(&Flash[SIM_FLASH_MARK + n], &mark[n], 8U);
+    Interrupt();
+  }
+
+  return 0;
+}
+
+/* Same check as DFU_GetImage_FS */
+static uint32_t Flash_GetLength(void)
+{
+  uint32_t len = GetLE32(&Flash[SIM_FLASH_MARK]);
+
+  if ((GetLE32(&Flash[SIM_FLASH_MARK + 8U]) != DFU_MARK_MAGIC) ||
+      (GetLE32(&Flash[SIM_FLASH_MARK + 12U]) != ~DFU_MARK_MAGIC) ||
+      (len == 0U) || (len > DFU_IMAGE_MAX_SIZE))
+  {
+    return 0U;
+  }
+  return len;
+}
+
+static void End(uint8_t result)
+{
+  Xfer.Result = result;
+  Xfer.Stage = STAGE_DONE;
+  HostReady = Now;
+}
+
+/* Host, one stage of the control transfer: the SETUP, a data packet or
+ * the status. A NAK leaves it for the next turn */
+static void HostStage(void)
+{
+  USBSIM_EpTypeDef *in0 = USBSIM_Ep(0x80U);
+  USBSIM_EpTypeDef *out0 = USBSIM_Ep(0x00U);
+  uint8_t dirIn = ((Xfer.Setup[0] & 0x80U) != 0U) ? 1U : 0U;
+  uint32_t n;
+
+  Xfer.DueAt = Now + BUS_US_PER_PACKET;
+
+  switch (Xfer.Stage)
+  {
+    case STAGE_SETUP:
+      /* A SETUP clears the halt of EP0, as the PCD does */
+      in0->Armed = 0U;
+      in0->Halted = 0U;
+      out0->Armed = 0U;
+      out0->Halted = 0U;
+      (void)USBD_LL_SetupStage(&Dev, Xfer.Setup);
+      Xfer.Stage = (Xfer.Len != 0U) ? STAGE_DATA : STAGE_STATUS;
+      break;
+
+    case STAGE_DATA:
+      if (dirIn)
+      {
+        if (in0->Halted)
+        {
+          End(HOST_STALL);
+        }
+        else if (in0->Armed)
+        {
+          n = (in0->Len < USB_MAX_EP0_SIZE) ? in0->Len : USB_MAX_EP0_SIZE;
+          if ((Xfer.Done + n) > Xfer.Len)
+          {
+            End(HOST_BABBLE);
+            break;
+          }
+          (void)memcpy(&Xfer.Data[Xfer.Done], in0->Pma, n);
+          Xfer.Done += n;
+          USBSIM_DataIn(&Dev, 0x80U);
+          if ((n < USB_MAX_EP0_SIZE) || (Xfer.Done == Xfer.Len))
+          {
+            Xfer.Stage = STAGE_STATUS;
+          }
+        }
+      }
+      else if (out0->Halted)
+      {
+        End(HOST_STALL);
+      }
+      else if (out0->Armed)
+      {
+        n = Xfer.Len - Xfer.Done;
+        n = (n < USB_MAX_EP0_SIZE) ? n : USB_MAX_EP0_SIZE;
+        (void)memcpy(out0->Buf, &Xfer.Data[Xfer.Done], n);
+        Xfer.Done += n;
+        USBSIM_DataOut(&Dev, 0x00U, n);
+        if (Xfer.Done == Xfer.Len)
+        {
+          Xfer.Stage = STAGE_STATUS;
+        }
+      }
+      break;
+
+    default:
+      /* Status, the other way than the data */
+      if (dirIn && (Xfer.Len != 0U))
+      {
+        if (out0->Halted)
+        {
+          End(HOST_STALL);
+        }
+        else if (out0->Armed)
+        {
+          USBSIM_DataOut(&Dev, 0x00U, 0U);
+          End(HOST_OK);
+        }
+      }
+      else if (in0->Halted)
+      {
+        End(HOST_STALL);
+      }
+      else if (in0->Armed)
+      {
+        USBSIM_DataIn(&Dev, 0x80U);
+        End(HOST_OK);
+      }
+      break;
+  }
+}
+
+/* One turn of the device: the USB interrupt when a host stage is due,
+ * otherwise a step of the main loop, otherwise idle until the host. A
+ * step without flash work takes no time, a few in a row mean idle */
+static void Run(uint32_t until)
+{
+  uint32_t before = Now;
+
+  if ((Xfer.Stage != STAGE_DONE) && (Xfer.DueAt <= Now))
+  {
+    HostStage();
+    return;
+  }
+
+  USBD_DFU_Process(&Dev);
+  if (Now != before)
+  {
+    Idle = 0U;
+  }
+  else if (++Idle > 4U)
+  {
+    Idle = 0U;
+    if ((Xfer.Stage != STAGE_DONE) && (Xfer.DueAt < until))
+    {
+      until = Xfer.DueAt;
+    }
+    if (until > Now)
+    {
+      Advance(until - Now);
+    }
+  }
+}
+
+/* The device alone for us, the main loop done with the last blocks */
+static void Settle(uint32_t us)
+{
+  uint32_t until = Now + us;
+
+  while ((Now < until) && !PowerLost)
+  {
+    Run(until);
+  }
+}
+
+/* One control transfer to the DFU interface, from the next frame */
+static uint8_t Request(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                       uint8_t *data, uint16_t wLength)
+{
+  Xfer.Setup[0] = bmRequest;
+  Xfer.Setup[1] = bRequest;
+  Xfer.Setup[2] = LOBYTE(wValue);
+  Xfer.Setup[3] = HIBYTE(wValue);
+  Xfer.Setup[4] = LOBYTE(USBD_COMP_ITF_DFU);
+  Xfer.Setup[5] = HIBYTE(USBD_COMP_ITF_DFU);
+  Xfer.Setup[6] = LOBYTE(wLength);
+  Xfer.Setup[7] = HIBYTE(wLength);
+  Xfer.Data = data;
+  Xfer.Len = wLength;
+  Xfer.Done = 0U;
+  Xfer.DueAt = ((HostReady + FRAME_US - 1U) / FRAME_US) * FRAME_US;
+  Xfer.Stage = STAGE_SETUP;
+
+  while (Xfer.Stage != STAGE_DONE)
+  {
+    if (PowerLost)
+    {
+      Xfer.Stage = STAGE_DONE;
+      return HOST_DEAD;
+    }
+    Run(Xfer.DueAt);
+  }
+
+  return Xfer.Result;
+}
+
+/* GETSTATUS, then the host waits bwPollTimeout. Returns bState */
+static uint8_t GetStatus(void)
+{
+  uint8_t st[6];
+
+  switch (Request(0xA1U, DFU_GETSTATUS, 0U, st, 6U))
+  {
+    case HOST_OK:
+      break;
+
+    case HOST_DEAD:
+      return DFU_STATE_ERROR;
+
+    default:
+      Fail("GETSTATUS refused");
+      return DFU_STATE_ERROR;
+  }
+
+  Status = st[0];
+  HostReady = Now + ((st[1] | ((uint32_t)st[2] << 8) | ((uint32_t)st[3] << 16)) * 1000U);
+  return st[4];
+}
+
+/* Host, as dfu-util: each block DNLOAD then GETSTATUS until the device
+ * takes the next one, then the manifestation. Stops after stop bytes when
+ * less than the image. Returns the last bState, bStatus in Status */
+static uint8_t Download(const uint8_t *image, uint32_t len, uint32_t stop)
+{
+  uint16_t block = 0U;
+  uint32_t n;
+  uint8_t state;
+
+  for (uint32_t off = 0U; (off < len) && (off < stop); off += n, block++)
+  {
+    n = ((len - off) < DFU_XFER_SIZE) ? (len - off) : DFU_XFER_SIZE;
+    switch (Request(0x21U, DFU_DNLOAD, block, (uint8_t *)&image[off], (uint16_t)n))
+    {
+      case HOST_OK:
+        break;
+
+      case HOST_STALL:
+        return GetStatus();
+
+      default:
+        return DFU_STATE_ERROR;
+    }
+
+    do
+    {
+      state = GetStatus();
+    }
+    while (state == DFU_STATE_DNLOAD_BUSY);
+
+    if (state != DFU_STATE_DNLOAD_IDLE)
+    {
+      return state;
+    }
+  }
+
+  if (stop < len)
+  {
+    return DFU_STATE_DNLOAD_IDLE;
+  }
+
+  if (Request(0x21U, DFU_DNLOAD, block, NULL, 0U) != HOST_OK)
+  {
+    return GetStatus();
+  }
+  do
+  {
+    state = GetStatus();
+  }
+  while ((state == DFU_STATE_MANIFEST) || (state == DFU_STATE_MANIFEST_SYNC));
+
+  return state;
+}
+
+/* UPLOAD of the complete image, returns its length */
+static uint32_t Upload(uint8_t *dest)
+{
+  uint32_t len = 0U;
+  uint16_t block = 0U;
+
+  do
+  {
+    if (Request(0xA1U, DFU_UPLOAD, block++, &dest[len], DFU_XFER_SIZE) != HOST_OK)
+    {
+      Fail("UPLOAD refused");
+      return 0U;
+    }
+    len += Xfer.Done;
+  }
+  while (Xfer.Done == DFU_XFER_SIZE);
+
+  return len;
+}
+
+static void MakeImage(uint32_t len, uint32_t seed)
+{
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    Image[i] = (uint8_t)(((i + seed) * 2654435761U) >> 16);
+  }
+}
+
+/* Complete mark of an image of len bytes, whose CRC matches */
+static uint8_t Marked(const uint8_t *image, uint32_t len)
+{
+  return (Flash_GetLength() == len) &&
+         (GetLE32(&Flash[SIM_FLASH_MARK + 4U]) == Crc32(image, len)) &&
+         (memcmp(Flash, image, len) == 0);
+}
+
+/* Power back, or a new enumeration: the handle comes back in dfuIDLE */
+static void Reboot(void)
+{
+  PowerLost = 0U;
+  PowerOps = NO_FAILURE;
+  (void)USBD_DFU.DeInit(&Dev, 0U);
+  USBSIM_Reset();
+  USBSIM_Tick = Now / 1000U;
+  Xfer.Stage = STAGE_DONE;
+  HostReady = Now;
+  if (USBD_DFU.Init(&Dev, 0U) != USBD_OK)
+  {
+    Fail("DFU handle not allocated");
+    exit(1);
+  }
+}
+
+static void Start(const char *name)
+{
+  CaseName = name;
+  EraseFailed = 0U;
+  FailErase = NO_FAILURE;
+  Reboot();
+}
+
+/* Images of several sizes, the 256 KB one timed */
+static void RunImages(void)
+{
+  static const uint32_t Sizes[] =
+  {
+    1000U, 4096U, (195U * 1024U) + 300U, DFU_IMAGE_MAX_SIZE
+  };
+  USBD_DFU_StatsTypeDef stats;
+  uint32_t start, ops, flashUs, hostUs;
+
+  for (size_t i = 0U; i < sizeof(Sizes) / sizeof(Sizes[0]); i++)
+  {
+    Start("images");
+    MakeImage(Sizes[i], (uint32_t)i);
+    start = Now;
+    ops = FlashOps;
+    flashUs = FlashUs;
+    if ((Download(Image, Sizes[i], Sizes[i]) != DFU_STATE_IDLE) || (Status != DFU_ERROR_NONE))
+    {
+      Fail("download not back to dfuIDLE");
+    }
+    hostUs = Now - start;
+    flashUs = FlashUs - flashUs;
+    ops = FlashOps - ops;
+    if (!Marked(Image, Sizes[i]))
+    {
+      Fail("image not marked complete with its CRC");
+    }
+    (void)memset(Back, 0, sizeof(Back));
+    if ((Upload(Back) != Sizes[i]) || (memcmp(Back, Image, Sizes[i]) != 0))
+    {
+      Fail("UPLOAD differs from the image");
+    }
+
+    (void)USBD_DFU_GetStats(&Dev, &stats);
+    if (stats.ImageSize != Sizes[i])
+    {
+      Fail("ImageSize");
+    }
+    if ((Sizes[i] >= (64U * 1024U)) && (hostUs > (flashUs * UPDATE_SLACK)))
+    {
+      Fail("the host waits on top of the flash");
+    }
+    printf("%7u bytes: %5.3f s, flash %5.3f s in %4u operations, UpdateMs %u, "
+           "%u busy polls, %.1f KB/s\n",
+           Sizes[i], hostUs * 1e-6, flashUs * 1e-6, ops, stats.UpdateMs,
+           stats.BusyPolls, Sizes[i] / 1.024 / ((hostUs != 0U) ? (hostUs * 1e-3) : 1.0));
+  }
+}
+
+/* Larger than the staging area: the block past it is stalled */
+static void RunOversized(void)
+{
+  uint32_t len = DFU_IMAGE_MAX_SIZE + DFU_XFER_SIZE;
+
+  Start("oversized image");
+  MakeImage(len, 7U);
+  if ((Download(Image, len, len) != DFU_STATE_ERROR) || (Status != DFU_ERROR_ADDRESS))
+  {
+    Fail("not stalled with errADDRESS");
+  }
+  Settle(100000U);
+  if ((Flash_GetLength() != 0U) || !Erased(&Flash[SIM_FLASH_MARK], DFU_PAGE_SIZE))
+  {
+    Fail("complete mark left");
+  }
+  if ((Request(0x21U, DFU_CLRSTATUS, 0U, NULL, 0U) != HOST_OK) || (GetStatus() != DFU_STATE_IDLE))
+  {
+    Fail("CLRSTATUS not back to dfuIDLE");
+  }
+  printf("%-28s stalled, errADDRESS, no mark\n", CaseName);
+}
+
+/* A page erase fails mid-download: dfuERROR, nothing programmed after it */
+static void RunEraseFailure(void)
+{
+  uint32_t len = 128U * 1024U;
+
+  Start("erase failure");
+  MakeImage(len, 11U);
+  FailErase = 0x10000U;
+  if ((Download(Image, len, len) != DFU_STATE_ERROR) || (Status != DFU_ERROR_ERASE))
+  {
+    Fail("not reported as errERASE");
+  }
+  Settle(100000U);
+  if (Flash_GetLength() != 0U)
+  {
+    Fail("complete mark left");
+  }
+
+  FailErase = NO_FAILURE;
+  EraseFailed = 0U;
+  if ((Request(0x21U, DFU_CLRSTATUS, 0U, NULL, 0U) != HOST_OK) ||
+      (Download(Image, len, len) != DFU_STATE_IDLE) || !Marked(Image, len))
+  {
+    Fail("no complete download after the error");
+  }
+  printf("%-28s dfuERROR, errERASE, no mark, next download complete\n", CaseName);
+}
+
+/* Downloads cut off by the host, by the cable, by the power */
+static void RunCutOff(void)
+{
+  uint32_t lenA = 8U * 1024U;
+  uint32_t lenB = (10U * 1024U) + 100U;
+  uint32_t cuts = 0U;
+
+  Start("ABORT");
+  MakeImage(64U * 1024U, 3U);
+  if ((Download(Image, 64U * 1024U, 32U * 1024U) != DFU_STATE_DNLOAD_IDLE) ||
+      (Request(0x21U, DFU_ABORT, 0U, NULL, 0U) != HOST_OK) || (GetStatus() != DFU_STATE_IDLE))
+  {
+    Fail("ABORT not back to dfuIDLE");
+  }
+  Settle(200000U);
+  if (Flash_GetLength() != 0U)
+  {
+    Fail("complete mark left");
+  }
+
+  CaseName = "cable pulled";
+  MakeImage(64U * 1024U, 4U);
+  (void)Download(Image, 64U * 1024U, 40U * 1024U);
+  Reboot();
+  Settle(200000U);
+  if (Flash_GetLength() != 0U)
+  {
+    Fail("complete mark left");
+  }
+  if ((Download(Image, 64U * 1024U, 64U * 1024U) != DFU_STATE_IDLE) ||
+      !Marked(Image, 64U * 1024U))
+  {
+    Fail("no complete download after the cut");
+  }
+
+  /* Power lost at each flash operation in turn, an image complete before */
+  CaseName = "power loss";
+  for (uint32_t k = 0U; ; k++)
+  {
+    Reboot();
+    MakeImage(lenA, 5U);
+    if (Download(Image, lenA, lenA) != DFU_STATE_IDLE)
+    {
+      Fail("first image not complete");
+    }
+
+    MakeImage(lenB, 6U);
+    PowerOps = k;
+    (void)Download(Image, lenB, lenB);
+    if (!PowerLost)
+    {
+      if (!Marked(Image, lenB))
+      {
+        Fail("image not marked complete");
+      }
+      break;
+    }
+
+    cuts++;
+    Reboot();
+    Settle(100000U);
+    if (Flash_GetLength() != 0U)
+    {
+      Fail("complete mark left after a power loss");
+    }
+    if ((Download(Image, lenB, lenB) != DFU_STATE_IDLE) || !Marked(Image, lenB))
+    {
+      Fail("no complete download after the power loss");
+    }
+  }
+
+  printf("%-28s no mark after ABORT, cable or %u power losses, next download complete\n",
+         "cut off", cuts);
+}
+
+int main(int argc, char **argv)
+{
+  Dev.dev_state = USBD_STATE_CONFIGURED;
+  Dev.pClass = &USBD_DFU;
+  Dev.pClassData = &CompHandle;
+  Dev.pUserData = &CompItf;
+  Dev.ep_in[0].maxpacket = USB_MAX_EP0_SIZE;
+  Dev.ep_out[0].maxpacket = USB_MAX_EP0_SIZE;
+  (void)USBD_DFU_RegisterMedia(&CompItf, &SimFlash);
+  (void)memset(Flash, 0xFF, sizeof(Flash));
+
+  RunImages();
+  RunOversized();
+  RunEraseFailure();
+  RunCutOff();
+
+  if (Errors != 0U)
+  {
+    printf("FAIL: %u errors\n", Errors);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
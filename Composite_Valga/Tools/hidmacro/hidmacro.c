@@ -0,0 +1,807 @@
+/*
+ * hidmacro.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host compiler for the keyboard macro bytecode played by usbd_hid_macro.c.
+ *
+ *  Build (Linux):
+ *    gcc -O2 -Wall -o hidmacro hidmacro.c \
+ *        ../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Src/usbd_hid_layout.c
+ *
+ *  Usage:
+ *    hidmacro -c macro.hm -o macro.c [-n name]   compile to a const C array
+ *    hidmacro -c macro.hm -b macro.bin           compile to a raw binary
+ *    hidmacro -d macro.bin                       disassemble to source
+ *    hidmacro -r macro.hm                        compile, disassemble, compile
+ *                                                again and compare the bytecode
+ *    hidmacro -t                                 round trip the built-in sources,
+ *                                                exit status 0 when all match
+ *
+ *  Source, one statement per line, '#' starts a comment:
+ *    layout us|es            host layout for the following text/chars
+ *    text "Hello\n"          keys resolved now with the current layout
+ *    chars "Hello"           characters resolved by the device layout
+ *    key LCTRL+LALT+DELETE   tap a key, modifiers joined with '+'
+ *    hold LSHIFT             keep modifiers pressed for the following keys
+ *    release LSHIFT          let them go
+ *    delay 250               wait, in ms
+ *    report 02 E9 00         raw report frame, report ID first
+ *  Strings accept \n \r \t \b \e \\ \" and \xNN.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define HID_MACRO_HOST_TOOL
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid_macro.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid_layout.h"
+
+#define MAX_PROGRAM   65536U
+#define MAX_LINE      1024U
+
+typedef struct
+{
+  uint8_t  data[MAX_PROGRAM];
+  uint32_t size;
+  uint8_t  layout;
+  uint8_t  held;
+  unsigned line;
+  const char *file;
+}
+Program;
+
+typedef struct
+{
+  const char *name;
+  uint8_t     value;
+}
+Name;
+
+static const Name ModifierNames[] =
+{
+  { "LCTRL", 0x01 }, { "LSHIFT", 0x02 }, { "LALT", 0x04 }, { "LGUI", 0x08 },
+  { "RCTRL", 0x10 }, { "RSHIFT", 0x20 }, { "RALT", 0x40 }, { "RGUI", 0x80 },
+};
+
+static const Name KeyNames[] =
+{
+  { "ENTER", 0x28 }, { "ESC", 0x29 }, { "BACKSPACE", 0x2A }, { "TAB", 0x2B },
+  { "SPACE", 0x2C }, { "CAPSLOCK", 0x39 }, { "F1", 0x3A }, { "F2", 0x3B },
+  { "F3", 0x3C }, { "F4", 0x3D }, { "F5", 0x3E }, { "F6", 0x3F },
+  { "F7", 0x40 }, { "F8", 0x41 }, { "F9", 0x42 }, { "F10", 0x43 },
+  { "F11", 0x44 }, { "F12", 0x45 }, { "PRINTSCREEN", 0x46 }, { "SCROLLLOCK", 0x47 },
+  { "PAUSE", 0x48 }, { "INSERT", 0x49 }, { "HOME", 0x4A }, { "PAGEUP", 0x4B },
+  { "DELETE", 0x4C }, { "END", 0x4D }, { "PAGEDOWN", 0x4E }, { "RIGHT", 0x4F },
+  { "LEFT", 0x50 }, { "DOWN", 0x51 }, { "UP", 0x52 }, { "NUMLOCK", 0x53 },
+  { "MENU", 0x65 },
+};
+
+static const char *LayoutNames[HID_NUM_LAYOUTS] = { "us", "es" };
+
+#define COUNT_OF(a)   (sizeof(a) / sizeof((a)[0]))
+
+/* The layout tables are indexed by character, a short table would shift them */
+typedef char LayoutTableSizeCheck[(sizeof(HID_LayoutTable[0]) / sizeof(HID_LayoutTable[0][0]) == 95U) ? 1 : -1];
+
+static void fail(const Program *p, const char *msg, const char *arg)
+{
+  fprintf(stderr, "%s:%u: %s%s%s\n", p->file, p->line, msg, arg ? ": " : "", arg ? arg : "");
+  exit(1);
+}
+
+static void emit(Program *p, uint8_t byte)
+{
+  if (p->size >= MAX_PROGRAM)
+  {
+    fail(p, "program too large", NULL);
+  }
+  p->data[p->size++] = byte;
+}
+
+static int lookup(const Name *table, size_t count, const char *name, uint8_t *value)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    if (strcasecmp(table[i].name, name) == 0)
+    {
+      *value = table[i].value;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int parse_number(const char *s, unsigned long max, unsigned long *value)
+{
+  char *end;
+
+  if (*s == '\0')
+  {
+    return 0;
+  }
+  *value = strtoul(s, &end, 0);
+  return (*end == '\0') && (*value <= max);
+}
+
+/* "LCTRL+LALT+DELETE": modifiers, then an optional key. Returns 1 if a key was given */
+static int parse_combo(Program *p, char *arg, uint8_t *mods, uint8_t *usage)
+{
+  char *tok;
+  unsigned long n;
+  uint8_t v;
+  int have_key = 0;
+
+  *mods = 0;
+  *usage = 0;
+
+  for (tok = strtok(arg, "+"); tok != NULL; tok = strtok(NULL, "+"))
+  {
+    if (have_key)
+    {
+      fail(p, "the key must come last", tok);
+    }
+    if (lookup(ModifierNames, COUNT_OF(ModifierNames), tok, &v))
+    {
+      *mods |= v;
+    }
+    else if (lookup(KeyNames, COUNT_OF(KeyNames), tok, &v))
+    {
+      *usage = v;
+      have_key = 1;
+    }
+    else if ((strlen(tok) == 1) && isalnum((unsigned char)tok[0]))
+    {
+      /* Letters and digits by their US position */
+      *usage = HID_LAYOUT_USAGE(HID_Layout_Lookup(HID_LAYOUT_US, (uint8_t)tolower((unsigned char)tok[0])));
+      have_key = 1;
+    }
+    else if (parse_number(tok, 0xFF, &n))
+    {
+      *usage = (uint8_t)n;
+      have_key = 1;
+    }
+    else
+    {
+      fail(p, "unknown key or modifier", tok);
+    }
+  }
+  return have_key;
+}
+
+/* Decode a quoted string in place, returns its length */
+static size_t parse_string(Program *p, char *arg)
+{
+  char *src = arg;
+  char *dst = arg;
+  unsigned long n;
+  char hex[3];
+
+  if (*src++ != '"')
+  {
+    fail(p, "expected a quoted string", arg);
+  }
+  while (*src != '"')
+  {
+    if (*src == '\0')
+    {
+      fail(p, "unterminated string", NULL);
+    }
+    if (*src != '\\')
+    {
+      *dst++ = *src++;
+      continue;
+    }
+    src++;
+    switch (*src++)
+    {
+      case 'n':  *dst++ = '\n'; break;
+      case 'r':  *dst++ = '\r'; break;
+      case 't':  *dst++ = '\t'; break;
+      case 'b':  *dst++ = '\b'; break;
+      case 'e':  *dst++ = 0x1B; break;
+      case '\\': *dst++ = '\\'; break;
+      case '"':  *dst++ = '"'; break;
+      case 'x':
+        if (!isxdigit((unsigned char)src[0]) || !isxdigit((unsigned char)src[1]))
+        {
+          fail(p, "bad \\x escape", NULL);
+        }
+        hex[0] = src[0];
+        hex[1] = src[1];
+        hex[2] = '\0';
+        n = strtoul(hex, NULL, 16);
+        *dst++ = (char)n;
+        src += 2;
+        break;
+      default:
+        fail(p, "unknown escape", NULL);
+    }
+  }
+  if (src[1] != '\0')
+  {
+    fail(p, "trailing characters after string", src + 1);
+  }
+  return (size_t)(dst - arg);
+}
+
+static void compile_line(Program *p, char *line)
+{
+  char *cmd;
+  char *arg;
+  char *tok;
+  unsigned long n;
+  uint8_t mods;
+  uint8_t usage;
+  uint8_t frame[HID_MACRO_MAX_FRAME];
+  size_t len;
+  size_t i;
+  uint16_t entry;
+
+  /* Strip the comment, quotes may hold a '#' (len: inside a string) */
+  for (i = 0, len = 0; line[i] != '\0'; i++)
+  {
+    if ((len != 0U) && (line[i] == '\\') && (line[i + 1] != '\0'))
+    {
+      i++;
+    }
+    else if (line[i] == '"')
+    {
+      len ^= 1U;
+    }
+    else if ((line[i] == '#') && (len == 0U))
+    {
+      line[i] = '\0';
+      break;
+    }
+  }
+
+  cmd = strtok(line, " \t\r\n");
+  if (cmd == NULL)
+  {
+    return;
+  }
+  arg = strtok(NULL, "\r\n");
+  while ((arg != NULL) && isspace((unsigned char)*arg))
+  {
+    arg++;
+  }
+  if (arg != NULL)
+  {
+    for (len = strlen(arg); (len > 0U) && isspace((unsigned char)arg[len - 1U]); len--)
+    {
+      arg[len - 1U] = '\0';
+    }
+  }
+  if ((arg == NULL) || (*arg == '\0'))
+  {
+    fail(p, "missing argument", cmd);
+  }
+
+  if (strcmp(cmd, "layout") == 0)
+  {
+    for (i = 0; i < HID_NUM_LAYOUTS; i++)
+    {
+      if (strcasecmp(arg, LayoutNames[i]) == 0)
+      {
+        break;
+      }
+    }
+    if (i == HID_NUM_LAYOUTS)
+    {
+      /* Numeric layouts the tool does not know, kept for round trips */
+      if (!parse_number(arg, 0xFF, &n))
+      {
+        fail(p, "unknown layout", arg);
+      }
+      i = n;
+    }
+    p->layout = (uint8_t)i;
+    if (p->layout >= HID_NUM_LAYOUTS)
+    {
+      fprintf(stderr, "%s:%u: warning: text uses the us layout after an unknown layout\n", p->file, p->line);
+      p->layout = HID_LAYOUT_US;
+      emit(p, HID_MACRO_OP_LAYOUT);
+      emit(p, (uint8_t)i);
+      return;
+    }
+    emit(p, HID_MACRO_OP_LAYOUT);
+    emit(p, p->layout);
+  }
+  else if (strcmp(cmd, "text") == 0)
+  {
+    len = parse_string(p, arg);
+    for (i = 0; i < len; i++)
+    {
+      entry = HID_Layout_Lookup(p->layout, (uint8_t)arg[i]);
+      if (entry == 0U)
+      {
+        char c[8];
+        snprintf(c, sizeof(c), "0x%02X", (uint8_t)arg[i]);
+        fail(p, "character has no key on this layout", c);
+      }
+      emit(p, HID_MACRO_OP_KEY);
+      emit(p, HID_LAYOUT_MOD(entry));
+      emit(p, HID_LAYOUT_USAGE(entry));
+    }
+  }
+  else if (strcmp(cmd, "chars") == 0)
+  {
+    len = parse_string(p, arg);
+    for (i = 0; i < len; i++)
+    {
+      emit(p, HID_MACRO_OP_CHAR);
+      emit(p, (uint8_t)arg[i]);
+    }
+  }
+  else if (strcmp(cmd, "key") == 0)
+  {
+    if (!parse_combo(p, arg, &mods, &usage))
+    {
+      fail(p, "key needs a key, use hold for modifiers", NULL);
+    }
+    emit(p, HID_MACRO_OP_KEY);
+    emit(p, mods);
+    emit(p, usage);
+  }
+  else if ((strcmp(cmd, "hold") == 0) || (strcmp(cmd, "release") == 0))
+  {
+    if (parse_combo(p, arg, &mods, &usage))
+    {
+      fail(p, "only modifiers can be held", NULL);
+    }
+    if (cmd[0] == 'h')
+    {
+      p->held |= mods;
+      emit(p, HID_MACRO_OP_HOLD);
+    }
+    else
+    {
+      p->held &= (uint8_t)~mods;
+      emit(p, HID_MACRO_OP_RELEASE);
+    }
+    emit(p, mods);
+  }
+  else if (strcmp(cmd, "delay") == 0)
+  {
+    if (!parse_number(arg, 0xFFFF, &n))
+    {
+      fail(p, "delay is 0..65535 ms", arg);
+    }
+    emit(p, HID_MACRO_OP_DELAY);
+    emit(p, (uint8_t)(n & 0xFF));
+    emit(p, (uint8_t)(n >> 8));
+  }
+  else if (strcmp(cmd, "report") == 0)
+  {
+    len = 0;
+    for (tok = strtok(arg, " \t"); tok != NULL; tok = strtok(NULL, " \t"))
+    {
+      /* Report bytes are always hex, with or without 0x */
+      char *end;
+      n = strtoul(tok, &end, 16);
+      if ((len == HID_MACRO_MAX_FRAME) || (*end != '\0') || (n > 0xFF))
+      {
+        fail(p, "report is 1 to 8 hex bytes", tok);
+      }
+      frame[len++] = (uint8_t)n;
+    }
+    emit(p, HID_MACRO_OP_REPORT);
+    emit(p, (uint8_t)len);
+    for (i = 0; i < len; i++)
+    {
+      emit(p, frame[i]);
+    }
+  }
+  else
+  {
+    fail(p, "unknown statement", cmd);
+  }
+}
+
+static void compile_file(Program *p, const char *path)
+{
+  char line[MAX_LINE];
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    exit(1);
+  }
+
+  memset(p, 0, sizeof(*p));
+  p->file = path;
+  p->layout = HID_LAYOUT_US;
+
+  emit(p, HID_MACRO_MAGIC_0);
+  emit(p, HID_MACRO_MAGIC_1);
+  emit(p, HID_MACRO_VERSION);
+  emit(p, 0x00);
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    p->line++;
+    compile_line(p, line);
+  }
+  fclose(f);
+
+  if (p->held != 0U)
+  {
+    fprintf(stderr, "%s: warning: modifiers 0x%02X still held at the end\n", path, p->held);
+  }
+  emit(p, HID_MACRO_OP_END);
+}
+
+static void print_mods(FILE *out, uint8_t mods, int plus)
+{
+  size_t i;
+  int first = 1;
+
+  for (i = 0; i < COUNT_OF(ModifierNames); i++)
+  {
+    if (mods & ModifierNames[i].value)
+    {
+      fprintf(out, "%s%s", (first || !plus) ? "" : "+", ModifierNames[i].name);
+      if (!plus)
+      {
+        fputc('+', out);
+      }
+      first = 0;
+    }
+  }
+}
+
+static void print_char(FILE *out, uint8_t c)
+{
+  switch (c)
+  {
+    case '\n': fputs("\\n", out); break;
+    case '\r': fputs("\\r", out); break;
+    case '\t': fputs("\\t", out); break;
+    case '\b': fputs("\\b", out); break;
+    case 0x1B: fputs("\\e", out); break;
+    case '\\': fputs("\\\\", out); break;
+    case '"':  fputs("\\\"", out); break;
+    default:
+      if ((c >= 0x20) && (c < 0x7F) && (c != '#'))
+      {
+        fputc(c, out);
+      }
+      else
+      {
+        fprintf(out, "\\x%02X", c);
+      }
+      break;
+  }
+}
+
+/* Returns 0 on success */
+static int disassemble(const uint8_t *code, uint32_t size, FILE *out)
+{
+  uint32_t pc = HID_MACRO_HEADER_SIZE;
+  uint32_t i;
+
+  if ((size < HID_MACRO_HEADER_SIZE) || (code[0] != HID_MACRO_MAGIC_0) ||
+      (code[1] != HID_MACRO_MAGIC_1) || (code[2] != HID_MACRO_VERSION))
+  {
+    fprintf(stderr, "not a version %u macro\n", HID_MACRO_VERSION);
+    return 1;
+  }
+
+  while (pc < size)
+  {
+    uint8_t op = code[pc];
+    uint32_t need = (op == HID_MACRO_OP_END) ? 1U :
+                    (op == HID_MACRO_OP_REPORT) ? 2U :
+                    ((op == HID_MACRO_OP_KEY) || (op == HID_MACRO_OP_DELAY)) ? 3U : 2U;
+
+    if ((pc + need > size) ||
+        ((op == HID_MACRO_OP_REPORT) && (pc + 2U + code[pc + 1] > size)))
+    {
+      fprintf(stderr, "truncated at offset %u\n", pc);
+      return 1;
+    }
+
+    switch (op)
+    {
+      case HID_MACRO_OP_END:
+        return (pc + 1U == size) ? 0 : (fprintf(stderr, "data after end\n"), 1);
+
+      case HID_MACRO_OP_REPORT:
+        fputs("report", out);
+        for (i = 0; i < code[pc + 1]; i++)
+        {
+          fprintf(out, " %02X", code[pc + 2 + i]);
+        }
+        fputc('\n', out);
+        pc += 2U + code[pc + 1];
+        continue;
+
+      case HID_MACRO_OP_KEY:
+        fputs("key ", out);
+        print_mods(out, code[pc + 1], 0);
+        fprintf(out, "0x%02X\n", code[pc + 2]);
+        break;
+
+      case HID_MACRO_OP_DELAY:
+        fprintf(out, "delay %u\n", code[pc + 1] | (code[pc + 2] << 8));
+        break;
+
+      case HID_MACRO_OP_HOLD:
+      case HID_MACRO_OP_RELEASE:
+        if (code[pc + 1] == 0U)
+        {
+          fprintf(stderr, "empty hold/release at offset %u\n", pc);
+          return 1;
+        }
+        fputs((op == HID_MACRO_OP_HOLD) ? "hold " : "release ", out);
+        print_mods(out, code[pc + 1], 1);
+        fputc('\n', out);
+        break;
+
+      case HID_MACRO_OP_LAYOUT:
+        if (code[pc + 1] < HID_NUM_LAYOUTS)
+        {
+          fprintf(out, "layout %s\n", LayoutNames[code[pc + 1]]);
+        }
+        else
+        {
+          fprintf(out, "layout %u\n", code[pc + 1]);
+        }
+        break;
+
+      case HID_MACRO_OP_CHAR:
+        /* Fold runs of characters back into one string */
+        fputs("chars \"", out);
+        while ((pc + 1U < size) && (code[pc] == HID_MACRO_OP_CHAR))
+        {
+          print_char(out, code[pc + 1]);
+          pc += 2U;
+        }
+        fputs("\"\n", out);
+        continue;
+
+      default:
+        fprintf(stderr, "unknown opcode 0x%02X at offset %u\n", op, pc);
+        return 1;
+    }
+    pc += need;
+  }
+
+  fprintf(stderr, "missing end\n");
+  return 1;
+}
+
+static void write_c(const Program *p, const char *path, const char *name)
+{
+  FILE *f = fopen(path, "w");
+  uint32_t i;
+
+  if (f == NULL)
+  {
+    perror(path);
+    exit(1);
+  }
+
+  fprintf(f, "/* Generated by hidmacro from %s, do not edit */\n\n", p->file);
+  fprintf(f, "#include <stdint.h>\n\n");
+  fprintf(f, "const uint8_t %s[%u] =\n{", name, p->size);
+  for (i = 0; i < p->size; i++)
+  {
+    fprintf(f, "%s0x%02X,", (i % 12U) ? " " : "\n  ", p->data[i]);
+  }
+  fprintf(f, "\n};\n");
+  fclose(f);
+}
+
+/* Compile the listing of a program again and compare. Returns 0 when both
+ * give the same bytecode */
+static int round_trip(const Program *p, const char *name)
+{
+  static Program again;
+  char tmp[] = "/tmp/hidmacroXXXXXX";
+  FILE *f;
+  int fd;
+
+  fd = mkstemp(tmp);
+  f = (fd < 0) ? NULL : fdopen(fd, "w");
+  if (f == NULL)
+  {
+    perror("temporary file");
+    return 1;
+  }
+  if (disassemble(p->data, p->size, f) != 0)
+  {
+    fclose(f);
+    remove(tmp);
+    return 1;
+  }
+  fclose(f);
+  compile_file(&again, tmp);
+  remove(tmp);
+  if ((again.size != p->size) || (memcmp(again.data, p->data, p->size) != 0))
+  {
+    fprintf(stderr, "%s: round trip mismatch\n", name);
+    return 1;
+  }
+  printf("%s: %u bytes, round trip ok\n", name, p->size);
+  return 0;
+}
+
+typedef struct
+{
+  const char    *source;
+  const uint8_t *bytecode;    /* expected, NULL for the round trip alone */
+  uint32_t      size;
+}
+TestCase;
+
+static const uint8_t TestDelete[] =
+{
+  HID_MACRO_MAGIC_0, HID_MACRO_MAGIC_1, HID_MACRO_VERSION, 0x00,
+  HID_MACRO_OP_KEY, 0x05, 0x4C,
+  HID_MACRO_OP_DELAY, 0xFA, 0x00,
+  HID_MACRO_OP_END
+};
+
+/* Sources of -t, every statement and escape at least once */
+static const TestCase TestCases[] =
+{
+  { "key LCTRL+LALT+DELETE\ndelay 250\n", TestDelete, sizeof(TestDelete) },
+  { "layout us\ntext \"Hello, World!\\n\"\nlayout es\ntext \"Hola, mundo (1+2=3)?\\n\"\n", NULL, 0 },
+  { "hold LSHIFT+RALT\nchars \"a\\tb\\e\\\\\\\"\\x7F\"\nrelease LSHIFT\nrelease RALT\n", NULL, 0 },
+  { "# login\ntext \"pass#word\" # not typed\nkey ENTER\ndelay 65535\n", NULL, 0 },
+  { "report 02 E9 00\nreport 0x03 1 2 3 4 5 6 7\nkey F12\nkey 0x65\n", NULL, 0 },
+};
+
+/* Built-in round trips, and the bytecode of the cases that give it */
+static int self_test(void)
+{
+  static Program prog;
+  char path[sizeof("/tmp/hidmacroXXXXXX")];
+  char name[16];
+  unsigned errors = 0;
+  size_t i;
+  FILE *f;
+  int fd;
+
+  for (i = 0; i < COUNT_OF(TestCases); i++)
+  {
+    strcpy(path, "/tmp/hidmacroXXXXXX");
+    fd = mkstemp(path);
+    f = (fd < 0) ? NULL : fdopen(fd, "w");
+    if (f == NULL)
+    {
+      perror("temporary file");
+      return 1;
+    }
+    fputs(TestCases[i].source, f);
+    fclose(f);
+    compile_file(&prog, path);
+    remove(path);
+
+    snprintf(name, sizeof(name), "case %u", (unsigned)(i + 1U));
+    if ((TestCases[i].bytecode != NULL) &&
+        ((prog.size != TestCases[i].size) || (memcmp(prog.data, TestCases[i].bytecode, prog.size) != 0)))
+    {
+      fprintf(stderr, "%s: unexpected bytecode\n", name);
+      errors++;
+    }
+    if (round_trip(&prog, name) != 0)
+    {
+      errors++;
+    }
+  }
+
+  return (errors == 0U) ? 0 : 1;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: hidmacro -c file.hm (-o file.c [-n name] | -b file.bin)\n"
+          "       hidmacro -d file.bin\n"
+          "       hidmacro -r file.hm\n"
+          "       hidmacro -t\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  static Program prog;
+  static uint8_t bin[MAX_PROGRAM];
+  const char *mode = NULL;
+  const char *in = NULL;
+  const char *out_c = NULL;
+  const char *out_bin = NULL;
+  const char *name = "hid_macro";
+  FILE *f;
+  size_t size;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (((strcmp(argv[i], "-c") == 0) || (strcmp(argv[i], "-d") == 0) ||
+         (strcmp(argv[i], "-r") == 0)) && (i + 1 < argc))
+    {
+      mode = argv[i];
+      in = argv[++i];
+    }
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      mode = argv[i];
+    }
+    else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+    {
+      out_c = argv[++i];
+    }
+    else if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+    {
+      out_bin = argv[++i];
+    }
+    else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+    {
+      name = argv[++i];
+    }
+    else
+    {
+      usage();
+    }
+  }
+  if (mode == NULL)
+  {
+    usage();
+  }
+
+  if (mode[1] == 't')
+  {
+    return self_test();
+  }
+
+  if (mode[1] == 'd')
+  {
+    f = fopen(in, "rb");
+    if (f == NULL)
+    {
+      perror(in);
+      return 1;
+    }
+    size = fread(bin, 1, sizeof(bin), f);
+    fclose(f);
+    return disassemble(bin, (uint32_t)size, stdout);
+  }
+
+  compile_file(&prog, in);
+
+  if (mode[1] == 'r')
+  {
+    return round_trip(&prog, in);
+  }
+
+  if ((out_c == NULL) && (out_bin == NULL))
+  {
+    usage();
+  }
+  if (out_c != NULL)
+  {
+    write_c(&prog, out_c, name);
+  }
+  if (out_bin != NULL)
+  {
+    f = fopen(out_bin, "wb");
+    if ((f == NULL) || (fwrite(prog.data, 1, prog.size, f) != prog.size))
+    {
+      perror(out_bin);
+      return 1;
+    }
+    fclose(f);
+  }
+  return 0;
+}
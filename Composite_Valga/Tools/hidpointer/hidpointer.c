@@ -0,0 +1,273 @@
+/*
+ * hidpointer.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test of the pointer motion accumulator of usbd_hid_pointer.h.
+ *  A motion trace is replayed through HID_Pointer_Add, one report per poll
+ *  is taken with HID_Pointer_Take, and the position integrated by the host
+ *  from the reports is checked against the motion fed in: every report
+ *  field stays in its logical range and no motion is lost or duplicated.
+ *
+ *  Build (Linux):
+ *    gcc -O2 -Wall -o hidpointer hidpointer.c
+ *
+ *  Usage:
+ *    hidpointer                  replay the built-in traces
+ *    hidpointer trace.txt        replay a trace, one event per line:
+ *                                  move dx dy wheel
+ *                                  poll [count]
+ *                                '#' starts a comment
+ *  Exit status is 0 when every check passes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HID_POINTER_HOST_TOOL
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid_pointer.h"
+
+typedef struct
+{
+  int32_t  acc[3];      /* device accumulators: x, y, wheel */
+  int64_t  fed[3];      /* motion fed in, as the device kept it */
+  int64_t  host[3];     /* position integrated from the reports */
+  uint32_t moves;
+  uint32_t polls;
+  uint32_t reports;
+  unsigned errors;
+}
+Replay;
+
+static const int32_t FieldMax[3] =
+{
+  HID_POINTER_DELTA_MAX, HID_POINTER_DELTA_MAX, HID_POINTER_WHEEL_MAX
+};
+
+static const char *const AxisName[3] = { "x", "y", "wheel" };
+
+static void Check(Replay *r, int ok, const char *what, int axis)
+{
+  if (!ok)
+  {
+    if (r->errors < 10U)
+    {
+      fprintf(stderr, "  %s (%s) after %u moves, %u polls\n",
+              what, AxisName[axis], r->moves, r->polls);
+    }
+    r->errors++;
+  }
+}
+
+/* Same sequence as USBD_HID_Pointer_Move */
+static void Move(Replay *r, int32_t dx, int32_t dy, int32_t wheel)
+{
+  int32_t delta[3] = { dx, dy, wheel };
+
+  for (int i = 0; i < 3; i++)
+  {
+    int32_t before = r->acc[i];
+
+    r->acc[i] = HID_Pointer_Add(r->acc[i], delta[i]);
+    Check(r, (r->acc[i] >= -INT32_MAX), "accumulator below -INT32_MAX", i);
+    /* Saturation drops motion, account only for what was kept */
+    r->fed[i] += (int64_t)r->acc[i] - before;
+  }
+  r->moves++;
+}
+
+/* Same sequence as USBD_HID_Pointer_Load for a relative report */
+static void Poll(Replay *r)
+{
+  int send = (r->acc[0] != 0) || (r->acc[1] != 0) || (r->acc[2] != 0);
+
+  r->polls++;
+  if (!send)
+  {
+    return;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    int32_t value = HID_Pointer_Take(&r->acc[i], FieldMax[i]);
+
+    Check(r, (value >= -FieldMax[i]) && (value <= FieldMax[i]),
+          "report field out of range", i);
+    r->host[i] += value;
+    Check(r, (r->host[i] + r->acc[i]) == r->fed[i],
+          "reported + pending differs from the motion fed in", i);
+  }
+  r->reports++;
+}
+
+/* Polls until the accumulators are empty, bounded by the slowest axis */
+static void Drain(Replay *r)
+{
+  uint32_t limit = (uint32_t)(INT32_MAX / HID_POINTER_WHEEL_MAX) + 2U;
+
+  while (((r->acc[0] != 0) || (r->acc[1] != 0) || (r->acc[2] != 0)) && (limit-- != 0U))
+  {
+    Poll(r);
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    Check(r, r->acc[i] == 0, "motion left after draining", i);
+    Check(r, r->host[i] == r->fed[i], "integrated position differs", i);
+  }
+}
+
+static int Finish(const char *name, Replay *r)
+{
+  printf("%-28s %8u moves %8u polls %8u reports  pos %lld,%lld,%lld  %s\n",
+         name, r->moves, r->polls, r->reports,
+         (long long)r->host[0], (long long)r->host[1], (long long)r->host[2],
+         (r->errors == 0U) ? "ok" : "FAIL");
+  return (r->errors == 0U) ? 0 : 1;
+}
+
+static uint32_t Rand(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+/* Sensor faster than the host: several small moves per poll */
+static int TraceFastSensor(void)
+{
+  Replay r = { 0 };
+  uint32_t seed = 0x2545F491U;
+
+  for (int frame = 0; frame < 100000; frame++)
+  {
+    int n = (int)(Rand(&seed) % 8U);
+
+    for (int k = 0; k < n; k++)
+    {
+      Move(&r, (int32_t)(Rand(&seed) % 401U) - 200,
+               (int32_t)(Rand(&seed) % 401U) - 200,
+               (int32_t)(Rand(&seed) % 5U) - 2);
+    }
+    Poll(&r);
+  }
+  Drain(&r);
+  return Finish("fast sensor", &r);
+}
+
+/* Large jumps between polls, carried over several reports */
+static int TraceLargeJumps(void)
+{
+  Replay r = { 0 };
+  uint32_t seed = 0x9E3779B9U;
+
+  Move(&r, 100000, -100000, 1000);
+  Poll(&r);
+  Check(&r, r.host[0] == HID_POINTER_DELTA_MAX, "first report not at the field limit", 0);
+  Check(&r, r.host[1] == -HID_POINTER_DELTA_MAX, "first report not at the field limit", 1);
+  Check(&r, r.host[2] == HID_POINTER_WHEEL_MAX, "first report not at the field limit", 2);
+  Drain(&r);
+  Check(&r, r.reports == 8U, "1000 wheel steps not in 8 reports", 2);
+
+  for (int frame = 0; frame < 20000; frame++)
+  {
+    if ((Rand(&seed) % 4U) == 0U)
+    {
+      Move(&r, (int32_t)(Rand(&seed) % 400001U) - 200000,
+               (int32_t)(Rand(&seed) % 400001U) - 200000,
+               (int32_t)(Rand(&seed) % 2001U) - 1000);
+    }
+    Poll(&r);
+  }
+  Drain(&r);
+  return Finish("large jumps", &r);
+}
+
+/* Runaway motion: saturates instead of wrapping, then drains */
+static int TraceSaturation(void)
+{
+  Replay r = { 0 };
+
+  for (int k = 0; k < 4; k++)
+  {
+    Move(&r, INT32_MAX, INT32_MIN, INT32_MAX);
+  }
+  Check(&r, r.acc[0] == INT32_MAX, "x not saturated", 0);
+  Check(&r, r.acc[1] == -INT32_MAX, "y not saturated", 1);
+  /* Opposite motion is applied in full from the saturated value */
+  Move(&r, -1000, 1000, -1000);
+  Check(&r, r.acc[0] == INT32_MAX - 1000, "x lost motion after saturation", 0);
+  Check(&r, r.acc[1] == -INT32_MAX + 1000, "y lost motion after saturation", 1);
+  Drain(&r);
+  return Finish("saturation", &r);
+}
+
+static int TraceFile(const char *path)
+{
+  Replay r = { 0 };
+  char line[256];
+  unsigned lineno = 0U;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    long dx, dy, wheel, count;
+    char *hash = strchr(line, '#');
+
+    lineno++;
+    if (hash != NULL)
+    {
+      *hash = '\0';
+    }
+    if (sscanf(line, " move %ld %ld %ld", &dx, &dy, &wheel) == 3)
+    {
+      Move(&r, (int32_t)dx, (int32_t)dy, (int32_t)wheel);
+    }
+    else if (strncmp(line + strspn(line, " \t"), "poll", 4) == 0)
+    {
+      if (sscanf(line, " poll %ld", &count) != 1)
+      {
+        count = 1;
+      }
+      while (count-- > 0)
+      {
+        Poll(&r);
+      }
+    }
+    else if (line[strspn(line, " \t\r\n")] != '\0')
+    {
+      fprintf(stderr, "%s:%u: bad event\n", path, lineno);
+      fclose(f);
+      return 1;
+    }
+  }
+  fclose(f);
+  Drain(&r);
+  return Finish(path, &r);
+}
+
+int main(int argc, char **argv)
+{
+  int failed = 0;
+
+  if (argc > 1)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      failed |= TraceFile(argv[i]);
+    }
+  }
+  else
+  {
+    failed |= TraceFastSensor();
+    failed |= TraceLargeJumps();
+    failed |= TraceSaturation();
+  }
+  return failed;
+}
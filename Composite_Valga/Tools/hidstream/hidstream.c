@@ -0,0 +1,557 @@
+/*
+ * hidstream.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host benchmark of the streaming typing engine of usbd_hid_typing.c, the
+ *  one behind SendMessageHID and SendStreamHID. Texts are pulled through
+ *  the lookahead window from a simulated source giving random sized pieces,
+ *  or nothing at times. Every keyboard report goes to a model of the host
+ *  (key presses seen on change only, Caps Lock, Linux Ctrl+Shift+U Unicode
+ *  entry), which must rebuild the text exactly.
+ *
+ *  Checks:
+ *    - a 1 MB text is rebuilt byte for byte;
+ *    - UTF-8 characters split across two pulls, or across a starved pull,
+ *      are typed whole;
+ *    - a repeated key is released first ("aA", "aa", "uü");
+ *    - a character cut by the end of the text is dropped;
+ *    - Caps Lock on the host does not change the text.
+ *
+ *  Build (Linux):
+ *    gcc -O2 -Wall -DHID_TYPING_HOST_TOOL -o hidstream hidstream.c \
+ *        ../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Src/usbd_hid_typing.c \
+ *        ../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Src/usbd_hid_unicode.c
+ *  Add -DHID_TYPING_KEYS_PER_REPORT=1 to check one key per report.
+ *
+ *  Usage:
+ *    hidstream [size]        size of the benchmark text, 1 MB by default
+ *  Exit status is 0 when every text is rebuilt.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid.h"
+
+#define BENCH_SIZE            (1024U * 1024U)
+#define MAX_WAITS             64U       /* starved calls in a row before giving up */
+
+#define MOD_CTRL              0x01U
+#define MOD_SHIFT             0x02U
+#define MOD_RALT              0x40U
+#define USAGE_U               0x18U
+#define USAGE_SPACE           0x2CU
+
+typedef enum
+{
+  PULL_FULL = 0,     /* as much as the window takes */
+  PULL_ONE,          /* one byte a call */
+  PULL_STARVED,      /* one byte, then nothing, alternately */
+  PULL_RANDOM        /* 0 to the room left, at random */
+}
+PullMode;
+
+typedef struct
+{
+  const uint8_t *text;
+  size_t        len;
+  size_t        pos;
+  PullMode      mode;
+  uint32_t      seed;
+  uint32_t      calls;
+  uint64_t      pulls;
+  uint64_t      splits;    /* pulls ending inside a UTF-8 character */
+  uint64_t      starved;   /* pulls giving nothing */
+}
+Source;
+
+typedef struct
+{
+  uint8_t       prev[HID_KEYBOARD_REPORT_SIZE];
+  uint8_t       caps;
+  uint8_t       unicode;   /* inside Ctrl+Shift+U */
+  uint32_t      value;
+  uint8_t       digits;
+  uint8_t       *out;
+  size_t        len;
+  size_t        cap;
+  unsigned      errors;
+}
+Host;
+
+typedef struct
+{
+  uint64_t      reports;
+  uint64_t      waits;
+  uint64_t      releases;  /* reports with no key pressed */
+}
+Stats;
+
+/* Character typed by each modifier and key, learnt from the engine */
+static int16_t KeyChar[256][256];
+static uint8_t Typable[128];
+static char TypableSet[128];
+static unsigned NumTypable;
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t Rand(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static uint32_t Pull(void *Ctx, uint8_t *Buf, uint32_t Len)
+{
+  Source *src = (Source *)Ctx;
+  size_t left = src->len - src->pos;
+  uint32_t n;
+
+  if (left == 0U)
+  {
+    return HID_STREAM_END;
+  }
+  src->calls++;
+  switch (src->mode)
+  {
+    case PULL_ONE:
+      n = 1U;
+      break;
+    case PULL_STARVED:
+      n = src->calls & 1U;
+      break;
+    case PULL_RANDOM:
+      n = Rand(&src->seed) % (Len + 1U);
+      break;
+    default:
+      n = Len;
+      break;
+  }
+  if (n > left)
+  {
+    n = (uint32_t)left;
+  }
+  memcpy(Buf, &src->text[src->pos], n);
+  src->pos += n;
+  src->pulls++;
+  if (n == 0U)
+  {
+    src->starved++;
+  }
+  else if ((src->pos < src->len) && ((src->text[src->pos] & 0xC0U) == 0x80U))
+  {
+    src->splits++;
+  }
+  return n;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void HostEmit(Host *h, uint8_t c)
+{
+  if (h->len == h->cap)
+  {
+    h->cap = (h->cap != 0U) ? (2U * h->cap) : 256U;
+    h->out = realloc(h->out, h->cap);
+    if (h->out == NULL)
+    {
+      perror("realloc");
+      exit(2);
+    }
+  }
+  h->out[h->len++] = c;
+}
+
+static void HostEmitUtf8(Host *h, uint32_t cp)
+{
+  if (cp < 0x80U)
+  {
+    HostEmit(h, (uint8_t)cp);
+  }
+  else if (cp < 0x800U)
+  {
+    HostEmit(h, (uint8_t)(0xC0U | (cp >> 6)));
+    HostEmit(h, (uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+  else if (cp < 0x10000U)
+  {
+    HostEmit(h, (uint8_t)(0xE0U | (cp >> 12)));
+    HostEmit(h, (uint8_t)(0x80U | ((cp >> 6) & 0x3FU)));
+    HostEmit(h, (uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+  else
+  {
+    HostEmit(h, (uint8_t)(0xF0U | (cp >> 18)));
+    HostEmit(h, (uint8_t)(0x80U | ((cp >> 12) & 0x3FU)));
+    HostEmit(h, (uint8_t)(0x80U | ((cp >> 6) & 0x3FU)));
+    HostEmit(h, (uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+}
+
+static int HexDigit(uint8_t usage)
+{
+  if ((usage >= 0x1EU) && (usage <= 0x26U))
+  {
+    return usage - 0x1EU + 1;
+  }
+  if (usage == 0x27U)
+  {
+    return 0;
+  }
+  if ((usage >= 0x04U) && (usage <= 0x09U))
+  {
+    return usage - 0x04U + 0xA;
+  }
+  return -1;
+}
+
+static void HostError(Host *h, const char *what, uint8_t mods, uint8_t key)
+{
+  if (h->errors++ < 10U)
+  {
+    fprintf(stderr, "  host: %s, mods %02X key %02X after %zu bytes\n", what, mods, key, h->len);
+  }
+}
+
+/* A key goes down: a character, or a step of the Unicode entry */
+static void HostPress(Host *h, uint8_t mods, uint8_t key)
+{
+  uint8_t m = mods;
+  int digit = HexDigit(key);
+
+  if (h->unicode)
+  {
+    if ((digit >= 0) && (mods == 0U) && (h->digits < 6U))
+    {
+      h->value = (h->value << 4) | (uint32_t)digit;
+      h->digits++;
+    }
+    else if ((key == USAGE_SPACE) && (mods == 0U) && (h->digits >= 4U))
+    {
+      HostEmitUtf8(h, h->value);
+      h->unicode = 0U;
+    }
+    else
+    {
+      HostError(h, "unexpected key in Unicode entry", mods, key);
+    }
+    return;
+  }
+
+  if ((key == USAGE_U) && (mods == (MOD_CTRL | MOD_SHIFT)))
+  {
+    h->unicode = 1U;
+    h->value = 0U;
+    h->digits = 0U;
+    return;
+  }
+
+  /* Caps Lock inverts Shift on letters, not on AltGr symbols */
+  if (h->caps && (key >= 0x04U) && (key <= 0x1DU) && ((mods & MOD_RALT) == 0U))
+  {
+    m ^= MOD_SHIFT;
+  }
+  if (KeyChar[m][key] < 0)
+  {
+    HostError(h, "key types no known character", mods, key);
+    return;
+  }
+  HostEmit(h, (uint8_t)KeyChar[m][key]);
+}
+
+/* Only keys that were not down in the previous report are new presses */
+static void HostReport(Host *h, const uint8_t *report, Stats *st)
+{
+  uint8_t any = 0U;
+
+  if (report[0] != HID_REPORT_ID_KEYBOARD)
+  {
+    HostError(h, "wrong report ID", report[1], report[0]);
+  }
+  for (uint8_t i = 3U; i < HID_KEYBOARD_REPORT_SIZE; i++)
+  {
+    if (report[i] == 0U)
+    {
+      continue;
+    }
+    any = 1U;
+    if (memchr(&h->prev[3], report[i], HID_KEYBOARD_REPORT_SIZE - 3U) == NULL)
+    {
+      HostPress(h, report[1], report[i]);
+    }
+  }
+  if (!any)
+  {
+    st->releases++;
+  }
+  memcpy(h->prev, report, HID_KEYBOARD_REPORT_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Types a text, as SendNextCharCallBack does on DataIn and SOF */
+static int Type(Source *src, Host *h, Stats *st)
+{
+  HID_TypingTypeDef typing;
+  unsigned waits = 0U;
+
+  HID_Typing_Start(&typing, Pull, src);
+  for (;;)
+  {
+    switch (HID_Typing_Next(&typing))
+    {
+      case HID_TYPING_REPORT:
+        waits = 0U;
+        st->reports++;
+        HostReport(h, typing.Report, st);
+        break;
+
+      case HID_TYPING_WAIT:
+        st->waits++;
+        if (++waits > MAX_WAITS)
+        {
+          HostError(h, "engine stuck waiting", 0U, 0U);
+          return 1;
+        }
+        break;
+
+      default:
+        for (uint8_t i = 1U; i < HID_KEYBOARD_REPORT_SIZE; i++)
+        {
+          if (h->prev[i] != 0U)
+          {
+            HostError(h, "text done with a key still down", h->prev[1], h->prev[i]);
+            break;
+          }
+        }
+        if (h->unicode)
+        {
+          HostError(h, "text done inside a Unicode entry", 0U, 0U);
+        }
+        return 0;
+    }
+  }
+}
+
+static void HostInit(Host *h, uint8_t caps)
+{
+  free(h->out);
+  memset(h, 0, sizeof(*h));
+  h->caps = caps;
+  h->prev[0] = HID_REPORT_ID_KEYBOARD;
+  HID_Typing_SetLocks((uint8_t)(LED_NUM_LOCK | (caps ? LED_CAPS_LOCK : 0U)));
+}
+
+/* Learns the key of every ASCII character from the engine itself, and
+   keeps the characters no other one shares */
+static void LearnKeys(void)
+{
+  static uint8_t mods[128];
+  static uint8_t keys[128];
+
+  memset(KeyChar, 0xFF, sizeof(KeyChar));
+  HID_Typing_SetLocks(LED_NUM_LOCK);
+  for (unsigned c = 1U; c < 128U; c++)
+  {
+    HID_TypingTypeDef typing;
+    uint8_t text = (uint8_t)c;
+    Source src = { &text, 1U, 0U, PULL_FULL, 1U, 0U, 0U, 0U, 0U };
+
+    HID_Typing_Start(&typing, Pull, &src);
+    if (HID_Typing_Next(&typing) == HID_TYPING_REPORT)
+    {
+      mods[c] = typing.Report[1];
+      keys[c] = typing.Report[3];
+    }
+  }
+  for (unsigned c = 1U; c < 128U; c++)
+  {
+    unsigned shared = 0U;
+
+    for (unsigned d = 1U; d < 128U; d++)
+    {
+      shared += (keys[d] == keys[c]) && (mods[d] == mods[c]);
+    }
+    if ((keys[c] != 0U) && (shared == 1U))
+    {
+      KeyChar[mods[c]][keys[c]] = (int16_t)c;
+      Typable[c] = 1U;
+      TypableSet[NumTypable++] = (char)c;
+    }
+  }
+}
+
+static int Check(const char *name, const uint8_t *text, size_t len,
+                 const uint8_t *expect, size_t expectLen, PullMode mode, uint8_t caps)
+{
+  Source src = { text, len, 0U, mode, 0x1234567U, 0U, 0U, 0U, 0U };
+  Host host = { 0 };
+  Stats st = { 0 };
+  int fail;
+
+  HostInit(&host, caps);
+  fail = Type(&src, &host, &st);
+  fail |= (host.errors != 0U) || (host.len != expectLen) || (memcmp(host.out, expect, expectLen) != 0);
+  printf("%-34s %4llu reports %3llu releases %3llu splits  %s\n", name,
+         (unsigned long long)st.reports, (unsigned long long)st.releases,
+         (unsigned long long)src.splits, fail ? "FAIL" : "ok");
+  if (fail)
+  {
+    fprintf(stderr, "  typed \"%.*s\"\n", (int)host.len, (const char *)host.out);
+  }
+  free(host.out);
+  return fail;
+}
+
+#define CHECK(name, text, expect, mode, caps) \
+  Check(name, (const uint8_t *)(text), sizeof(text) - 1U, \
+        (const uint8_t *)(expect), sizeof(expect) - 1U, mode, caps)
+
+static int Cases(void)
+{
+  int fail = 0;
+
+  fail |= CHECK("aA released between",        "aA", "aA", PULL_FULL, 0U);
+  fail |= CHECK("aa released between",        "aa", "aa", PULL_FULL, 0U);
+  fail |= CHECK("Hello, caps lock on",        "Hello World", "Hello World", PULL_FULL, 1U);
+  fail |= CHECK("uu then u-umlaut",           "uu\xC3\xBCu", "uu\xC3\xBCu", PULL_FULL, 0U);
+  fail |= CHECK("UTF-8 split, 1 byte pulls",  "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x91\x8Dz",
+                                              "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x91\x8Dz", PULL_ONE, 0U);
+  fail |= CHECK("UTF-8 split, starved pulls", "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x91\x8D",
+                                              "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x91\x8D", PULL_STARVED, 0U);
+  fail |= CHECK("UTF-8 cut by the end",       "abc\xE2\x82", "abc", PULL_ONE, 0U);
+  return fail;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const char *const Pool[] =
+{
+  "\xC3\xA9", "\xC3\xBC", "\xC3\x9F", "\xC3\xB1", "\xCE\xA9", "\xD1\x8F",
+  "\xE2\x82\xAC", "\xE6\xBC\xA2", "\xE2\x9C\x93", "\xF0\x9F\x91\x8D", "\xF0\x9D\x84\x9E",
+};
+
+static uint8_t *MakeText(size_t size, uint32_t seed)
+{
+  uint8_t *text = malloc(size);
+  size_t pos = 0U;
+
+  if (text == NULL)
+  {
+    perror("malloc");
+    exit(2);
+  }
+  while (pos < size)
+  {
+    uint32_t r = Rand(&seed) % 100U;
+    size_t room = size - pos;
+
+    if ((r < 8U) && (room >= 4U))
+    {
+      const char *u = Pool[Rand(&seed) % (sizeof(Pool) / sizeof(Pool[0]))];
+
+      memcpy(&text[pos], u, strlen(u));
+      pos += strlen(u);
+    }
+    else if (r < 12U)
+    {
+      text[pos++] = ' ';
+    }
+    else if ((r < 16U) && (room >= 2U))
+    {
+      /* Same key twice, and same key with another case */
+      uint8_t c = (uint8_t)('a' + (Rand(&seed) % 26U));
+
+      text[pos++] = c;
+      text[pos++] = (r & 1U) ? c : (uint8_t)(c ^ 0x20U);
+    }
+    else
+    {
+      text[pos++] = (uint8_t)TypableSet[Rand(&seed) % NumTypable];
+    }
+  }
+  return text;
+}
+
+static int Bench(size_t size, uint8_t caps)
+{
+  uint8_t *text = MakeText(size, 0xC0FFEEU + caps);
+  Source src = { text, size, 0U, PULL_RANDOM, 0x2545F491U, 0U, 0U, 0U, 0U };
+  Host host = { 0 };
+  Stats st = { 0 };
+  HID_UnicodeStatsTypeDef before;
+  HID_UnicodeStatsTypeDef after;
+  struct timespec t0;
+  struct timespec t1;
+  size_t chars = 0U;
+  double ms;
+  int fail;
+
+  for (size_t i = 0U; i < size; i++)
+  {
+    chars += (text[i] & 0xC0U) != 0x80U;
+  }
+
+  HostInit(&host, caps);
+  HID_Unicode_GetStats(&before);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  fail = Type(&src, &host, &st);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  HID_Unicode_GetStats(&after);
+  ms = ((double)(t1.tv_sec - t0.tv_sec) * 1e3) + ((double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+
+  fail |= (host.errors != 0U) || (host.len != size);
+  if (!fail && (memcmp(host.out, text, size) != 0))
+  {
+    fail = 1;
+  }
+  if (fail)
+  {
+    size_t i = 0U;
+
+    while ((i < host.len) && (i < size) && (host.out[i] == text[i]))
+    {
+      i++;
+    }
+    fprintf(stderr, "  rebuilt text differs at byte %zu of %zu (%zu typed)\n", i, size, host.len);
+  }
+
+  printf("%zu bytes, %zu chars, caps lock %s, %u keys per report\n", size, chars,
+         caps ? "on" : "off", (unsigned)HID_TYPING_KEYS_PER_REPORT);
+  printf("  %llu reports, %.2f reports/char, %.1f s at one report per frame\n",
+         (unsigned long long)st.reports, (double)st.reports / (double)chars,
+         (double)st.reports / 1000.0);
+  printf("  %llu pulls, %llu split UTF-8 characters, %llu starved pulls, %llu waits\n",
+         (unsigned long long)src.pulls, (unsigned long long)src.splits,
+         (unsigned long long)src.starved, (unsigned long long)st.waits);
+  printf("  unicode: %u chars, %u cache hits\n", (unsigned)(after.Chars - before.Chars),
+         (unsigned)(after.Hits - before.Hits));
+  printf("  engine state %zu bytes, %.1f ns/report with the host model\n",
+         sizeof(HID_TypingTypeDef), ms * 1e6 / (double)st.reports);
+  printf("  rebuilt %s\n", fail ? "FAIL" : "ok");
+
+  free(host.out);
+  free(text);
+  return fail | (src.splits == 0U);
+}
+
+int main(int argc, char **argv)
+{
+  size_t size = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_SIZE;
+  int fail = 0;
+
+  HID_Unicode_SetHost(HID_UNICODE_LINUX);
+  LearnKeys();
+  printf("%u typable ASCII characters: %.*s\n", NumTypable, (int)NumTypable, TypableSet);
+
+  fail |= Cases();
+  fail |= Bench(size, 0U);
+  fail |= Bench(size / 16U, 1U);
+  return fail;
+}
@@ -0,0 +1,477 @@
+/*
+ * hidunicode.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host benchmark of the Unicode typing engine of usbd_hid_unicode.c.
+ *  Sample texts are typed through HID_Unicode_Decode and HID_Unicode_Get for
+ *  every host input method. The reports of each character are replayed
+ *  through a model of the host input method, which must give the character
+ *  back, and the cost is printed as reports and cycles per character, with
+ *  the compiled-sequence cache and without it (HID_Unicode_Compile only).
+ *  The cache hit rate is given for the first pass over the text, from an
+ *  empty cache, and for the timed rounds that type it again and again.
+ *
+ *  Build (Linux):
+ *    gcc -O2 -Wall -o hidunicode hidunicode.c \
+ *        ../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Src/usbd_hid_unicode.c
+ *
+ *  Usage:
+ *    hidunicode                  benchmark the built-in texts
+ *    hidunicode text.txt ...     benchmark UTF-8 files
+ *  Exit status is 0 when every character is entered back by the host model.
+ *  Cycles are TSC cycles on x86, nanoseconds elsewhere.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid_unicode.h"
+
+#define BENCH_ROUNDS                  200U
+#define BENCH_RUNS                    7U    /* timings keep the fastest run */
+#define MAX_FILE                      (16U * 1024U * 1024U)
+
+#define MOD_CTRL                      0x01U
+#define MOD_SHIFT                     0x02U
+#define MOD_ALT                       0x04U
+
+typedef struct
+{
+  const char *name;
+  const char *text;
+}
+Sample;
+
+static const Sample Samples[] =
+{
+  { "french",  "Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva de crapaüter en "
+               "canoë au delà des îles, près du mälström où brûlent les novæ." },
+  { "german",  "Falsches Üben von Xylophonmusik quält jeden größeren Zwerg. "
+               "Zwölf Boxkämpfer jagen Viktor quer über den großen Sylter Deich." },
+  { "greek",   "Ξεσκεπάζω την ψυχοφθόρα βδελυγμία. Τάχιστη αλώπηξ βαφής ψημένη γη, "
+               "δρασκελίζει υπέρ νωθρού κυνός." },
+  { "russian", "Съешь же ещё этих мягких французских булок, да выпей чаю. "
+               "В чащах юга жил бы цитрус? Да, но фальшивый экземпляр!" },
+  { "cjk",     "いろはにほへと ちりぬるを わかよたれそ つねならむ 色は匂へど散りぬるを "
+               "我が世誰ぞ常ならむ 天地玄黄宇宙洪荒日月盈昃辰宿列張" },
+  { "emoji",   "ok 👍 ship it 🚀🚀 thanks 🙏 — 5 € / 3 £ ✓ 𝄞 𝔘𝔫𝔦𝔠𝔬𝔡𝔢" },
+  { "invalid", "cut \xC3 and \xE2\x82 stray \x80\xBF overlong \xC0\xAF \xED\xA0\x80 end" },
+};
+
+static const char *const HostName[HID_NUM_UNICODE_HOSTS] = { "windows", "linux", "macos" };
+
+/* ------------------------------------------------------------------------- */
+
+static uint64_t Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Hex digit of a key usage, top row, keypad or A-F, -1 otherwise */
+static int HexDigit(uint8_t usage)
+{
+  if ((usage >= 0x1EU) && (usage <= 0x26U))
+  {
+    return usage - 0x1EU + 1;
+  }
+  if (usage == 0x27U)
+  {
+    return 0;
+  }
+  if ((usage >= 0x59U) && (usage <= 0x61U))
+  {
+    return usage - 0x59U + 1;
+  }
+  if (usage == 0x62U)
+  {
+    return 0;
+  }
+  if ((usage >= 0x04U) && (usage <= 0x09U))
+  {
+    return usage - 0x04U + 0xA;
+  }
+  return -1;
+}
+
+/*
+ * Host input method model: keys are seen on press, the character entered is
+ * returned once the sequence is closed, 0xFFFFFFFF if it is malformed.
+ *  windows  Alt held, keypad '+', hex digits, Alt released
+ *  linux    Ctrl+Shift+U, hex digits, space
+ *  macos    Option held, groups of 4 hex digits, Option released
+ */
+static uint32_t HostEnter(uint8_t host, const HID_UnicodeSeqTypeDef *seq)
+{
+  uint8_t prevMods = 0U;
+  uint8_t prevKey = 0U;
+  uint32_t value = 0U;
+  uint32_t units[2] = { 0U, 0U };
+  uint8_t digits = 0U;
+  uint8_t open = 0U;
+  uint8_t closed = 0U;
+
+  if ((seq->Length == 0U) || (seq->Step[seq->Length - 1U] != 0U))
+  {
+    return 0xFFFFFFFFU;
+  }
+
+  for (uint8_t i = 0U; i < seq->Length; i++)
+  {
+    uint8_t mods = (uint8_t)(seq->Step[i] >> 8);
+    uint8_t key = (uint8_t)(seq->Step[i] & 0xFFU);
+    int press = (key != 0U) && (key != prevKey);
+    int digit = HexDigit(key);
+
+    if ((i != 0U) && (seq->Step[i] == seq->Step[i - 1U]))
+    {
+      /* Same report twice is dropped by the device as a duplicate */
+      return 0xFFFFFFFFU;
+    }
+    if (closed && press)
+    {
+      /* Keys after the character is entered would type more text */
+      return 0xFFFFFFFFU;
+    }
+
+    switch (host)
+    {
+      case HID_UNICODE_WINDOWS:
+        if (press && (key == 0x57U) && (mods == MOD_ALT) && !open)
+        {
+          open = 1U;
+        }
+        else if (press && open && (mods == MOD_ALT) && (digit >= 0))
+        {
+          value = (value << 4) | (uint32_t)digit;
+          digits++;
+        }
+        else if (press)
+        {
+          return 0xFFFFFFFFU;
+        }
+        if (open && ((mods & MOD_ALT) == 0U) && ((prevMods & MOD_ALT) != 0U))
+        {
+          open = 0U;
+          closed = 1U;
+        }
+        break;
+
+      case HID_UNICODE_LINUX:
+        if (press && (key == 0x18U) && (mods == (MOD_CTRL | MOD_SHIFT)) && !open)
+        {
+          open = 1U;
+        }
+        else if (press && open && (mods == 0U) && (digit >= 0))
+        {
+          value = (value << 4) | (uint32_t)digit;
+          digits++;
+        }
+        else if (press && open && (key == 0x2CU) && (mods == 0U))
+        {
+          open = 0U;
+          closed = 1U;
+        }
+        else if (press)
+        {
+          return 0xFFFFFFFFU;
+        }
+        break;
+
+      case HID_UNICODE_MACOS:
+        if ((mods & MOD_ALT) != 0U)
+        {
+          open = 1U;
+        }
+        if (press && open && (mods == MOD_ALT) && (digit >= 0) && (digits < 8U))
+        {
+          units[digits / 4U] = (units[digits / 4U] << 4) | (uint32_t)digit;
+          digits++;
+        }
+        else if (press)
+        {
+          return 0xFFFFFFFFU;
+        }
+        if (open && ((mods & MOD_ALT) == 0U))
+        {
+          open = 0U;
+          closed = 1U;
+          if ((digits == 8U) && (units[0] >= 0xD800U) && (units[0] <= 0xDBFFU) &&
+              (units[1] >= 0xDC00U) && (units[1] <= 0xDFFFU))
+          {
+            value = 0x10000U + ((units[0] - 0xD800U) << 10) + (units[1] - 0xDC00U);
+          }
+          else if (digits == 4U)
+          {
+            value = units[0];
+          }
+          else
+          {
+            return 0xFFFFFFFFU;
+          }
+        }
+        break;
+
+      default:
+        return 0xFFFFFFFFU;
+    }
+
+    prevMods = mods;
+    prevKey = key;
+  }
+
+  if (!closed || (digits < 4U))
+  {
+    return 0xFFFFFFFFU;
+  }
+  return value;
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  uint64_t chars;       /* characters of the text */
+  uint64_t unicode;     /* non-ASCII ones, typed through the engine */
+  uint64_t reports;
+  uint64_t cyclesGet;   /* decode + cached lookup */
+  uint64_t cyclesCompile; /* decode + compile every character */
+  uint64_t lookups;     /* HID_Unicode_Get calls of the timed rounds */
+  uint64_t hits;        /* found in the cache */
+  unsigned errors;
+}
+Result;
+
+/* Checks every character of the text once against the host model */
+static void Verify(uint8_t host, const uint8_t *text, uint32_t len, Result *res)
+{
+  HID_UnicodeSeqTypeDef seq;
+  uint32_t pos = 0U;
+  uint32_t cp;
+  uint32_t expected;
+
+  while (pos < len)
+  {
+    uint8_t n = HID_Unicode_Decode(&text[pos], len - pos, &cp);
+    const HID_UnicodeSeqTypeDef *got;
+
+    if (n == 0U)
+    {
+      /* Cut by the end of the text, the typing engine drops it */
+      break;
+    }
+    res->chars++;
+    pos += n;
+    if (cp < 0x80U)
+    {
+      continue;
+    }
+    res->unicode++;
+
+    got = HID_Unicode_Get(cp);
+    HID_Unicode_CountReports(got->Length);
+    res->reports += got->Length;
+    expected = cp;
+    if (HID_Unicode_Compile(host, cp, &seq) != 0U)
+    {
+      expected = HID_UNICODE_REPLACEMENT;
+      (void)HID_Unicode_Compile(host, expected, &seq);
+    }
+    if ((seq.Length != got->Length) ||
+        (memcmp(seq.Step, got->Step, seq.Length * sizeof(seq.Step[0])) != 0))
+    {
+      if (res->errors++ < 10U)
+      {
+        fprintf(stderr, "  %s U+%04X: cached sequence differs from compiled\n",
+                HostName[host], (unsigned)cp);
+      }
+    }
+    if (HostEnter(host, got) != expected)
+    {
+      if (res->errors++ < 10U)
+      {
+        fprintf(stderr, "  %s U+%04X: host enters U+%04X\n", HostName[host],
+                (unsigned)cp, (unsigned)HostEnter(host, got));
+      }
+    }
+  }
+}
+
+/* One timed run of both loops, the text typed BENCH_ROUNDS times */
+static void TimeRun(uint8_t host, const uint8_t *text, uint32_t len,
+                    uint64_t *cyclesGet, uint64_t *cyclesCompile)
+{
+  HID_UnicodeSeqTypeDef seq;
+  volatile uint32_t sink = 0U;
+  uint64_t start;
+  uint32_t cp;
+
+  start = Now();
+  for (uint32_t round = 0U; round < BENCH_ROUNDS; round++)
+  {
+    for (uint32_t pos = 0U; pos < len; )
+    {
+      uint8_t n = HID_Unicode_Decode(&text[pos], len - pos, &cp);
+
+      if (n == 0U)
+      {
+        break;
+      }
+      pos += n;
+      if (cp >= 0x80U)
+      {
+        sink += HID_Unicode_Get(cp)->Length;
+      }
+    }
+  }
+  *cyclesGet = Now() - start;
+
+  start = Now();
+  for (uint32_t round = 0U; round < BENCH_ROUNDS; round++)
+  {
+    for (uint32_t pos = 0U; pos < len; )
+    {
+      uint8_t n = HID_Unicode_Decode(&text[pos], len - pos, &cp);
+
+      if (n == 0U)
+      {
+        break;
+      }
+      pos += n;
+      if (cp >= 0x80U)
+      {
+        (void)HID_Unicode_Compile(host, cp, &seq);
+        sink += seq.Length;
+      }
+    }
+  }
+  *cyclesCompile = Now() - start;
+  (void)sink;
+}
+
+static void Time(uint8_t host, const uint8_t *text, uint32_t len, Result *res)
+{
+  HID_UnicodeStatsTypeDef before;
+  HID_UnicodeStatsTypeDef after;
+  uint64_t cyclesGet;
+  uint64_t cyclesCompile;
+
+  res->cyclesGet = UINT64_MAX;
+  res->cyclesCompile = UINT64_MAX;
+  HID_Unicode_GetStats(&before);
+  for (uint32_t run = 0U; run < BENCH_RUNS; run++)
+  {
+    TimeRun(host, text, len, &cyclesGet, &cyclesCompile);
+    res->cyclesGet = (cyclesGet < res->cyclesGet) ? cyclesGet : res->cyclesGet;
+    res->cyclesCompile = (cyclesCompile < res->cyclesCompile) ? cyclesCompile : res->cyclesCompile;
+  }
+  HID_Unicode_GetStats(&after);
+  res->lookups = after.Chars - before.Chars;
+  res->hits = after.Hits - before.Hits;
+}
+
+static unsigned Bench(const char *name, const uint8_t *text, uint32_t len)
+{
+  unsigned errors = 0U;
+
+  for (uint8_t host = 0U; host < HID_NUM_UNICODE_HOSTS; host++)
+  {
+    /* Num Lock only changes the Windows digits, off types them on the top row */
+    uint8_t passes = (host == HID_UNICODE_WINDOWS) ? 2U : 1U;
+
+    for (uint8_t pass = 0U; pass < passes; pass++)
+    {
+      uint8_t numLock = (pass == 0U) ? 1U : 0U;
+      HID_UnicodeStatsTypeDef before;
+      HID_UnicodeStatsTypeDef after;
+      Result res = { 0 };
+      double uni;
+
+      HID_Unicode_SetHost(host);
+      HID_Unicode_SetNumLock(numLock);
+      HID_Unicode_GetStats(&before);
+      Verify(host, text, len, &res);
+      HID_Unicode_GetStats(&after);
+      Time(host, text, len, &res);
+
+      uni = (res.unicode != 0U) ? (double)res.unicode : 1.0;
+      printf("%-10s %-7s %-6s %6llu chars %6llu unicode  %5.2f reports/char"
+             "  hit %5.1f%% first %5.1f%% rounds  %6.1f cycles/char cached  %6.1f uncached  %s\n",
+             name, HostName[host], (host != HID_UNICODE_WINDOWS) ? "" : (numLock ? "numlk" : "toprow"),
+             (unsigned long long)res.chars, (unsigned long long)res.unicode,
+             (double)res.reports / uni,
+             100.0 * (double)(after.Hits - before.Hits) / uni,
+             100.0 * (double)res.hits / ((res.lookups != 0U) ? (double)res.lookups : 1.0),
+             (double)res.cyclesGet / (uni * BENCH_ROUNDS),
+             (double)res.cyclesCompile / (uni * BENCH_ROUNDS),
+             (res.errors == 0U) ? "ok" : "FAIL");
+      if ((after.Chars - before.Chars) != res.unicode)
+      {
+        fprintf(stderr, "  engine counted %u characters\n", (unsigned)(after.Chars - before.Chars));
+        res.errors++;
+      }
+      errors += res.errors;
+    }
+  }
+  return errors;
+}
+
+static unsigned BenchFile(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  uint8_t *text;
+  size_t len;
+  unsigned errors;
+
+  if (f == NULL)
+  {
+    perror(path);
+    return 1U;
+  }
+  text = malloc(MAX_FILE);
+  if (text == NULL)
+  {
+    fclose(f);
+    return 1U;
+  }
+  len = fread(text, 1U, MAX_FILE, f);
+  fclose(f);
+  errors = Bench(path, text, (uint32_t)len);
+  free(text);
+  return errors;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned errors = 0U;
+
+  if (argc > 1)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      errors += BenchFile(argv[i]);
+    }
+  }
+  else
+  {
+    for (size_t i = 0U; i < sizeof(Samples) / sizeof(Samples[0]); i++)
+    {
+      errors += Bench(Samples[i].name, (const uint8_t *)Samples[i].text,
+                      (uint32_t)strlen(Samples[i].text));
+    }
+  }
+  return (errors == 0U) ? 0 : 1;
+}
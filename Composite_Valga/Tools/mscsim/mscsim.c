@@ -0,0 +1,763 @@
+/*
+ * mscsim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test and benchmark of the mass storage function: usbd_msc.c and
+ *  usbd_msc_scsi.c run unchanged behind a host that speaks the bulk-only
+ *  transport, recovery included. The block device is the RAM disk of
+ *  usbd_storage_if.c, or a bigger simulated one with access times and
+ *  injected failures.
+ *
+ *  The tick counts microseconds. The bus carries 19 bulk packets a frame,
+ *  a transfer starts once it is armed and the bus is free, and its
+ *  completion is handled once the device is done with the previous one:
+ *  the media accesses of the simulated disk take device time. A file is
+ *  written, copied by READ(10)/WRITE(10) as a host copy does, and read
+ *  back, and each rate must come within 10% of the bound of a data stage
+ *  where bus and media overlap. Then the error paths: an invalid CBW halts
+ *  both endpoints until a reset recovery, a failed host to device command
+ *  keeps the OUT endpoint halted until the host clears it, and media
+ *  errors end in a failed CSW with the right sense data.
+ *
+ *  Build (Linux):
+ *    M=../../Middlewares/ST/STM32_USB_Device_Library
+ *    gcc -O2 -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER -I../../Core/Inc \
+ *        -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -I../../USB_Device/Target \
+ *        -I../../USB_Device/App -I$M/Core/Inc -Wno-int-to-pointer-cast \
+ *        -Wno-pointer-to-int-cast -o mscsim mscsim.c ../usbsim/usbsim.c \
+ *        $M/Class/MSC/Src/usbd_msc.c $M/Class/MSC/Src/usbd_msc_scsi.c \
+ *        ../../USB_Device/App/usbd_storage_if.c $M/Core/Src/usbd_core.c \
+ *        $M/Core/Src/usbd_ctlreq.c $M/Core/Src/usbd_ioreq.c
+ *
+ *  Usage:
+ *    mscsim
+ *  Exit status is 0 when every case passes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usbsim/usbsim.h"
+#include "usbd_storage_if.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/MSC/Inc/usbd_msc_scsi.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
+
+#define BUS_US_PER_PACKET             53U     /* 19 bulk packets a frame */
+
+#define SIM_BLK_NBR                   8192U
+#define SIM_BLK_SIZ                   512U
+#define SIM_NO_FAILURE                0xFFFFFFFFU
+
+#define FILE_FIRST_BLOCK              8U      /* past the boot sector and FATs */
+#define FILE_MAX_BLOCKS               2048U   /* 1 MB */
+#define CHUNK_BLOCKS                  128U    /* 64 KB a command, as a host copies */
+
+/* Host side of a transfer */
+#define HOST_OK                       0U
+#define HOST_STALL                    1U
+#define HOST_NAK                      2U      /* nothing armed, the host would wait forever */
+#define HOST_BABBLE                   3U      /* more data than the host asked for */
+
+/* Command result when the transport itself failed */
+#define CSW_NONE                      0xFFU
+
+typedef struct
+{
+  const char *Name;
+  USBD_StorageTypeDef *Storage;
+  uint32_t ReadUs;      /* simulated disk, per block */
+  uint32_t WriteUs;
+}
+MscCase;
+
+static int8_t Sim_Init(uint8_t lun);
+static int8_t Sim_GetCapacity(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+static int8_t Sim_IsReady(uint8_t lun);
+static int8_t Sim_IsWriteProtected(uint8_t lun);
+static int8_t Sim_Read(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t Sim_Write(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t Sim_GetMaxLun(void);
+
+static USBD_StorageTypeDef SimStorage =
+{
+  Sim_Init,
+  Sim_GetCapacity,
+  Sim_IsReady,
+  Sim_IsWriteProtected,
+  Sim_Read,
+  Sim_Write,
+  Sim_GetMaxLun,
+  NULL
+};
+
+static const MscCase Cases[] =
+{
+  { "RAM disk, usbd_storage_if.c", &USBD_Storage_Interface_fops_FS, 0U,   0U    },
+  { "simulated RAM",               &SimStorage,                     0U,   0U    },
+  { "simulated SD card",           &SimStorage,                     250U, 700U  },
+  { "simulated NOR flash",         &SimStorage,                     80U,  2500U },
+};
+
+static USBD_HandleTypeDef Dev;
+static USBD_Composite_HandleTypeDef CompHandle;
+static USBD_Comp_ItfTypeDef CompItf;
+static const char *CaseName;
+static unsigned Errors;
+
+static uint32_t BusFree;      /* tick the bus is done with the last transfer */
+static uint32_t Tag;
+static uint32_t Residue;      /* of the last CSW */
+static uint8_t DataStalled;   /* the data stage of the last command was halted */
+static uint32_t HostRead;     /* blocks moved by READ(10)/WRITE(10) */
+static uint32_t HostWritten;
+
+static uint8_t SimDisk[SIM_BLK_NBR * SIM_BLK_SIZ];
+static uint32_t SimReadUs;
+static uint32_t SimWriteUs;
+static uint32_t SimFailBlock = SIM_NO_FAILURE;
+static uint8_t SimProtect;
+
+static uint8_t File[FILE_MAX_BLOCKS * SIM_BLK_SIZ];
+static uint8_t Data[FILE_MAX_BLOCKS * SIM_BLK_SIZ];
+
+static void Fail(const char *what)
+{
+  if (Errors < 20U)
+  {
+    fprintf(stderr, "  %s: %s\n", CaseName, what);
+  }
+  Errors++;
+}
+
+static void PutBE32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void PutLE32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t GetLE32(const uint8_t *p)
+{
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Simulated disk: the access time is device time spent in the interrupt */
+static int8_t Sim_Init(uint8_t lun)
+{
+  return 0;
+}
+
+static int8_t Sim_GetCapacity(uint8_t lun, uint32_t *block_num, uint16_t *block_size)
+{
+  *block_num = SIM_BLK_NBR;
+  *block_size = SIM_BLK_SIZ;
+  return 0;
+}
+
+static int8_t Sim_IsReady(uint8_t lun)
+{
+  return 0;
+}
+
+static int8_t Sim_IsWriteProtected(uint8_t lun)
+{
+  return (int8_t)SimProtect;
+}
+
+static int8_t Sim_Read(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  USBSIM_Tick += blk_len * SimReadUs;
+  if ((SimFailBlock >= blk_addr) && (SimFailBlock < (blk_addr + blk_len)))
+  {
+    return -1;
+  }
+  (void)memcpy(buf, &SimDisk[blk_addr * SIM_BLK_SIZ], (uint32_t)blk_len * SIM_BLK_SIZ);
+  return 0;
+}
+
+static int8_t Sim_Write(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  USBSIM_Tick += blk_len * SimWriteUs;
+  if ((SimFailBlock >= blk_addr) && (SimFailBlock < (blk_addr + blk_len)))
+  {
+    return -1;
+  }
+  (void)memcpy(&SimDisk[blk_addr * SIM_BLK_SIZ], buf, (uint32_t)blk_len * SIM_BLK_SIZ);
+  return 0;
+}
+
+static int8_t Sim_GetMaxLun(void)
+{
+  return 0;
+}
+
+/* Bus time of a transfer of len bytes, armed on ep. Its completion is
+ * handled once the bus is done and the device is free */
+static void Bus(const USBSIM_EpTypeDef *ep, uint32_t len)
+{
+  uint32_t packets = (len + MSC_MAX_FS_PACKET - 1U) / MSC_MAX_FS_PACKET;
+
+  BusFree = ((ep->ArmedAt > BusFree) ? ep->ArmedAt : BusFree) +
+            (((packets != 0U) ? packets : 1U) * BUS_US_PER_PACKET);
+  if (USBSIM_Tick < BusFree)
+  {
+    USBSIM_Tick = BusFree;
+  }
+}
+
+/* Host, bulk OUT: len bytes, over as many transfers as the device arms */
+static uint8_t HostOut(const uint8_t *data, uint32_t len)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(MSC_EPOUT_ADDR);
+  uint32_t sent = 0U;
+  uint32_t n;
+
+  do
+  {
+    if (ep->Halted)
+    {
+      return HOST_STALL;
+    }
+    if (!ep->Armed)
+    {
+      return HOST_NAK;
+    }
+    n = ((len - sent) < ep->Len) ? (len - sent) : ep->Len;
+    (void)memcpy(ep->Buf, &data[sent], n);
+    Bus(ep, n);
+    sent += n;
+    USBSIM_DataOut(&Dev, MSC_EPOUT_ADDR, n);
+  }
+  while (sent < len);
+
+  return HOST_OK;
+}
+
+/* Host, bulk IN: up to len bytes, a short packet ends the transfer. The
+ * first packet is the one copied to the packet memory when armed */
+static uint8_t HostIn(uint8_t *data, uint32_t len, uint32_t *got)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(MSC_EPIN_ADDR);
+  uint32_t first;
+  uint32_t n;
+
+  *got = 0U;
+  while (*got < len)
+  {
+    if (ep->Halted)
+    {
+      return HOST_STALL;
+    }
+    if (!ep->Armed)
+    {
+      return HOST_NAK;
+    }
+    n = ep->Len;
+    if (n > (len - *got))
+    {
+      return HOST_BABBLE;
+    }
+    first = (n < MSC_MAX_FS_PACKET) ? n : MSC_MAX_FS_PACKET;
+    (void)memcpy(&data[*got], ep->Pma, first);
+    (void)memcpy(&data[*got + first], &ep->Buf[first], n - first);
+    Bus(ep, n);
+    *got += n;
+    USBSIM_DataIn(&Dev, MSC_EPIN_ADDR);
+    if ((n == 0U) || ((n % MSC_MAX_FS_PACKET) != 0U))
+    {
+      break;
+    }
+  }
+
+  return HOST_OK;
+}
+
+/* Control transfer, its data stage one packet from the device at most. A
+ * SETUP clears the halt of EP0, as the PCD does */
+static uint8_t Control(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                       uint16_t wIndex, uint16_t wLength, uint8_t *data)
+{
+  uint8_t setup[8];
+  USBSIM_EpTypeDef *in0 = USBSIM_Ep(0x80U);
+  USBSIM_EpTypeDef *out0 = USBSIM_Ep(0x00U);
+
+  setup[0] = bmRequest;
+  setup[1] = bRequest;
+  setup[2] = LOBYTE(wValue);
+  setup[3] = HIBYTE(wValue);
+  setup[4] = LOBYTE(wIndex);
+  setup[5] = HIBYTE(wIndex);
+  setup[6] = LOBYTE(wLength);
+  setup[7] = HIBYTE(wLength);
+
+  in0->Armed = 0U;
+  in0->Halted = 0U;
+  out0->Armed = 0U;
+  out0->Halted = 0U;
+  (void)USBD_LL_SetupStage(&Dev, setup);
+
+  if (in0->Halted)
+  {
+    return HOST_STALL;
+  }
+  if (!in0->Armed)
+  {
+    return HOST_NAK;
+  }
+  if (wLength != 0U)
+  {
+    (void)memcpy(data, in0->Pma, (in0->Len < wLength) ? in0->Len : wLength);
+    USBSIM_DataIn(&Dev, 0x80U);
+    if (!out0->Armed)
+    {
+      return HOST_NAK;
+    }
+    USBSIM_DataOut(&Dev, 0x00U, 0U);
+  }
+  else
+  {
+    USBSIM_DataIn(&Dev, 0x80U);
+  }
+
+  return HOST_OK;
+}
+
+static void ClearHalt(uint8_t ep_addr)
+{
+  if (Control(USB_REQ_RECIPIENT_ENDPOINT, USB_REQ_CLEAR_FEATURE, USB_FEATURE_EP_HALT,
+              ep_addr, 0U, NULL) != HOST_OK)
+  {
+    Fail("CLEAR_FEATURE(ENDPOINT_HALT) refused");
+  }
+}
+
+static void ResetRecovery(void)
+{
+  if (Control(USB_REQ_TYPE_CLASS | USB_REQ_RECIPIENT_INTERFACE, MSC_BOT_RESET, 0U,
+              USBD_COMP_ITF_MSC, 0U, NULL) != HOST_OK)
+  {
+    Fail("bulk-only mass storage reset refused");
+  }
+  ClearHalt(MSC_EPIN_ADDR);
+  ClearHalt(MSC_EPOUT_ADDR);
+}
+
+static void MakeCbw(uint8_t *cbw, const uint8_t *cb, uint8_t cbLen, uint8_t flags,
+                    uint32_t len)
+{
+  (void)memset(cbw, 0, MSC_BOT_CBW_LENGTH);
+  PutLE32(&cbw[0], MSC_BOT_CBW_SIGNATURE);
+  PutLE32(&cbw[4], ++Tag);
+  PutLE32(&cbw[8], len);
+  cbw[12] = flags;
+  cbw[13] = 0U;
+  cbw[14] = cbLen;
+  (void)memcpy(&cbw[15], cb, cbLen);
+}
+
+/* One command, CBW, data and CSW, with the host side of the recovery: a
+ * halted data stage is cleared and the CSW read after it. Returns the CSW
+ * status, the residue in Residue */
+static uint8_t Command(const uint8_t *cb, uint8_t cbLen, uint8_t flags, uint8_t *data,
+                       uint32_t len)
+{
+  uint8_t cbw[MSC_BOT_CBW_LENGTH];
+  uint8_t csw[MSC_BOT_CSW_LENGTH];
+  uint32_t got = 0U;
+  uint8_t r = HOST_OK;
+
+  DataStalled = 0U;
+  MakeCbw(cbw, cb, cbLen, flags, len);
+  if (HostOut(cbw, MSC_BOT_CBW_LENGTH) != HOST_OK)
+  {
+    Fail("CBW not taken");
+    return CSW_NONE;
+  }
+
+  if ((len != 0U) && ((flags & 0x80U) != 0U))
+  {
+    r = HostIn(data, len, &got);
+    if (r == HOST_STALL)
+    {
+      DataStalled = 1U;
+      ClearHalt(MSC_EPIN_ADDR);
+    }
+  }
+  else if (len != 0U)
+  {
+    r = HostOut(data, len);
+    if (r == HOST_STALL)
+    {
+      /* The host clears the OUT halt first, then goes for the CSW */
+      DataStalled = 1U;
+      ClearHalt(MSC_EPOUT_ADDR);
+    }
+  }
+  if ((r == HOST_NAK) || (r == HOST_BABBLE))
+  {
+    Fail((r == HOST_NAK) ? "data stage stuck" : "more data than asked for");
+    return CSW_NONE;
+  }
+
+  r = HostIn(csw, MSC_BOT_CSW_LENGTH, &got);
+  if (r == HOST_STALL)
+  {
+    ClearHalt(MSC_EPIN_ADDR);
+    r = HostIn(csw, MSC_BOT_CSW_LENGTH, &got);
+  }
+  if ((r != HOST_OK) || (got != MSC_BOT_CSW_LENGTH) ||
+      (GetLE32(&csw[0]) != MSC_BOT_CSW_SIGNATURE) || (GetLE32(&csw[4]) != Tag))
+  {
+    Fail("no valid CSW");
+    return CSW_NONE;
+  }
+
+  Residue = GetLE32(&csw[8]);
+  return csw[12];
+}
+
+static uint8_t TestUnitReady(void)
+{
+  uint8_t cb[6] = { SCSI_TEST_UNIT_READY, 0U, 0U, 0U, 0U, 0U };
+
+  return Command(cb, 6U, 0x00U, NULL, 0U);
+}
+
+static void CheckSense(uint8_t key, uint8_t asc)
+{
+  uint8_t cb[6] = { SCSI_REQUEST_SENSE, 0U, 0U, 0U, SCSI_REQUEST_SENSE_LEN, 0U };
+  uint8_t sense[SCSI_REQUEST_SENSE_LEN];
+
+  if ((Command(cb, 6U, 0x80U, sense, SCSI_REQUEST_SENSE_LEN) != MSC_CSW_CMD_PASSED) ||
+      (sense[2] != key) || (sense[12] != asc))
+  {
+    Fail("wrong sense data");
+  }
+}
+
+static uint8_t ReadWrite10(uint8_t op, uint32_t lba, uint16_t blocks, uint8_t *data)
+{
+  uint8_t cb[10] = { op, 0U, 0U, 0U, 0U, 0U, 0U, HIBYTE(blocks), LOBYTE(blocks), 0U };
+  uint8_t status;
+
+  PutBE32(&cb[2], lba);
+  status = Command(cb, 10U, (op == SCSI_READ10) ? 0x80U : 0x00U, data,
+                   (uint32_t)blocks * SIM_BLK_SIZ);
+  if (status == MSC_CSW_CMD_PASSED)
+  {
+    if (op == SCSI_READ10)
+    {
+      HostRead += blocks;
+    }
+    else
+    {
+      HostWritten += blocks;
+    }
+  }
+
+  return status;
+}
+
+/* A range of blocks in commands of CHUNK_BLOCKS, returns the tick it took */
+static uint32_t Transfer(uint8_t op, uint32_t lba, uint32_t blocks, uint8_t *data)
+{
+  uint32_t start = USBSIM_Tick;
+  uint16_t n;
+
+  for (uint32_t done = 0U; done < blocks; done += n)
+  {
+    n = (uint16_t)(((blocks - done) < CHUNK_BLOCKS) ? (blocks - done) : CHUNK_BLOCKS);
+    if (ReadWrite10(op, lba + done, n, &data[done * SIM_BLK_SIZ]) != MSC_CSW_CMD_PASSED)
+    {
+      Fail((op == SCSI_READ10) ? "READ(10) failed" : "WRITE(10) failed");
+      break;
+    }
+  }
+
+  return USBSIM_Tick - start;
+}
+
+static double Rate(uint32_t bytes, uint32_t us)
+{
+  return (us != 0U) ? (bytes * 1e6 / 1024.0 / us) : 0.0;
+}
+
+static void Start(const char *name, USBD_StorageTypeDef *storage)
+{
+  CaseName = name;
+  USBSIM_Reset();
+  BusFree = 0U;
+  HostRead = 0U;
+  HostWritten = 0U;
+  (void)USBD_MSC_RegisterStorage(&CompItf, storage);
+  (void)USBD_LL_OpenEP(&Dev, MSC_EPOUT_ADDR, USBD_EP_TYPE_BULK, MSC_MAX_FS_PACKET);
+  (void)USBD_LL_OpenEP(&Dev, MSC_EPIN_ADDR, USBD_EP_TYPE_BULK, MSC_MAX_FS_PACKET);
+  if (USBD_MSC.Init(&Dev, 0U) != USBD_OK)
+  {
+    Fail("mass storage handle not allocated");
+    exit(1);
+  }
+}
+
+static void Stop(void)
+{
+  USBD_MSC_HandleTypeDef *hmsc = (USBD_MSC_HandleTypeDef *)CompHandle.msc;
+
+  if ((hmsc->Stats.ReadBlocks != HostRead) || (hmsc->Stats.WriteBlocks != HostWritten))
+  {
+    Fail("block counts differ from what the host moved");
+  }
+  (void)USBD_MSC.DeInit(&Dev, 0U);
+}
+
+/* Enumeration as a host does it, then the file copy benchmark */
+static void RunCase(const MscCase *c)
+{
+  uint8_t buf[36];
+  uint8_t cb[10];
+  uint32_t blocks;
+  uint32_t busUs = (SIM_BLK_SIZ / MSC_MAX_FS_PACKET) * BUS_US_PER_PACKET;
+  uint32_t readUs = (c->ReadUs > busUs) ? c->ReadUs : busUs;
+  uint32_t writeUs = (c->WriteUs > busUs) ? c->WriteUs : busUs;
+  uint32_t tWrite, tCopy, tRead;
+  uint32_t bytes;
+
+  SimReadUs = c->ReadUs;
+  SimWriteUs = c->WriteUs;
+  Start(c->Name, c->Storage);
+
+  if ((Control(0xA1U, MSC_BOT_GET_MAX_LUN, 0U, USBD_COMP_ITF_MSC, 1U, buf) != HOST_OK) ||
+      (buf[0] != 0U))
+  {
+    Fail("GET_MAX_LUN");
+  }
+
+  (void)memset(cb, 0, sizeof(cb));
+  cb[0] = SCSI_INQUIRY;
+  cb[4] = SCSI_STANDARD_INQUIRY_LEN;
+  if ((c->Storage->pInquiry != NULL) &&
+      ((Command(cb, 6U, 0x80U, buf, SCSI_STANDARD_INQUIRY_LEN) != MSC_CSW_CMD_PASSED) ||
+       (memcmp(buf, c->Storage->pInquiry, SCSI_STANDARD_INQUIRY_LEN) != 0)))
+  {
+    Fail("INQUIRY");
+  }
+
+  if (TestUnitReady() != MSC_CSW_CMD_PASSED)
+  {
+    Fail("TEST UNIT READY");
+  }
+
+  (void)memset(cb, 0, sizeof(cb));
+  cb[0] = SCSI_READ_CAPACITY10;
+  if ((Command(cb, 10U, 0x80U, buf, 8U) != MSC_CSW_CMD_PASSED) || (Residue != 0U) ||
+      (buf[6] != HIBYTE(SIM_BLK_SIZ)) || (buf[7] != LOBYTE(SIM_BLK_SIZ)))
+  {
+    Fail("READ CAPACITY(10)");
+    Stop();
+    return;
+  }
+  blocks = ((((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) |
+             ((uint32_t)buf[2] << 8) | buf[3]) + 1U - FILE_FIRST_BLOCK) / 2U;
+  blocks = (blocks < FILE_MAX_BLOCKS) ? blocks : FILE_MAX_BLOCKS;
+
+  /* The RAM disk comes formatted */
+  if ((c->Storage == &USBD_Storage_Interface_fops_FS) &&
+      ((ReadWrite10(SCSI_READ10, 0U, 1U, Data) != MSC_CSW_CMD_PASSED) ||
+       (Data[510] != 0x55U) || (Data[511] != 0xAAU)))
+  {
+    Fail("no boot sector on the RAM disk");
+  }
+
+  /* Write the file, copy it behind itself, read the copy back */
+  for (uint32_t i = 0U; i < (blocks * SIM_BLK_SIZ); i++)
+  {
+    File[i] = (uint8_t)((i * 2654435761U) >> 13);
+  }
+  tWrite = Transfer(SCSI_WRITE10, FILE_FIRST_BLOCK, blocks, File);
+  tCopy = 0U;
+  for (uint32_t done = 0U; done < blocks; done += CHUNK_BLOCKS)
+  {
+    uint32_t n = ((blocks - done) < CHUNK_BLOCKS) ? (blocks - done) : CHUNK_BLOCKS;
+
+    tCopy += Transfer(SCSI_READ10, FILE_FIRST_BLOCK + done, n, Data);
+    tCopy += Transfer(SCSI_WRITE10, FILE_FIRST_BLOCK + blocks + done, n, Data);
+  }
+  (void)memset(Data, 0, blocks * SIM_BLK_SIZ);
+  tRead = Transfer(SCSI_READ10, FILE_FIRST_BLOCK + blocks, blocks, Data);
+  if (memcmp(Data, File, blocks * SIM_BLK_SIZ) != 0)
+  {
+    Fail("the copy differs from the file");
+  }
+
+  /* Bus and media overlap: a block costs the slower of the two */
+  bytes = blocks * SIM_BLK_SIZ;
+  if ((Rate(bytes, tWrite) < 0.9 * Rate(SIM_BLK_SIZ, writeUs)) ||
+      (Rate(bytes, tRead) < 0.9 * Rate(SIM_BLK_SIZ, readUs)) ||
+      (Rate(bytes, tCopy) < 0.9 * Rate(SIM_BLK_SIZ, readUs + writeUs)))
+  {
+    Fail("data stages do not overlap bus and media");
+  }
+
+  printf("%-28s %4u KB file: write %6.1f KB/s, copy %6.1f KB/s, read %6.1f KB/s "
+         "(bounds %.1f, %.1f, %.1f)\n",
+         c->Name, bytes / 1024U, Rate(bytes, tWrite), Rate(bytes, tCopy), Rate(bytes, tRead),
+         Rate(SIM_BLK_SIZ, writeUs), Rate(SIM_BLK_SIZ, readUs + writeUs),
+         Rate(SIM_BLK_SIZ, readUs));
+  Stop();
+}
+
+/* Invalid CBWs: both endpoints halted until a reset recovery, whatever the
+ * host clears before */
+static void RunInvalidCbw(void)
+{
+  static const uint8_t tur[6] = { SCSI_TEST_UNIT_READY, 0U, 0U, 0U, 0U, 0U };
+  uint8_t bad[MSC_BOT_CBW_LENGTH];
+  uint8_t cbw[MSC_BOT_CBW_LENGTH];
+  uint8_t csw[MSC_BOT_CSW_LENGTH];
+  uint32_t got;
+
+  Start("invalid CBW", &SimStorage);
+
+  for (uint8_t i = 0U; i < 2U; i++)
+  {
+    MakeCbw(bad, tur, 6U, 0x00U, 0U);
+    bad[0] ^= (i == 0U) ? 0x01U : 0x00U;
+    if (HostOut(bad, MSC_BOT_CBW_LENGTH - i) != HOST_OK)
+    {
+      Fail("CBW not taken");
+    }
+    if (HostIn(csw, MSC_BOT_CSW_LENGTH, &got) != HOST_STALL)
+    {
+      Fail("IN endpoint not halted after an invalid CBW");
+    }
+
+    MakeCbw(cbw, tur, 6U, 0x00U, 0U);
+    if (HostOut(cbw, MSC_BOT_CBW_LENGTH) != HOST_STALL)
+    {
+      Fail("OUT endpoint takes a CBW before the reset recovery");
+    }
+    ClearHalt(MSC_EPIN_ADDR);
+    ClearHalt(MSC_EPOUT_ADDR);
+    if ((HostOut(cbw, MSC_BOT_CBW_LENGTH) != HOST_STALL) ||
+        (HostIn(csw, MSC_BOT_CSW_LENGTH, &got) != HOST_STALL))
+    {
+      Fail("halt cleared without a reset recovery");
+    }
+
+    ResetRecovery();
+    if (TestUnitReady() != MSC_CSW_CMD_PASSED)
+    {
+      Fail("no command after the reset recovery");
+    }
+    CheckSense(SCSI_ILLEGAL_REQUEST, SCSI_ASC_INVALID_CDB);
+  }
+
+  printf("%-28s halted until the reset recovery\n", CaseName);
+  Stop();
+}
+
+/* Failed commands and media errors: the CSW reports them, once the host
+ * has cleared the halt of the data stage if there was one */
+static void RunFailures(void)
+{
+  uint8_t status;
+
+  Start("failed commands", &SimStorage);
+  SimReadUs = 0U;
+  SimWriteUs = 0U;
+  (void)memset(File, 0x5A, 16U * SIM_BLK_SIZ);
+
+  /* Host to device, nothing to take the data: the OUT endpoint stays
+   * halted until the host clears it */
+  status = ReadWrite10(SCSI_WRITE10, SIM_BLK_NBR - 4U, 8U, File);
+  if ((status != MSC_CSW_CMD_FAILED) || !DataStalled || (Residue != (8U * SIM_BLK_SIZ)))
+  {
+    Fail("WRITE(10) out of range not halted and failed");
+  }
+  CheckSense(SCSI_ILLEGAL_REQUEST, SCSI_ASC_ADDRESS_OUT_OF_RANGE);
+
+  SimProtect = 1U;
+  status = ReadWrite10(SCSI_WRITE10, 100U, 8U, File);
+  SimProtect = 0U;
+  if ((status != MSC_CSW_CMD_FAILED) || !DataStalled)
+  {
+    Fail("WRITE(10) to a protected disk not halted and failed");
+  }
+  CheckSense(SCSI_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED);
+
+  /* Media errors: a READ(10) ends its data stage early, a WRITE(10) takes
+   * all the data */
+  (void)Transfer(SCSI_WRITE10, 100U, 16U, File);
+  SimFailBlock = 105U;
+  status = ReadWrite10(SCSI_READ10, 100U, 16U, Data);
+  if ((status != MSC_CSW_CMD_FAILED) || !DataStalled || (Residue != (11U * SIM_BLK_SIZ)) ||
+      (memcmp(Data, File, 5U * SIM_BLK_SIZ) != 0))
+  {
+    Fail("READ(10) media error not reported after the good blocks");
+  }
+  if (USBSIM_Ep(MSC_EPOUT_ADDR)->Halted)
+  {
+    Fail("OUT endpoint halted by a device to host command");
+  }
+  CheckSense(SCSI_MEDIUM_ERROR, SCSI_ASC_UNRECOVERED_READ_ERROR);
+
+  status = ReadWrite10(SCSI_WRITE10, 100U, 16U, File);
+  SimFailBlock = SIM_NO_FAILURE;
+  if ((status != MSC_CSW_CMD_FAILED) || DataStalled)
+  {
+    Fail("WRITE(10) media error not reported in the CSW");
+  }
+  CheckSense(SCSI_MEDIUM_ERROR, SCSI_ASC_WRITE_FAULT);
+
+  /* The transport went on without a reset */
+  if ((TestUnitReady() != MSC_CSW_CMD_PASSED) ||
+      (ReadWrite10(SCSI_READ10, 100U, 16U, Data) != MSC_CSW_CMD_PASSED) ||
+      (memcmp(Data, File, 16U * SIM_BLK_SIZ) != 0))
+  {
+    Fail("no command after the failures");
+  }
+
+  printf("%-28s halts cleared by the host, CSW and sense data as expected\n", CaseName);
+  HostRead += 5U;       /* read before the media error */
+  HostWritten += 5U;    /* written before it */
+  Stop();
+}
+
+int main(int argc, char **argv)
+{
+  Dev.dev_state = USBD_STATE_CONFIGURED;
+  Dev.pClass = &USBD_MSC;
+  Dev.pClassData = &CompHandle;
+  Dev.pUserData = &CompItf;
+  Dev.ep_in[0].maxpacket = USB_MAX_EP0_SIZE;
+  Dev.ep_out[0].maxpacket = USB_MAX_EP0_SIZE;
+
+  for (size_t i = 0U; i < sizeof(Cases) / sizeof(Cases[0]); i++)
+  {
+    RunCase(&Cases[i]);
+  }
+  RunInvalidCbw();
+  RunFailures();
+
+  if (Errors != 0U)
+  {
+    printf("FAIL: %u errors\n", Errors);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
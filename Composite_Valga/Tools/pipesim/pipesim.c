@@ -0,0 +1,593 @@
+/*
+ * pipesim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test of the CDC to keyboard pipe of usbd_cdc_hid_pipe.c. The CDC
+ *  class, usbd_cdc_if.c and the HID class with its typing engine run
+ *  unchanged on usbsim. Each frame the host writes bulk OUT packets until
+ *  the CDC OUT endpoint NAKs, then SOF comes and the host polls the
+ *  keyboard. The keyboard reports go to a model of the host (key presses
+ *  seen on change only, Linux Ctrl+Shift+U Unicode entry), which must
+ *  rebuild the text exactly.
+ *
+ *  Checks:
+ *    - the typed text is the text written, packets of any size, zero
+ *      length packets and UTF-8 characters split by two packets included;
+ *    - the OUT endpoint is left NAKed once every buffer is waiting, and
+ *      armed again each time, as CDC_HID_Pipe_GetStats counts it;
+ *    - the completion hook found at init still runs at the end of a text;
+ *    - interrupts are never left masked.
+ *
+ *  Build (Linux):
+ *    M=../../Middlewares/ST/STM32_USB_Device_Library
+ *    gcc -O2 -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER -I../../Core/Inc \
+ *        -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -I../../USB_Device/Target \
+ *        -I../../USB_Device/App -I$M/Core/Inc -I$M/Class/CDC/Inc \
+ *        -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *        -include ../usbsim/usbsim.h -o pipesim pipesim.c ../usbsim/usbsim.c \
+ *        ../../USB_Device/App/usbd_cdc_hid_pipe.c ../../USB_Device/App/usbd_cdc_if.c \
+ *        $M/Class/CDC/Src/usbd_cdc.c $M/Class/HID/Src/usbd_hid.c \
+ *        $M/Class/HID/Src/usbd_hid_typing.c $M/Class/HID/Src/usbd_hid_unicode.c \
+ *        $M/Class/HID/Src/usbd_hid_layout.c $M/Class/HID/Src/usbd_hid_macro.c \
+ *        $M/Core/Src/usbd_core.c $M/Core/Src/usbd_ctlreq.c $M/Core/Src/usbd_ioreq.c
+ *
+ *  Usage:
+ *    pipesim [size]          bytes of the longest text, 16 KB by default
+ *  Exit status is 0 when every case passes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usbsim/usbsim.h"
+#include "usbd_cdc_if.h"
+#include "usbd_cdc_hid_pipe.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
+
+#define TEXT_SIZE                     (16U * 1024U)
+#define PACKETS_PER_FRAME             19U     /* bulk packets of 64 bytes */
+#define ZLP_EVERY                     1024U   /* bytes of a host write ending on a full packet */
+
+#define MOD_CTRL                      0x01U
+#define MOD_SHIFT                     0x02U
+#define USAGE_U                       0x18U
+#define USAGE_SPACE                   0x2CU
+
+typedef enum
+{
+  PACKET_FULL = 0,   /* 64 bytes, a zero length packet after each write */
+  PACKET_RANDOM,     /* 1 to 64 bytes */
+  PACKET_ONE         /* one byte a packet, a buffer per byte */
+}
+PacketMode;
+
+typedef struct
+{
+  const char *Name;
+  PacketMode Mode;
+  uint8_t    Unicode;   /* per cent of the characters typed as Unicode */
+  uint32_t   Divider;   /* text size is the size asked divided by this */
+}
+PipeCase;
+
+static const PipeCase Cases[] =
+{
+  { "ASCII, full packets",            PACKET_FULL,   0U,  1U  },
+  { "UTF-8, random packets",          PACKET_RANDOM, 10U, 1U  },
+  { "UTF-8, one byte packets",        PACKET_ONE,    10U, 16U },
+};
+
+static const char *const Pool[] =
+{
+  "\xC3\xA9", "\xC3\xBC", "\xC3\x9F", "\xCE\xA9", "\xE2\x82\xAC", "\xE6\xBC\xA2",
+  "\xF0\x9F\x91\x8D",
+};
+
+extern HIDLOP_TransferHandler hHIDTransfer;
+
+USBD_HandleTypeDef hUsbDeviceFS;
+static USBD_Composite_HandleTypeDef CompHandle;
+static USBD_Comp_ItfTypeDef CompItf;
+static const char *CaseName;
+static unsigned Errors;
+static uint32_t Completions;
+
+/* Host model of the keyboard */
+static uint8_t Prev[HID_KEYBOARD_REPORT_SIZE];
+static uint8_t InUnicode;
+static uint32_t UnicodeValue;
+static uint8_t UnicodeDigits;
+static uint8_t *Typed;
+static uint32_t TypedLen;
+static uint32_t TypedMax;
+
+/* Character of each modifier and key, learnt from the engine */
+static int16_t KeyChar[256][256];
+static char Typable[128];
+static unsigned NumTypable;
+
+static uint8_t  Sim_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t  Sim_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t  Sim_SOF(USBD_HandleTypeDef *pdev);
+
+/* The composite routing of the two functions under test */
+static USBD_ClassTypeDef SimClass =
+{
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  Sim_DataIn,
+  Sim_DataOut,
+  Sim_SOF,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static void Fail(const char *what)
+{
+  if (Errors < 20U)
+  {
+    fprintf(stderr, "  %s: %s\n", CaseName, what);
+  }
+  Errors++;
+}
+
+static uint32_t Rand(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+/* Replaces the weak hook of usbd_hid.c, the pipe must chain to it */
+void TransferCompletedCallBack(void *ptr)
+{
+  (void)ptr;
+  Completions++;
+}
+
+static uint8_t Sim_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if ((epnum == (CDC_IN_EP & 0x0FU)) || (epnum == (CDC_CMD_EP & 0x0FU)))
+  {
+    return USBD_CDC.DataIn(pdev, epnum);
+  }
+  return USBD_HID.DataIn(pdev, epnum);
+}
+
+static uint8_t Sim_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  return USBD_CDC.DataOut(pdev, epnum);
+}
+
+static uint8_t Sim_SOF(USBD_HandleTypeDef *pdev)
+{
+  return USBD_HID.SOF(pdev);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t LearnPos;
+
+static uint32_t LearnPull(void *Ctx, uint8_t *Buf, uint32_t Len)
+{
+  if ((LearnPos != 0U) || (Len == 0U))
+  {
+    return HID_STREAM_END;
+  }
+  Buf[0] = *(const uint8_t *)Ctx;
+  LearnPos = 1U;
+  return 1U;
+}
+
+/* Key of every ASCII character, keeping those no other one shares */
+static void LearnKeys(void)
+{
+  static uint8_t mods[128];
+  static uint8_t keys[128];
+  HID_TypingTypeDef typing;
+  unsigned c;
+  unsigned d;
+  unsigned shared;
+  uint8_t text;
+
+  memset(KeyChar, 0xFF, sizeof(KeyChar));
+  HID_Typing_SetLocks(LED_NUM_LOCK);
+  for (c = 1U; c < 128U; c++)
+  {
+    text = (uint8_t)c;
+    LearnPos = 0U;
+    HID_Typing_Start(&typing, LearnPull, &text);
+    if (HID_Typing_Next(&typing) == HID_TYPING_REPORT)
+    {
+      mods[c] = typing.Report[1];
+      keys[c] = typing.Report[3];
+    }
+  }
+  for (c = 1U; c < 128U; c++)
+  {
+    shared = 0U;
+    for (d = 1U; d < 128U; d++)
+    {
+      shared += (keys[d] == keys[c]) && (mods[d] == mods[c]);
+    }
+    if ((keys[c] != 0U) && (shared == 1U) && (c >= 0x20U))
+    {
+      KeyChar[mods[c]][keys[c]] = (int16_t)c;
+      Typable[NumTypable++] = (char)c;
+    }
+  }
+}
+
+static void HostEmit(uint8_t c)
+{
+  if (TypedLen < TypedMax)
+  {
+    Typed[TypedLen] = c;
+  }
+  TypedLen++;
+}
+
+static void HostEmitUtf8(uint32_t cp)
+{
+  if (cp < 0x80U)
+  {
+    HostEmit((uint8_t)cp);
+  }
+  else if (cp < 0x800U)
+  {
+    HostEmit((uint8_t)(0xC0U | (cp >> 6)));
+    HostEmit((uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+  else if (cp < 0x10000U)
+  {
+    HostEmit((uint8_t)(0xE0U | (cp >> 12)));
+    HostEmit((uint8_t)(0x80U | ((cp >> 6) & 0x3FU)));
+    HostEmit((uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+  else
+  {
+    HostEmit((uint8_t)(0xF0U | (cp >> 18)));
+    HostEmit((uint8_t)(0x80U | ((cp >> 12) & 0x3FU)));
+    HostEmit((uint8_t)(0x80U | ((cp >> 6) & 0x3FU)));
+    HostEmit((uint8_t)(0x80U | (cp & 0x3FU)));
+  }
+}
+
+static int HexDigit(uint8_t usage)
+{
+  if ((usage >= 0x1EU) && (usage <= 0x26U))
+  {
+    return usage - 0x1EU + 1;
+  }
+  if (usage == 0x27U)
+  {
+    return 0;
+  }
+  if ((usage >= 0x04U) && (usage <= 0x09U))
+  {
+    return usage - 0x04U + 0xA;
+  }
+  return -1;
+}
+
+/* A key goes down: a character, or a step of the Unicode entry */
+static void HostPress(uint8_t mods, uint8_t key)
+{
+  int digit = HexDigit(key);
+
+  if (InUnicode != 0U)
+  {
+    if ((digit >= 0) && (mods == 0U) && (UnicodeDigits < 6U))
+    {
+      UnicodeValue = (UnicodeValue << 4) | (uint32_t)digit;
+      UnicodeDigits++;
+    }
+    else if ((key == USAGE_SPACE) && (mods == 0U) && (UnicodeDigits >= 4U))
+    {
+      HostEmitUtf8(UnicodeValue);
+      InUnicode = 0U;
+    }
+    else
+    {
+      Fail("unexpected key in a Unicode entry");
+    }
+    return;
+  }
+
+  if ((key == USAGE_U) && (mods == (MOD_CTRL | MOD_SHIFT)))
+  {
+    InUnicode = 1U;
+    UnicodeValue = 0U;
+    UnicodeDigits = 0U;
+    return;
+  }
+
+  if (KeyChar[mods][key] < 0)
+  {
+    Fail("key types no known character");
+    return;
+  }
+  HostEmit((uint8_t)KeyChar[mods][key]);
+}
+
+/* Only keys that were not down in the previous report are new presses */
+static void HostReport(const uint8_t *report, uint32_t len)
+{
+  uint8_t i;
+
+  if ((len < HID_KEYBOARD_REPORT_SIZE) || (report[0] != HID_REPORT_ID_KEYBOARD))
+  {
+    Fail("not a keyboard report");
+    return;
+  }
+  for (i = 3U; i < HID_KEYBOARD_REPORT_SIZE; i++)
+  {
+    if ((report[i] != 0U) && (memchr(&Prev[3], report[i], HID_KEYBOARD_REPORT_SIZE - 3U) == NULL))
+    {
+      HostPress(report[1], report[i]);
+    }
+  }
+  memcpy(Prev, report, HID_KEYBOARD_REPORT_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *MakeText(uint32_t size, uint8_t unicode, uint32_t seed)
+{
+  uint8_t *text = malloc(size);
+  uint32_t pos = 0U;
+  const char *u;
+
+  if (text == NULL)
+  {
+    perror("malloc");
+    exit(2);
+  }
+  while (pos < size)
+  {
+    u = Pool[Rand(&seed) % (sizeof(Pool) / sizeof(Pool[0]))];
+    if (((Rand(&seed) % 100U) < unicode) && ((size - pos) >= strlen(u)))
+    {
+      memcpy(&text[pos], u, strlen(u));
+      pos += (uint32_t)strlen(u);
+    }
+    else
+    {
+      text[pos++] = (uint8_t)Typable[Rand(&seed) % NumTypable];
+    }
+  }
+  return text;
+}
+
+static void Attach(void)
+{
+  USBSIM_Reset();
+  memset(&hUsbDeviceFS, 0, sizeof(hUsbDeviceFS));
+  memset(&CompHandle, 0, sizeof(CompHandle));
+  memset(&CompItf, 0, sizeof(CompItf));
+  hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+  hUsbDeviceFS.dev_speed = USBD_SPEED_FULL;
+  hUsbDeviceFS.pClass = &SimClass;
+  hUsbDeviceFS.pClassData = &CompHandle;
+  hUsbDeviceFS.pUserData = &CompItf;
+  (void)USBD_CDC_RegisterInterface(&CompItf, &USBD_Interface_fops_FS);
+
+  /* Opened by the composite layer on the target */
+  (void)USBD_LL_OpenEP(&hUsbDeviceFS, CDC_OUT_EP, USBD_EP_TYPE_BULK, CDC_DATA_FS_MAX_PACKET_SIZE);
+  (void)USBD_LL_OpenEP(&hUsbDeviceFS, CDC_IN_EP, USBD_EP_TYPE_BULK, CDC_DATA_FS_MAX_PACKET_SIZE);
+  (void)USBD_LL_OpenEP(&hUsbDeviceFS, CDC_CMD_EP, USBD_EP_TYPE_INTR, CDC_CMD_PACKET_SIZE);
+  (void)USBD_LL_OpenEP(&hUsbDeviceFS, HID_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_EPIN_SIZE);
+
+  HID_Unicode_SetHost(HID_UNICODE_LINUX);
+  if ((USBD_HID.Init(&hUsbDeviceFS, 0U) != USBD_OK) || (USBD_CDC.Init(&hUsbDeviceFS, 0U) != USBD_OK))
+  {
+    Fail("init failed");
+  }
+}
+
+static int RunCase(const PipeCase *c, uint32_t size)
+{
+  uint8_t *text = MakeText(size, c->Unicode, 0x9E3779B9U + size);
+  USBSIM_EpTypeDef *out;
+  USBSIM_EpTypeDef *kb;
+  CDC_HID_PipeStatsTypeDef before;   /* the statistics add up since reset */
+  CDC_HID_PipeStatsTypeDef stats;
+  uint32_t seed = 0x2545F491U;
+  uint32_t sent = 0U;
+  uint32_t written = 0U;    /* bytes of the current host write */
+  uint32_t frames = 0U;
+  uint32_t maxFrames = (size * 40U) + 10000U;
+  uint32_t parks = 0U;
+  uint32_t resumes = 0U;
+  uint32_t zlps = 0U;
+  uint32_t splits = 0U;     /* packets ending inside a UTF-8 character */
+  uint32_t reports = 0U;
+  uint32_t n;
+  uint32_t len;
+  uint8_t parked = 0U;
+  uint8_t zlp = 0U;
+
+  CaseName = c->Name;
+  Errors = 0U;
+  Completions = 0U;
+  memset(Prev, 0, sizeof(Prev));
+  InUnicode = 0U;
+  TypedLen = 0U;
+  TypedMax = size;
+  Typed = malloc(size);
+  if (Typed == NULL)
+  {
+    perror("malloc");
+    exit(2);
+  }
+
+  CDC_HID_Pipe_GetStats(&before);
+  Attach();
+  out = USBSIM_Ep(CDC_OUT_EP);
+  kb = USBSIM_Ep(HID_EPIN_ADDR);
+
+  for (frames = 0U; frames < maxFrames; frames++)
+  {
+    USBSIM_Tick++;
+
+    /* Bulk OUT, until the endpoint NAKs */
+    for (n = 0U; (n < PACKETS_PER_FRAME) && ((sent < size) || (zlp != 0U)); n++)
+    {
+      if (out->Armed == 0U)
+      {
+        break;
+      }
+      if (parked != 0U)
+      {
+        parked = 0U;
+        resumes++;
+      }
+
+      if (zlp != 0U)
+      {
+        len = 0U;
+        zlp = 0U;
+        zlps++;
+      }
+      else
+      {
+        switch (c->Mode)
+        {
+          case PACKET_RANDOM:
+            len = 1U + (Rand(&seed) % CDC_DATA_FS_MAX_PACKET_SIZE);
+            break;
+          case PACKET_ONE:
+            len = 1U;
+            break;
+          default:
+            len = CDC_DATA_FS_MAX_PACKET_SIZE;
+            break;
+        }
+        len = (len < (size - sent)) ? len : (size - sent);
+        memcpy(out->Buf, &text[sent], len);
+        sent += len;
+        written += len;
+        if ((sent < size) && ((text[sent] & 0xC0U) == 0x80U))
+        {
+          splits++;
+        }
+        /* A write of whole packets ends with a zero length packet */
+        if ((c->Mode == PACKET_FULL) && ((written >= ZLP_EVERY) || (sent == size)) &&
+            (len == CDC_DATA_FS_MAX_PACKET_SIZE))
+        {
+          written = 0U;
+          zlp = 1U;
+        }
+      }
+
+      USBSIM_DataOut(&hUsbDeviceFS, CDC_OUT_EP, len);
+      if (out->Armed == 0U)
+      {
+        parked = 1U;
+        parks++;
+      }
+      if (USBSIM_Primask != 0U)
+      {
+        Fail("interrupts left masked by DataOut");
+        USBSIM_Primask = 0U;
+      }
+    }
+
+    USBSIM_Sof(&hUsbDeviceFS);
+
+    /* Interrupt IN, polled every frame */
+    if (kb->Armed != 0U)
+    {
+      reports++;
+      HostReport(kb->Pma, kb->Len);
+      USBSIM_DataIn(&hUsbDeviceFS, HID_EPIN_ADDR);
+    }
+    if (USBSIM_Primask != 0U)
+    {
+      Fail("interrupts left masked by SOF or DataIn");
+      USBSIM_Primask = 0U;
+    }
+
+    CDC_HID_Pipe_GetStats(&stats);
+    if ((sent == size) && (zlp == 0U) && ((stats.Typed - before.Typed) == size) &&
+        (hHIDTransfer.HID_StateMachine == LOP_IDLE) && (kb->Armed == 0U))
+    {
+      break;
+    }
+  }
+
+  CDC_HID_Pipe_GetStats(&stats);
+  if (frames == maxFrames)
+  {
+    Fail("text not typed in time");
+  }
+  if ((InUnicode != 0U) || (TypedLen != size) || (memcmp(Typed, text, size) != 0))
+  {
+    n = 0U;
+    while ((n < TypedLen) && (n < size) && (Typed[n] == text[n]))
+    {
+      n++;
+    }
+    fprintf(stderr, "  %s: typed text differs at byte %u of %u (%u typed)\n",
+            CaseName, (unsigned)n, (unsigned)size, (unsigned)TypedLen);
+    Errors++;
+  }
+  if (((stats.Received - before.Received) != size) || ((stats.Typed - before.Typed) != size))
+  {
+    Fail("statistics do not count every byte");
+  }
+  if ((parks == 0U) || ((stats.Parked - before.Parked) != parks))
+  {
+    Fail("the OUT endpoint was not left NAKed as counted");
+  }
+  /* The last park ends after the host wrote everything */
+  if (((resumes + parked) != parks) || (out->Armed == 0U))
+  {
+    Fail("a parked OUT endpoint was not armed again");
+  }
+  if ((c->Unicode != 0U) && (splits == 0U))
+  {
+    Fail("no UTF-8 character split by two packets");
+  }
+  if (Completions == 0U)
+  {
+    Fail("the completion hook did not run");
+  }
+
+  printf("%-24s %6u bytes %6u frames %6u reports %4u parks %3u splits %2u zlps  %s\n",
+         CaseName, (unsigned)size, (unsigned)frames, (unsigned)reports, (unsigned)parks,
+         (unsigned)splits, (unsigned)zlps, (Errors == 0U) ? "ok" : "FAIL");
+
+  free(Typed);
+  free(text);
+  return (Errors == 0U) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t size = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : TEXT_SIZE;
+  int fail = 0;
+  size_t i;
+
+  LearnKeys();
+  for (i = 0U; i < (sizeof(Cases) / sizeof(Cases[0])); i++)
+  {
+    fail |= RunCase(&Cases[i], size / Cases[i].Divider);
+  }
+  printf("%s\n", fail ? "FAIL" : "PASS");
+  return fail;
+}
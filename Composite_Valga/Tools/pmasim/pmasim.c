@@ -0,0 +1,130 @@
+/*
+ * pmasim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host model of the USB packet memory for USB_WritePMA/USB_ReadPMA of
+ *  stm32wbxx_ll_usb.c. The USB peripheral page is mapped at its real address
+ *  so the driver runs unchanged, and every copy is checked against the
+ *  halfword loop of the original HAL for all buffer alignments, odd and even
+ *  lengths and packet memory offsets. The user buffers are written through
+ *  their own type right before each copy, so an aliasing bug in the word
+ *  accesses shows up once the driver is inlined.
+ *
+ *  Build (Linux, x86_64):
+ *    gcc -Os -fstrict-aliasing -flto -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER \
+ *        -I../../Core/Inc -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -Wno-int-to-pointer-cast \
+ *        -Wno-pointer-to-int-cast -o pmasim pmasim.c \
+ *        ../../Drivers/STM32WBxx_HAL_Driver/Src/stm32wbxx_ll_usb.c
+ *
+ *  Usage:
+ *    pmasim [iterations]     exit status 0 when every copy matches
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "stm32wbxx_hal.h"
+
+#define PMA_PAGE              (USB1_BASE & ~0xFFFUL)
+#define PMA_SIZE              1024U
+#define BUF_SIZE              528U      /* a 512 byte packet plus misalignment */
+
+static uint16_t RefPma[PMA_SIZE / 2U];
+static uint32_t Src[BUF_SIZE / 4U];
+static uint32_t Dst[BUF_SIZE / 4U];
+static uint8_t RefDst[BUF_SIZE];
+
+/* Halfword loops of the original HAL */
+static void RefWrite(uint16_t *pma, const uint8_t *buf, uint32_t len)
+{
+  uint32_t i;
+
+  for (i = 0U; i < ((len + 1U) >> 1); i++)
+  {
+    pma[i] = (uint16_t)(buf[2U * i] | ((uint16_t)buf[(2U * i) + 1U] << 8));
+  }
+}
+
+static void RefRead(const uint16_t *pma, uint8_t *buf, uint32_t len)
+{
+  uint32_t i;
+
+  for (i = 0U; i < (len >> 1); i++)
+  {
+    buf[2U * i] = (uint8_t)pma[i];
+    buf[(2U * i) + 1U] = (uint8_t)(pma[i] >> 8);
+  }
+  if ((len & 1U) != 0U)
+  {
+    buf[2U * i] = (uint8_t)pma[i];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  USB_TypeDef *usb;
+  uint16_t *pma;
+  uint8_t *page;
+  uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 100000U;
+  uint32_t it, i, len, off, addr;
+  uint32_t runs = 0U, bad = 0U;
+
+  page = mmap((void *)PMA_PAGE, 0x1000U, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+  if (page != (uint8_t *)PMA_PAGE)
+  {
+    fprintf(stderr, "pmasim: cannot map 0x%08lx\n", (unsigned long)PMA_PAGE);
+    return 2;
+  }
+  usb = (USB_TypeDef *)USB1_BASE;
+  pma = (uint16_t *)USB1_PMAADDR;
+
+  srand(1U);
+  for (it = 0U; it < iterations; it++)
+  {
+    len = (uint32_t)rand() % (BUF_SIZE - 8U);
+    off = (uint32_t)rand() % 8U;
+    addr = ((uint32_t)rand() % (PMA_SIZE / 2U)) * 2U;
+    if ((addr + len + 1U) > PMA_SIZE)
+    {
+      continue;
+    }
+
+    for (i = 0U; i < (BUF_SIZE / 4U); i++)
+    {
+      Src[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+      Dst[i] = 0x5A5A5A5AU;
+    }
+    (void)memset(RefPma, 0xA5, PMA_SIZE);
+    (void)memset(pma, 0xA5, PMA_SIZE);
+    (void)memset(RefDst, 0x5A, BUF_SIZE);
+
+    USB_WritePMA(usb, (uint8_t *)Src + off, (uint16_t)addr, (uint16_t)len);
+    RefWrite(&RefPma[addr / 2U], (const uint8_t *)Src + off, len);
+    if (memcmp(RefPma, pma, PMA_SIZE) != 0)
+    {
+      fprintf(stderr, "write: len %lu off %lu pma 0x%03lx\n",
+              (unsigned long)len, (unsigned long)off, (unsigned long)addr);
+      bad++;
+    }
+
+    USB_ReadPMA(usb, (uint8_t *)Dst + off, (uint16_t)addr, (uint16_t)len);
+    RefRead(&pma[addr / 2U], &RefDst[off], len);
+    if (memcmp(Dst, RefDst, BUF_SIZE) != 0)
+    {
+      fprintf(stderr, "read: len %lu off %lu pma 0x%03lx\n",
+              (unsigned long)len, (unsigned long)off, (unsigned long)addr);
+      bad++;
+    }
+    runs++;
+  }
+
+  printf("pmasim: %lu copies, %lu mismatches\n", (unsigned long)runs, (unsigned long)bad);
+  return (bad != 0U) ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * streamsim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host test of the isochronous frame scheduler of usbd_stream.c, with the
+ *  FIFO of usbd_stream_if.c and the incomplete isochronous IN detection of
+ *  usbd_conf.c (USBD_IsoInTypeDef), entered through the core the way the
+ *  PCD callbacks do. Every frame the application writes some bytes, SOF
+ *  comes, then the host polls the IN endpoint and sends an OUT packet,
+ *  unless the frame is one it misses. The host checks the bytes arrive in
+ *  order, and USBD_STREAM_StatsTypeDef is checked against what the host
+ *  saw: packets taken, frames that went out empty, packets left in the
+ *  packet memory past their frame, OUT packets and frames without one.
+ *
+ *  Build (Linux):
+ *    M=../../Middlewares/ST/STM32_USB_Device_Library
+ *    gcc -O2 -Wall -DSTM32WB55xx -DUSE_HAL_DRIVER -DSTREAM_OUT_ENABLE=1 \
+ *        -DHID_POINTER_ENABLE=0 -I../../Core/Inc \
+ *        -I../../Drivers/STM32WBxx_HAL_Driver/Inc \
+ *        -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include \
+ *        -I../../Drivers/CMSIS/Include -I../../USB_Device/Target \
+ *        -I../../USB_Device/App -I$M/Core/Inc -Wno-int-to-pointer-cast \
+ *        -Wno-pointer-to-int-cast -o streamsim streamsim.c ../usbsim/usbsim.c \
+ *        $M/Class/STREAM/Src/usbd_stream.c ../../USB_Device/App/usbd_stream_if.c \
+ *        $M/Core/Src/usbd_core.c $M/Core/Src/usbd_ctlreq.c \
+ *        $M/Core/Src/usbd_ioreq.c
+ *
+ *  Usage:
+ *    streamsim [frames]      per case, 100000 by default
+ *  Exit status is 0 when every case passes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../usbsim/usbsim.h"
+#include "usbd_stream_if.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
+
+typedef struct
+{
+  const char *Name;
+  uint16_t RateMin;     /* bytes written per frame, even */
+  uint16_t RateMax;
+  uint16_t SkipIn;      /* per mille of the frames the host misses the IN */
+  uint16_t SkipOut;     /* and the OUT */
+  uint16_t RunEvery;    /* every so many frames on average, the host */
+  uint16_t RunMax;      /* misses a run of up to RunMax frames */
+  uint16_t Restart;     /* frames between SET_INTERFACE 0 and 1, 0 never */
+}
+StreamCase;
+
+static const StreamCase Cases[] =
+{
+  { "steady, 192 bytes a frame",    192U, 192U, 0U,  0U,  0U,   0U, 0U    },
+  { "bursty application",           0U,   400U, 0U,  0U,  0U,   0U, 0U    },
+  { "starved application",          0U,   60U,  0U,  0U,  0U,   0U, 0U    },
+  { "starved, host misses 2%",      0U,   60U,  20U, 0U,  0U,   0U, 0U    },
+  { "host misses 2% of frames",     100U, 192U, 20U, 20U, 0U,   0U, 0U    },
+  { "runs of missed frames",        150U, 250U, 0U,  0U,  200U, 5U, 0U    },
+  { "everything, with restarts",    0U,   300U, 10U, 30U, 300U, 4U, 1000U },
+};
+
+static USBD_HandleTypeDef Dev;
+static USBD_Composite_HandleTypeDef CompHandle;
+static USBD_Comp_ItfTypeDef CompItf;
+static uint32_t Seed = 1U;
+static unsigned Errors;
+
+static uint32_t Random(uint32_t n)
+{
+  Seed = (Seed * 1103515245U) + 12345U;
+  return (n != 0U) ? ((Seed >> 8) % n) : 0U;
+}
+
+static void Fail(const StreamCase *c, uint32_t frame, const char *what)
+{
+  if (Errors < 10U)
+  {
+    fprintf(stderr, "  %s: %s at frame %u\n", c->Name, what, frame);
+  }
+  Errors++;
+}
+
+static void SetInterface(uint16_t alt)
+{
+  USBD_SetupReqTypedef req;
+
+  req.bmRequest = USB_REQ_TYPE_STANDARD | USB_REQ_RECIPIENT_INTERFACE;
+  req.bRequest = USB_REQ_SET_INTERFACE;
+  req.wValue = alt;
+  req.wIndex = USBD_COMP_ITF_STREAM;
+  req.wLength = 0U;
+  (void)USBD_STREAM.Setup(&Dev, &req);
+}
+
+static void CheckStat(const StreamCase *c, const char *name, uint32_t got, uint32_t want)
+{
+  if (got != want)
+  {
+    if (Errors < 10U)
+    {
+      fprintf(stderr, "  %s: %s %u, the host saw %u\n", c->Name, name, got, want);
+    }
+    Errors++;
+  }
+}
+
+static void RunCase(const StreamCase *c, uint32_t frames)
+{
+  USBSIM_EpTypeDef *in = USBSIM_Ep(STREAM_EPIN_ADDR);
+  USBSIM_EpTypeDef *out = USBSIM_Ep(STREAM_EPOUT_ADDR);
+  USBD_STREAM_StatsTypeDef want;
+  USBD_STREAM_StatsTypeDef got;
+  uint8_t data[400];
+  uint16_t txWord = 0U;       /* next 16 bit word the application writes */
+  uint16_t rxWord = 0U;       /* next word the host expects */
+  uint8_t resync = 1U;
+  uint32_t runLeft = 0U;
+  uint64_t bytesIn = 0U;
+
+  (void)memset(&want, 0, sizeof(want));
+  USBSIM_Reset();
+  (void)USBD_LL_OpenEP(&Dev, STREAM_EPIN_ADDR, STREAM_EP_ATTR, STREAM_IN_PACKET_SIZE);
+  (void)USBD_LL_OpenEP(&Dev, STREAM_EPOUT_ADDR, STREAM_EP_ATTR, STREAM_OUT_PACKET_SIZE);
+  if (USBD_STREAM.Init(&Dev, 0U) != USBD_OK)
+  {
+    Fail(c, 0U, "stream handle not allocated");
+    return;
+  }
+  SetInterface(1U);
+
+  for (uint32_t frame = 0U; frame <= frames; frame++)
+  {
+    uint8_t skipIn;
+    uint8_t skipOut;
+    uint16_t len;
+
+    /* Application: whole words, as many as the FIFO takes */
+    len = (uint16_t)((c->RateMin + Random(c->RateMax - c->RateMin + 1U)) & ~1U);
+    for (uint16_t i = 0U; i < len; i += 2U)
+    {
+      data[i] = (uint8_t)(txWord + (i / 2U));
+      data[i + 1U] = (uint8_t)((txWord + (i / 2U)) >> 8);
+    }
+    txWord = (uint16_t)(txWord + (STREAM_Write_FS(data, len) / 2U));
+
+    USBSIM_Sof(&Dev);
+    if (!in->Armed)
+    {
+      want.Underruns++;
+    }
+    if (frame == frames)
+    {
+      /* Last SOF, it closes the accounting of the frame before */
+      break;
+    }
+
+    if ((c->RunEvery != 0U) && (runLeft == 0U) && (Random(c->RunEvery) == 0U))
+    {
+      runLeft = 1U + Random(c->RunMax);
+    }
+    skipIn = (runLeft != 0U) || (Random(1000U) < c->SkipIn);
+    skipOut = (runLeft != 0U) || (Random(1000U) < c->SkipOut);
+    runLeft -= (runLeft != 0U) ? 1U : 0U;
+
+    /* Host, IN token: the packet armed for this frame, if any */
+    if (in->Armed && skipIn)
+    {
+      want.Missed++;
+    }
+    else if (in->Armed)
+    {
+      if ((in->Len == 0U) || (in->Len > STREAM_IN_PACKET_SIZE) || ((in->Len & 1U) != 0U))
+      {
+        Fail(c, frame, "bad IN packet length");
+      }
+      for (uint32_t i = 0U; (i + 1U) < in->Len; i += 2U)
+      {
+        uint16_t word = (uint16_t)(in->Pma[i] | (in->Pma[i + 1U] << 8));
+
+        if (resync)
+        {
+          /* After a restart the packet that was prepared is dropped */
+          if ((uint16_t)(word - rxWord) > (2U * STREAM_IN_PACKET_SIZE))
+          {
+            Fail(c, frame, "stream does not resume after the restart");
+          }
+          rxWord = word;
+          resync = 0U;
+        }
+        if (word != rxWord)
+        {
+          Fail(c, frame, "bytes out of order");
+          rxWord = word;
+        }
+        rxWord++;
+      }
+      bytesIn += in->Len;
+      want.InPackets++;
+      USBSIM_DataIn(&Dev, STREAM_EPIN_ADDR);
+    }
+
+    /* Host, OUT token */
+    if (skipOut)
+    {
+      want.OutMissed++;
+    }
+    else if (!out->Armed)
+    {
+      Fail(c, frame, "OUT endpoint not armed");
+    }
+    else
+    {
+      len = (uint16_t)Random(out->Len + 1U);
+      (void)memset(out->Buf, (int)frame, len);
+      want.OutPackets++;
+      USBSIM_DataOut(&Dev, STREAM_EPOUT_ADDR, len);
+    }
+
+    /* Only between frames the host did not miss: the frames of a restart
+     * owe nothing */
+    if ((c->Restart != 0U) && ((frame % c->Restart) == (c->Restart - 1U)) &&
+        !skipIn && !skipOut)
+    {
+      SetInterface(0U);
+      SetInterface(1U);
+      resync = 1U;
+    }
+  }
+
+  (void)USBD_STREAM_GetStats(&Dev, &got);
+  CheckStat(c, "InPackets", got.InPackets, want.InPackets);
+  CheckStat(c, "Underruns", got.Underruns, want.Underruns);
+  CheckStat(c, "Missed", got.Missed, want.Missed);
+  CheckStat(c, "OutPackets", got.OutPackets, want.OutPackets);
+  CheckStat(c, "OutMissed", got.OutMissed, want.OutMissed);
+
+  printf("%-30s %7u in, %6u empty, %5u late, %7u out, %5u no out, %.1f KB/s\n",
+         c->Name, got.InPackets, got.Underruns, got.Missed, got.OutPackets,
+         got.OutMissed, (double)bytesIn / frames);
+
+  SetInterface(0U);
+  (void)USBD_STREAM.DeInit(&Dev, 0U);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 100000U;
+
+  Dev.dev_state = USBD_STATE_CONFIGURED;
+  Dev.pClass = &USBD_STREAM;
+  Dev.pClassData = &CompHandle;
+  Dev.pUserData = &CompItf;
+  (void)USBD_STREAM_RegisterInterface(&CompItf, &USBD_Stream_Interface_fops_FS);
+
+  for (size_t i = 0U; i < sizeof(Cases) / sizeof(Cases[0]); i++)
+  {
+    RunCase(&Cases[i], frames);
+  }
+
+  if (Errors != 0U)
+  {
+    printf("FAIL: %u errors\n", Errors);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
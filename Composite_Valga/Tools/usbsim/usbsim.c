@@ -0,0 +1,254 @@
+/*
+ * usbsim.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Low level driver calls of the USB device library, recorded for the host
+ *  tools. See usbsim.h.
+ */
+
+#include <string.h>
+
+#include "usbsim.h"
+
+#define USBSIM_ARENA_SIZE             16384U
+
+USBSIM_EpTypeDef USBSIM_In[USBSIM_NUM_EP];
+USBSIM_EpTypeDef USBSIM_Out[USBSIM_NUM_EP];
+uint32_t USBSIM_Tick;
+uint32_t USBSIM_Primask;
+USBD_IsoInTypeDef USBSIM_IsoIn;
+
+/* Same policy as the arena of usbd_conf.c: 8-byte blocks, a release drops
+ * the block and every block taken after it */
+static uint64_t USBSIM_Arena[USBSIM_ARENA_SIZE / 8U];
+static uint32_t USBSIM_ArenaTop;
+static uint32_t USBSIM_ArenaMax;
+
+/* Bytes of the first packet of a transfer, EP0 taking 64 */
+static uint32_t USBSIM_PacketSize(const USBSIM_EpTypeDef *ep, uint32_t size)
+{
+  uint32_t mps = (ep->Mps != 0U) ? ep->Mps : USB_MAX_EP0_SIZE;
+
+  return (size < mps) ? size : mps;
+}
+
+USBSIM_EpTypeDef *USBSIM_Ep(uint8_t ep_addr)
+{
+  return ((ep_addr & 0x80U) != 0U) ? &USBSIM_In[ep_addr & 0x07U] : &USBSIM_Out[ep_addr & 0x07U];
+}
+
+void USBSIM_Reset(void)
+{
+  (void)memset(USBSIM_In, 0, sizeof(USBSIM_In));
+  (void)memset(USBSIM_Out, 0, sizeof(USBSIM_Out));
+  (void)memset(&USBSIM_IsoIn, 0, sizeof(USBSIM_IsoIn));
+  USBSIM_ArenaTop = 0U;
+  USBSIM_Tick = 0U;
+  USBSIM_Primask = 0U;
+}
+
+uint32_t USBSIM_ArenaPeak(void)
+{
+  return USBSIM_ArenaMax;
+}
+
+void *USBD_static_malloc(uint32_t size)
+{
+  uint32_t block = (size + 7U) & ~7U;
+  void *p;
+
+  if (block > (sizeof(USBSIM_Arena) - USBSIM_ArenaTop))
+  {
+    return NULL;
+  }
+
+  p = (uint8_t *)USBSIM_Arena + USBSIM_ArenaTop;
+  USBSIM_ArenaTop += block;
+  if (USBSIM_ArenaTop > USBSIM_ArenaMax)
+  {
+    USBSIM_ArenaMax = USBSIM_ArenaTop;
+  }
+
+  return p;
+}
+
+void USBD_static_free(void *p)
+{
+  uint32_t offset = (uint32_t)((uint8_t *)p - (uint8_t *)USBSIM_Arena);
+
+  if (((uint8_t *)p >= (uint8_t *)USBSIM_Arena) && (offset < USBSIM_ArenaTop))
+  {
+    USBSIM_ArenaTop = offset;
+  }
+}
+
+/* Same order as HAL_PCD_SOFCallback */
+void USBSIM_Sof(USBD_HandleTypeDef *pdev)
+{
+  uint8_t missed = USBD_IsoIn_Missed(&USBSIM_IsoIn);
+  uint8_t epnum;
+
+  for (epnum = 1U; missed != 0U; epnum++)
+  {
+    if ((missed & (1U << epnum)) != 0U)
+    {
+      missed &= (uint8_t)~(1U << epnum);
+      (void)USBD_LL_IsoINIncomplete(pdev, epnum);
+    }
+  }
+  (void)USBD_LL_SOF(pdev);
+  USBD_IsoIn_Frame(&USBSIM_IsoIn);
+}
+
+/* The PCD passes its transfer buffer moved past the data, where the core
+ * goes on with the next packet of EP0 */
+void USBSIM_DataIn(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(ep_addr);
+  uint32_t len = ((ep_addr & 0x07U) == 0U) ? USBSIM_PacketSize(ep, ep->Len) : ep->Len;
+
+  ep->Armed = 0U;
+  if (ep->Type == USBD_EP_TYPE_ISOC)
+  {
+    USBD_IsoIn_Release(&USBSIM_IsoIn, ep_addr & 0x07U);
+  }
+  (void)USBD_LL_DataInStage(pdev, ep_addr & 0x07U, (ep->Buf != NULL) ? &ep->Buf[len] : NULL);
+}
+
+void USBSIM_DataOut(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint32_t len)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(ep_addr);
+
+  ep->Armed = 0U;
+  ep->RxSize = len;
+  (void)USBD_LL_DataOutStage(pdev, ep_addr & 0x07U, (ep->Buf != NULL) ? &ep->Buf[len] : NULL);
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return USBSIM_Tick;
+}
+
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                  uint8_t ep_type, uint16_t ep_mps)
+{
+  USBSIM_Ep(ep_addr)->Open = 1U;
+  USBSIM_Ep(ep_addr)->Type = ep_type & 0x03U;
+  USBSIM_Ep(ep_addr)->Mps = ep_mps;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBSIM_Ep(ep_addr)->Open = 0U;
+  USBSIM_Ep(ep_addr)->Armed = 0U;
+  if ((ep_addr & 0x80U) != 0U)
+  {
+    USBD_IsoIn_Release(&USBSIM_IsoIn, ep_addr & 0x07U);
+  }
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBSIM_Ep(ep_addr)->Armed = 0U;
+  USBSIM_Ep(ep_addr)->Flushes++;
+  if (((ep_addr & 0x80U) != 0U) && (USBSIM_Ep(ep_addr)->Type == USBD_EP_TYPE_ISOC))
+  {
+    USBD_IsoIn_Release(&USBSIM_IsoIn, ep_addr & 0x07U);
+  }
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBSIM_Ep(ep_addr)->Stalled = 1U;
+  USBSIM_Ep(ep_addr)->Halted = 1U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBSIM_Ep(ep_addr)->Stalled = 0U;
+  USBSIM_Ep(ep_addr)->Halted = 0U;
+  return USBD_OK;
+}
+
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return USBSIM_Ep(ep_addr)->Stalled;
+}
+
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                    const uint8_t *pbuf, uint16_t size)
+{
+  /* Always IN, the core sends on EP0 as 0x00 */
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(ep_addr | 0x80U);
+
+  if (ep->Type == USBD_EP_TYPE_ISOC)
+  {
+    USBD_IsoIn_Arm(&USBSIM_IsoIn, ep_addr & 0x07U);
+  }
+
+  if (pbuf != NULL)
+  {
+    (void)memcpy(ep->Pma, pbuf, USBSIM_PacketSize(ep, size));
+  }
+  ep->Buf = (uint8_t *)pbuf;
+  ep->Len = size;
+  ep->Armed = 1U;
+  ep->Halted = 0U;
+  ep->ArmedAt = USBSIM_Tick;
+  ep->Transfers++;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                          uint8_t *pbuf, uint16_t size)
+{
+  USBSIM_EpTypeDef *ep = USBSIM_Ep(ep_addr & 0x7FU);
+
+  ep->Buf = pbuf;
+  ep->Len = size;
+  ep->Armed = 1U;
+  ep->Halted = 0U;
+  ep->ArmedAt = USBSIM_Tick;
+  ep->Transfers++;
+  return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  return USBSIM_Ep(ep_addr)->RxSize;
+}
+
+void USBD_LL_Delay(uint32_t Delay)
+{
+  USBSIM_Tick += Delay;
+}
@@ -0,0 +1,96 @@
+/*
+ * usbsim.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Host stand-in for the low level driver of usbd_conf.c, shared by the
+ *  host tools that run the class sources unchanged. Every USBD_LL_ call is
+ *  recorded per endpoint: the tool plays the host by reading the buffer of
+ *  an armed IN endpoint, or by filling the buffer of an armed OUT endpoint,
+ *  setting its received size and calling the class DataIn/DataOut, or
+ *  through USBSIM_Sof, USBSIM_DataIn and USBSIM_DataOut, which enter the
+ *  core the way the PCD callbacks of usbd_conf.c do, incomplete isochronous
+ *  IN detection included. The handles come from an arena released like the
+ *  one of usbd_conf.c.
+ *
+ *  The class sources are built with the real device headers:
+ *    -DSTM32WB55xx -DUSE_HAL_DRIVER -I../../Core/Inc
+ *    -I../../Drivers/STM32WBxx_HAL_Driver/Inc
+ *    -I../../Drivers/CMSIS/Device/ST/STM32WBxx/Include
+ *    -I../../Drivers/CMSIS/Include -I../../USB_Device/Target
+ *    -I../../USB_Device/App -I../../Middlewares/ST/STM32_USB_Device_Library/Core/Inc
+ *    -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast
+ *  Sources that mask interrupts are built with -include ../usbsim/usbsim.h
+ *  as well: the CMSIS PRIMASK intrinsics then work on USBSIM_Primask.
+ */
+
+#ifndef TOOLS_USBSIM_USBSIM_H_
+#define TOOLS_USBSIM_USBSIM_H_
+
+#include "usbd_core.h"
+
+#define USBSIM_NUM_EP                 8U
+#define USBSIM_PMA_SIZE               1024U
+
+typedef struct
+{
+  uint8_t  *Buf;        /* buffer of the transfer armed last */
+  uint32_t Len;         /* its length, or the size offered for OUT */
+  uint8_t  Open;
+  uint8_t  Type;        /* USBD_EP_TYPE_xxx */
+  uint16_t Mps;
+  uint8_t  Armed;       /* cleared by the tool once it takes the transfer */
+  uint8_t  Stalled;     /* returned by USBD_LL_IsStallEP */
+  /* The endpoint answers STALL. Set with Stalled, but arming a transfer
+   * lifts it as the PCD does, setting the endpoint valid */
+  uint8_t  Halted;
+  uint32_t ArmedAt;     /* USBSIM_Tick when the transfer was armed */
+  uint32_t Transfers;   /* transfers armed since USBSIM_Reset */
+  uint32_t Flushes;
+  uint32_t RxSize;      /* returned by USBD_LL_GetRxDataSize */
+  /* First packet of an IN transfer, copied when it is armed as the PCD
+   * does, the following packets are read from Buf as the host takes them */
+  uint8_t  Pma[USBSIM_PMA_SIZE];
+}
+USBSIM_EpTypeDef;
+
+extern USBSIM_EpTypeDef USBSIM_In[USBSIM_NUM_EP];
+extern USBSIM_EpTypeDef USBSIM_Out[USBSIM_NUM_EP];
+
+/* Returned by HAL_GetTick, moved by the tool */
+extern uint32_t USBSIM_Tick;
+
+/* PRIMASK of the sources built with -include, 1 while interrupts are
+ * masked */
+extern uint32_t USBSIM_Primask;
+
+#define __get_PRIMASK()               (USBSIM_Primask)
+#define __set_PRIMASK(primask)        (USBSIM_Primask = (primask))
+#define __disable_irq()               (USBSIM_Primask = 1U)
+#define __enable_irq()                (USBSIM_Primask = 0U)
+#define __DMB()                       __asm volatile ("" ::: "memory")
+
+/* Isochronous IN packets waiting for the host, as kept by usbd_conf.c */
+extern USBD_IsoInTypeDef USBSIM_IsoIn;
+
+/* Endpoint of an address, IN or OUT */
+USBSIM_EpTypeDef *USBSIM_Ep(uint8_t ep_addr);
+
+/* Every endpoint closed and idle, the arena empty */
+void USBSIM_Reset(void);
+
+/* Peak use of the arena, in bytes */
+uint32_t USBSIM_ArenaPeak(void);
+
+/* Start of frame: incomplete isochronous IN endpoints, then the class */
+void USBSIM_Sof(USBD_HandleTypeDef *pdev);
+
+/* The host took the transfer armed on an IN endpoint. EP0 completes each
+ * packet as the PCD does: there the host takes the first one only */
+void USBSIM_DataIn(USBD_HandleTypeDef *pdev, uint8_t ep_addr);
+
+/* The host wrote len bytes to the buffer armed on an OUT endpoint, one
+ * packet at most on EP0 */
+void USBSIM_DataOut(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint32_t len);
+
+#endif /* TOOLS_USBSIM_USBSIM_H_ */
@@ -26,7 +26,12 @@
 #include "usbd_desc.h"
 #include "usbd_cdc.h"
 #include "usbd_cdc_if.h"
-#include "..\..\Middlewares\ST\STM32_USB_Device_Library\Class\Composite\Inc\Composite.h"
+#include "usbd_hid_if.h"
+#include "usbd_storage_if.h"
+#include "usbd_stream_if.h"
+#include "usbd_audio_if.h"
+#include "usbd_dfu_if.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -70,7 +75,8 @@ extern USBD_Comp_ItfTypeDef Composite_Operators;
 void MX_USB_Device_Init(void)
 {
   /* USER CODE BEGIN USB_Device_Init_PreTreatment */
-  
+  /* The serial number string is served as is from then on */
+  USBD_Composite_InitSerialNum();
   /* USER CODE END USB_Device_Init_PreTreatment */
   
   /* Init Device Library, add supported class and start the library. */
@@ -83,6 +89,29 @@ void MX_USB_Device_Init(void)
   if (USBD_CDC_RegisterInterface(&Composite_Operators, &USBD_Interface_fops_FS) != USBD_OK) {
     Error_Handler();
   }
+  if (USBD_HID_RegisterInterface(&Composite_Operators, &USBD_HID_Interface_fops_FS) != USBD_OK) {
+    Error_Handler();
+  }
+#if (MSC_ENABLE == 1U)
+  if (USBD_MSC_RegisterStorage(&Composite_Operators, &USBD_Storage_Interface_fops_FS) != USBD_OK) {
+    Error_Handler();
+  }
+#endif /* MSC_ENABLE */
+#if (STREAM_ENABLE == 1U)
+  if (USBD_STREAM_RegisterInterface(&Composite_Operators, &USBD_Stream_Interface_fops_FS) != USBD_OK) {
+    Error_Handler();
+  }
+#endif /* STREAM_ENABLE */
+#if (AUDIO_ENABLE == 1U)
+  if (USBD_AUDIO_RegisterInterface(&Composite_Operators, &USBD_Audio_Interface_fops_FS) != USBD_OK) {
+    Error_Handler();
+  }
+#endif /* AUDIO_ENABLE */
+#if (DFU_ENABLE == 1U)
+  if (USBD_DFU_RegisterMedia(&Composite_Operators, &USBD_DFU_fops_FS) != USBD_OK) {
+    Error_Handler();
+  }
+#endif /* DFU_ENABLE */
   if (USBD_Composite_RegisterInterface(&hUsbDeviceFS, &Composite_Operators) != USBD_OK) {
     Error_Handler();
   }
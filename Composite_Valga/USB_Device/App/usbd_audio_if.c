@@ -0,0 +1,282 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_audio_if.c
+  * @brief          : Samples received from the host, queued for the playback
+  *                   of the device.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_AUDIO_IF
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_IF_Private_Variables USBD_AUDIO_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN PRIVATE_VARIABLES */
+#if ((AUDIO_FIFO_FRAMES & (AUDIO_FIFO_FRAMES - 1U)) != 0U)
+#error "AUDIO_FIFO_FRAMES must be a power of two"
+#endif
+
+/* Single producer, the USB interrupt, and single consumer, the playback:
+ * each side only moves its own index, in sample frames */
+static int16_t AudioFifo[AUDIO_FIFO_FRAMES * AUDIO_CHANNELS];
+static volatile uint16_t AudioHead;
+static volatile uint16_t AudioTail;
+/* Sample frames the playback took, silence included: the device clock */
+static volatile uint32_t AudioPlayed;
+/* Set by the USB side to empty the queue, done by the playback side */
+static volatile uint8_t AudioFlush;
+/* Playback waits for a half full queue, again after running dry */
+static uint8_t AudioPrimed;
+static uint32_t AudioOverruns;
+static uint32_t AudioUnderruns;
+/* USER CODE END PRIVATE_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_AUDIO_IF_Private_FunctionPrototypes USBD_AUDIO_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t AUDIO_Init_FS(void);
+static int8_t AUDIO_DeInit_FS(void);
+static int8_t AUDIO_Start_FS(void);
+static int8_t AUDIO_Stop_FS(void);
+static int8_t AUDIO_Receive_FS(const uint8_t *buf, uint16_t len);
+static void AUDIO_GetClock_FS(uint32_t *played, uint16_t *level);
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
+
+/**
+  * @}
+  */
+
+USBD_AUDIO_ItfTypeDef USBD_Audio_Interface_fops_FS =
+{
+  AUDIO_Init_FS,
+  AUDIO_DeInit_FS,
+  AUDIO_Start_FS,
+  AUDIO_Stop_FS,
+  AUDIO_Receive_FS,
+  AUDIO_GetClock_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the audio output
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t AUDIO_Init_FS(void)
+{
+  /* USER CODE BEGIN 3 */
+  AudioFlush = 1U;
+  return (USBD_OK);
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  DeInitializes the audio output
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t AUDIO_DeInit_FS(void)
+{
+  /* USER CODE BEGIN 4 */
+  return (USBD_OK);
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  The host starts streaming, the queue fills from empty
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t AUDIO_Start_FS(void)
+{
+  /* USER CODE BEGIN 5 */
+  AudioFlush = 1U;
+  return (USBD_OK);
+  /* USER CODE END 5 */
+}
+
+/**
+  * @brief  The host stops streaming, what is queued plays out
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t AUDIO_Stop_FS(void)
+{
+  /* USER CODE BEGIN 6 */
+  return (USBD_OK);
+  /* USER CODE END 6 */
+}
+
+/**
+  * @brief  Queue the sample frames of one packet. Called from the USB
+  *         interrupt
+  * @param  buf: 16 bit little endian samples, channels interleaved
+  * @param  len: packet length, whole sample frames
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t AUDIO_Receive_FS(const uint8_t *buf, uint16_t len)
+{
+  /* USER CODE BEGIN 7 */
+  uint16_t head = AudioHead;
+  uint16_t frames = len / AUDIO_FRAME_SIZE;
+  uint16_t room = (uint16_t)(AUDIO_FIFO_FRAMES - (uint16_t)(head - AudioTail));
+  uint16_t first;
+
+  if (frames > room)
+  {
+    /* The feedback keeps this from happening but for a host ignoring it */
+    AudioOverruns++;
+    frames = room;
+  }
+
+  first = (uint16_t)(AUDIO_FIFO_FRAMES - (head & (AUDIO_FIFO_FRAMES - 1U)));
+  if (first > frames)
+  {
+    first = frames;
+  }
+  (void)memcpy(&AudioFifo[(head & (AUDIO_FIFO_FRAMES - 1U)) * AUDIO_CHANNELS], buf,
+               (uint32_t)first * AUDIO_FRAME_SIZE);
+  (void)memcpy(&AudioFifo[0], &buf[(uint32_t)first * AUDIO_FRAME_SIZE],
+               (uint32_t)(frames - first) * AUDIO_FRAME_SIZE);
+  AudioHead = (uint16_t)(head + frames);
+
+  return (USBD_OK);
+  /* USER CODE END 7 */
+}
+
+/**
+  * @brief  Device clock and queue level for the rate feedback. Called from
+  *         the USB interrupt
+  * @param  played: sample frames played so far
+  * @param  level: sample frames queued
+  * @retval None
+  */
+static void AUDIO_GetClock_FS(uint32_t *played, uint16_t *level)
+{
+  /* USER CODE BEGIN 8 */
+  *played = AudioPlayed;
+  *level = (uint16_t)(AudioHead - AudioTail);
+  /* USER CODE END 8 */
+}
+
+/**
+  * @brief  Take the next sample frames for the audio output, from its DMA
+  *         interrupt, at the pace of the device sample clock. Silence fills
+  *         in while the queue is not half full yet. Smaller blocks give the
+  *         rate feedback a finer measure of the clock
+  * @param  Buf: destination, channels interleaved
+  * @param  Frames: number of sample frames
+  * @retval Number of sample frames taken from the host stream
+  */
+uint16_t AUDIO_Play_FS(int16_t *Buf, uint16_t Frames)
+{
+  /* USER CODE BEGIN 9 */
+  uint16_t tail = AudioTail;
+  uint16_t level;
+  uint16_t n;
+  uint16_t first;
+
+  if (AudioFlush != 0U)
+  {
+    AudioFlush = 0U;
+    AudioPrimed = 0U;
+    tail = AudioHead;
+  }
+
+  level = (uint16_t)(AudioHead - tail);
+  if ((AudioPrimed == 0U) && (level >= (AUDIO_FIFO_FRAMES / 2U)))
+  {
+    AudioPrimed = 1U;
+  }
+
+  n = (AudioPrimed != 0U) ? level : 0U;
+  if (n > Frames)
+  {
+    n = Frames;
+  }
+
+  first = (uint16_t)(AUDIO_FIFO_FRAMES - (tail & (AUDIO_FIFO_FRAMES - 1U)));
+  if (first > n)
+  {
+    first = n;
+  }
+  (void)memcpy(Buf, &AudioFifo[(tail & (AUDIO_FIFO_FRAMES - 1U)) * AUDIO_CHANNELS],
+               (uint32_t)first * AUDIO_FRAME_SIZE);
+  (void)memcpy(&Buf[first * AUDIO_CHANNELS], &AudioFifo[0],
+               (uint32_t)(n - first) * AUDIO_FRAME_SIZE);
+  AudioTail = (uint16_t)(tail + n);
+
+  if (n < Frames)
+  {
+    if (AudioPrimed != 0U)
+    {
+      AudioUnderruns++;
+      AudioPrimed = 0U;
+    }
+    (void)memset(&Buf[n * AUDIO_CHANNELS], 0, (uint32_t)(Frames - n) * AUDIO_FRAME_SIZE);
+  }
+
+  AudioPlayed += Frames;
+
+  return n;
+  /* USER CODE END 9 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+  * @brief  Packets cut short by a full queue, and playbacks run dry once
+  *         primed, since power up
+  * @param  Overruns: count of overruns
+  * @param  Underruns: count of underruns
+  * @retval None
+  */
+void AUDIO_GetErrors_FS(uint32_t *Overruns, uint32_t *Underruns)
+{
+  *Overruns = AudioOverruns;
+  *Underruns = AudioUnderruns;
+}
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
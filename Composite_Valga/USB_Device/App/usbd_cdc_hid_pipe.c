@@ -0,0 +1,201 @@
+/*
+ * usbd_cdc_hid_pipe.c
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  The pool is cut in CDC_HID_PIPE_BUFFER_SIZE buffers used as a ring: the
+ *  OUT endpoint receives into the buffer at Head, the typing engine pulls
+ *  from the one at Tail. A buffer goes back to the endpoint as soon as its
+ *  last byte is in the typing window, and a UTF-8 character split by two
+ *  packets is still typed. Everything runs from the USB interrupt (CDC
+ *  DataOut, HID DataIn and SOF), so no locking is needed there.
+ */
+
+#include "usbd_cdc_hid_pipe.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid.h"
+
+extern HIDLOP_TransferHandler hHIDTransfer;
+
+static void CDC_HID_Pipe_TypingDone(void *ptr);
+static uint32_t CDC_HID_Pipe_Pull(void *Ctx, uint8_t *Buf, uint32_t Len);
+
+static USBD_HandleTypeDef *PipeDev;
+static uint8_t *PipePool;
+static uint16_t PipeLength[CDC_HID_PIPE_MAX_BUFFERS];
+static uint8_t PipeNumBuffers;
+static uint8_t PipeHead;     /* buffer armed on the OUT endpoint */
+static uint8_t PipeTail;     /* oldest buffer waiting or being typed */
+static uint16_t PipeOffset;  /* bytes of Tail already pulled */
+static uint8_t PipeCount;    /* buffers holding text */
+static uint8_t PipeTyping;   /* Tail is owned by the typing engine */
+static uint8_t PipeParked;   /* OUT endpoint left NAKed, no free buffer */
+static CDC_HID_PipeStatsTypeDef PipeStats;
+static void (*PipeChainedDone)(void *ptr);  /* completion hook found at init */
+
+#define PIPE_BUFFER(n)        (&PipePool[(uint32_t)(n) * CDC_HID_PIPE_BUFFER_SIZE])
+
+/**
+  * @brief  CDC_HID_Pipe_Init
+  *         Hand the pool to the CDC receiver, called from the CDC Init callback
+  * @param  pdev: device instance
+  * @param  pool: receive memory, at least 2 buffers
+  * @param  size: pool size in bytes
+  * @retval None
+  */
+void CDC_HID_Pipe_Init(USBD_HandleTypeDef *pdev, uint8_t *pool, uint32_t size)
+{
+  PipeDev = pdev;
+  PipePool = pool;
+  PipeNumBuffers = (uint8_t)MIN(size / CDC_HID_PIPE_BUFFER_SIZE, CDC_HID_PIPE_MAX_BUFFERS);
+  PipeHead = 0U;
+  PipeTail = 0U;
+  PipeOffset = 0U;
+  PipeCount = 0U;
+  PipeTyping = 0U;
+  PipeParked = 0U;
+
+  /* Keep the application hook, it still runs at the end of each text.
+  Init runs again on every enumeration, do not chain to ourselves */
+  if (hHIDTransfer.TransferCompletedCallBack != CDC_HID_Pipe_TypingDone)
+  {
+    PipeChainedDone = hHIDTransfer.TransferCompletedCallBack;
+    hHIDTransfer.TransferCompletedCallBack = CDC_HID_Pipe_TypingDone;
+  }
+
+  /* USBD_CDC_Init arms the endpoint with this buffer */
+  USBD_CDC_SetRxBuffer(pdev, PIPE_BUFFER(PipeHead));
+}
+
+/**
+  * @brief  CDC_HID_Pipe_Receive
+  *         Queue a received buffer for typing and arm the endpoint with the
+  *         next free one, or leave it NAKed when there is none
+  * @param  pdev: device instance
+  * @param  Buf: buffer just filled, always the one at Head
+  * @param  Len: received bytes
+  * @retval USBD_OK
+  */
+int8_t CDC_HID_Pipe_Receive(USBD_HandleTypeDef *pdev, uint8_t *Buf, uint32_t Len)
+{
+  UNUSED(Buf);
+
+  if (Len != 0U)
+  {
+    PipeLength[PipeHead] = (uint16_t)Len;
+    PipeHead = (uint8_t)((PipeHead + 1U) % PipeNumBuffers);
+    PipeCount++;
+    PipeStats.Received += Len;
+  }
+
+  if (PipeCount < PipeNumBuffers)
+  {
+    USBD_CDC_SetRxBuffer(pdev, PIPE_BUFFER(PipeHead));
+    USBD_CDC_ReceivePacket(pdev);
+  }
+  else
+  {
+    PipeParked = 1U;
+    PipeStats.Parked++;
+  }
+
+  CDC_HID_Pipe_Kick(pdev);
+
+  return (USBD_OK);
+}
+
+/**
+  * @brief  CDC_HID_Pipe_Kick
+  *         Start typing the received text if the typing engine is free. Call it
+  *         after an application text or a macro if they share the keyboard
+  * @param  pdev: device instance
+  * @retval None
+  */
+void CDC_HID_Pipe_Kick(USBD_HandleTypeDef *pdev)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ((PipeTyping == 0U) && (PipeCount != 0U))
+  {
+    PipeTyping = 1U;
+    if (SendStreamHID(pdev, CDC_HID_Pipe_Pull, NULL) != LOP_OK)
+    {
+      PipeTyping = 0U;
+    }
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  CDC_HID_Pipe_GetStats
+  * @param  stats: destination
+  * @retval None
+  */
+void CDC_HID_Pipe_GetStats(CDC_HID_PipeStatsTypeDef *stats)
+{
+  *stats = PipeStats;
+}
+
+/**
+  * @brief  CDC_HID_Pipe_Pull
+  *         Typing source: copy from the oldest buffer and give it back to the
+  *         endpoint once it is fully pulled
+  * @param  Ctx: unused
+  * @param  Buf: typing window
+  * @param  Len: room in the window
+  * @retval bytes copied, HID_STREAM_END when no buffer is left
+  */
+static uint32_t CDC_HID_Pipe_Pull(void *Ctx, uint8_t *Buf, uint32_t Len)
+{
+  uint32_t n;
+
+  UNUSED(Ctx);
+
+  if (PipeCount == 0U)
+  {
+    return HID_STREAM_END;
+  }
+
+  n = MIN(Len, (uint32_t)PipeLength[PipeTail] - PipeOffset);
+  (void)memcpy(Buf, PIPE_BUFFER(PipeTail) + PipeOffset, n);
+  PipeOffset += (uint16_t)n;
+
+  if (PipeOffset == PipeLength[PipeTail])
+  {
+    PipeStats.Typed += PipeLength[PipeTail];
+    PipeTail = (uint8_t)((PipeTail + 1U) % PipeNumBuffers);
+    PipeOffset = 0U;
+    PipeCount--;
+
+    if (PipeParked != 0U)
+    {
+      PipeParked = 0U;
+      USBD_CDC_SetRxBuffer(PipeDev, PIPE_BUFFER(PipeHead));
+      USBD_CDC_ReceivePacket(PipeDev);
+    }
+  }
+
+  return n;
+}
+
+/**
+  * @brief  CDC_HID_Pipe_TypingDone
+  *         Typing engine completion: type what arrived since the end of the
+  *         text, or what waited behind an application text. The completion
+  *         hook that was installed before the pipe runs first
+  * @param  ptr: passed to the chained hook
+  * @retval None
+  */
+static void CDC_HID_Pipe_TypingDone(void *ptr)
+{
+  if (PipeChainedDone != NULL)
+  {
+    PipeChainedDone(ptr);
+  }
+
+  PipeTyping = 0U;
+  CDC_HID_Pipe_Kick(PipeDev);
+}
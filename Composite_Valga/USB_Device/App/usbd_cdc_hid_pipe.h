@@ -0,0 +1,41 @@
+/*
+ * usbd_cdc_hid_pipe.h
+ *
+ *  Created on: 19 oct. 2026
+ *
+ *  Text received on the CDC data interface is typed by the HID keyboard.
+ *  Receive buffers queue as they are and the typing engine copies them
+ *  into its lookahead window: consecutive packets are typed as one text, a
+ *  buffer goes back to the endpoint once copied, and the CDC OUT endpoint
+ *  is left NAKed while every buffer is waiting to be typed.
+ */
+#ifndef USBD_CDC_HID_PIPE_H_
+#define USBD_CDC_HID_PIPE_H_
+
+#include "usbd_cdc.h"
+
+/* 0 keeps the CDC loopback of usbd_cdc_if.c */
+#ifndef CDC_HID_PIPE_ENABLE
+#define CDC_HID_PIPE_ENABLE           1U
+#endif /* CDC_HID_PIPE_ENABLE */
+
+#define CDC_HID_PIPE_BUFFER_SIZE      CDC_DATA_FS_MAX_PACKET_SIZE
+#define CDC_HID_PIPE_MAX_BUFFERS      32U
+
+typedef struct
+{
+  uint32_t             Received;   /* bytes received from the host */
+  uint32_t             Typed;      /* bytes pulled by the typing engine */
+  uint32_t             Parked;     /* times the OUT endpoint was left NAKed */
+}
+CDC_HID_PipeStatsTypeDef;
+
+void CDC_HID_Pipe_Init(USBD_HandleTypeDef *pdev, uint8_t *pool, uint32_t size);
+
+int8_t CDC_HID_Pipe_Receive(USBD_HandleTypeDef *pdev, uint8_t *Buf, uint32_t Len);
+
+void CDC_HID_Pipe_Kick(USBD_HandleTypeDef *pdev);
+
+void CDC_HID_Pipe_GetStats(CDC_HID_PipeStatsTypeDef *stats);
+
+#endif /* USBD_CDC_HID_PIPE_H_ */
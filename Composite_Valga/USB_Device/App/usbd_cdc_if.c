@@ -23,7 +23,7 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+#include "usbd_cdc_hid_pipe.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -64,9 +64,9 @@
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
 /* Define size for the receive and transmit buffer over CDC */
-/* It's up to user to redefine and/or remove those define */
-#define APP_RX_DATA_SIZE  2048
-#define APP_TX_DATA_SIZE  2048
+/* Set in usbd_conf.h, the arena reserves them with the class handles */
+#define APP_RX_DATA_SIZE  USBD_CDC_RX_DATA_SIZE
+#define APP_TX_DATA_SIZE  USBD_CDC_TX_DATA_SIZE
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -90,13 +90,13 @@
   * @brief Private variables.
   * @{
   */
-/* Create buffer for reception and transmission           */
-/* It's up to user to redefine and/or remove those define */
+/* Buffers for reception and transmission, taken from the arena of
+ * usbd_conf.c by CDC_Init_FS, NULL while the device is not configured */
 /** Received data over USB are stored in this buffer      */
-uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
+uint8_t *UserRxBufferFS;
 
 /** Data to send over USB CDC are stored in this buffer   */
-uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+uint8_t *UserTxBufferFS;
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
 
@@ -155,9 +155,20 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_FS =
 static int8_t CDC_Init_FS(void)
 {
   /* USER CODE BEGIN 3 */
-  /* Set Application Buffers */
+  /* Set Application Buffers, released with the class handles */
+  UserRxBufferFS = USBD_malloc_Type(uint8_t, APP_RX_DATA_SIZE);
+  UserTxBufferFS = USBD_malloc_Type(uint8_t, APP_TX_DATA_SIZE);
+  if ((UserRxBufferFS == NULL) || (UserTxBufferFS == NULL))
+  {
+    return (USBD_FAIL);
+  }
   USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
+#if (CDC_HID_PIPE_ENABLE == 1U)
+  /* The receive buffer becomes the pool of the text pipe */
+  CDC_HID_Pipe_Init(&hUsbDeviceFS, UserRxBufferFS, APP_RX_DATA_SIZE);
+#else
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+#endif /* CDC_HID_PIPE_ENABLE */
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -169,6 +180,9 @@ static int8_t CDC_Init_FS(void)
 static int8_t CDC_DeInit_FS(void)
 {
   /* USER CODE BEGIN 4 */
+  /* The composite layer releases the arena */
+  UserRxBufferFS = NULL;
+  UserTxBufferFS = NULL;
   return (USBD_OK);
   /* USER CODE END 4 */
 }
@@ -263,10 +277,14 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
+#if (CDC_HID_PIPE_ENABLE == 1U)
+  return CDC_HID_Pipe_Receive(&hUsbDeviceFS, Buf, *Len);
+#else
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
   USBD_CDC_ReceivePacket(&hUsbDeviceFS);
   CDC_Transmit_FS(Buf, *Len);
   return (USBD_OK);
+#endif /* CDC_HID_PIPE_ENABLE */
   /* USER CODE END 6 */
 }
 
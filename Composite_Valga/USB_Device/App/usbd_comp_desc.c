@@ -19,16 +19,15 @@
 #define USBD_INTERFACE_CDC_STRING     "Poli-LOP CDC Interface"
 #define USBD_INTERFACE_HID_STRING	  "Poli-LOP HID Interface"
 
-static void Get_SerialNum(void);
 static void IntToUnicode(uint32_t value, uint8_t * pbuf, uint8_t len);
 
-uint8_t * USBD_Composite_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
-uint8_t * USBD_Composite_InterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length, uint8_t iInterf);
+const uint8_t * USBD_Composite_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length);
+const uint8_t * USBD_Composite_InterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length, uint8_t iInterf);
 
 USBD_DescriptorsTypeDef Composite_Desc =
 {
@@ -45,15 +44,15 @@ USBD_DescriptorsTypeDef Composite_Desc =
   #pragma data_alignment=4
 #endif /* defined ( __ICCARM__ ) */
 /** USB standard device descriptor. */
-__ALIGN_BEGIN uint8_t USBD_Composite_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
+__ALIGN_BEGIN const uint8_t USBD_Composite_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
 {
   0x12,                       /*bLength */
   USB_DESC_TYPE_DEVICE,       /*bDescriptorType*/
   0x00,                       /*bcdUSB */
   0x02,
-  0x00,                       /*bDeviceClass*/    //SE DEFINE EN INTERFAZ
-  0x00,                       /*bDeviceSubClass*/ //SE DEFINE EN INTERFAZ
-  0x00,                       /*bDeviceProtocol*/ //SE DEFINE EN INTERFAZ
+  0xEF,                       /*bDeviceClass: Miscellaneous, functions use IADs*/
+  0x02,                       /*bDeviceSubClass: Common Class*/
+  0x01,                       /*bDeviceProtocol: Interface Association Descriptor*/
   USB_MAX_EP0_SIZE,           /*bMaxPacketSize*/
   LOBYTE(USBD_VID),           /*idVendor*/
   HIBYTE(USBD_VID),           /*idVendor*/
@@ -83,7 +82,7 @@ __ALIGN_BEGIN uint8_t USBD_Composite_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
 #endif /* defined ( __ICCARM__ ) */
 
 /** USB lang indentifier descriptor. */
-__ALIGN_BEGIN uint8_t USBD_LangIDDesc[USB_LEN_LANGID_STR_DESC] __ALIGN_END =
+__ALIGN_BEGIN const uint8_t USBD_LangIDDesc[USB_LEN_LANGID_STR_DESC] __ALIGN_END =
 {
      USB_LEN_LANGID_STR_DESC,
      USB_DESC_TYPE_STRING,
@@ -91,16 +90,30 @@ __ALIGN_BEGIN uint8_t USBD_LangIDDesc[USB_LEN_LANGID_STR_DESC] __ALIGN_END =
      HIBYTE(USBD_LANGID_STRING)
 };
 
-#if defined ( __ICCARM__ ) /* IAR Compiler */
-  #pragma data_alignment=4
-#endif /* defined ( __ICCARM__ ) */
-/* Internal string descriptor. */
-__ALIGN_BEGIN uint8_t USBD_StrDesc[USBD_MAX_STR_DESC_SIZ] __ALIGN_END;
+/* String descriptor of an ASCII literal, converted to UTF-16LE by the
+ * compiler. 126 characters at most */
+#define USBD_STRING_DESC(name, str)                                           \
+  __ALIGN_BEGIN static const struct                                           \
+  {                                                                           \
+    uint8_t  bLength;                                                         \
+    uint8_t  bDescriptorType;                                                 \
+    uint16_t wString[sizeof(str) - 1U];                                       \
+  } name __ALIGN_END =                                                        \
+  {                                                                           \
+    (uint8_t)(2U + (2U * (sizeof(str) - 1U))), USB_DESC_TYPE_STRING, u"" str  \
+  }
+
+USBD_STRING_DESC(USBD_ManufacturerStrDesc, USBD_MANUFACTURER_STRING);
+USBD_STRING_DESC(USBD_ProductStrDesc, USBD_PRODUCT_STRING);
+USBD_STRING_DESC(USBD_ConfigurationStrDesc, USBD_CONFIGURATION_STRING);
+USBD_STRING_DESC(USBD_InterfaceHidStrDesc, USBD_INTERFACE_HID_STRING);
+USBD_STRING_DESC(USBD_InterfaceCdcStrDesc, USBD_INTERFACE_CDC_STRING);
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
 #endif
-__ALIGN_BEGIN uint8_t USBD_StringSerial[USB_SIZ_STRING_SERIAL] __ALIGN_END = {
+/* Filled from the unique ID once, by USBD_Composite_InitSerialNum */
+__ALIGN_BEGIN static uint8_t USBD_StringSerial[USB_SIZ_STRING_SERIAL] __ALIGN_END = {
   USB_SIZ_STRING_SERIAL,
   USB_DESC_TYPE_STRING,
 };
@@ -120,7 +133,7 @@ __ALIGN_BEGIN uint8_t USBD_StringSerial[USB_SIZ_STRING_SERIAL] __ALIGN_END = {
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
   *length = sizeof(USBD_Composite_DeviceDesc);
@@ -133,7 +146,7 @@ uint8_t * USBD_Composite_DeviceDescriptor(USBD_SpeedTypeDef speed, uint16_t *len
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
   *length = sizeof(USBD_LangIDDesc);
@@ -146,17 +159,11 @@ uint8_t * USBD_Composite_LangIDStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-  if(speed == 0)
-  {
-    USBD_GetString((uint8_t *)USBD_PRODUCT_STRING, USBD_StrDesc, length);
-  }
-  else
-  {
-    USBD_GetString((uint8_t *)USBD_PRODUCT_STRING, USBD_StrDesc, length);
-  }
-  return USBD_StrDesc;
+  UNUSED(speed);
+  *length = sizeof(USBD_ProductStrDesc);
+  return (const uint8_t *)&USBD_ProductStrDesc;
 }
 
 /**
@@ -165,11 +172,11 @@ uint8_t * USBD_Composite_ProductStrDescriptor(USBD_SpeedTypeDef speed, uint16_t
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
-  USBD_GetString((uint8_t *)USBD_MANUFACTURER_STRING, USBD_StrDesc, length);
-  return USBD_StrDesc;
+  *length = sizeof(USBD_ManufacturerStrDesc);
+  return (const uint8_t *)&USBD_ManufacturerStrDesc;
 }
 
 /**
@@ -178,20 +185,16 @@ uint8_t * USBD_Composite_ManufacturerStrDescriptor(USBD_SpeedTypeDef speed, uint
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
   UNUSED(speed);
   *length = USB_SIZ_STRING_SERIAL;
 
-  /* Update the serial number string descriptor with the data from the unique
-   * ID */
-  Get_SerialNum();
-
   /* USER CODE BEGIN USBD_CDC_SerialStrDescriptor */
 
   /* USER CODE END USBD_CDC_SerialStrDescriptor */
 
-  return (uint8_t *) USBD_StringSerial;
+  return USBD_StringSerial;
 }
 
 /**
@@ -200,17 +203,11 @@ uint8_t * USBD_Composite_SerialStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
+const uint8_t * USBD_Composite_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length)
 {
-  if(speed == USBD_SPEED_HIGH)
-  {
-    USBD_GetString((uint8_t *)USBD_CONFIGURATION_STRING, USBD_StrDesc, length);
-  }
-  else
-  {
-    USBD_GetString((uint8_t *)USBD_CONFIGURATION_STRING, USBD_StrDesc, length);
-  }
-  return USBD_StrDesc;
+  UNUSED(speed);
+  *length = sizeof(USBD_ConfigurationStrDesc);
+  return (const uint8_t *)&USBD_ConfigurationStrDesc;
 }
 
 /**
@@ -219,40 +216,30 @@ uint8_t * USBD_Composite_ConfigStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *
   * @param  length : Pointer to data length variable
   * @retval Pointer to descriptor buffer
   */
-uint8_t * USBD_Composite_InterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length, uint8_t iInterf)
+const uint8_t * USBD_Composite_InterfaceStrDescriptor(USBD_SpeedTypeDef speed, uint16_t *length, uint8_t iInterf)
 {
-  if(speed == 0)
+  UNUSED(speed);
+  if(iInterf == 5)
   {
-	  if(iInterf == 5)
-		  USBD_GetString((uint8_t *)USBD_INTERFACE_HID_STRING, USBD_StrDesc, length);
-	  else if(iInterf == 6)
-		  USBD_GetString((uint8_t *)USBD_INTERFACE_CDC_STRING, USBD_StrDesc, length);
-	  else
-	  {
-		  *length = 0;
-	  }
+    *length = sizeof(USBD_InterfaceHidStrDesc);
+    return (const uint8_t *)&USBD_InterfaceHidStrDesc;
   }
-  else
+  else if(iInterf == 6)
   {
-	  if(iInterf == 5)
-		  USBD_GetString((uint8_t *)USBD_INTERFACE_HID_STRING, USBD_StrDesc, length);
-	  else if(iInterf == 6)
-		  USBD_GetString((uint8_t *)USBD_INTERFACE_CDC_STRING, USBD_StrDesc, length);
-	  else
-	  {
-		  *length = 0;
-	  }
+    *length = sizeof(USBD_InterfaceCdcStrDesc);
+    return (const uint8_t *)&USBD_InterfaceCdcStrDesc;
   }
-  return USBD_StrDesc;
+  *length = 0;
+  return NULL;
 }
 
-
 /**
-  * @brief  Create the serial number string descriptor
+  * @brief  Create the serial number string descriptor from the unique ID,
+  *         once before the device starts
   * @param  None
   * @retval None
   */
-static void Get_SerialNum(void)
+void USBD_Composite_InitSerialNum(void)
 {
   uint32_t deviceserial0, deviceserial1, deviceserial2;
 
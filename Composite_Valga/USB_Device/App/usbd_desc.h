@@ -121,6 +121,7 @@ extern USBD_DescriptorsTypeDef     Composite_Desc;
   */
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+void USBD_Composite_InitSerialNum(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
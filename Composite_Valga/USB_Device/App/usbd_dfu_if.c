@@ -0,0 +1,303 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_dfu_if.c
+  * @brief          : Internal flash staging area of the firmware upgrade.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_dfu_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_DFU_IF
+  * @{
+  */
+
+/** @defgroup USBD_DFU_IF_Private_Variables USBD_DFU_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN PRIVATE_VARIABLES */
+/* Complete mark: length and CRC in the first double word, the magic in the
+ * second. The mark page is erased before the image and programmed after it,
+ * a download cut short at any point, power loss included, leaves no mark */
+typedef struct
+{
+  uint32_t Len;
+  uint32_t Crc;
+  uint32_t Magic;
+  uint32_t MagicInv;
+} DFU_MarkTypeDef;
+
+#define DFU_MARK                         ((const DFU_MarkTypeDef *)DFU_MARK_ADDR)
+
+#if (DFU_PAGE_SIZE != FLASH_PAGE_SIZE)
+#error "DFU_PAGE_SIZE must match the flash pages"
+#endif
+/* USER CODE END PRIVATE_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_DFU_IF_Private_FunctionPrototypes USBD_DFU_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t DFU_Init_FS(void);
+static int8_t DFU_DeInit_FS(void);
+static int8_t DFU_Invalidate_FS(void);
+static int8_t DFU_Erase_FS(uint32_t Offset);
+static int8_t DFU_Write_FS(const uint8_t *Src, uint32_t Offset, uint32_t Len);
+static int8_t DFU_Read_FS(uint8_t *Dest, uint32_t Offset, uint32_t Len);
+static int8_t DFU_Commit_FS(uint32_t Len, uint32_t Crc);
+static uint32_t DFU_GetLength_FS(void);
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+static int8_t DFU_ErasePage(uint32_t Addr);
+/* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
+
+/**
+  * @}
+  */
+
+USBD_DFU_MediaTypeDef USBD_DFU_fops_FS =
+{
+  DFU_Init_FS,
+  DFU_DeInit_FS,
+  DFU_Invalidate_FS,
+  DFU_Erase_FS,
+  DFU_Write_FS,
+  DFU_Read_FS,
+  DFU_Commit_FS,
+  DFU_GetLength_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the staging area
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Init_FS(void)
+{
+  /* USER CODE BEGIN 3 */
+  return (USBD_OK);
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  DeInitializes the staging area
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_DeInit_FS(void)
+{
+  /* USER CODE BEGIN 4 */
+  return (USBD_OK);
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  Erase the complete mark, left alone when already erased
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Invalidate_FS(void)
+{
+  /* USER CODE BEGIN 5 */
+  const uint32_t *p = (const uint32_t *)DFU_MARK_ADDR;
+  uint32_t i;
+
+  for (i = 0U; i < (sizeof(DFU_MarkTypeDef) / 4U); i++)
+  {
+    if (p[i] != 0xFFFFFFFFU)
+    {
+      return DFU_ErasePage(DFU_MARK_ADDR);
+    }
+  }
+
+  return (USBD_OK);
+  /* USER CODE END 5 */
+}
+
+/**
+  * @brief  Erase the page at an offset of the image
+  * @param  Offset: page offset in the image
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Erase_FS(uint32_t Offset)
+{
+  /* USER CODE BEGIN 6 */
+  return DFU_ErasePage(DFU_SLOT_ADDR + Offset);
+  /* USER CODE END 6 */
+}
+
+/**
+  * @brief  Program whole rows with fast programming, 64 double words each.
+  *         The CPU waits for the flash with the interrupts off for each row
+  * @param  Src: data, on 32-bit boundary
+  * @param  Offset: row offset in the image
+  * @param  Len: bytes, whole rows
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Write_FS(const uint8_t *Src, uint32_t Offset, uint32_t Len)
+{
+  /* USER CODE BEGIN 7 */
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t n;
+
+  (void)HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  for (n = 0U; (n < Len) && (status == HAL_OK); n += DFU_ROW_SIZE)
+  {
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_FAST, DFU_SLOT_ADDR + Offset + n,
+                               (uint64_t)(uint32_t)&Src[n]);
+  }
+  (void)HAL_FLASH_Lock();
+
+  return (status == HAL_OK) ? USBD_OK : USBD_FAIL;
+  /* USER CODE END 7 */
+}
+
+/**
+  * @brief  Read back the image
+  * @param  Dest: destination
+  * @param  Offset: offset in the image
+  * @param  Len: bytes
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Read_FS(uint8_t *Dest, uint32_t Offset, uint32_t Len)
+{
+  /* USER CODE BEGIN 8 */
+  (void)memcpy(Dest, (const uint8_t *)(DFU_SLOT_ADDR + Offset), Len);
+  return (USBD_OK);
+  /* USER CODE END 8 */
+}
+
+/**
+  * @brief  Program the complete mark, the magic last
+  * @param  Len: image bytes
+  * @param  Crc: CRC-32 of the image
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_Commit_FS(uint32_t Len, uint32_t Crc)
+{
+  /* USER CODE BEGIN 9 */
+  HAL_StatusTypeDef status;
+
+  (void)HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, DFU_MARK_ADDR,
+                             ((uint64_t)Crc << 32) | Len);
+  if (status == HAL_OK)
+  {
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, DFU_MARK_ADDR + 8U,
+                               ((uint64_t)(~DFU_MARK_MAGIC) << 32) | DFU_MARK_MAGIC);
+  }
+  (void)HAL_FLASH_Lock();
+
+  return (status == HAL_OK) ? USBD_OK : USBD_FAIL;
+  /* USER CODE END 9 */
+}
+
+/**
+  * @brief  Length of the complete image
+  * @retval bytes, 0 when no image is marked complete
+  */
+static uint32_t DFU_GetLength_FS(void)
+{
+  /* USER CODE BEGIN 10 */
+  uint32_t len = 0U;
+
+  (void)DFU_GetImage_FS(NULL, &len, NULL);
+  return len;
+  /* USER CODE END 10 */
+}
+
+/**
+  * @brief  Image marked complete in the staging area, for the boot stage
+  *         that installs it
+  * @param  Addr: image address, may be NULL
+  * @param  Len: image bytes, may be NULL
+  * @param  Crc: CRC-32 of the image, may be NULL
+  * @retval 1 if an image is marked complete else 0
+  */
+uint8_t DFU_GetImage_FS(uint32_t *Addr, uint32_t *Len, uint32_t *Crc)
+{
+  /* USER CODE BEGIN 11 */
+  uint8_t valid = ((DFU_MARK->Magic == DFU_MARK_MAGIC) &&
+                   (DFU_MARK->MagicInv == ~DFU_MARK_MAGIC) &&
+                   (DFU_MARK->Len != 0U) && (DFU_MARK->Len <= DFU_IMAGE_MAX_SIZE)) ? 1U : 0U;
+
+  if (Addr != NULL)
+  {
+    *Addr = DFU_SLOT_ADDR;
+  }
+  if (Len != NULL)
+  {
+    *Len = (valid != 0U) ? DFU_MARK->Len : 0U;
+  }
+  if (Crc != NULL)
+  {
+    *Crc = (valid != 0U) ? DFU_MARK->Crc : 0U;
+  }
+
+  return valid;
+  /* USER CODE END 11 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+  * @brief  Erase one flash page. The CPU waits for the flash, about 22 ms
+  * @param  Addr: page address
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t DFU_ErasePage(uint32_t Addr)
+{
+  FLASH_EraseInitTypeDef erase;
+  HAL_StatusTypeDef status;
+  uint32_t error;
+
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Page = (Addr - FLASH_BASE) / FLASH_PAGE_SIZE;
+  erase.NbPages = 1U;
+
+  (void)HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  status = HAL_FLASHEx_Erase(&erase, &error);
+  (void)HAL_FLASH_Lock();
+
+  return (status == HAL_OK) ? USBD_OK : USBD_FAIL;
+}
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,109 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_dfu_if.h
+  * @brief          : Header for usbd_dfu_if.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_DFU_IF_H__
+#define __USBD_DFU_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/DFU/Inc/usbd_dfu.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief For Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_DFU_IF USBD_DFU_IF
+  * @brief Usb firmware upgrade media module
+  * @{
+  */
+
+/** @defgroup USBD_DFU_IF_Exported_Defines USBD_DFU_IF_Exported_Defines
+  * @brief Defines.
+  * @{
+  */
+
+/* USER CODE BEGIN EXPORTED_DEFINES */
+/* Staging area of the downloaded image, below the application's own flash
+ * and the secure area of the wireless stack (SFSA). The page after the image
+ * area holds the complete mark */
+#define DFU_SLOT_ADDR                    0x08080000U
+#define DFU_MARK_ADDR                    (DFU_SLOT_ADDR + DFU_IMAGE_MAX_SIZE)
+#define DFU_MARK_MAGIC                   0x31554644U
+/* USER CODE END EXPORTED_DEFINES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_DFU_IF_Exported_Variables USBD_DFU_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+
+/** DFU media callback. */
+extern USBD_DFU_MediaTypeDef USBD_DFU_fops_FS;
+
+/* USER CODE BEGIN EXPORTED_VARIABLES */
+
+/* USER CODE END EXPORTED_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_DFU_IF_Exported_FunctionsPrototype USBD_DFU_IF_Exported_FunctionsPrototype
+  * @brief Public functions declaration.
+  * @{
+  */
+
+uint8_t DFU_GetImage_FS(uint32_t *Addr, uint32_t *Len, uint32_t *Crc);
+
+/* USER CODE BEGIN EXPORTED_FUNCTIONS */
+
+/* USER CODE END EXPORTED_FUNCTIONS */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_DFU_IF_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
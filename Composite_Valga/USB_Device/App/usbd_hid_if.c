@@ -0,0 +1,119 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_hid_if.c
+  * @brief          : Usb device for the HID keyboard output and feature reports.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_hid_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_HID_IF
+  * @{
+  */
+
+/** @defgroup USBD_HID_IF_Private_FunctionPrototypes USBD_HID_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t HID_Init_FS(void);
+static int8_t HID_DeInit_FS(void);
+static int8_t HID_OutEvent_FS(uint8_t report_type, uint8_t *pbuf, uint16_t length);
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
+
+/**
+  * @}
+  */
+
+USBD_HID_ItfTypeDef USBD_HID_Interface_fops_FS =
+{
+  HID_Init_FS,
+  HID_DeInit_FS,
+  HID_OutEvent_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the HID media low layer over the FS USB IP
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t HID_Init_FS(void)
+{
+  /* USER CODE BEGIN 3 */
+  return (USBD_OK);
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  DeInitializes the HID media low layer
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t HID_DeInit_FS(void)
+{
+  /* USER CODE BEGIN 4 */
+  return (USBD_OK);
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  Output or feature report received from the host, either on the
+  *         interrupt OUT endpoint or through SET_REPORT.
+  *
+  *         @note
+  *         Called from the USB interrupt, the keyboard LED state is already
+  *         stored by the class and can be read with USBD_HID_GetLedState().
+  *
+  * @param  report_type: HID_REPORT_TYPE_OUTPUT or HID_REPORT_TYPE_FEATURE
+  * @param  pbuf: report, report ID in the first byte
+  * @param  length: Number of data received (in bytes)
+  * @retval Result of the operation: USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t HID_OutEvent_FS(uint8_t report_type, uint8_t *pbuf, uint16_t length)
+{
+  /* USER CODE BEGIN 5 */
+  UNUSED(report_type);
+  UNUSED(pbuf);
+  UNUSED(length);
+  return (USBD_OK);
+  /* USER CODE END 5 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
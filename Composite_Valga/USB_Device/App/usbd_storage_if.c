@@ -0,0 +1,264 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_storage_if.c
+  * @brief          : Block device of the mass storage function, a RAM disk
+  *                   formatted FAT12 the first time it is mounted.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_storage_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_STORAGE_IF
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE_IF_Private_Variables USBD_STORAGE_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN INQUIRY_DATA_FS */
+/** USB Mass storage Standard Inquiry Data. */
+const int8_t STORAGE_Inquirydata_FS[] = {/* 36 */
+
+  /* LUN 0 */
+  0x00,
+  0x80,
+  0x02,
+  0x02,
+  0x1F,                                   /* additional length, 36 - 5 */
+  0x00,
+  0x00,
+  0x00,
+  'V', 'a', 'l', 'g', 'a', ' ', ' ', ' ', /* Manufacturer : 8 bytes */
+  'R', 'A', 'M', ' ', 'D', 'i', 's', 'k', /* Product      : 16 Bytes */
+  ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+  '0', '.', '0' ,'1'                      /* Version      : 4 Bytes */
+};
+/* USER CODE END INQUIRY_DATA_FS */
+
+/* USER CODE BEGIN PRIVATE_VARIABLES */
+static uint8_t STORAGE_Disk[STORAGE_BLK_NBR * STORAGE_BLK_SIZ];
+
+/* FAT12 boot sector of the whole disk: one reserved sector, two FATs of one
+ * sector, 16 root entries, one sector per cluster */
+static const uint8_t STORAGE_BootSector[] =
+{
+  0xEB, 0x3C, 0x90,                                       /* jump */
+  'M', 'S', 'D', 'O', 'S', '5', '.', '0',                 /* OEM name */
+  LOBYTE(STORAGE_BLK_SIZ), HIBYTE(STORAGE_BLK_SIZ),       /* bytes per sector */
+  0x01,                                                   /* sectors per cluster */
+  0x01, 0x00,                                             /* reserved sectors */
+  0x02,                                                   /* FATs */
+  0x10, 0x00,                                             /* root entries */
+  LOBYTE(STORAGE_BLK_NBR), HIBYTE(STORAGE_BLK_NBR),       /* sectors */
+  0xF8,                                                   /* media */
+  0x01, 0x00,                                             /* sectors per FAT */
+  0x01, 0x00,                                             /* sectors per track */
+  0x01, 0x00,                                             /* heads */
+  0x00, 0x00, 0x00, 0x00,                                 /* hidden sectors */
+  0x00, 0x00, 0x00, 0x00,                                 /* sectors, 32 bits */
+  0x80, 0x00, 0x29,                                       /* drive, reserved, signature */
+  0x26, 0x10, 0x19, 0x20,                                 /* volume serial */
+  'V', 'A', 'L', 'G', 'A', ' ', 'D', 'I', 'S', 'K', ' ',  /* volume label */
+  'F', 'A', 'T', '1', '2', ' ', ' ', ' ',                 /* file system */
+};
+/* USER CODE END PRIVATE_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_STORAGE_IF_Private_FunctionPrototypes USBD_STORAGE_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t STORAGE_Init_FS(uint8_t lun);
+static int8_t STORAGE_GetCapacity_FS(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+static int8_t STORAGE_IsReady_FS(uint8_t lun);
+static int8_t STORAGE_IsWriteProtected_FS(uint8_t lun);
+static int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_GetMaxLun_FS(void);
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
+
+/**
+  * @}
+  */
+
+USBD_StorageTypeDef USBD_Storage_Interface_fops_FS =
+{
+  STORAGE_Init_FS,
+  STORAGE_GetCapacity_FS,
+  STORAGE_IsReady_FS,
+  STORAGE_IsWriteProtected_FS,
+  STORAGE_Read_FS,
+  STORAGE_Write_FS,
+  STORAGE_GetMaxLun_FS,
+  (int8_t *)STORAGE_Inquirydata_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the storage unit (medium). The disk is formatted the
+  *         first time only, its content survives a reconfiguration
+  * @param  lun: Logical unit number
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_Init_FS(uint8_t lun)
+{
+  /* USER CODE BEGIN 2 */
+  uint8_t *fat;
+
+  if ((STORAGE_Disk[510] == 0x55U) && (STORAGE_Disk[511] == 0xAAU))
+  {
+    return (USBD_OK);
+  }
+
+  (void)memcpy(STORAGE_Disk, STORAGE_BootSector, sizeof(STORAGE_BootSector));
+  STORAGE_Disk[510] = 0x55U;
+  STORAGE_Disk[511] = 0xAAU;
+
+  /* Both FATs: media descriptor and end of chain for the reserved clusters */
+  fat = &STORAGE_Disk[STORAGE_BLK_SIZ];
+  fat[0] = 0xF8U;
+  fat[1] = 0xFFU;
+  fat[2] = 0xFFU;
+  (void)memcpy(fat + STORAGE_BLK_SIZ, fat, 3U);
+
+  UNUSED(lun);
+  return (USBD_OK);
+  /* USER CODE END 2 */
+}
+
+/**
+  * @brief  Returns the medium capacity.
+  * @param  lun: Logical unit number
+  * @param  block_num: Number of total block number
+  * @param  block_size: Block size
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_GetCapacity_FS(uint8_t lun, uint32_t *block_num, uint16_t *block_size)
+{
+  /* USER CODE BEGIN 3 */
+  UNUSED(lun);
+  *block_num  = STORAGE_BLK_NBR;
+  *block_size = STORAGE_BLK_SIZ;
+  return (USBD_OK);
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  Checks whether the medium is ready.
+  * @param  lun: Logical unit number
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_IsReady_FS(uint8_t lun)
+{
+  /* USER CODE BEGIN 4 */
+  UNUSED(lun);
+  return (USBD_OK);
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  Checks whether the medium is write protected.
+  * @param  lun: Logical unit number
+  * @retval USBD_OK if writes are allowed
+  */
+static int8_t STORAGE_IsWriteProtected_FS(uint8_t lun)
+{
+  /* USER CODE BEGIN 5 */
+  UNUSED(lun);
+  return (USBD_OK);
+  /* USER CODE END 5 */
+}
+
+/**
+  * @brief  Reads data from the medium. Called from the USB interrupt, while
+  *         the previous buffer is being sent
+  * @param  lun: Logical unit number
+  * @param  buf: data buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  /* USER CODE BEGIN 6 */
+  UNUSED(lun);
+  (void)memcpy(buf, &STORAGE_Disk[blk_addr * STORAGE_BLK_SIZ], (uint32_t)blk_len * STORAGE_BLK_SIZ);
+  return (USBD_OK);
+  /* USER CODE END 6 */
+}
+
+/**
+  * @brief  Writes data into the medium. Called from the USB interrupt, while
+  *         the next buffer is being received
+  * @param  lun: Logical unit number
+  * @param  buf: data buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  /* USER CODE BEGIN 7 */
+  UNUSED(lun);
+  (void)memcpy(&STORAGE_Disk[blk_addr * STORAGE_BLK_SIZ], buf, (uint32_t)blk_len * STORAGE_BLK_SIZ);
+  return (USBD_OK);
+  /* USER CODE END 7 */
+}
+
+/**
+  * @brief  Returns the Max Supported LUNs.
+  * @param  None
+  * @retval Lun(s) number.
+  */
+static int8_t STORAGE_GetMaxLun_FS(void)
+{
+  /* USER CODE BEGIN 8 */
+  return (STORAGE_LUN_NBR - 1);
+  /* USER CODE END 8 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,191 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_stream_if.c
+  * @brief          : Sensor data queued by the application and sent on the
+  *                   isochronous stream, one packet per frame.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under Ultimate Liberty license
+  * SLA0044, the "License"; You may not use this file except in compliance with
+  * the License. You may obtain a copy of the License at:
+  *                             www.st.com/SLA0044
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_stream_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_STREAM_IF
+  * @{
+  */
+
+/** @defgroup USBD_STREAM_IF_Private_Variables USBD_STREAM_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN PRIVATE_VARIABLES */
+#if ((STREAM_FIFO_SIZE & (STREAM_FIFO_SIZE - 1U)) != 0U)
+#error "STREAM_FIFO_SIZE must be a power of two"
+#endif
+
+/* Single producer, the application, and single consumer, the USB interrupt:
+ * each side only moves its own index */
+static uint8_t StreamFifo[STREAM_FIFO_SIZE];
+static volatile uint16_t StreamHead;
+static volatile uint16_t StreamTail;
+/* USER CODE END PRIVATE_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_STREAM_IF_Private_FunctionPrototypes USBD_STREAM_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t STREAM_Init_FS(void);
+static int8_t STREAM_DeInit_FS(void);
+static uint16_t STREAM_Fill_FS(uint8_t *buf, uint16_t max);
+static int8_t STREAM_Receive_FS(uint8_t *buf, uint16_t len);
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
+
+/**
+  * @}
+  */
+
+USBD_STREAM_ItfTypeDef USBD_Stream_Interface_fops_FS =
+{
+  STREAM_Init_FS,
+  STREAM_DeInit_FS,
+  STREAM_Fill_FS,
+  STREAM_Receive_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the stream, queue emptied
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STREAM_Init_FS(void)
+{
+  /* USER CODE BEGIN 3 */
+  StreamTail = StreamHead;
+  return (USBD_OK);
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  DeInitializes the stream
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STREAM_DeInit_FS(void)
+{
+  /* USER CODE BEGIN 4 */
+  return (USBD_OK);
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  Next IN packet, as much of the queue as fits. Called from the USB
+  *         interrupt
+  * @param  buf: packet buffer
+  * @param  max: packet size
+  * @retval Packet length, 0 when the queue is empty
+  */
+static uint16_t STREAM_Fill_FS(uint8_t *buf, uint16_t max)
+{
+  /* USER CODE BEGIN 5 */
+  uint16_t tail = StreamTail;
+  uint16_t len = (uint16_t)(StreamHead - tail);
+  uint16_t i;
+
+  if (len > max)
+  {
+    len = max;
+  }
+  for (i = 0U; i < len; i++)
+  {
+    buf[i] = StreamFifo[(tail + i) & (STREAM_FIFO_SIZE - 1U)];
+  }
+  StreamTail = (uint16_t)(tail + len);
+
+  return len;
+  /* USER CODE END 5 */
+}
+
+/**
+  * @brief  OUT packet from the host. Called from the USB interrupt
+  * @param  buf: packet
+  * @param  len: packet length
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t STREAM_Receive_FS(uint8_t *buf, uint16_t len)
+{
+  /* USER CODE BEGIN 6 */
+  UNUSED(buf);
+  UNUSED(len);
+  return (USBD_OK);
+  /* USER CODE END 6 */
+}
+
+/**
+  * @brief  Queue sensor data for the host
+  * @param  Buf: data
+  * @param  Len: number of bytes
+  * @retval Number of bytes queued, less than Len when the queue is full
+  */
+uint16_t STREAM_Write_FS(const uint8_t *Buf, uint16_t Len)
+{
+  /* USER CODE BEGIN 7 */
+  uint16_t head = StreamHead;
+  uint16_t room = (uint16_t)(STREAM_FIFO_SIZE - (uint16_t)(head - StreamTail));
+  uint16_t i;
+
+  if (Len > room)
+  {
+    Len = room;
+  }
+  for (i = 0U; i < Len; i++)
+  {
+    StreamFifo[(head + i) & (STREAM_FIFO_SIZE - 1U)] = Buf[i];
+  }
+  StreamHead = (uint16_t)(head + Len);
+
+  return Len;
+  /* USER CODE END 7 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -26,7 +26,7 @@
 #include "usbd_core.h"
 
 #include "usbd_cdc.h"
-#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/HID/Inc/usbd_hid.h"
+#include "../../Middlewares/ST/STM32_USB_Device_Library/Class/Composite/Inc/Composite.h"
 
 /* USER CODE BEGIN Includes */
 
@@ -38,14 +38,25 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-
+/* Isochronous IN packets waiting for the host, see USBD_IsoInTypeDef */
+static USBD_IsoInTypeDef PCD_IsoIn;
+#if (USBD_PMA_DMA == 1U)
+DMA_HandleTypeDef hdma_usb_pma;
+/* Endpoint of the copy in progress, NULL while the channel is free */
+static PCD_EPTypeDef *USBD_PmaDmaEp;
+#endif /* USBD_PMA_DMA */
 /* USER CODE END PV */
 
 PCD_HandleTypeDef hpcd_USB_FS;
 void Error_Handler(void);
 
 /* USER CODE BEGIN 0 */
-
+/* USB_HP services the isochronous and double buffered endpoints and
+ * preempts USB_LP. The setup, control data, SOF and reset callbacks of
+ * USB_LP change the class and endpoint state that path works on: they enter
+ * the library with it masked, pending until they return */
+#define USBD_LL_FAST_PATH_MASK()        HAL_NVIC_DisableIRQ(USB_HP_IRQn)
+#define USBD_LL_FAST_PATH_UNMASK()      HAL_NVIC_EnableIRQ(USB_HP_IRQn)
 /* USER CODE END 0 */
 
 /* Exported function prototypes ----------------------------------------------*/
@@ -59,6 +70,10 @@ void Error_Handler(void);
 static USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
 /* USER CODE BEGIN 1 */
 static void SystemClockConfig_Resume(void);
+#if (USBD_PMA_DMA == 1U)
+static void USBD_PMA_DMAInit(void);
+static void USBD_PMA_DMAAbort(const PCD_EPTypeDef *ep);
+#endif /* USBD_PMA_DMA */
 
 /* USER CODE END 1 */
 extern void SystemClock_Config(void);
@@ -97,11 +112,14 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
     __HAL_RCC_USB_CLK_ENABLE();
 
     /* Peripheral interrupt init */
-    HAL_NVIC_SetPriority(USB_HP_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(USB_HP_IRQn, USBD_IRQ_PRIORITY_HP, 0);
     HAL_NVIC_EnableIRQ(USB_HP_IRQn);
-    HAL_NVIC_SetPriority(USB_LP_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(USB_LP_IRQn, USBD_IRQ_PRIORITY_LP, 0);
     HAL_NVIC_EnableIRQ(USB_LP_IRQn);
   /* USER CODE BEGIN USB_MspInit 1 */
+#if (USBD_PMA_DMA == 1U)
+    USBD_PMA_DMAInit();
+#endif /* USBD_PMA_DMA */
 
   /* USER CODE END USB_MspInit 1 */
   }
@@ -116,6 +134,11 @@ void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
   if(pcdHandle->Instance==USB)
   {
   /* USER CODE BEGIN USB_MspDeInit 0 */
+#if (USBD_PMA_DMA == 1U)
+    HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    USBD_PMA_DMAAbort(NULL);
+    (void)HAL_DMA_DeInit(&hdma_usb_pma);
+#endif /* USBD_PMA_DMA */
 
   /* USER CODE END USB_MspDeInit 0 */
     /* Peripheral clock disable */
@@ -150,11 +173,11 @@ void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* USER CODE BEGIN HAL_PCD_SetupStageCallback_PreTreatment */
-  
+  USBD_LL_FAST_PATH_MASK();
   /* USER CODE END  HAL_PCD_SetupStageCallback_PreTreatment */
   USBD_LL_SetupStage((USBD_HandleTypeDef*)hpcd->pData, (uint8_t *)hpcd->Setup);  
   /* USER CODE BEGIN HAL_PCD_SetupStageCallback_PostTreatment */
-  
+  USBD_LL_FAST_PATH_UNMASK();
   /* USER CODE END  HAL_PCD_SetupStageCallback_PostTreatment */
 }
 
@@ -171,11 +194,17 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* USER CODE BEGIN HAL_PCD_DataOutStageCallback_PreTreatment */
-  
+  if (epnum == 0U)
+  {
+    USBD_LL_FAST_PATH_MASK();
+  }
   /* USER CODE END HAL_PCD_DataOutStageCallback_PreTreatment */
   USBD_LL_DataOutStage((USBD_HandleTypeDef*)hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);  
   /* USER CODE BEGIN HAL_PCD_DataOutStageCallback_PostTreatment */
-  
+  if (epnum == 0U)
+  {
+    USBD_LL_FAST_PATH_UNMASK();
+  }
   /* USER CODE END HAL_PCD_DataOutStageCallback_PostTreatment */
 }
 
@@ -192,11 +221,35 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* USER CODE BEGIN HAL_PCD_DataInStageCallback_PreTreatment */
-  
+  if (epnum == 0U)
+  {
+    USBD_LL_FAST_PATH_MASK();
+  }
+  else if (hpcd->IN_ep[epnum].type == EP_TYPE_ISOC)
+  {
+    USBD_IsoIn_Release(&PCD_IsoIn, epnum);
+    /* The endpoint stays valid: empty the buffer just sent, so that a frame
+     * the class has no data for goes out as a zero length packet rather
+     * than as the previous packet again */
+    if (hpcd->IN_ep[epnum].doublebuffer != 0U)
+    {
+      if ((PCD_GET_ENDPOINT(hpcd->Instance, epnum) & USB_EP_DTOG_TX) != 0U)
+      {
+        PCD_SET_EP_DBUF0_CNT(hpcd->Instance, epnum, 1U, 0U);
+      }
+      else
+      {
+        PCD_SET_EP_DBUF1_CNT(hpcd->Instance, epnum, 1U, 0U);
+      }
+    }
+  }
   /* USER CODE END HAL_PCD_DataInStageCallback_PreTreatment */  
   USBD_LL_DataInStage((USBD_HandleTypeDef*)hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);  
   /* USER CODE BEGIN HAL_PCD_DataInStageCallback_PostTreatment  */
-  
+  if (epnum == 0U)
+  {
+    USBD_LL_FAST_PATH_UNMASK();
+  }
   /* USER CODE END HAL_PCD_DataInStageCallback_PostTreatment */
 }
 
@@ -212,11 +265,29 @@ void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* USER CODE BEGIN HAL_PCD_SOFCallback_PreTreatment */
-  
+  uint8_t missed;
+  uint8_t epnum;
+
+  USBD_LL_FAST_PATH_MASK();
+  missed = USBD_IsoIn_Missed(&PCD_IsoIn);
+
+  for (epnum = 1U; missed != 0U; epnum++)
+  {
+    if ((missed & (1U << epnum)) != 0U)
+    {
+      missed &= (uint8_t)~(1U << epnum);
+#if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
+      hpcd->ISOINIncompleteCallback(hpcd, epnum);
+#else
+      HAL_PCD_ISOINIncompleteCallback(hpcd, epnum);
+#endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+    }
+  }
   /* USER CODE END HAL_PCD_SOFCallback_PreTreatment */  
   USBD_LL_SOF((USBD_HandleTypeDef*)hpcd->pData);  
   /* USER CODE BEGIN HAL_PCD_SOFCallback_PostTreatment */
-  
+  USBD_IsoIn_Frame(&PCD_IsoIn);
+  USBD_LL_FAST_PATH_UNMASK();
   /* USER CODE END HAL_PCD_SOFCallback_PostTreatment */
 }
 
@@ -232,7 +303,10 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 { 
   /* USER CODE BEGIN HAL_PCD_ResetCallback_PreTreatment */
-  
+  USBD_LL_FAST_PATH_MASK();
+#if (USBD_PMA_DMA == 1U)
+  USBD_PMA_DMAAbort(NULL);
+#endif /* USBD_PMA_DMA */
   /* USER CODE END HAL_PCD_ResetCallback_PreTreatment */
   USBD_SpeedTypeDef speed = USBD_SPEED_FULL;
 
@@ -246,7 +320,7 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
   /* Reset Device. */
   USBD_LL_Reset((USBD_HandleTypeDef*)hpcd->pData);
   /* USER CODE BEGIN HAL_PCD_ResetCallback_PostTreatment */
-  
+  USBD_LL_FAST_PATH_UNMASK();
   /* USER CODE END HAL_PCD_ResetCallback_PostTreatment */
 }
 
@@ -408,6 +482,9 @@ void HAL_PCD_DisconnectCallback(PCD_HandleTypeDef *hpcd)
   */
 USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
 {
+  const USBD_Composite_EpTypeDef *ep;
+  uint8_t i;
+
   /* Init USB Ip. */
   hpcd_USB_FS.pData = pdev;
   /* Link the driver to the stack. */
@@ -457,17 +534,26 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   /* USER CODE END RegisterCallBackSecondPart */
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
   /* USER CODE BEGIN EndPoint_Configuration */
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x00 , PCD_SNG_BUF, 0x18);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x80 , PCD_SNG_BUF, 0x58);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x00 , PCD_SNG_BUF, USB_COMPOSITE_PMA_EP0_OUT);
+  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , 0x80 , PCD_SNG_BUF, USB_COMPOSITE_PMA_EP0_IN);
   /* USER CODE END EndPoint_Configuration */
-  /* USER CODE BEGIN EndPoint_Configuration_CDC */
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_IN_EP , PCD_SNG_BUF, 0xd8 + 64);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_OUT_EP , PCD_SNG_BUF, 0xd8);
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , CDC_CMD_EP , PCD_SNG_BUF, 0xd8 + 2*64);
-  /* USER CODE END EndPoint_Configuration_CDC */
-  /* USER CODE BEGIN EndPoint_Configuration_HID */
-  HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , HID_EPIN_ADDR , PCD_SNG_BUF, 0xd8 + 4*64);
-  /* USER CODE END EndPoint_Configuration_HID */
+  /* USER CODE BEGIN EndPoint_Configuration_Composite */
+  /* Buffers laid out at compile time, USBD_Composite_PmaTypeDef. Isochronous
+   * endpoints have two: the peripheral sends or fills one while the other is
+   * written or read */
+  for (i = 0U; i < USB_COMPOSITE_NUM_EP; i++)
+  {
+    ep = &USBD_Composite_Endpoints[i];
+    if (ep->Type == USBD_EP_TYPE_ISOC)
+    {
+      HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , ep->Addr , PCD_DBL_BUF, ep->Pma[0] | ((uint32_t)ep->Pma[1] << 16));
+    }
+    else
+    {
+      HAL_PCDEx_PMAConfig((PCD_HandleTypeDef*)pdev->pData , ep->Addr , PCD_SNG_BUF, ep->Pma[0]);
+    }
+  }
+  /* USER CODE END EndPoint_Configuration_Composite */
   return USBD_OK;
 }
 
@@ -553,6 +639,15 @@ USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
   
+  if ((ep_addr & 0x80U) != 0U)
+  {
+    USBD_IsoIn_Release(&PCD_IsoIn, ep_addr & 0x0FU);
+  }
+#if (USBD_PMA_DMA == 1U)
+  USBD_PMA_DMAAbort(((ep_addr & 0x80U) != 0U) ?
+                    &hpcd_USB_FS.IN_ep[ep_addr & 0x0FU] : &hpcd_USB_FS.OUT_ep[ep_addr & 0x0FU]);
+#endif /* USBD_PMA_DMA */
+
   hal_status = HAL_PCD_EP_Close(pdev->pData, ep_addr);
       
   usb_status =  USBD_Get_USB_Status(hal_status);
@@ -571,6 +666,14 @@ USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
   
+  if (((ep_addr & 0x80U) != 0U) && (hpcd_USB_FS.IN_ep[ep_addr & 0x0FU].type == EP_TYPE_ISOC))
+  {
+    /* An isochronous endpoint stays valid, empty both buffers instead */
+    USBD_IsoIn_Release(&PCD_IsoIn, ep_addr & 0x0FU);
+    PCD_SET_EP_DBUF0_CNT(hpcd_USB_FS.Instance, ep_addr & 0x0FU, 1U, 0U);
+    PCD_SET_EP_DBUF1_CNT(hpcd_USB_FS.Instance, ep_addr & 0x0FU, 1U, 0U);
+  }
+
   hal_status = HAL_PCD_EP_Flush(pdev->pData, ep_addr);
       
   usb_status =  USBD_Get_USB_Status(hal_status);
@@ -660,12 +763,18 @@ USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_a
   * @param  size: Data size    
   * @retval USBD status
   */
-USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size)
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, const uint8_t *pbuf, uint16_t size)
 {
   HAL_StatusTypeDef hal_status = HAL_OK;
   USBD_StatusTypeDef usb_status = USBD_OK;
 
-  hal_status = HAL_PCD_EP_Transmit(pdev->pData, ep_addr, pbuf, size);
+  if (hpcd_USB_FS.IN_ep[ep_addr & 0x0FU].type == EP_TYPE_ISOC)
+  {
+    USBD_IsoIn_Arm(&PCD_IsoIn, ep_addr & 0x0FU);
+  }
+
+  /* The PCD only reads the buffer, descriptors are sent from flash */
+  hal_status = HAL_PCD_EP_Transmit(pdev->pData, ep_addr, (uint8_t *)pbuf, size);
      
   usb_status =  USBD_Get_USB_Status(hal_status);
   
@@ -753,45 +862,277 @@ void USBD_LL_Delay(uint32_t Delay)
   HAL_Delay(Delay);
 }
 
+/* Arena of the class handles and the CDC buffers: one block per entry of
+ * USB_COMPOSITE_HANDLES, each rounded up to 8 bytes so that any member is
+ * aligned. Its size shows in the map file as .bss.USBD_Arena */
+#define USBD_ARENA_ALIGN                8U
+#define USBD_ARENA_BLOCK(size)          (((size) + USBD_ARENA_ALIGN - 1U) & ~(USBD_ARENA_ALIGN - 1U))
+#define USBD_ARENA_ADD(type, n)         + USBD_ARENA_BLOCK(sizeof(type) * (n))
+#define USBD_ARENA_NEED(type, n)        + (sizeof(type) * (n))
+#define USBD_ARENA_SIZE                 (0U USB_COMPOSITE_HANDLES(USBD_ARENA_ADD))
+
+static uint64_t USBD_Arena[USBD_ARENA_SIZE / 8U] __attribute__((section(".bss.USBD_Arena")));
+
+_Static_assert(sizeof(USBD_Arena) == USBD_ARENA_SIZE,
+               "The arena must be whole 8-byte blocks");
+_Static_assert(sizeof(USBD_Arena) >= (0U USB_COMPOSITE_HANDLES(USBD_ARENA_NEED)),
+               "The arena must hold the summed sizes of USB_COMPOSITE_HANDLES");
+static uint32_t USBD_ArenaTop;
+/* Highest use, equal to USBD_ARENA_SIZE once every function is configured */
+uint32_t USBD_ArenaPeak;
+
 /**
-  * @brief  Static single allocation.
+  * @brief  Allocation from the arena, on 8-byte boundary.
   * @param  size: Size of allocated memory
+  * @retval Pointer to the memory, NULL when the arena is full
+  */
+void *USBD_static_malloc(uint32_t size)
+{
+  uint32_t block = USBD_ARENA_BLOCK(size);
+  void *p;
+
+  if (block > (sizeof(USBD_Arena) - USBD_ArenaTop))
+  {
+    return NULL;
+  }
+
+  p = (uint8_t *)USBD_Arena + USBD_ArenaTop;
+  USBD_ArenaTop += block;
+  if (USBD_ArenaTop > USBD_ArenaPeak)
+  {
+    USBD_ArenaPeak = USBD_ArenaTop;
+  }
+
+  return p;
+}
+
+/**
+  * @brief  Release to the arena: the block and every block allocated after
+  *         it, which the composite layer releases with it
+  * @param  p: Pointer to allocated  memory address
   * @retval None
   */
-//void *USBD_static_malloc(uint32_t size)
-//{
-//  //static uint32_t mem[(sizeof(USBD_CDC_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-//  //static uint32_t mem[(sizeof(USBD_CDC_HandleTypeDef + USBD_HID_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-//	static uint32_t mem[(size>>2)+1];
-//  return mem;
-//}
+void USBD_static_free(void *p)
+{
+  uint32_t offset = (uint32_t)((uint8_t *)p - (uint8_t *)USBD_Arena);
+
+  if (((uint8_t *)p >= (uint8_t *)USBD_Arena) && (offset < USBD_ArenaTop))
+  {
+    USBD_ArenaTop = offset;
+  }
+}
 
-void *USBD_static_malloc_Comp(uint32_t size)
+#if (USBD_PMA_BENCH == 1U)
+/* Scratch buffer of the benchmark: packet memory after the endpoint
+ * buffers, which the peripheral never uses */
+#define USBD_PMA_BENCH_ADDR             ((uint16_t)USB_COMPOSITE_PMA_END)
+#define USBD_PMA_BENCH_LEN              64U
+
+#if ((USBD_PMA_SIZE - USB_COMPOSITE_PMA_END) < USBD_PMA_BENCH_LEN)
+#error "USBD_PMA_BENCH needs 64 bytes of packet memory after the endpoint buffers"
+#endif
+
+/**
+  * @brief  Time the packet memory copies with the DWT cycle counter,
+  *         interrupts masked, and check the data read back.
+  * @param  bench: Results
+  * @retval None
+  */
+void USBD_LL_PMABench(USBD_PMA_BenchTypeDef *bench)
 {
-  static uint32_t mem[(sizeof(USBD_Composite_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-  return mem;
+  static uint32_t src[(USBD_PMA_BENCH_LEN / 4U) + 1U];
+  static uint32_t dst[(USBD_PMA_BENCH_LEN / 4U) + 1U];
+  uint8_t *s8 = (uint8_t *)src;
+  uint8_t *d8 = (uint8_t *)dst;
+  uint32_t primask;
+  uint32_t start;
+  uint32_t i;
+
+  for (i = 0U; i < sizeof(src); i++)
+  {
+    s8[i] = (uint8_t)((i * 7U) + 1U);
+    d8[i] = 0U;
+  }
+  bench->Errors = 0U;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  start = DWT->CYCCNT;
+  USB_WritePMA(USB, s8, USBD_PMA_BENCH_ADDR, USBD_PMA_BENCH_LEN);
+  bench->WriteCycles = DWT->CYCCNT - start;
+  start = DWT->CYCCNT;
+  USB_ReadPMA(USB, d8, USBD_PMA_BENCH_ADDR, USBD_PMA_BENCH_LEN);
+  bench->ReadCycles = DWT->CYCCNT - start;
+  for (i = 0U; i < USBD_PMA_BENCH_LEN; i++)
+  {
+    bench->Errors += (d8[i] != s8[i]) ? 1U : 0U;
+  }
+
+  start = DWT->CYCCNT;
+  USB_WritePMA(USB, &s8[1], USBD_PMA_BENCH_ADDR, USBD_PMA_BENCH_LEN - 1U);
+  bench->WriteCyclesUnaligned = DWT->CYCCNT - start;
+  start = DWT->CYCCNT;
+  USB_ReadPMA(USB, &d8[1], USBD_PMA_BENCH_ADDR, USBD_PMA_BENCH_LEN - 1U);
+  bench->ReadCyclesUnaligned = DWT->CYCCNT - start;
+  for (i = 1U; i < USBD_PMA_BENCH_LEN; i++)
+  {
+    bench->Errors += (d8[i] != s8[i]) ? 1U : 0U;
+  }
+
+  __set_PRIMASK(primask);
 }
+#endif /* USBD_PMA_BENCH */
 
-void *USBD_static_malloc_CDC(uint32_t size)
+#if (USBD_PMA_DMA == 1U)
+/* Packets copied by the DMA: full packets of bulk endpoints, halfword
+ * transfers from a halfword aligned buffer. Every other packet, and a packet
+ * offered while the channel is busy, is copied by the CPU */
+#define USBD_PMA_DMA_LEN                64U
+#define USBD_PMA_DMA_ADDR(hpcd, pma)    ((uint32_t)(hpcd)->Instance + 0x400U + ((uint32_t)(pma) * PMA_ACCESS))
+
+static void USBD_PMA_DMACplt(DMA_HandleTypeDef *hdma);
+static void USBD_PMA_DMAError(DMA_HandleTypeDef *hdma);
+
+/**
+  * @brief  Memory to memory channel of the packet memory copies. Its
+  *         interrupt has the priority of USB_LP, which services the single
+  *         buffered endpoints: a completion never runs inside it.
+  * @retval None
+  */
+static void USBD_PMA_DMAInit(void)
 {
-  static uint32_t mem[(sizeof(USBD_CDC_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-  return mem;
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  hdma_usb_pma.Instance = DMA1_Channel1;
+  hdma_usb_pma.Init.Request = DMA_REQUEST_MEM2MEM;
+  hdma_usb_pma.Init.Direction = DMA_MEMORY_TO_MEMORY;
+  hdma_usb_pma.Init.PeriphInc = DMA_PINC_ENABLE;
+  hdma_usb_pma.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usb_pma.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_usb_pma.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  hdma_usb_pma.Init.Mode = DMA_NORMAL;
+  hdma_usb_pma.Init.Priority = DMA_PRIORITY_HIGH;
+  if (HAL_DMA_Init(&hdma_usb_pma) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  hdma_usb_pma.XferCpltCallback = USBD_PMA_DMACplt;
+  hdma_usb_pma.XferErrorCallback = USBD_PMA_DMAError;
+  USBD_PmaDmaEp = NULL;
+
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, USBD_IRQ_PRIORITY_LP, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
 }
 
-void *USBD_static_malloc_HID(uint32_t size)
+/**
+  * @brief  Drop the copy in progress for an endpoint closed or reset.
+  * @param  ep: Endpoint, NULL for any
+  * @retval None
+  */
+static void USBD_PMA_DMAAbort(const PCD_EPTypeDef *ep)
 {
-  static uint32_t mem[(sizeof(USBD_HID_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-  return mem;
+  if ((USBD_PmaDmaEp != NULL) && ((ep == NULL) || (ep == USBD_PmaDmaEp)))
+  {
+    (void)HAL_DMA_Abort(&hdma_usb_pma);
+    USBD_PmaDmaEp = NULL;
+  }
 }
+
 /**
-  * @brief  Dummy memory free
-  * @param  p: Pointer to allocated  memory address
+  * @brief  Take the copy of a full bulk packet, see HAL_PCD_PMACopyCallback.
+  * @param  hpcd: PCD handle
+  * @param  ep: Endpoint
+  * @param  len: Bytes of the packet
+  * @retval 1 when the DMA copies the packet
+  */
+uint8_t HAL_PCD_PMACopyCallback(PCD_HandleTypeDef *hpcd, PCD_EPTypeDef *ep, uint16_t len)
+{
+  uint32_t pma = USBD_PMA_DMA_ADDR(hpcd, ep->pmaadress);
+  uint32_t primask;
+  HAL_StatusTypeDef status;
+
+  if ((len != USBD_PMA_DMA_LEN) || (ep->type != EP_TYPE_BULK) ||
+      (((uint32_t)ep->xfer_buff & 1U) != 0U))
+  {
+    return 0U;
+  }
+
+  /* Offered from the USB interrupt and from the application */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (USBD_PmaDmaEp != NULL)
+  {
+    __set_PRIMASK(primask);
+    return 0U;
+  }
+  USBD_PmaDmaEp = ep;
+  __set_PRIMASK(primask);
+
+  if (ep->is_in != 0U)
+  {
+    status = HAL_DMA_Start_IT(&hdma_usb_pma, (uint32_t)ep->xfer_buff, pma, len / 2U);
+  }
+  else
+  {
+    status = HAL_DMA_Start_IT(&hdma_usb_pma, pma, (uint32_t)ep->xfer_buff, len / 2U);
+  }
+
+  if (status != HAL_OK)
+  {
+    USBD_PmaDmaEp = NULL;
+    return 0U;
+  }
+
+  return 1U;
+}
+
+/**
+  * @brief  Copy complete: the endpoint is validated again, or the transfer
+  *         goes on, if it still waits for the packet.
+  * @param  hdma: DMA handle
   * @retval None
   */
-void USBD_static_free(void *p)
+static void USBD_PMA_DMACplt(DMA_HandleTypeDef *hdma)
 {
+  PCD_EPTypeDef *ep = USBD_PmaDmaEp;
+
+  UNUSED(hdma);
 
+  if (ep != NULL)
+  {
+    /* Free for the next packet, which the completion may start */
+    USBD_PmaDmaEp = NULL;
+    (void)HAL_PCD_EP_PMACopyDone(&hpcd_USB_FS, ep, USBD_PMA_DMA_LEN);
+  }
+}
+
+/**
+  * @brief  Copy failed, done again by the CPU.
+  * @param  hdma: DMA handle
+  * @retval None
+  */
+static void USBD_PMA_DMAError(DMA_HandleTypeDef *hdma)
+{
+  PCD_EPTypeDef *ep = USBD_PmaDmaEp;
+
+  if (ep != NULL)
+  {
+    if (ep->is_in != 0U)
+    {
+      USB_WritePMA(hpcd_USB_FS.Instance, ep->xfer_buff, ep->pmaadress, USBD_PMA_DMA_LEN);
+    }
+    else
+    {
+      USB_ReadPMA(hpcd_USB_FS.Instance, ep->xfer_buff, ep->pmaadress, USBD_PMA_DMA_LEN);
+    }
+    USBD_PMA_DMACplt(hdma);
+  }
 }
+#endif /* USBD_PMA_DMA */
 
 /* USER CODE BEGIN 5 */
 /**
@@ -55,6 +55,8 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
+/* Highest use of the class handle arena, in bytes */
+extern uint32_t USBD_ArenaPeak;
 /* USER CODE END PV */
 /**
   * @}
@@ -66,7 +68,7 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     3U
+#define USBD_MAX_NUM_INTERFACES     8U
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -77,6 +79,29 @@
 #define USBD_LPM_ENABLED     1U
 /*---------- -----------*/
 #define USBD_SELF_POWERED     1U
+/*---------- -----------*/
+/* 1 adds USBD_LL_PMABench, cycle counts of the packet memory copies */
+#ifndef USBD_PMA_BENCH
+#define USBD_PMA_BENCH     0U
+#endif /* USBD_PMA_BENCH */
+/* 1 copies full 64-byte bulk packets to and from the packet memory with
+ * DMA1 channel 1, the USB interrupt returning meanwhile */
+#ifndef USBD_PMA_DMA
+#define USBD_PMA_DMA     0U
+#endif /* USBD_PMA_DMA */
+/* NVIC preemption priorities. USB_HP, the correct transfers of the
+ * isochronous and double buffered endpoints, preempts USB_LP, every other
+ * event. The tick stays above both */
+#define USBD_IRQ_PRIORITY_HP     1U
+#define USBD_IRQ_PRIORITY_LP     2U
+/* Receive and transmit buffers of usbd_cdc_if.c, taken from the arena
+ * after the CDC handle */
+#ifndef USBD_CDC_RX_DATA_SIZE
+#define USBD_CDC_RX_DATA_SIZE     2048U
+#endif /* USBD_CDC_RX_DATA_SIZE */
+#ifndef USBD_CDC_TX_DATA_SIZE
+#define USBD_CDC_TX_DATA_SIZE     2048U
+#endif /* USBD_CDC_TX_DATA_SIZE */
 
 /****************************************/
 /* #define for FS and HS identification */
@@ -93,10 +118,11 @@
 
 /* Memory management macros */
 
-/** Alias for memory allocation. */
-#define USBD_malloc_Comp         (uint32_t *)USBD_static_malloc_Comp
-#define USBD_malloc_CDC         (uint32_t *)USBD_static_malloc_CDC
-#define USBD_malloc_HID         (uint32_t *)USBD_static_malloc_HID
+/** Alias for memory allocation, from the arena of usbd_conf.c. */
+#define USBD_malloc         USBD_static_malloc
+
+/** Allocation of n objects of a type, on 8-byte boundary. */
+#define USBD_malloc_Type(type, n)         ((type *)USBD_static_malloc(sizeof(type) * (n)))
 
 /** Alias for memory release. */
 #define USBD_free           USBD_static_free
@@ -145,6 +171,30 @@
   * @{
   */
 
+#if (USBD_PMA_BENCH == 1U)
+/* Cycles of USB_WritePMA and USB_ReadPMA, a 64-byte packet from a word
+ * aligned buffer and 63 bytes from an odd address */
+typedef struct
+{
+  uint32_t WriteCycles;
+  uint32_t ReadCycles;
+  uint32_t WriteCyclesUnaligned;
+  uint32_t ReadCyclesUnaligned;
+  uint32_t Errors;             /* bytes read back different from written */
+} USBD_PMA_BenchTypeDef;
+#endif /* USBD_PMA_BENCH */
+
+/* Isochronous IN endpoints holding a packet, one bit per endpoint number.
+ * The FS peripheral has no incomplete isochronous interrupt: a packet armed
+ * by the end of a SOF, and still armed at the next one without the host
+ * taking it in between, missed its frame. A packet armed after the SOF, on
+ * the transfer complete of the previous one, is owed to the next frame */
+typedef struct
+{
+  uint8_t Armed;
+  uint8_t Stale;               /* owed to the current frame, not taken yet */
+} USBD_IsoInTypeDef;
+
 /**
   * @}
   */
@@ -155,10 +205,39 @@
   */
 
 /* Exported functions -------------------------------------------------------*/
-void *USBD_static_malloc_Comp(uint32_t size);
-void *USBD_static_malloc_CDC(uint32_t size);
-void *USBD_static_malloc_HID(uint32_t size);
+void *USBD_static_malloc(uint32_t size);
 void USBD_static_free(void *p);
+#if (USBD_PMA_BENCH == 1U)
+void USBD_LL_PMABench(USBD_PMA_BenchTypeDef *bench);
+#endif /* USBD_PMA_BENCH */
+
+/* Bookkeeping of USBD_IsoInTypeDef, without hardware access so that the
+ * host tools run the same code */
+static inline void USBD_IsoIn_Arm(USBD_IsoInTypeDef *iso, uint8_t epnum)
+{
+  iso->Armed |= (uint8_t)(1U << epnum);
+}
+
+/* The packet was taken by the host, or dropped by a flush or a close */
+static inline void USBD_IsoIn_Release(USBD_IsoInTypeDef *iso, uint8_t epnum)
+{
+  iso->Armed &= (uint8_t)~(1U << epnum);
+  iso->Stale &= (uint8_t)~(1U << epnum);
+}
+
+/* At SOF, before the class: the endpoints whose packet missed the frame
+ * that just ended */
+static inline uint8_t USBD_IsoIn_Missed(const USBD_IsoInTypeDef *iso)
+{
+  return iso->Armed & iso->Stale;
+}
+
+/* At SOF, after the class has armed the packets it had ready: every packet
+ * armed now is owed to the frame that starts */
+static inline void USBD_IsoIn_Frame(USBD_IsoInTypeDef *iso)
+{
+  iso->Stale = iso->Armed;
+}
 
 /**
   * @}